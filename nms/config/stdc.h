@@ -50,6 +50,7 @@
 /* === stdc === */
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #include <math.h>
 
 // c11 threads
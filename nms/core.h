@@ -23,6 +23,10 @@
 #include <nms/core/exception.h>
 #include <nms/core/view.h>
 #include <nms/core/list.h>
+#include <nms/core/vlist.h>
+#include <nms/core/arena.h>
+#include <nms/core/heap.h>
+#include <nms/core/memstat.h>
 #include <nms/core/time.h>
 
 #endif
@@ -0,0 +1,409 @@
+#include <nms/test.h>
+#include <nms/core/arena.h>
+#include <nms/core/heap.h>
+#include <nms/core/memstat.h>
+
+namespace nms
+{
+
+struct alignas(16) Arena::Block
+{
+    Block*  prev;
+    u64     size;
+    u64     used;
+
+    char* data() noexcept {
+        return reinterpret_cast<char*>(this + 1);
+    }
+
+    const char* data() const noexcept {
+        return reinterpret_cast<const char*>(this + 1);
+    }
+};
+
+/* the header before every allocation: 16 bytes keep the data aligned */
+struct ArenaHead
+{
+    u64     size;
+    u64     reserved;
+};
+
+static const u64 gArenaMaxBlockSize = 64 * 1024 * 1024;    // 64MB
+static const u64 gArenaMaxSize      = 1ull << 48;           // more than the heap can reserve
+
+static ArenaHead* _arena_head(const void* ptr) noexcept {
+    return const_cast<ArenaHead*>(static_cast<const ArenaHead*>(ptr) - 1);
+}
+
+/* memstat counts the blocks of an arena, not the allocations in them */
+static void* _arena_block_new(u64 size, Arena* owner) {
+    const auto ptr = _heap_block_new(size, owner);
+    if (ptr != nullptr && memstat_enabled()) {
+        _memstat_new(_heap_size(ptr));
+    }
+    return ptr;
+}
+
+static void _arena_block_del(void* ptr) {
+    if (memstat_enabled()) {
+        _memstat_del(_heap_size(ptr));
+    }
+    _heap_block_del(ptr);
+}
+
+/* the first address after the header, aligned to align */
+static uintptr_t _arena_addr(uintptr_t pos, u64 align) noexcept {
+    return (pos + sizeof(ArenaHead) + align - 1) & ~(align - 1);
+}
+
+NMS_API Arena::~Arena() {
+    reset();
+    if (spare_ != nullptr) {
+        _arena_block_del(spare_);
+    }
+}
+
+NMS_API void* Arena::alloc(u64 size, u64 align) {
+    if (size == 0) {
+        return nullptr;
+    }
+    if (size > gArenaMaxSize) {
+        NMS_THROW(EBadAlloc{});
+    }
+
+    // try: the head block
+    uintptr_t addr = 0;
+    if (head_ != nullptr) {
+        const auto base = reinterpret_cast<uintptr_t>(head_->data());
+        const auto next = _arena_addr(base + head_->used, align);
+        if (next + size <= base + head_->size) {
+            addr = next;
+        }
+    }
+
+    if (addr == 0) {
+        addr = reinterpret_cast<uintptr_t>(grow(size, align)->data());
+        addr = _arena_addr(addr, align);
+    }
+
+    head_->used = addr + size - reinterpret_cast<uintptr_t>(head_->data());
+    last_ = reinterpret_cast<void*>(addr);
+    ++count_;
+
+    _arena_head(last_)->size = size;
+    return last_;
+}
+
+Arena::Block* Arena::grow(u64 size, u64 align) {
+    // new block: the spare block, or a larger one from the pages of the heap (they tell its owner)
+    const auto need = size + align + sizeof(ArenaHead);
+    Block* block = nullptr;
+    if (spare_ != nullptr && spare_->size >= need) {
+        block  = spare_;
+        spare_ = nullptr;
+    }
+    else {
+        const auto block_size = sizeof(Block) + need > block_size_ ? sizeof(Block) + need : block_size_;
+        block = static_cast<Block*>(_arena_block_new(block_size, this));
+        if (block == nullptr) {
+            NMS_THROW(EBadAlloc{});
+        }
+        block->size = _heap_size(block) - sizeof(Block);
+
+        // geometric growth, the number of blocks stays small
+        if (block_size_ < gArenaMaxBlockSize) {
+            block_size_ *= 2;
+        }
+    }
+    block->prev = head_;
+    block->used = 0;
+    head_ = block;
+
+    const auto base = reinterpret_cast<uintptr_t>(block->data());
+    lo_ = (lo_ == 0 || base < lo_) ? base : lo_;
+    hi_ = (base + block->size > hi_) ? base + block->size : hi_;
+    return block;
+}
+
+NMS_API void* Arena::realloc(void* ptr, u64 size) {
+    if (ptr == nullptr) {
+        return alloc(size);
+    }
+    if (size == 0) {
+        free(ptr);
+        return nullptr;
+    }
+
+    const auto head     = _arena_head(ptr);
+    const auto old_size = head->size;
+
+    // grow (or shrink) in place
+    if (ptr == last_) {
+        const auto base = reinterpret_cast<uintptr_t>(head_->data());
+        const auto addr = reinterpret_cast<uintptr_t>(ptr);
+        if (size <= base + head_->size - addr) {
+            head_->used = addr + size - base;
+            head->size  = size;
+            return ptr;
+        }
+    }
+
+    const auto new_ptr = alloc(size);
+    _mcpy(new_ptr, ptr, old_size < size ? old_size : size);
+    return new_ptr;
+}
+
+NMS_API void Arena::free(void* ptr) noexcept {
+    if (ptr == nullptr || ptr != last_) {
+        return;
+    }
+    head_->used = u64(reinterpret_cast<char*>(_arena_head(ptr)) - head_->data());
+    last_ = nullptr;
+}
+
+NMS_API Arena* Arena::owner(const void* ptr) noexcept {
+    return static_cast<Arena*>(_heap_block_owner(ptr));
+}
+
+NMS_API u64 Arena::size_of(const void* ptr) noexcept {
+    return _arena_head(ptr)->size;
+}
+
+NMS_API bool Arena::contains(const void* ptr) const noexcept {
+    const auto addr = static_cast<const char*>(ptr);
+    if (reinterpret_cast<uintptr_t>(ptr) < lo_ || reinterpret_cast<uintptr_t>(ptr) >= hi_) {
+        return false;
+    }
+    for (auto block = head_; block != nullptr; block = block->prev) {
+        const auto base = block->data();
+        if (addr >= base && addr < base + block->size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+NMS_API Arena::Mark Arena::mark() const noexcept {
+    return { head_, head_ == nullptr ? 0 : head_->used };
+}
+
+void Arena::release(Block* block) noexcept {
+    // keep the largest block for reuse
+    if (spare_ == nullptr || spare_->size < block->size) {
+        if (spare_ != nullptr) {
+            _arena_block_del(spare_);
+        }
+        spare_ = block;
+    }
+    else {
+        _arena_block_del(block);
+    }
+}
+
+NMS_API void Arena::rewind(Mark mark) noexcept {
+    while (head_ != mark.block && head_ != nullptr) {
+        const auto block = head_;
+        head_ = block->prev;
+        release(block);
+    }
+    if (head_ != nullptr) {
+        head_->used = mark.used;
+    }
+    last_ = nullptr;
+    bound();
+}
+
+void Arena::bound() noexcept {
+    lo_ = 0;
+    hi_ = 0;
+    for (auto block = head_; block != nullptr; block = block->prev) {
+        const auto base = reinterpret_cast<uintptr_t>(block->data());
+        lo_ = (lo_ == 0 || base < lo_) ? base : lo_;
+        hi_ = (base + block->size > hi_) ? base + block->size : hi_;
+    }
+}
+
+NMS_API void Arena::reset() noexcept {
+    rewind({ nullptr, 0 });
+    count_ = 0;
+}
+
+NMS_API u64 Arena::used() const noexcept {
+    u64 result = 0;
+    for (auto block = head_; block != nullptr; block = block->prev) {
+        result += block->used;
+    }
+    return result;
+}
+
+NMS_API u64 Arena::capacity() const noexcept {
+    u64 result = spare_ == nullptr ? 0 : spare_->size;
+    for (auto block = head_; block != nullptr; block = block->prev) {
+        result += block->size;
+    }
+    return result;
+}
+
+static thread_local Arena* t_arena = nullptr;
+
+NMS_API ArenaScope::ArenaScope(Arena& arena) noexcept
+    : prev_(t_arena) {
+    t_arena = &arena;
+}
+
+NMS_API ArenaScope::~ArenaScope() {
+    t_arena = prev_;
+}
+
+NMS_API Arena* arena_current() noexcept {
+    return t_arena;
+}
+
+NMS_API Arena& arena_scratch() noexcept {
+    static thread_local Arena arena;
+    return arena;
+}
+
+}
+
+namespace nms::core
+{
+
+#pragma region unittest
+
+nms_test(arena) {
+    Arena arena(256);
+
+    auto a = arena.alloc<u32>(16);
+    auto b = arena.alloc<f64>(4);
+    test::assert_true(arena.contains(a));
+    test::assert_true(arena.contains(b));
+    test::assert_eq(reinterpret_cast<uintptr_t>(b) % 16, uintptr_t(0));
+
+    // mark/rewind: the memory after the mark is reused
+    const auto mark = arena.mark();
+    auto c = arena.alloc<u8>(128 * 1024);   // new block
+    for (u32 i = 0; i < 1024; ++i) c[i] = u8(i);
+    arena.rewind(mark);
+    test::assert_false(arena.contains(c));
+    auto d = arena.alloc<f64>(4);
+    test::assert_eq(arena.mark().used, mark.used + 16 + 32);    // header + data
+    test::assert_eq(Arena::size_of(d), u64(32));
+
+    // realloc: in place for the last allocation
+    auto e = static_cast<u8*>(arena.alloc(8));
+    e[0] = 42;
+    test::assert_eq(static_cast<u8*>(arena.realloc(e, 64)), e);
+    test::assert_eq(e[0], u8(42));
+    test::assert_eq(Arena::size_of(e), u64(64));
+
+    // realloc: else a copy of the old size
+    auto f = static_cast<u8*>(arena.realloc(d, 1024));
+    test::assert_true(f != reinterpret_cast<u8*>(d));
+    test::assert_eq(Arena::size_of(f), u64(1024));
+
+    arena.reset();
+    test::assert_eq(arena.count(), u64(0));
+    test::assert_eq(arena.used(), u64(0));
+}
+
+nms_test(arena_scope) {
+    Arena arena;
+    const auto heap = mnew<u32>(4);
+    {
+        ArenaScope scope(arena);
+        test::assert_true(arena_current() == &arena);
+
+        // List/String allocate from the arena
+        List<String<> > strs;
+        for (u32 i = 0; i < 100; ++i) {
+            String<> s;
+            sformat(s, "arena {}", i);
+            strs.append(static_cast<String<>&&>(s));
+        }
+        test::assert_true(arena.contains(strs.data()));
+        test::assert_true(arena.contains(strs[99].data()));
+        test::assert_eq(strs[42], String<>("arena 42"));
+
+        // heap memory allocated before the scope is returned to the heap
+        mdel(heap);
+    }
+    test::assert_true(arena_current() == nullptr);
+    test::assert_true(arena.count() > 100);
+    arena.reset();
+
+    // a list allocated before the scope grows on the heap in the scope, it outlives the scope
+    List<u32> before;
+    before.appends(16, 1u);
+    {
+        ArenaScope scope(arena);
+        for (u32 i = 0; i < 100000; ++i) {
+            before.append(i);
+        }
+        test::assert_true(!arena.contains(before.data()));
+        test::assert_true(Arena::owner(before.data()) == nullptr);
+    }
+    arena.reset();
+    test::assert_eq(before.count(), 100016u);
+    test::assert_eq(before[15], 1u);
+    test::assert_eq(before[100015], 99999u);
+
+    // scratch arena
+    auto& scratch = arena_scratch();
+    const auto mark = scratch.mark();
+    {
+        ArenaScope scope(scratch);
+        List<u32> list;
+        list.appends(1000, 7u);
+        test::assert_true(scratch.contains(list.data()));
+    }
+    scratch.rewind(mark);
+}
+
+nms_test(arena_escape) {
+    Arena outer;
+    Arena inner;
+
+    u32* kept = nullptr;
+    {
+        ArenaScope scope(outer);
+        auto a = mnew<u32>(8);
+        {
+            ArenaScope nested(inner);
+            auto b = mnew<u32>(8);
+            test::assert_true(Arena::owner(a) == &outer);
+            test::assert_true(Arena::owner(b) == &inner);
+
+            // a block of the outer scope goes back to its arena, not to ::free
+            a[7] = 7;
+            a = mrenew(a, 1024);
+            test::assert_true(Arena::owner(a) == &outer);
+            test::assert_eq(a[7], 7u);
+            mdel(a);
+            mdel(b);
+        }
+        kept = mnew<u32>(4);
+        kept[3] = 3;
+    }
+
+    // the scope has ended, the block is still known by its arena
+    test::assert_true(arena_current() == nullptr);
+    test::assert_eq(msize(kept), u64(16));
+    kept = mrenew(kept, 64);
+    test::assert_true(Arena::owner(kept) == &outer);
+    test::assert_eq(kept[3], 3u);
+    mdel(kept);
+
+    // heap blocks are not arena blocks
+    const auto heap = mnew<u32>(4);
+    test::assert_true(Arena::owner(heap) == nullptr);
+    mdel(heap);
+
+    // the bytes before a block are never read: whatever they hold, it is not an arena block
+    u64 fake[4] = { reinterpret_cast<u64>(&outer), ~0ull, 0, 0 };
+    test::assert_true(Arena::owner(&fake[2]) == nullptr);
+}
+
+#pragma endregion
+
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <nms/core/type.h>
+#include <nms/core/memory.h>
+
+namespace nms
+{
+
+/*!
+ * monotonic (bump pointer) allocator over chained blocks.
+ *
+ * allocations are never freed one by one: the whole arena is released in O(1)
+ * with rewind/reset. while an ArenaScope is active, mnew/mdel of this thread
+ * (List, String, Tree...) are served by the arena.
+ *
+ * the blocks are pages of the nms heap range, tagged with their arena: mdel/mrenew
+ * find the arena of an allocation by its address (@see owner).
+ * every allocation is preceded by a 16 bytes header holding its size.
+ */
+class Arena final
+{
+    struct Block;
+
+public:
+    /* a position in the arena, @see mark/rewind */
+    struct Mark
+    {
+        Block*  block;
+        u64     used;
+    };
+
+    /* block_size: bytes of the first block, rounded up to the heap page size (64KB) */
+    explicit Arena(u64 block_size = 64 * 1024) noexcept
+        : block_size_(block_size)
+    {}
+
+    NMS_API ~Arena();
+
+    Arena(const Arena&)             = delete;
+    Arena& operator=(const Arena&)  = delete;
+
+    /* allocate size bytes, aligned to align (power of 2) */
+    NMS_API void* alloc(u64 size, u64 align = 16);
+
+    /* allocate cnt elements of T, no constructor is called */
+    template<class T>
+    T* alloc(u64 cnt) {
+        const auto align = alignof(T) < 16 ? 16 : alignof(T);
+        return static_cast<T*>(alloc(cnt * sizeof(T), align));
+    }
+
+    /*! resize an allocation of this arena: grows in place, if ptr is the last allocation */
+    NMS_API void* realloc(void* ptr, u64 size);
+
+    /*! release an allocation: only the last allocation is reclaimed */
+    NMS_API void  free(void* ptr) noexcept;
+
+    /* test if ptr points into a block of this arena */
+    NMS_API bool  contains(const void* ptr) const noexcept;
+
+    /*!
+     * the arena of an allocation, nullptr if ptr is not allocated by an arena.
+     * a range check, then a lookup in the page map of the heap: ptr can be any address.
+     */
+    NMS_API static Arena* owner(const void* ptr) noexcept;
+
+    /* the size of an allocation of an arena */
+    NMS_API static u64    size_of(const void* ptr) noexcept;
+
+    /* current position */
+    NMS_API Mark mark() const noexcept;
+
+    /* release all allocations after the mark */
+    NMS_API void rewind(Mark mark) noexcept;
+
+    /* release all allocations, the largest block is kept for reuse */
+    NMS_API void reset() noexcept;
+
+    /* number of allocations */
+    u64 count() const noexcept {
+        return count_;
+    }
+
+    /* bytes in use */
+    NMS_API u64 used() const noexcept;
+
+    /* bytes reserved from the heap */
+    NMS_API u64 capacity() const noexcept;
+
+protected:
+    u64     block_size_;
+    Block*  head_   = nullptr;
+    Block*  spare_  = nullptr;
+    void*   last_   = nullptr;
+    u64     count_  = 0;
+    u64     lo_     = 0;        // [lo_, hi_) bounds the blocks in use, @see contains
+    u64     hi_     = 0;
+
+    Block* grow(u64 size, u64 align);
+    void   release(Block* block) noexcept;
+    void   bound() noexcept;
+};
+
+/*!
+ * redirect mnew of the current thread to an arena, until the scope ends.
+ * scopes can be nested. mdel/mrenew find the arena of a block by its address:
+ * a block of an outer scope, or of a scope already ended, goes back to its own arena.
+ * a block must be freed before its arena is rewound, reset or destroyed,
+ * and by the thread that uses the arena.
+ */
+class ArenaScope final
+{
+public:
+    NMS_API explicit ArenaScope(Arena& arena) noexcept;
+    NMS_API ~ArenaScope();
+
+    ArenaScope(const ArenaScope&)            = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    Arena* prev_;
+};
+
+/* the arena of the current thread, nullptr if no ArenaScope is active */
+NMS_API Arena* arena_current() noexcept;
+
+/* the scratch arena of the current thread */
+NMS_API Arena& arena_scratch() noexcept;
+
+}
@@ -1,4 +1,6 @@
 ﻿#include <nms/core.h>
+#include <nms/test.h>
+#include <nms/io/log.h>
 
 namespace nms
 {
@@ -84,115 +86,570 @@ static void _formatStr(String<>& buf, const StrView& sfmt, const StrView& val) {
     }
 }
 
-static inline auto snprint_int(char buff[], u64 buff_size, u32 val) {
-    return ::snprintf(buff, buff_size, "%u", val);
+/* pads str to fmt.width, default align: '>' */
+static void _formatPad(String<>& str_out, const FmtSpec& fmt, const char* str, u32 len) {
+    if (fmt.width <= len) {
+        str_out.appends(str, len);
+        return;
+    }
+
+    str_out.reserve(str_out.count() + fmt.width);
+
+    switch (fmt.align) {
+    case '<':
+        str_out._appends(str, len);
+        str_out._appends(fmt.width - len, ' ');
+        break;
+    case '>': default:
+        str_out._appends(fmt.width - len, ' ');
+        str_out._appends(str, len);
+        break;
+    case '^':
+        str_out._appends((fmt.width - len + 0) / 2, ' ');
+        str_out._appends(str, len);
+        str_out._appends((fmt.width - len + 1) / 2, ' ');
+        break;
+    }
+}
+
+#pragma region format: integer
+static const char gDigitPairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* writes val backward, two digits at a time, returns the first char */
+static char* _fmtDec(char* end, u64 val) {
+    while (val > 0xFFFFFFFFull) {
+        const auto r = u32(val % 100);
+        val /= 100;
+        end -= 2;
+        ::memcpy(end, gDigitPairs + 2 * r, 2);
+    }
+
+    auto v = u32(val);
+    while (v >= 100) {
+        const auto r = v % 100;
+        v /= 100;
+        end -= 2;
+        ::memcpy(end, gDigitPairs + 2 * r, 2);
+    }
+
+    if (v >= 10) {
+        end -= 2;
+        ::memcpy(end, gDigitPairs + 2 * v, 2);
+    }
+    else {
+        *--end = char('0' + v);
+    }
+    return end;
+}
+
+static char* _fmtHex(char* end, u64 val, bool upper) {
+    const auto digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    do {
+        *--end = digits[val & 15];
+        val >>= 4;
+    } while (val != 0);
+    return end;
+}
+
+// [align:<>^][sign:+-][width:number][type:c x X ' ']
+static void _formatInt(String<>& str_out, const StrView& sfmt, bool neg, u64 val_abs) {
+    char str_body[288];
+    auto str_end  = str_body + sizeof(str_body);
+    auto str_head = str_end;
+
+    if (sfmt.count() == 0) {
+        str_head = _fmtDec(str_end, val_abs);
+        if (neg) {
+            *--str_head = '-';
+        }
+        str_out.appends(str_head, u32(str_end - str_head));
+        return;
+    }
+
+    const FmtSpec fmt(sfmt);
+
+    switch (fmt.type) {
+    case 'c':   // character
+        *--str_head = char(neg ? 0 - val_abs : val_abs);
+        break;
+
+    case ' ': { // blanks
+        const auto cnt = !neg && val_abs < 256u ? u32(val_abs) : 256u;
+        str_head -= cnt;
+        ::memset(str_head, ' ', cnt);
+        break;
+    }
+
+    default:
+        str_head = (fmt.type == 'x' || fmt.type == 'X')
+            ? _fmtHex(str_end, val_abs, fmt.type == 'X')
+            : _fmtDec(str_end, val_abs);
+
+        if (neg) {
+            *--str_head = '-';
+        }
+        else {
+            if (fmt.sign == '+') { *--str_head = '+'; }
+            if (fmt.sign == '-') { *--str_head = ' '; }
+        }
+        break;
+    }
+
+    _formatPad(str_out, fmt, str_head, u32(str_end - str_head));
+}
+
+static void _formatInt(String<>& str_out, const StrView& sfmt, i64 val) {
+    _formatInt(str_out, sfmt, val < 0, val < 0 ? 0 - u64(val) : u64(val));
+}
+
+static void _formatInt(String<>& str_out, const StrView& sfmt, u64 val) {
+    _formatInt(str_out, sfmt, false, val);
+}
+#pragma endregion
+
+#pragma region format: float
+/*
+ * shortest round-trip digits: Grisu2 (Loitsch, "Printing Floating-Point Numbers
+ * Quickly and Accurately with Integers", 2010).
+ * the digits always read back to the same value, and are the shortest ones
+ * except for a few rare inputs, where one more digit is printed.
+ */
+struct FmtFp
+{
+    u64 f;
+    i32 e;
+
+    friend FmtFp operator-(const FmtFp& x, const FmtFp& y) {
+        return { x.f - y.f, x.e };
+    }
+
+    /* the high 64 bits of x.f*y.f, rounded */
+    friend FmtFp operator*(const FmtFp& x, const FmtFp& y) {
+        const auto a = x.f >> 32, b = x.f & 0xFFFFFFFFu;
+        const auto c = y.f >> 32, d = y.f & 0xFFFFFFFFu;
+
+        const auto ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+        const auto mid = (bd >> 32) + (ad & 0xFFFFFFFFu) + (bc & 0xFFFFFFFFu) + (1ull << 31);
+        return { ac + (ad >> 32) + (bc >> 32) + (mid >> 32), x.e + y.e + 64 };
+    }
+
+    FmtFp normalize() const {
+#ifdef NMS_CC_MSVC
+        unsigned long idx = 0;
+        _BitScanReverse64(&idx, f);
+        const auto s = 63 - i32(idx);
+#else
+        const auto s = __builtin_clzll(f);
+#endif
+        return { f << s, e - s };
+    }
+};
+
+struct FmtPow10
+{
+    u64 f;
+    i32 e;
+    i32 k;
+};
+
+/* 10^k = f*2^e, k = -300, -292, ..., 324 */
+static const FmtPow10 gFmtPow10[] = {
+    { 0xAB70FE17C79AC6CAull, -1060, -300 },
+    { 0xFF77B1FCBEBCDC4Full, -1034, -292 },
+    { 0xBE5691EF416BD60Cull, -1007, -284 },
+    { 0x8DD01FAD907FFC3Cull,  -980, -276 },
+    { 0xD3515C2831559A83ull,  -954, -268 },
+    { 0x9D71AC8FADA6C9B5ull,  -927, -260 },
+    { 0xEA9C227723EE8BCBull,  -901, -252 },
+    { 0xAECC49914078536Dull,  -874, -244 },
+    { 0x823C12795DB6CE57ull,  -847, -236 },
+    { 0xC21094364DFB5637ull,  -821, -228 },
+    { 0x9096EA6F3848984Full,  -794, -220 },
+    { 0xD77485CB25823AC7ull,  -768, -212 },
+    { 0xA086CFCD97BF97F4ull,  -741, -204 },
+    { 0xEF340A98172AACE5ull,  -715, -196 },
+    { 0xB23867FB2A35B28Eull,  -688, -188 },
+    { 0x84C8D4DFD2C63F3Bull,  -661, -180 },
+    { 0xC5DD44271AD3CDBAull,  -635, -172 },
+    { 0x936B9FCEBB25C996ull,  -608, -164 },
+    { 0xDBAC6C247D62A584ull,  -582, -156 },
+    { 0xA3AB66580D5FDAF6ull,  -555, -148 },
+    { 0xF3E2F893DEC3F126ull,  -529, -140 },
+    { 0xB5B5ADA8AAFF80B8ull,  -502, -132 },
+    { 0x87625F056C7C4A8Bull,  -475, -124 },
+    { 0xC9BCFF6034C13053ull,  -449, -116 },
+    { 0x964E858C91BA2655ull,  -422, -108 },
+    { 0xDFF9772470297EBDull,  -396, -100 },
+    { 0xA6DFBD9FB8E5B88Full,  -369,  -92 },
+    { 0xF8A95FCF88747D94ull,  -343,  -84 },
+    { 0xB94470938FA89BCFull,  -316,  -76 },
+    { 0x8A08F0F8BF0F156Bull,  -289,  -68 },
+    { 0xCDB02555653131B6ull,  -263,  -60 },
+    { 0x993FE2C6D07B7FACull,  -236,  -52 },
+    { 0xE45C10C42A2B3B06ull,  -210,  -44 },
+    { 0xAA242499697392D3ull,  -183,  -36 },
+    { 0xFD87B5F28300CA0Eull,  -157,  -28 },
+    { 0xBCE5086492111AEBull,  -130,  -20 },
+    { 0x8CBCCC096F5088CCull,  -103,  -12 },
+    { 0xD1B71758E219652Cull,   -77,   -4 },
+    { 0x9C40000000000000ull,   -50,    4 },
+    { 0xE8D4A51000000000ull,   -24,   12 },
+    { 0xAD78EBC5AC620000ull,     3,   20 },
+    { 0x813F3978F8940984ull,    30,   28 },
+    { 0xC097CE7BC90715B3ull,    56,   36 },
+    { 0x8F7E32CE7BEA5C70ull,    83,   44 },
+    { 0xD5D238A4ABE98068ull,   109,   52 },
+    { 0x9F4F2726179A2245ull,   136,   60 },
+    { 0xED63A231D4C4FB27ull,   162,   68 },
+    { 0xB0DE65388CC8ADA8ull,   189,   76 },
+    { 0x83C7088E1AAB65DBull,   216,   84 },
+    { 0xC45D1DF942711D9Aull,   242,   92 },
+    { 0x924D692CA61BE758ull,   269,  100 },
+    { 0xDA01EE641A708DEAull,   295,  108 },
+    { 0xA26DA3999AEF774Aull,   322,  116 },
+    { 0xF209787BB47D6B85ull,   348,  124 },
+    { 0xB454E4A179DD1877ull,   375,  132 },
+    { 0x865B86925B9BC5C2ull,   402,  140 },
+    { 0xC83553C5C8965D3Dull,   428,  148 },
+    { 0x952AB45CFA97A0B3ull,   455,  156 },
+    { 0xDE469FBD99A05FE3ull,   481,  164 },
+    { 0xA59BC234DB398C25ull,   508,  172 },
+    { 0xF6C69A72A3989F5Cull,   534,  180 },
+    { 0xB7DCBF5354E9BECEull,   561,  188 },
+    { 0x88FCF317F22241E2ull,   588,  196 },
+    { 0xCC20CE9BD35C78A5ull,   614,  204 },
+    { 0x98165AF37B2153DFull,   641,  212 },
+    { 0xE2A0B5DC971F303Aull,   667,  220 },
+    { 0xA8D9D1535CE3B396ull,   694,  228 },
+    { 0xFB9B7CD9A4A7443Cull,   720,  236 },
+    { 0xBB764C4CA7A44410ull,   747,  244 },
+    { 0x8BAB8EEFB6409C1Aull,   774,  252 },
+    { 0xD01FEF10A657842Cull,   800,  260 },
+    { 0x9B10A4E5E9913129ull,   827,  268 },
+    { 0xE7109BFBA19C0C9Dull,   853,  276 },
+    { 0xAC2820D9623BF429ull,   880,  284 },
+    { 0x80444B5E7AA7CF85ull,   907,  292 },
+    { 0xBF21E44003ACDD2Dull,   933,  300 },
+    { 0x8E679C2F5E44FF8Full,   960,  308 },
+    { 0xD433179D9C8CB841ull,   986,  316 },
+    { 0x9E19DB92B4E31BA9ull,  1013,  324 },
+};
+
+/* a cached 10^k, that brings the exponent e into [-60, -32] */
+static const FmtPow10& _fmtPow10(i32 e) {
+    const auto f = -60 - e - 1;
+    const auto k = (f * 78913) / (1 << 18) + (f > 0 ? 1 : 0);
+    return gFmtPow10[(300 + k + 7) / 8];
 }
 
-static inline auto snprint_int(char buff[], u64 buff_size, i32 val) {
-    return ::snprintf(buff, buff_size, "%u", val);
+static void _fmtRound(char* buf, u32 len, u64 dist, u64 delta, u64 rest, u64 ten_k) {
+    while (rest < dist && delta - rest >= ten_k && (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+        --buf[len - 1];
+        rest += ten_k;
+    }
 }
 
-static inline auto snprint_int(char buff[], u64 buff_size, u64 val) {
-    return ::snprintf(buff, buff_size, "%llu", ullong(val));
+/* digits of w in (lo, hi), value = buf*10^dexp */
+static u32 _fmtDigits(char* buf, i32& dexp, FmtFp lo, FmtFp w, FmtFp hi) {
+    auto delta = (hi - lo).f;
+    auto dist  = (hi - w).f;
+
+    const auto shift = u32(-hi.e);
+    const auto one   = 1ull << shift;
+
+    auto p1 = u32(hi.f >> shift);
+    auto p2 = hi.f & (one - 1);
+    auto n  = 1;
+    auto pow10 = 1u;
+    while (n < 10 && p1 / pow10 >= 10) {
+        pow10 *= 10;
+        ++n;
+    }
+
+    // integral part
+    auto len = 0u;
+    while (n > 0) {
+        buf[len++] = char('0' + p1 / pow10);
+        p1 %= pow10;
+        --n;
+
+        const auto rest = (u64(p1) << shift) + p2;
+        if (rest <= delta) {
+            dexp += n;
+            _fmtRound(buf, len, dist, delta, rest, u64(pow10) << shift);
+            return len;
+        }
+        pow10 /= 10;
+    }
+
+    // fractional part
+    auto m = 0;
+    for (;;) {
+        p2 *= 10;
+        buf[len++] = char('0' + (p2 >> shift));
+        p2 &= one - 1;
+        ++m;
+
+        delta *= 10;
+        dist  *= 10;
+        if (p2 <= delta) {
+            break;
+        }
+    }
+    dexp -= m;
+    _fmtRound(buf, len, dist, delta, p2, one);
+    return len;
 }
 
-static inline auto snprint_int(char buff[], u64 buff_size, i64 val) {
-    return ::snprintf(buff, buff_size, "%lld", llong(val));
+/* F: fraction bits, E: biased exponent, v != 0 */
+static u32 _fmtShortest(char* buf, i32& dexp, u64 F, i32 E, u32 frac_bits, i32 bias) {
+    const auto v = E == 0 ? FmtFp{ F, 1 - bias } : FmtFp{ F + (1ull << frac_bits), E - bias };
+
+    // the boundaries: halfway to the neighbours
+    const auto m_plus = FmtFp{ 2 * v.f + 1, v.e - 1 }.normalize();
+    auto m_minus = (F == 0 && E > 1) ? FmtFp{ 4 * v.f - 1, v.e - 2 } : FmtFp{ 2 * v.f - 1, v.e - 1 };
+    m_minus.f <<= m_minus.e - m_plus.e;
+    m_minus.e   = m_plus.e;
+
+    const auto& pow10 = _fmtPow10(m_plus.e);
+    const auto  c     = FmtFp{ pow10.f, pow10.e };
+
+    const auto w  = v.normalize() * c;
+    const auto lo = m_minus * c;
+    const auto hi = m_plus  * c;
+
+    dexp = -pow10.k;
+    return _fmtDigits(buf, dexp, { lo.f + 1, lo.e }, w, { hi.f - 1, hi.e });
+}
+
+static u32 _fmtShortest(char* buf, i32& dexp, f64 val) {
+    u64 bits;
+    ::memcpy(&bits, &val, sizeof(bits));
+    return _fmtShortest(buf, dexp, bits & ((1ull << 52) - 1), i32(bits >> 52 & 0x7FF), 52, 1075);
 }
 
-// [align:<>=][width:number].[prec:number]s
+static u32 _fmtShortest(char* buf, i32& dexp, f32 val) {
+    u32 bits;
+    ::memcpy(&bits, &val, sizeof(bits));
+    return _fmtShortest(buf, dexp, bits & ((1u << 23) - 1), i32(bits >> 23 & 0xFF), 23, 150);
+}
+
+/* shortest round-trip text of val >= 0: 0.001, 12.5, 1.0, 1e+16, 2.5e-07 */
 template<class T>
-static void _formatInt(String<>& str_out, const StrView& sfmt, const T& val_ori) {
-    char str_body[256];
-    auto str_len = 0u;
+static u32 _fmtRepr(char* out, T val) {
+    if (val == 0) {
+        ::memcpy(out, "0.0", 3);
+        return 3;
+    }
 
-    if (sfmt.count()==0) {
-        const auto num_cnt = snprint_int(str_body, sizeof(str_body), val_ori);
-        if (num_cnt > 0) {
-            str_out.appends(str_body, u32(num_cnt));
+    char dig[32];
+    auto dexp = 0;
+    const auto len = i32(_fmtShortest(dig, dexp, val));
+    const auto pos = len + dexp;    // digits before the point
+
+    auto n = 0;
+    if (-3 <= pos && pos <= 16) {
+        if (pos >= len) {
+            ::memcpy(out, dig, u32(len));
+            ::memset(out + len, '0', u32(pos - len));
+            n = pos;
+            out[n++] = '.';
+            out[n++] = '0';
+        }
+        else if (pos > 0) {
+            ::memcpy(out, dig, u32(pos));
+            out[pos] = '.';
+            ::memcpy(out + pos + 1, dig + pos, u32(len - pos));
+            n = len + 1;
         }
+        else {
+            out[n++] = '0';
+            out[n++] = '.';
+            ::memset(out + n, '0', u32(-pos));
+            n += -pos;
+            ::memcpy(out + n, dig, u32(len));
+            n += len;
+        }
+        return u32(n);
     }
-    else {
-        const auto  val_abs = val_ori < 0 ? 0 - val_ori : val_ori;
 
-        const FmtSpec fmt(sfmt);
+    out[n++] = dig[0];
+    if (len > 1) {
+        out[n++] = '.';
+        ::memcpy(out + n, dig + 1, u32(len - 1));
+        n += len - 1;
+    }
+    const auto x = pos - 1;
+    out[n++] = 'e';
+    out[n++] = x < 0 ? '-' : '+';
+
+    char exp_buf[8];
+    auto exp_end  = exp_buf + sizeof(exp_buf);
+    auto exp_head = _fmtDec(exp_end, u64(x < 0 ? -x : x));
+    if (exp_end - exp_head < 2) {
+        *--exp_head = '0';
+    }
+    ::memcpy(out + n, exp_head, u32(exp_end - exp_head));
+    n += i32(exp_end - exp_head);
+    return u32(n);
+}
 
-        switch (fmt.type) {
-        case 'c':   // character
-            str_body[str_len++] = char(val_ori);
-            break;
+/*
+ * exact %.*f of val >= 0, for val in [2^-71, 2^64) and prec <= 100. returns 0 otherwise.
+ * the fraction is kept as a 128 bit fixed point number, the point at bit 124,
+ * and the last digit is rounded half to even, like printf.
+ */
+static u32 _fmtFixed(char* out, f64 val, u32 prec) {
+    if (prec > 100) {
+        return 0;
+    }
 
-        case ' ':   // blanks
-            str_len = u32(val_ori) < 256u ? u32(val_ori) : 256u;
-            ::memset(str_body, ' ', str_len);
-            break;
+    u64 bits;
+    ::memcpy(&bits, &val, sizeof(bits));
+    const auto E = i32(bits >> 52 & 0x7FF);
+    const auto m = E == 0 ? bits & ((1ull << 52) - 1) : (bits & ((1ull << 52) - 1)) | (1ull << 52);
+    const auto e = E == 0 ? -1074 : E - 1075;
 
-        default:
-            if (val_ori < 0) {
-                str_body[str_len++] = '-';
-            }
-            else {
-                if (fmt.sign == '+') { str_body[str_len++] = '+'; }
-                if (fmt.sign == '-') { str_body[str_len++] = ' '; }
-            }
-            auto num_cnt = snprint_int(str_body + str_len, sizeof(str_body) - str_len, val_abs);
-            if (num_cnt > 0) {
-                str_len += u32(num_cnt);
-            }
-            break;
+    u64 ipart = 0;
+    u64 fhi   = 0;
+    u64 flo   = 0;
+    if (m == 0) {
+    }
+    else if (e >= 0) {
+        if (e > 11) {
+            return 0;
+        }
+        ipart = m << e;
+    }
+    else {
+        const auto k = u32(-e);
+        if (k > 124) {
+            return 0;
         }
+        const auto frac = k < 64 ? m & ((1ull << k) - 1) : m;
+        const auto s    = 124 - k;
 
-        if (fmt.width <= str_len) {
-            str_out.appends(str_body, str_len);
+        ipart = k < 64 ? m >> k : 0;
+        if (s >= 64) {
+            fhi = frac << (s - 64);
+        }
+        else if (s > 0) {
+            fhi = frac >> (64 - s);
+            flo = frac << s;
         }
         else {
-            str_out.reserve(str_out.count());
+            flo = frac;
+        }
+    }
 
-            switch (fmt.align) {
-            case '<':
-                str_out._appends(str_body, str_len);
-                str_out._appends(fmt.width - str_len, ' ');
-                break;
-            case '>': default:
-                str_out._appends(fmt.width - str_len, ' ');
-                str_out._appends(str_body, str_len);
-                break;
-            case '^':
-                str_out._appends((fmt.width - str_len + 0) / 2, ' ');
-                str_out._appends(str_body, str_len) ;
-                str_out._appends((fmt.width - str_len + 1) / 2, ' ');
+    // out[0] is kept for the carry of the rounding
+    char int_buf[24];
+    auto int_end  = int_buf + sizeof(int_buf);
+    auto int_head = _fmtDec(int_end, ipart);
+    auto n = u32(int_end - int_head);
+    ::memcpy(out + 1, int_head, n);
+    ++n;
+
+    if (prec > 0) {
+        out[n++] = '.';
+        for (u32 i = 0; i < prec; ++i) {
+            // f = f*2 + f*8
+            const auto lo2 = flo << 1;
+            const auto lo8 = flo << 3;
+            const auto lo  = lo2 + lo8;
+            const auto hi  = fhi * 10 + (flo >> 63) + (flo >> 61) + (lo < lo2 ? 1 : 0);
+
+            out[n++] = char('0' + (hi >> 60));
+            fhi = hi & ((1ull << 60) - 1);
+            flo = lo;
+        }
+    }
+
+    // round: compare the rest with 1/2 = 2^123
+    const auto half = 1ull << 59;
+    const auto up   = fhi > half || (fhi == half && (flo != 0 || (out[n - 1] - '0') % 2 == 1));
+    if (up) {
+        auto i = n - 1;
+        for (; i > 0; --i) {
+            if (out[i] == '.') {
+                continue;
+            }
+            if (out[i] != '9') {
+                ++out[i];
                 break;
             }
+            out[i] = '0';
+        }
+        if (i == 0) {
+            out[0] = '1';
+            return n;
         }
     }
+
+    ::memmove(out, out + 1, n - 1);
+    return n - 1;
 }
 
-// [align:<>=][sign:+-][width:number].[prec:number]
+// [align:<>^][sign:+-][width:number].[prec:number][type:f g]
 template<class T>
 static void _formatFlt(String<>& str_out, const StrView& str_fmt, const T& val_ori) {
     FmtSpec fmt(str_fmt);
 
-    // set default prec
-    // float:  3
-    // double: 6
-    if (fmt.prec == -1) {
+    // no prec: shortest round-trip
+    // f,g: default prec, float: 3, double: 6
+    if (fmt.prec == -1 && (fmt.type == 'f' || fmt.type == 'g')) {
         fmt.prec = $is<float, T> ? 3 : 6;
         if (fmt.type == 'g') {
             fmt.prec += 3;
         }
     }
 
-    const auto val_abs = val_ori < 0 ? -val_ori : +val_ori;
+    // the sign bit: -0.0 is formatted as -0.0
+    const auto val_neg = signbit(val_ori);
+    const auto val_abs = val_neg ? -val_ori : +val_ori;
 
-    char str_body[256];
+    // [sign] digits: fixed notation of a large value (or a large prec) takes the heap
+    char     str_buff[256];
+    String<> str_large;
+    auto str_body = str_buff;
     auto str_head = str_body + 1;
-    auto str_cnt  = fmt.type == 'g'
-        ? snprintf(str_head, sizeof(str_body) - 1, "%.*g", fmt.prec, val_abs)
-        : snprintf(str_head, sizeof(str_body) - 1, "%.*f", fmt.prec, val_abs);
+    auto str_len  = 0u;
 
-    auto str_len = str_cnt > 0 ? u32(str_cnt) : 0;
+    if (val_abs != val_abs) {
+        ::memcpy(str_head, "nan", 3);
+        str_len = 3;
+    }
+    else if (val_abs - val_abs != 0) {
+        ::memcpy(str_head, "inf", 3);
+        str_len = 3;
+    }
+    else if (fmt.type != 'g' && fmt.prec < 0) {
+        str_len = _fmtRepr(str_head, val_abs);
+    }
+    else if (fmt.type != 'g') {
+        str_len = _fmtFixed(str_head, f64(val_abs), u32(fmt.prec));
+    }
 
-    if (val_ori < 0) {
+    if (str_len == 0) {
+        const auto str_fmt = fmt.type == 'g' ? "%.*g" : "%.*f";
+        const auto str_cnt = snprintf(str_head, sizeof(str_buff) - 1, str_fmt, fmt.prec, val_abs);
+        str_len = str_cnt > 0 ? u32(str_cnt) : 0;
+
+        // truncated: snprintf returns the length it would have written
+        if (str_len >= sizeof(str_buff) - 1) {
+            str_large.resize(str_len + 2);
+            str_body = str_large.data();
+            str_head = str_body + 1;
+            snprintf(str_head, str_len + 1, str_fmt, fmt.prec, val_abs);
+        }
+    }
+
+    if (val_neg) {
         str_body[0] = '-';
         ++str_len;
         --str_head;
@@ -202,38 +659,18 @@ static void _formatFlt(String<>& str_out, const StrView& str_fmt, const T& val_o
         if (fmt.sign == '-') { str_body[0] = ' '; ++str_len; --str_head; }
     }
 
-    if (str_len >= fmt.width) {
-        str_out.appends(str_head, str_len);
-    }
-    else {
-        str_out.reserve(str_out.count() + fmt.width);
-
-        switch (fmt.align) {
-        case '<':
-            str_out._appends(str_head, str_len);
-            str_out._appends(fmt.width - str_len, ' ');
-            break;
-        case '>': default:
-            str_out._appends(fmt.width - str_len, ' ');
-            str_out._appends(str_head, str_len);
-            break;
-        case '^':
-            str_out._appends((fmt.width - str_len + 0) / 2, ' ');
-            str_out._appends(str_head, str_len);
-            str_out._appends((fmt.width - str_len + 1) / 2, ' ');
-            break;
-        }
-    }
+    _formatPad(str_out, fmt, str_head, str_len);
 }
+#pragma endregion
 
 NMS_API void _format(String<>& buf, const StrView& fmt, StrView val) { _formatStr(buf, fmt, val); }
 
-NMS_API void _format(String<>& buf, const StrView& fmt, i8      val) { _formatInt(buf, fmt, val); }
-NMS_API void _format(String<>& buf, const StrView& fmt, u8      val) { _formatInt(buf, fmt, val); }
-NMS_API void _format(String<>& buf, const StrView& fmt, i16     val) { _formatInt(buf, fmt, val); }
-NMS_API void _format(String<>& buf, const StrView& fmt, u16     val) { _formatInt(buf, fmt, val); }
-NMS_API void _format(String<>& buf, const StrView& fmt, i32     val) { _formatInt(buf, fmt, val); }
-NMS_API void _format(String<>& buf, const StrView& fmt, u32     val) { _formatInt(buf, fmt, val); }
+NMS_API void _format(String<>& buf, const StrView& fmt, i8      val) { _formatInt(buf, fmt, i64(val)); }
+NMS_API void _format(String<>& buf, const StrView& fmt, u8      val) { _formatInt(buf, fmt, u64(val)); }
+NMS_API void _format(String<>& buf, const StrView& fmt, i16     val) { _formatInt(buf, fmt, i64(val)); }
+NMS_API void _format(String<>& buf, const StrView& fmt, u16     val) { _formatInt(buf, fmt, u64(val)); }
+NMS_API void _format(String<>& buf, const StrView& fmt, i32     val) { _formatInt(buf, fmt, i64(val)); }
+NMS_API void _format(String<>& buf, const StrView& fmt, u32     val) { _formatInt(buf, fmt, u64(val)); }
 NMS_API void _format(String<>& buf, const StrView& fmt, i64     val) { _formatInt(buf, fmt, val); }
 NMS_API void _format(String<>& buf, const StrView& fmt, u64     val) { _formatInt(buf, fmt, val); }
 NMS_API void _format(String<>& buf, const StrView& fmt, f32     val) { _formatFlt(buf, fmt, val); }
@@ -274,91 +711,276 @@ NMS_API void _format(String<>& buf, const StrView& fmt, const IException& val) {
     val.format(buf);
 }
 
-NMS_API bool Formatter::next(u32* pid, StrView* pfmt) {
-    auto& id    = *pid;
-    auto& fmt   = *pfmt;
+#pragma region formatter
+struct FmtCache
+{
+    const char* key;
+    u32         len;
+    u32         cnt;
+    char        text[256];
+    FmtItem     items[16];
+};
 
-    fmt = StrView();
+static u32 _fmtParse(const StrView& fmts, u32* ppos, u32* pid, FmtItem items[], u32 cnt) {
+    auto& pos = *ppos;
+    auto& id  = *pid;
 
-    const auto old_len = pbuf_->count();
-    pbuf_->reserve(old_len + fmts_.count());
-    auto new_len = old_len;
-    auto new_dat = pbuf_->data();
+    const auto str = fmts.data();
+    const auto len = fmts.count();
 
-    // find {
-    for (u32 i = 0; i < fmts_.count(); ++i) {
-        auto c = fmts_[i];
+    auto n = 0u;
+    while (pos < len && n < cnt) {
+        auto& item = items[n++];
+        item = { pos, 0, 0, 0, u32(-1) };
 
-        if (c == '{') {
-            if (i + 1 < fmts_.count() && fmts_[i + 1] == '{') {
-                new_dat[new_len++] = '{';
-                ++i;
-                continue;
-            }
-            else {
-                fmts_ = fmts_.slice( i, fmts_.count() - 1);
-                break;
-            }
+        // literal text
+        auto i = pos;
+        while (i < len && str[i] != '{' && str[i] != '}') {
+            ++i;
         }
+        item.text_len = i - pos;
 
-        if (c == '}') {
-            if (i + 1 < fmts_.count() && fmts_[i + 1] == '}') {
-                ++i;
-            }
+        if (i == len) {
+            pos = len;
+            break;
         }
 
-        new_dat[new_len++] = c;
+        // {{, }}: the first one is text
+        if (i + 1 < len && str[i + 1] == str[i]) {
+            item.text_len += 1;
+            pos = i + 2;
+            continue;
+        }
 
-        if (i == fmts_.count() - 1) {
-            fmts_ = {};
-            pbuf_->resize(new_len);
-            return false;
+        // a single }: text
+        if (str[i] == '}') {
+            item.text_len += 1;
+            pos = i + 1;
+            continue;
         }
-    }
 
-    // find }
-    for (u32 i = 0; i < fmts_.count(); ++i) {
-        auto c = fmts_[i];
+        // {id:spec}, an unclosed { drops the rest
+        auto j = i + 1;
+        while (j < len && str[j] != '}') {
+            ++j;
+        }
+        if (j == len) {
+            pos = len;
+            break;
+        }
 
-        if (c == '}') {
-            if (i + 1 < fmts_.count() && fmts_[i + 1] == '}') {
-                new_dat[new_len++] = '}';
-                ++i;
-                continue;
-            }
-            else {
-                fmt   = fmts_.slice( 0u,       i);
-                fmts_ = fmts_.slice( i + 1, fmts_.count() - 1);
-                break;
+        auto k = i + 1;
+        if (k < j && '0' <= str[k] && str[k] <= '9') {
+            id = 0;
+            while (k < j && '0' <= str[k] && str[k] <= '9') {
+                id = id * 10 + u32(str[k++] - '0');
             }
         }
+        if (k < j && str[k] == ':') {
+            ++k;
+        }
+
+        item.spec     = k;
+        item.spec_len = j - k;
+        item.id       = id++;
+        pos = j + 1;
     }
+    return n;
+}
+
+NMS_API u32 Formatter::parse(u32* ppos, u32* pid, FmtItem items[], u32 cnt) const {
+    static thread_local FmtCache t_fmt_cache[64];
 
-    if (fmt.count() < 2) {
-        fmts_ = {};
-        pbuf_->resize(new_len);
-        return false;
+    const auto str = fmts_.data();
+    const auto len = fmts_.count();
+
+    if (*ppos != 0 || len > sizeof(FmtCache::text) || cnt < 16) {
+        return _fmtParse(fmts_, ppos, pid, items, cnt);
     }
 
-    fmt = fmt.slice(1u, fmt.count() - 2);
-    if (fmt[0] >= '0' && fmt[0] <= '9') {
-        id = 0;
-        for (u32 i = 0; i < fmt.count(); ++i) {
-            if (fmt[i] >= '0' && fmt[i] <= '9') {
-                id = id * 10 + u32(fmt[i] - '0');
-            }
-            else {
-                fmt = fmt.slice( i, fmt.count() - 1);
-            }
+    auto& cache = t_fmt_cache[(u64(str) * 0x9E3779B97F4A7C15ull) >> 58];
+    if (cache.key == str && cache.len == len && ::memcmp(cache.text, str, len) == 0) {
+        ::memcpy(items, cache.items, cache.cnt * sizeof(FmtItem));
+        *ppos = len;
+        return cache.cnt;
+    }
+
+    const auto n = _fmtParse(fmts_, ppos, pid, items, cnt);
+    if (*ppos == len && n <= 16) {
+        cache.key = str;
+        cache.len = len;
+        cache.cnt = n;
+        ::memcpy(cache.text,  str,   len);
+        ::memcpy(cache.items, items, n * sizeof(FmtItem));
+    }
+    return n;
+}
+#pragma endregion
+
+#pragma region unittest
+nms_test(format_int) {
+    String<> s;
+    sformat(s, "{}|{}|{}|{}|{}", -123, 0u, i8(-128), i64(-9223372036854775807ll - 1), u64(18446744073709551615ull));
+    test::assert_eq(s, String<>("-123|0|-128|-9223372036854775808|18446744073709551615"));
+
+    s.clear();
+    sformat(s, "[{:5}][{:<5}][{:^6}][{:+}][{:-}][{:x}][{:X}][{:c}]", -42, 42, 42, 42, 42, 255, 255, 65);
+    test::assert_eq(s, String<>("[  -42][42   ][  42  ][+42][ 42][ff][FF][A]"));
+
+    s.clear();
+    sformat(s, "{}", reinterpret_cast<const void*>(0x1234));
+    test::assert_eq(s, String<>("0x1234"));
+}
+
+nms_test(format_flt) {
+    String<> s;
+    sformat(s, "{}|{}|{}|{}|{}|{}|{}", 0.0, 1.0, 0.1, -2.5f, 1e100, 1.5e-7, 0.1f);
+    test::assert_eq(s, String<>("0.0|1.0|0.1|-2.5|1e+100|1.5e-07|0.1"));
+
+    s.clear();
+    sformat(s, "[{.3}][{:8.2}][{<8.1}][{^8.0}][{+.1}][{f}][{f}]", 3.14159, -2.005, 0.25, 2.5, 1.25, 1.0, 1.0f);
+    test::assert_eq(s, String<>("[3.142][   -2.00][0.2     ][   2    ][+1.2][1.000000][1.000]"));
+
+    // the sign of zero, as printf
+    s.clear();
+    sformat(s, "{}|{}|{.2}|{+}|{}", -0.0, -0.0f, -0.0, 0.0, 0.0f);
+    test::assert_eq(s, String<>("-0.0|-0.0|-0.00|+0.0|0.0"));
+
+    // longer than the buffer: 301 digits
+    char str_big[1024];
+    s.clear();
+    sformat(s, "{.2}|{-.2}", 1e300, -1e300);
+    ::snprintf(str_big, sizeof(str_big), "%.2f|%.2f", 1e300, -1e300);
+    test::assert_eq(s.count(), u32(::strlen(str_big)));
+    test::assert_true(StrView(s) == StrView(str_big, u32(::strlen(str_big))));
+
+    // round-trip, and the same digits as printf
+    u64 x = 88172645463325252ull;
+    auto rand = [&] { x ^= x << 13; x ^= x >> 7; x ^= x << 17; return x; };
+
+    char str[512];
+    for (u32 i = 0; i < 100000; ++i) {
+        f64 v;
+        f32 f;
+        const auto b = rand();
+        const auto c = u32(b);
+        ::memcpy(&v, &b, sizeof(v));
+        ::memcpy(&f, &c, sizeof(f));
+        if (v != v || v - v != 0 || f != f || f - f != 0) {
+            continue;
         }
+
+        s.clear();
+        _format(s, {}, v);
+        s += '\0';
+        test::assert_eq(::strtod(s.data(), nullptr), v);
+
+        s.clear();
+        _format(s, {}, f);
+        s += '\0';
+        test::assert_eq(::strtof(s.data(), nullptr), f);
+
+        const auto y    = f64(i64(rand() % 2000000001) - 1000000000) / f64(1ull << (rand() % 40));
+        const auto prec = i32(rand() % 12);
+        const auto n    = ::snprintf(str, sizeof(str), "%.*f", prec, y);
+        char spec[4] = { '.', char('0' + prec / 10), char('0' + prec % 10), '\0' };
+        s.clear();
+        _format(s, StrView(spec, 3), y);
+        test::assert_eq(StrView(s), StrView(str, u32(n)));
     }
+}
 
-    if (fmt[0] == ':') {
-        fmt = fmt.slice(1u, fmt.count() - 1);
+nms_test(format_parse) {
+    String<> s;
+    sformat(s, "{{{}}} {1:4}|{0:<3}|{}|{2}} {", 1, 2, 3);
+    test::assert_eq(s, String<>("{1}    2|1  |2|3} "));
+
+    // explicit id, then a numeric spec
+    s.clear();
+    sformat(s, "{1:10}|{9}", 'a', 7);
+    test::assert_eq(s, String<>("         7|"));
+
+    // more fields than a parse chunk, and a format too long to cache
+    String<> f;
+    String<> e;
+    for (u32 i = 0; i < 40; ++i) {
+        f += StrView("[{}]   ");
+        sformat(e, "[{}]   ", i % 4);
+    }
+    for (u32 k = 0; k < 2; ++k) {
+        s.clear();
+        sformat(s, f, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3,
+                      0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3);
+        test::assert_eq(s, e);
     }
 
-    pbuf_->resize(new_len);
-    return true;
+    // same address, new content
+    char buf[] = "a={} b={}";
+    s.clear();
+    sformat(s, StrView(buf, 9), 1, 2);
+    buf[6] = '>';
+    sformat(s, StrView(buf, 9), 1, 2);
+    test::assert_eq(s, String<>("a=1 b=2a=1 b>2"));
 }
 
-}
\ No newline at end of file
+/* typical log lines: parsed once vs parsed on each call */
+nms_test(format_log_perf) {
+    static const u32 count = 1000000;
+
+    String<> buf;
+    buf.reserve(1024);
+
+    char line[] = "nms.test: x {}: insert={.3}ms, hit={.3}ms, miss={.3}ms, name=`{}`";
+    const auto  n = u32(sizeof(line) - 1);
+
+    const auto t0 = nms::clock();
+    for (u32 i = 0; i < count; ++i) {
+        buf.clear();
+        sformat(buf, StrView(line, n), i, 1.5, 0.25 * i, 3.0, "hashmap");
+    }
+    const auto t1 = nms::clock();
+    for (u32 i = 0; i < count; ++i) {
+        buf.clear();
+        line[n - 1] = (i & 1) ? '`' : '\'';
+        sformat(buf, StrView(line, n), i, 1.5, 0.25 * i, 3.0, "hashmap");
+    }
+    const auto t2 = nms::clock();
+
+    io::log::info("nms.format: log line x {}: cached={.3}ms, parsed={.3}ms", count, (t1 - t0)*1e3, (t2 - t1)*1e3);
+}
+
+/* format 10M ints and floats into a String<> */
+nms_test(format_perf) {
+    static const u32 count = 10000000;
+
+    char    str[64];
+    String<> buf;
+    buf.reserve(1024 * 1024);
+
+    auto run = [&](auto&& f) {
+        buf.clear();
+        const auto t0 = nms::clock();
+        for (u32 i = 0; i < count; ++i) {
+            f(i);
+            if (buf.count() > 1000000) {
+                buf.clear();
+            }
+        }
+        return nms::clock() - t0;
+    };
+
+    const auto flt = [](u32 i) { return f64(i * 2654435761u) * 1e-5; };
+
+    const auto ti0 = run([&](u32 i) { _format(buf, {}, i32(i * 2654435761u)); });
+    const auto ti1 = run([&](u32 i) { buf.appends(str, u32(::snprintf(str, sizeof(str), "%d", i32(i * 2654435761u)))); });
+    const auto tf0 = run([&](u32 i) { _format(buf, {}, flt(i)); });
+    const auto tf1 = run([&](u32 i) { buf.appends(str, u32(::snprintf(str, sizeof(str), "%.17g", flt(i)))); });
+    const auto tp0 = run([&](u32 i) { _format(buf, ".6", flt(i)); });
+    const auto tp1 = run([&](u32 i) { buf.appends(str, u32(::snprintf(str, sizeof(str), "%.6f", flt(i)))); });
+
+    io::log::info("nms.format: x {}: int={.3}ms(snprintf={.3}ms), f64 shortest={.3}ms(%.17g={.3}ms), f64 {{.6}}={.3}ms(%.6f={.3}ms)",
+        count, ti0*1e3, ti1*1e3, tf0*1e3, tf1*1e3, tp0*1e3, tp1*1e3);
+}
+#pragma endregion
+
+}
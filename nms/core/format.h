@@ -68,9 +68,13 @@ NMS_API void _format(String<>& buf, const StrView& fmt, decltype(typeid(void)) v
 NMS_API void _format(String<>& buf, const StrView& fmt, const IException&  val);
 
 inline  void _format(String<>& buf, const StrView& fmt, const void* val) {
-    fmt.count() == 0
-        ? _format(buf, "0x{:x}", reinterpret_cast<u64>(val))
-        : _format(buf, fmt, reinterpret_cast<u64>(val));
+    if (fmt.count() == 0) {
+        buf += StrView("0x");
+        _format(buf, "x", reinterpret_cast<u64>(val));
+    }
+    else {
+        _format(buf, fmt, reinterpret_cast<u64>(val));
+    }
 }
 
 inline  void _format(String<>& buf, const StrView& fmt, const String<>& val) {
@@ -242,6 +246,16 @@ void IFormatable::_do_format_property(Ti32<I> idx, String<>* buf, const T& obj,
 #pragma endregion
 
 #pragma region formatter
+/* a piece of a format string: literal text, then an optional {id:spec} field */
+struct FmtItem
+{
+    u32 text;       // offset of the literal text
+    u32 text_len;
+    u32 spec;       // offset of the spec
+    u32 spec_len;
+    u32 id;         // argument index, u32(-1): no field
+};
+
 class Formatter
 {
 public:
@@ -251,12 +265,26 @@ public:
 
     template<class ...U>
     void operator()(const U& ...u) {
-        u32     id  = 0u;
-        StrView fmt = fmts_;
-
-        while (next(&id, &fmt)) {
-            _doFormat(id, fmt, u...);
-            ++id;
+        using Tfunc = void(*)(String<>&, const StrView&, const void*);
+
+        static const Tfunc funcs[] = { &_doFormat<U>..., nullptr };
+        const void* const  args[]  = { static_cast<const void*>(&u)..., nullptr };
+
+        FmtItem items[16];
+        u32     pos = 0;
+        u32     id  = 0;
+
+        const auto str = fmts_.data();
+        while (pos < fmts_.count()) {
+            const auto cnt = parse(&pos, &id, items, 16);
+
+            for (u32 i = 0; i < cnt; ++i) {
+                const auto& item = items[i];
+                pbuf_->appends(str + item.text, item.text_len);
+                if (item.id < sizeof...(U)) {
+                    funcs[item.id](*pbuf_, StrView(str + item.spec, item.spec_len), args[item.id]);
+                }
+            }
         }
     }
 
@@ -264,19 +292,16 @@ protected:
     String<>* pbuf_;
     StrView fmts_;
 
-    NMS_API bool next(u32* id, StrView* fmt);
+    /*!
+     * split the format string into items, from *pos, at most cnt.
+     * a whole format string is parsed once per thread, then copied from a cache,
+     * keyed by its address and checked by its content.
+     */
+    NMS_API u32 parse(u32* pos, u32* id, FmtItem items[], u32 cnt) const;
 
-    void _doFormat(u32 /*id*/, const StrView& /*fmt*/) const {
-    }
-
-    template<class T, class ...U>
-    void _doFormat(u32 id, const StrView& fmt, const T& t, const U& ...u) {
-        if (id == 0) {
-            format_switch(*pbuf_, fmt, t);
-        }
-        else {
-            _doFormat(id - 1, fmt, u...);
-        }
+    template<class T>
+    static void _doFormat(String<>& buf, const StrView& fmt, const void* t) {
+        format_switch(buf, fmt, *static_cast<const T*>(t));
     }
 };
 
@@ -0,0 +1,923 @@
+#include <nms/test.h>
+#include <nms/core/heap.h>
+#include <nms/thread.h>
+
+namespace nms
+{
+
+using thread::Atomic;
+using thread::MemOrder;
+using thread::SpinWait;
+
+static const u64 gHeapPageBits  = 16;
+static const u64 gHeapPageSize  = 1ull << gHeapPageBits;            // 64KB
+static const u64 gHeapReserve   = 1ull << 36;                       // 64GB of address space
+static const u64 gHeapPageCount = gHeapReserve >> gHeapPageBits;
+static const u32 gHeapClasses   = 40;
+static const u64 gHeapSmallMax  = 32 * 1024;
+static const u32 gHeapLarge     = gHeapClasses;                     // Span::cls of a large block
+static const u32 gHeapFree      = gHeapClasses + 1;                 // Span::cls of free pages
+static const u32 gHeapBlock     = gHeapClasses + 2;                 // Span::cls of a tagged block
+static const u32 gHeapBins      = 128;                              // free spans by page count
+
+#pragma region bits
+static __forceinline u32 _heap_log2(u64 val) {
+#ifdef NMS_CC_MSVC
+    unsigned long idx = 0;
+    _BitScanReverse64(&idx, val);
+    return u32(idx);
+#else
+    return 63 - u32(__builtin_clzll(val));
+#endif
+}
+#pragma endregion
+
+#pragma region size class
+/* 16..128 step 16, then 4 classes per power of 2 up to 32KB */
+static __forceinline u32 _heap_class(u64 size) {
+    if (size <= 128) {
+        return size == 0 ? 0 : u32((size + 15) / 16) - 1;
+    }
+    const auto lg = _heap_log2(size - 1);
+    return 8 + (lg - 7) * 4 + u32((size - 1 - (1ull << lg)) >> (lg - 2));
+}
+
+static __forceinline u64 _heap_class_size(u32 cls) {
+    if (cls < 8) {
+        return (cls + 1) * 16;
+    }
+    const auto k  = cls - 8;
+    const auto lg = 7 + k / 4;
+    return (1ull << lg) + (k % 4 + 1) * (1ull << (lg - 2));
+}
+
+/* objects moved between a thread cache and the central list at once */
+static __forceinline u32 _heap_class_batch(u32 cls) {
+    const auto cnt = u32(16 * 1024 / _heap_class_size(cls));
+    return cnt < 2 ? 2 : cnt > 64 ? 64 : cnt;
+}
+
+/* pages of a span: 8 objects at least */
+static __forceinline u32 _heap_class_pages(u32 cls) {
+    const auto size = _heap_class_size(cls) * 8;
+    return u32((size + gHeapPageSize - 1) / gHeapPageSize);
+}
+#pragma endregion
+
+#pragma region lock
+struct HeapLock
+{
+    Atomic<u32> state = 0u;
+
+    void lock() noexcept {
+        SpinWait wait;
+        while (state.exchange(1u, MemOrder::Acquire) != 0) {
+            while (state.load(MemOrder::Relaxed) != 0) {
+                wait();
+            }
+        }
+    }
+
+    void unlock() noexcept {
+        state.store(0u, MemOrder::Release);
+    }
+};
+
+struct HeapLockGuard
+{
+    explicit HeapLockGuard(HeapLock& lock) noexcept
+        : lock_(lock) {
+        lock_.lock();
+    }
+
+    ~HeapLockGuard() {
+        lock_.unlock();
+    }
+
+    HeapLockGuard(const HeapLockGuard&)             = delete;
+    HeapLockGuard& operator=(const HeapLockGuard&)  = delete;
+
+private:
+    HeapLock& lock_;
+};
+#pragma endregion
+
+#pragma region page heap
+/* a run of pages: a span of one size class, a large block or free pages */
+struct HeapSpan
+{
+    u64         base;       // address of the first page
+    u32         pages;      // number of pages
+    u32         cls;        // size class, or gHeapLarge
+    u32         used;       // objects in use
+    u32         carved;     // objects handed out at least once
+    u32         capacity;   // objects in span
+    bool        committed;  // false: the pages are returned to the OS
+    void*       free;       // returned objects
+    void*       owner;      // the owner of a tagged block
+    HeapSpan*   prev;
+    HeapSpan*   next;
+};
+
+struct HeapPages
+{
+    HeapLock    lock;
+    Atomic<u32> state = 0u;             // 0: not ready, 1: ready, 2: failed
+    Atomic<u64> base  = 0ull;           // set once, before state: read by _heap_owns without the lock
+    u64         top   = 0;              // pages handed out from the reserved range
+    u64         idle  = 0;              // bytes of committed free pages
+    u64         idle_limit = 64 * 1024 * 1024;
+    HeapSpan**  map   = nullptr;        // page -> span
+    HeapSpan*   bins[gHeapBins + 1] = {};   // free spans, [0]: more than gHeapBins pages
+};
+
+static HeapPages gHeap;
+
+static bool _heap_init() {
+    auto& heap = gHeap;
+    const auto state = heap.state.load(MemOrder::Acquire);
+    if (state != 0) {
+        return state == 1;
+    }
+
+    HeapLockGuard guard(heap.lock);
+    if (heap.state.load(MemOrder::Relaxed) != 0) {
+        return heap.state.load(MemOrder::Relaxed) == 1;
+    }
+
+    const auto map_size = gHeapPageCount * sizeof(HeapSpan*);
+    const auto base     = vnew(gHeapReserve);
+    const auto map      = vnew(map_size);
+    if (base == nullptr || map == nullptr || !vuse(map, map_size)) {
+        heap.state.store(2u, MemOrder::Release);
+        return false;
+    }
+    heap.map  = static_cast<HeapSpan**>(map);
+    heap.base.store(reinterpret_cast<u64>(base), MemOrder::Release);
+    heap.state.store(1u, MemOrder::Release);
+    return true;
+}
+
+static HeapSpan* _heap_span_new() {
+    auto span = static_cast<HeapSpan*>(::malloc(sizeof(HeapSpan)));
+    if (span == nullptr) {
+        return nullptr;
+    }
+    *span = HeapSpan{};
+    return span;
+}
+
+static void _heap_bin_push(HeapSpan* span) {
+    auto& heap = gHeap;
+    auto& bin  = heap.bins[span->pages <= gHeapBins ? span->pages : 0];
+    span->prev = nullptr;
+    span->next = bin;
+    if (bin != nullptr) {
+        bin->prev = span;
+    }
+    bin = span;
+}
+
+static void _heap_bin_remove(HeapSpan* span) {
+    auto& heap = gHeap;
+    auto& bin  = heap.bins[span->pages <= gHeapBins ? span->pages : 0];
+    if (span->prev != nullptr) {
+        span->prev->next = span->next;
+    }
+    else {
+        bin = span->next;
+    }
+    if (span->next != nullptr) {
+        span->next->prev = span->prev;
+    }
+}
+
+/* a free span: only the first and the last page are mapped */
+static void _heap_map_ends(HeapSpan* span) {
+    auto& heap = gHeap;
+    const auto first = (span->base - heap.base.load(MemOrder::Relaxed)) >> gHeapPageBits;
+    heap.map[first] = span;
+    heap.map[first + span->pages - 1] = span;
+}
+
+/* allocate n pages, nullptr if the reserved range is used up */
+static HeapSpan* _heap_pages_new(u32 n) {
+    auto& heap = gHeap;
+    HeapLockGuard guard(heap.lock);
+
+    // reuse: the smallest bin, then first fit in the large bin
+    HeapSpan* span = nullptr;
+    for (auto k = n; k <= gHeapBins && span == nullptr; ++k) {
+        span = heap.bins[k];
+    }
+    if (span == nullptr) {
+        for (auto s = heap.bins[0]; s != nullptr; s = s->next) {
+            if (s->pages >= n) {
+                span = s;
+                break;
+            }
+        }
+    }
+
+    if (span != nullptr) {
+        _heap_bin_remove(span);
+        if (span->committed) {
+            heap.idle -= u64(span->pages) * gHeapPageSize;
+        }
+
+        // split: the tail goes back to the bins
+        if (span->pages > n) {
+            if (auto rest = _heap_span_new()) {
+                rest->base      = span->base + u64(n) * gHeapPageSize;
+                rest->pages     = span->pages - n;
+                rest->committed = span->committed;
+                if (rest->committed) {
+                    heap.idle += u64(rest->pages) * gHeapPageSize;
+                }
+                rest->cls       = gHeapFree;
+                _heap_map_ends(rest);
+                _heap_bin_push(rest);
+                span->pages = n;
+            }
+        }
+    }
+    else {
+        if (heap.top + n > gHeapPageCount) {
+            return nullptr;
+        }
+        span = _heap_span_new();
+        if (span == nullptr) {
+            return nullptr;
+        }
+        span->base  = heap.base.load(MemOrder::Relaxed) + heap.top * gHeapPageSize;
+        span->pages = n;
+        heap.top   += n;
+    }
+
+    span->cls      = 0;
+    span->used     = 0;
+    span->carved   = 0;
+    span->capacity = 0;
+    span->free     = nullptr;
+    span->owner    = nullptr;
+    span->prev     = nullptr;
+    span->next     = nullptr;
+
+    if (!span->committed) {
+        if (!vuse(reinterpret_cast<void*>(span->base), u64(span->pages) * gHeapPageSize)) {
+            span->cls = gHeapFree;
+            _heap_map_ends(span);
+            _heap_bin_push(span);
+            return nullptr;
+        }
+        span->committed = true;
+    }
+
+    const auto first = (span->base - heap.base.load(MemOrder::Relaxed)) >> gHeapPageBits;
+    for (u64 i = 0; i < span->pages; ++i) {
+        heap.map[first + i] = span;
+    }
+    return span;
+}
+
+static void _heap_pages_del(HeapSpan* span) {
+    auto& heap = gHeap;
+    HeapLockGuard guard(heap.lock);
+
+    span->cls   = gHeapFree;
+    span->free  = nullptr;
+    span->owner = nullptr;
+    if (heap.idle + u64(span->pages) * gHeapPageSize > heap.idle_limit) {
+        vunuse(reinterpret_cast<void*>(span->base), u64(span->pages) * gHeapPageSize);
+        span->committed = false;
+    }
+    else {
+        heap.idle += u64(span->pages) * gHeapPageSize;
+    }
+
+    // merge with the free neighbours, a merged span is committed only if both parts are
+    const auto first = (span->base - heap.base.load(MemOrder::Relaxed)) >> gHeapPageBits;
+    const auto last  = first + span->pages - 1;
+    HeapSpan* neighbours[] = {
+        first > 0           ? heap.map[first - 1] : nullptr,
+        last + 1 < heap.top ? heap.map[last + 1]  : nullptr
+    };
+    for (auto other : neighbours) {
+        if (other == nullptr || other->cls != gHeapFree) {
+            continue;
+        }
+        _heap_bin_remove(other);
+        if (other->committed != span->committed) {
+            auto part = other->committed ? other : span;
+            vunuse(reinterpret_cast<void*>(part->base), u64(part->pages) * gHeapPageSize);
+            heap.idle -= u64(part->pages) * gHeapPageSize;
+            span->committed = false;
+        }
+        if (other->base < span->base) {
+            span->base = other->base;
+        }
+        span->pages += other->pages;
+        ::free(other);
+    }
+
+    _heap_map_ends(span);
+    _heap_bin_push(span);
+}
+
+/*!
+ * resize a large block to n pages in place: the tail pages are released, or the
+ * free pages after it (or the pages at the top of the range) are taken.
+ * returns false if the pages after the block are in use.
+ */
+static bool _heap_pages_resize(HeapSpan* span, u32 n) {
+    auto& heap = gHeap;
+    const auto base = heap.base.load(MemOrder::Relaxed);
+
+    HeapSpan* rest = nullptr;
+    {
+        HeapLockGuard guard(heap.lock);
+        const auto first = (span->base - base) >> gHeapPageBits;
+
+        if (n < span->pages) {
+            rest = _heap_span_new();
+            if (rest == nullptr) {
+                return true;            // keep the pages
+            }
+            rest->base      = span->base + u64(n) * gHeapPageSize;
+            rest->pages     = span->pages - n;
+            rest->cls       = gHeapLarge;
+            rest->committed = true;
+            for (u64 i = n; i < span->pages; ++i) {
+                heap.map[first + i] = rest;
+            }
+            span->pages = n;
+        }
+        else if (n > span->pages) {
+            const auto more = n - span->pages;
+            const auto next = first + span->pages;
+            const auto addr = reinterpret_cast<void*>(span->base + u64(span->pages) * gHeapPageSize);
+
+            if (next == heap.top) {
+                // the top of the range
+                if (heap.top + more > gHeapPageCount || !vuse(addr, u64(more) * gHeapPageSize)) {
+                    return false;
+                }
+                heap.top += more;
+            }
+            else {
+                // the free span after the block
+                const auto other = heap.map[next];
+                if (other == nullptr || other->cls != gHeapFree || other->pages < more) {
+                    return false;
+                }
+                if (!other->committed && !vuse(addr, u64(more) * gHeapPageSize)) {
+                    return false;
+                }
+                _heap_bin_remove(other);
+                if (other->committed) {
+                    heap.idle -= u64(more) * gHeapPageSize;
+                }
+                if (other->pages > more) {
+                    other->base  += u64(more) * gHeapPageSize;
+                    other->pages -= more;
+                    _heap_map_ends(other);
+                    _heap_bin_push(other);
+                }
+                else {
+                    ::free(other);
+                }
+            }
+            for (u64 i = span->pages; i < n; ++i) {
+                heap.map[first + i] = span;
+            }
+            span->pages = n;
+        }
+    }
+
+    if (rest != nullptr) {
+        _heap_pages_del(rest);
+    }
+    return true;
+}
+
+static __forceinline HeapSpan* _heap_span_of(const void* ptr) {
+    auto& heap = gHeap;
+    const auto idx = (reinterpret_cast<u64>(ptr) - heap.base.load(MemOrder::Relaxed)) >> gHeapPageBits;
+    return heap.map[idx];
+}
+#pragma endregion
+
+#pragma region central
+struct alignas(64) HeapCentral
+{
+    HeapLock    lock;
+    HeapSpan*   partial = nullptr;      // spans with free objects
+};
+
+static HeapCentral gHeapCentral[gHeapClasses];
+
+static void _heap_partial_push(HeapCentral& central, HeapSpan* span) {
+    span->prev = nullptr;
+    span->next = central.partial;
+    if (central.partial != nullptr) {
+        central.partial->prev = span;
+    }
+    central.partial = span;
+}
+
+static void _heap_partial_remove(HeapCentral& central, HeapSpan* span) {
+    if (span->prev != nullptr) {
+        span->prev->next = span->next;
+    }
+    else {
+        central.partial = span->next;
+    }
+    if (span->next != nullptr) {
+        span->next->prev = span->prev;
+    }
+    span->prev = nullptr;
+    span->next = nullptr;
+}
+
+/* take up to cnt objects of class cls, linked through their first word */
+static u32 _heap_central_fetch(u32 cls, u32 cnt, void*& head) {
+    auto& central = gHeapCentral[cls];
+    const auto size = _heap_class_size(cls);
+
+    HeapLockGuard guard(central.lock);
+    u32 ret = 0;
+    while (ret < cnt) {
+        auto span = central.partial;
+        if (span == nullptr) {
+            const auto pages = _heap_class_pages(cls);
+            span = _heap_pages_new(pages);
+            if (span == nullptr) {
+                break;
+            }
+            span->cls      = cls;
+            span->capacity = u32(u64(pages) * gHeapPageSize / size);
+            _heap_partial_push(central, span);
+        }
+
+        while (ret < cnt && span->used < span->capacity) {
+            void* obj = span->free;
+            if (obj != nullptr) {
+                span->free = *static_cast<void**>(obj);
+            }
+            else {
+                obj = reinterpret_cast<void*>(span->base + span->carved * size);
+                ++span->carved;
+            }
+            *static_cast<void**>(obj) = head;
+            head = obj;
+            ++span->used;
+            ++ret;
+        }
+        if (span->used == span->capacity) {
+            _heap_partial_remove(central, span);
+        }
+    }
+    return ret;
+}
+
+/* return cnt objects of class cls, linked through their first word */
+static void _heap_central_release(u32 cls, void* head) {
+    auto& central = gHeapCentral[cls];
+
+    HeapLockGuard guard(central.lock);
+    while (head != nullptr) {
+        auto obj  = head;
+        head      = *static_cast<void**>(obj);
+
+        auto span = _heap_span_of(obj);
+        if (span->used == span->capacity) {
+            _heap_partial_push(central, span);
+        }
+        *static_cast<void**>(obj) = span->free;
+        span->free = obj;
+        --span->used;
+
+        // keep the last partial span for the next fetch
+        if (span->used == 0 && (central.partial != span || span->next != nullptr)) {
+            _heap_partial_remove(central, span);
+            _heap_pages_del(span);
+        }
+    }
+}
+#pragma endregion
+
+#pragma region thread cache
+struct HeapCache
+{
+    struct Bin
+    {
+        void*   head;
+        u32     count;
+    };
+
+    Bin bins[gHeapClasses];
+
+    /* return every cached object to the central lists */
+    void flush() {
+        for (u32 cls = 0; cls < gHeapClasses; ++cls) {
+            auto& bin = bins[cls];
+            if (bin.head != nullptr) {
+                _heap_central_release(cls, bin.head);
+                bin.head  = nullptr;
+                bin.count = 0;
+            }
+        }
+    }
+};
+
+static HeapCache* const gHeapCacheDead = reinterpret_cast<HeapCache*>(1);
+
+static thread_local HeapCache* t_heap_cache = nullptr;
+
+struct HeapCacheOwner
+{
+    ~HeapCacheOwner() {
+        const auto cache = t_heap_cache;
+        t_heap_cache = gHeapCacheDead;  // later frees of this thread go to the central lists
+        if (cache != nullptr && cache != gHeapCacheDead) {
+            cache->flush();
+            ::free(cache);
+        }
+    }
+};
+
+/* the cache of the current thread, nullptr while the thread exits */
+static __forceinline HeapCache* _heap_cache() {
+    const auto cache = t_heap_cache;
+    if (cache != nullptr) {
+        return cache == gHeapCacheDead ? nullptr : cache;
+    }
+
+    static thread_local HeapCacheOwner owner;
+    (void)owner;
+    t_heap_cache = static_cast<HeapCache*>(::calloc(1, sizeof(HeapCache)));
+    return t_heap_cache;
+}
+#pragma endregion
+
+#pragma region api
+NMS_API bool _heap_owns(const void* ptr) noexcept {
+    // acquire: a block of the range is only seen after the heap is ready
+    const auto base = gHeap.base.load(MemOrder::Acquire);
+    const auto addr = reinterpret_cast<u64>(ptr);
+    return base != 0 && addr >= base && addr < base + gHeapReserve;
+}
+
+NMS_API u64 _heap_size(const void* ptr) noexcept {
+    const auto span = _heap_span_of(ptr);
+    return span->cls >= gHeapLarge ? u64(span->pages) * gHeapPageSize : _heap_class_size(span->cls);
+}
+
+NMS_API u64 _heap_usable(u64 size) noexcept {
+    return size > gHeapSmallMax ? (size + gHeapPageSize - 1) / gHeapPageSize * gHeapPageSize : _heap_class_size(_heap_class(size));
+}
+
+NMS_API bool _heap_resize(void* ptr, u64 size) {
+    const auto span = _heap_span_of(ptr);
+    if (span->cls != gHeapLarge) {
+        return size <= _heap_class_size(span->cls);
+    }
+    const auto pages = (size + gHeapPageSize - 1) / gHeapPageSize;
+    if (pages > gHeapPageCount) {
+        return false;
+    }
+    return _heap_pages_resize(span, u32(pages == 0 ? 1 : pages));
+}
+
+NMS_API void* _heap_new(u64 size) {
+    if (!_heap_init()) {
+        return nullptr;
+    }
+
+    // large: whole pages, none larger than the reserved range
+    if (size > gHeapSmallMax) {
+        if (size > gHeapReserve) {
+            return nullptr;
+        }
+        const auto span = _heap_pages_new(u32((size + gHeapPageSize - 1) / gHeapPageSize));
+        if (span == nullptr) {
+            return nullptr;
+        }
+        span->cls = gHeapLarge;
+        return reinterpret_cast<void*>(span->base);
+    }
+
+    const auto cls   = _heap_class(size);
+    const auto cache = _heap_cache();
+    if (cache == nullptr) {
+        void* head = nullptr;
+        _heap_central_fetch(cls, 1, head);
+        return head;
+    }
+
+    auto& bin = cache->bins[cls];
+    if (bin.head == nullptr) {
+        bin.count = _heap_central_fetch(cls, _heap_class_batch(cls), bin.head);
+        if (bin.head == nullptr) {
+            return nullptr;
+        }
+    }
+    auto obj = bin.head;
+    bin.head = *static_cast<void**>(obj);
+    --bin.count;
+    return obj;
+}
+
+NMS_API void* _heap_anew(u64 size, u64 align) {
+    if (align <= 16) {
+        return _heap_new(size);
+    }
+
+    // objects of a power of 2 class are aligned to the class size, pages to 64KB
+    auto need = size > align ? size : align;
+    if (need <= gHeapSmallMax) {
+        need = 1ull << (_heap_log2(need - 1) + 1);
+        return _heap_new(need);
+    }
+    if (align <= gHeapPageSize) {
+        return _heap_new(need);
+    }
+    return nullptr;
+}
+
+NMS_API u64 _heap_del(void* ptr) {
+    const auto span = _heap_span_of(ptr);
+    if (span->cls == gHeapLarge) {
+        const auto size = u64(span->pages) * gHeapPageSize;
+        _heap_pages_del(span);
+        return size;
+    }
+
+    const auto cls   = span->cls;
+    const auto cache = _heap_cache();
+    *static_cast<void**>(ptr) = nullptr;
+    if (cache == nullptr) {
+        _heap_central_release(cls, ptr);
+        return _heap_class_size(cls);
+    }
+
+    auto& bin = cache->bins[cls];
+    *static_cast<void**>(ptr) = bin.head;
+    bin.head = ptr;
+    ++bin.count;
+
+    // too many: give a batch back
+    const auto batch = _heap_class_batch(cls);
+    if (bin.count > 2 * batch) {
+        void* head = nullptr;
+        for (u32 i = 0; i < batch; ++i) {
+            auto obj = bin.head;
+            bin.head = *static_cast<void**>(obj);
+            *static_cast<void**>(obj) = head;
+            head = obj;
+        }
+        bin.count -= batch;
+        _heap_central_release(cls, head);
+    }
+    return _heap_class_size(cls);
+}
+
+NMS_API void* _heap_block_new(u64 size, void* owner) {
+    if (!_heap_init() || size == 0 || size > gHeapReserve) {
+        return nullptr;
+    }
+    const auto span = _heap_pages_new(u32((size + gHeapPageSize - 1) / gHeapPageSize));
+    if (span == nullptr) {
+        return nullptr;
+    }
+    span->owner = owner;
+    span->cls   = gHeapBlock;
+    return reinterpret_cast<void*>(span->base);
+}
+
+NMS_API void _heap_block_del(void* ptr) {
+    _heap_pages_del(_heap_span_of(ptr));
+}
+
+NMS_API void* _heap_block_owner(const void* ptr) noexcept {
+    if (!_heap_owns(ptr)) {
+        return nullptr;
+    }
+    const auto span = _heap_span_of(ptr);
+    return span != nullptr && span->cls == gHeapBlock ? span->owner : nullptr;
+}
+
+NMS_API u64 heap_idle_limit() noexcept {
+    return gHeap.idle_limit;
+}
+
+NMS_API void heap_idle_limit(u64 bytes) noexcept {
+    HeapLockGuard guard(gHeap.lock);
+    gHeap.idle_limit = bytes;
+}
+
+NMS_API void heap_trim() {
+    const auto cache = t_heap_cache;
+    if (cache != nullptr && cache != gHeapCacheDead) {
+        cache->flush();
+    }
+
+    auto& heap = gHeap;
+    HeapLockGuard guard(heap.lock);
+    for (auto& bin : heap.bins) {
+        for (auto span = bin; span != nullptr; span = span->next) {
+            if (span->committed) {
+                vunuse(reinterpret_cast<void*>(span->base), u64(span->pages) * gHeapPageSize);
+                span->committed = false;
+            }
+        }
+    }
+    heap.idle = 0;
+}
+#pragma endregion
+
+
+#pragma region unittest
+
+nms_test(heap_class) {
+    // every size fits its class, and the class before is too small
+    for (u64 size = 1; size <= gHeapSmallMax; ++size) {
+        const auto cls = _heap_class(size);
+        test::assert_true(cls < gHeapClasses);
+        test::assert_true(_heap_class_size(cls) >= size);
+        test::assert_true(cls == 0 || _heap_class_size(cls - 1) < size);
+    }
+    test::assert_eq(_heap_class_size(gHeapClasses - 1), gHeapSmallMax);
+}
+
+nms_test(heap) {
+    const auto prev = allocator();
+    allocator(Allocator::Nms);
+
+    // NMS_MEM_DEBUG=1: mnew always uses malloc
+    const auto probe = mnew<u8>(1);
+    const auto used  = _heap_owns(probe);
+    mdel(probe);
+    if (!used) {
+        allocator(prev);
+        return;
+    }
+
+    // small and large blocks
+    List<char*> blocks;
+    for (u32 i = 0; i < 2000; ++i) {
+        const auto size = u64(1) + (i * 7919u) % (i % 10 == 0 ? 200000u : 4000u);
+        auto ptr = mnew<char>(size);
+        test::assert_true(_heap_owns(ptr));
+        test::assert_true(msize(ptr) >= size);
+        ptr[0]        = char(i);
+        ptr[size - 1] = char(i);
+        blocks.append(ptr);
+    }
+    for (u32 i = 0; i < blocks.count(); ++i) {
+        test::assert_eq(blocks[i][0], char(i));
+        mdel(blocks[i]);
+    }
+
+    // larger than the reserved range: 2^32 pages would wrap the page count to 0
+    test::assert_true(_heap_new(gHeapReserve + 1) == nullptr);
+    test::assert_true(_heap_new(1ull << 48) == nullptr);
+
+    // realloc keeps the contents
+    auto buf = mnew<u32>(10);
+    for (u32 i = 0; i < 10; ++i) buf[i] = i;
+    buf = mrenew(buf, 100000);
+    for (u32 i = 0; i < 10; ++i) test::assert_eq(buf[i], i);
+    mdel(buf);
+
+    // realloc in place: in the size class, or by the pages after a large block
+    auto small = mnew<char>(100);
+    test::assert_true(mrenew(small, 112) == small);
+    test::assert_true(mrenew(small, 16) == small);
+    mdel(small);
+
+    auto big  = mnew<char>(256 * 1024);
+    auto next = mnew<char>(256 * 1024);
+    const auto adjacent = next == big + 256 * 1024;
+    big[0] = 'x';
+    mdel(next);
+    auto grown = mrenew(big, 512 * 1024);
+    if (adjacent) {
+        test::assert_true(grown == big);
+    }
+    test::assert_eq(grown[0], 'x');
+    auto shrunk = mrenew(grown, 64 * 1024);
+    test::assert_true(shrunk == grown);
+    test::assert_eq(msize(shrunk), u64(64 * 1024));
+    mdel(shrunk);
+
+    // aligned
+    for (u64 align = 32; align <= 65536; align *= 2) {
+        auto ptr = anew<char>(100, align);
+        test::assert_eq(reinterpret_cast<u64>(ptr) % align, u64(0));
+        adel(ptr);
+    }
+
+    // blocks of one heap are freed by it, whatever the current allocator
+    auto nms_ptr = mnew<u64>(4);
+    allocator(Allocator::System);
+    auto sys_ptr = mnew<u64>(4);
+    test::assert_true(_heap_owns(nms_ptr));
+    test::assert_false(_heap_owns(sys_ptr));
+    mdel(nms_ptr);
+    mdel(sys_ptr);
+
+    // free in another thread
+    allocator(Allocator::Nms);
+    List<u64*> ptrs;
+    for (u32 i = 0; i < 1000; ++i) {
+        ptrs.append(mnew<u64>(1 + i % 64));
+    }
+    thread::Thread worker([&] {
+        for (auto ptr : ptrs) {
+            mdel(ptr);
+        }
+    });
+    worker.join();
+
+    heap_trim();
+    allocator(prev);
+}
+
+/* each thread: rounds of alloc n blocks of 16..1024 bytes, then free them */
+static f64 _heap_churn(Allocator type, u32 threads, u32 rounds) {
+    static const u32 n = 256;
+
+    const auto prev = allocator();
+    allocator(type);
+
+    thread::Atomic<u32> start = 0u;
+    List<thread::Thread, 16> workers;
+    for (u32 t = 0; t < threads; ++t) {
+        workers.append(thread::Thread([&, t] {
+            void* ptrs[n];
+            u32   seed = t + 1;
+            while (start.load() == 0) thread::Thread::yield();
+            for (u32 r = 0; r < rounds; ++r) {
+                for (u32 i = 0; i < n; ++i) {
+                    seed = seed * 1103515245u + 12345u;
+                    ptrs[i] = mnew<char>(16 + (seed >> 8) % 1009);
+                }
+                for (u32 i = 0; i < n; ++i) {
+                    mdel(ptrs[i]);
+                }
+            }
+        }));
+    }
+
+    const auto t0 = nms::clock();
+    start.store(1u);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const auto t1 = nms::clock();
+
+    allocator(prev);
+    return f64(threads) * rounds * n / (t1 - t0);
+}
+
+/* one thread allocates, another frees */
+static f64 _heap_handoff(Allocator type, u32 count) {
+    const auto prev = allocator();
+    allocator(type);
+
+    thread::SpscRing<void*> ring(1024);
+    const auto t0 = nms::clock();
+    thread::Thread consumer([&] {
+        for (u32 i = 0; i < count; ++i) {
+            mdel(ring.pop());
+        }
+    });
+    for (u32 i = 0; i < count; ++i) {
+        ring.push(static_cast<void*>(mnew<char>(16 + i % 1000)));
+    }
+    consumer.join();
+    const auto t1 = nms::clock();
+
+    allocator(prev);
+    return count / (t1 - t0);
+}
+
+nms_test(heap_perf) {
+    static const u32 rounds = 400;
+
+    for (u32 threads = 1; threads <= 8; threads *= 2) {
+        const auto sys = _heap_churn(Allocator::System, threads, rounds / threads);
+        const auto nms = _heap_churn(Allocator::Nms,    threads, rounds / threads);
+        io::log::info("nms.heap: churn threads={}: system={.2}M/s, nms={.2}M/s", threads, sys / 1e6, nms / 1e6);
+    }
+
+    const auto sys = _heap_handoff(Allocator::System, 100000);
+    const auto nms = _heap_handoff(Allocator::Nms,    100000);
+    io::log::info("nms.heap: cross-thread free: system={.2}M/s, nms={.2}M/s", sys / 1e6, nms / 1e6);
+    heap_trim();
+}
+
+#pragma endregion
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <nms/core/type.h>
+
+namespace nms
+{
+
+/*!
+ * nms heap: the thread-caching allocator behind mnew/mdel/anew, @see allocator()
+ *
+ * small blocks (<= 32KB) are rounded up to one of 40 size classes.
+ * each thread keeps a cache per class, refilled and drained in batches
+ * from a central free list, so most calls take no lock.
+ * large blocks are 64KB pages of a reserved address range: free pages stay
+ * committed up to heap_idle_limit() bytes, the rest is returned to the OS.
+ */
+
+/* allocate from the nms heap, nullptr if the heap is not available */
+NMS_API void* _heap_new(u64 size);
+
+/* aligned allocation from the nms heap, nullptr if the heap is not available */
+NMS_API void* _heap_anew(u64 size, u64 align);
+
+/* free a block of the nms heap, return its usable size */
+NMS_API u64   _heap_del(void* ptr);
+
+/* test if ptr is allocated by the nms heap */
+NMS_API bool  _heap_owns(const void* ptr) noexcept;
+
+/*!
+ * resize a block of the nms heap in place: a small block keeps its size class,
+ * a large block takes or releases pages after it. false if it has to move.
+ */
+NMS_API bool  _heap_resize(void* ptr, u64 size);
+
+/* usable size of a block of the nms heap */
+NMS_API u64   _heap_size(const void* ptr) noexcept;
+
+/* usable size of the block _heap_new(size) returns: the size class or whole pages, no lookup */
+NMS_API u64   _heap_usable(u64 size) noexcept;
+
+/*!
+ * allocate a block of whole pages tagged with its owner (an arena), nullptr if the heap is not available.
+ * the heap is used whatever allocator() is: the owner of any address in the block is found by a lookup.
+ */
+NMS_API void* _heap_block_new(u64 size, void* owner);
+
+/* free a tagged block */
+NMS_API void  _heap_block_del(void* ptr);
+
+/* the owner of the tagged block that contains ptr, nullptr for any other address */
+NMS_API void* _heap_block_owner(const void* ptr) noexcept;
+
+/* bytes of free pages kept committed (default: 64MB) */
+NMS_API u64   heap_idle_limit() noexcept;
+
+/* set the bytes of free pages kept committed */
+NMS_API void  heap_idle_limit(u64 bytes) noexcept;
+
+/* return the cache of the current thread and every free page to the OS */
+NMS_API void  heap_trim();
+
+}
@@ -1,4 +1,32 @@
 #include <nms/test.h>
+#include <nms/core/list.h>
+#include <nms/core/time.h>
+#include <nms/io/log.h>
+#include <nms/thread/atomic.h>
+
+namespace nms
+{
+
+/* the bits of the f32 factor: read by every growing List, set by any thread */
+static thread::Atomic<u32> gListGrowth = 0x3FC00000u;   // 1.5f
+
+NMS_API f32 list_growth() {
+    const auto bits = gListGrowth.load(thread::MemOrder::Relaxed);
+    f32 factor;
+    ::memcpy(&factor, &bits, sizeof(factor));
+    return factor;
+}
+
+NMS_API void list_growth(f32 factor) {
+    factor = factor < 1.125f ? 1.125f : factor > 4.0f ? 4.0f : factor;
+    u32 bits;
+    ::memcpy(&bits, &factor, sizeof(bits));
+    gListGrowth.store(bits, thread::MemOrder::Relaxed);
+}
+
+}
+
+#include <vector>
 
 namespace nms::core
 {
@@ -13,6 +41,95 @@ nms_test(list) {
     io::log::info("list = {}", list);
 }
 
+nms_test(list_growth) {
+    List<u32> list;
+
+    u32 reallocs = 0;
+    for (u32 i = 0; i < 100000; ++i) {
+        const auto oldcap = list.capacity();
+        list.append(i);
+        if (list.capacity() != oldcap) {
+            ++reallocs;
+        }
+    }
+    // 1.5x: log(100000/32)/log(1.5) ~ 20
+    test::assert_eq(list_growth(), 1.5f);
+    test::assert_true(reallocs < 32);
+
+    // clamped to [1.125, 4]
+    list_growth(8.0f);
+    test::assert_eq(list_growth(), 4.0f);
+    list_growth(1.0f);
+    test::assert_eq(list_growth(), 1.125f);
+    list_growth(1.5f);
+    for (u32 i = 0; i < 100000; ++i) {
+        test::assert_eq(list[i], i);
+    }
+
+    list.shrink_to_fit();
+    test::assert_eq(list.capacity(), list.count());
+    test::assert_eq(list[99999], 99999u);
+
+    list.clear();
+    list.shrink_to_fit();
+    test::assert_eq(list.capacity(), 0u);
+
+    // the inline buffer flag is not part of the capacity
+    List<u32, 4> small;
+    test::assert_eq(small.capacity(), 4u);
+    small.appends(5, 1u);
+    test::assert_eq(small.capacity(), 32u);
+}
+
+nms_test(list_relocate) {
+    // List<String> is relocated with realloc: the strings keep their heap buffers
+    static_assert($is<$relocatable, String<> >, "nms.List: String should be relocatable");
+    static_assert(!$is<$relocatable, List<u32, 4> >, "nms.List: inline buffer is not relocatable");
+
+    List<String<> > strs;
+    for (u32 i = 0; i < 1000; ++i) {
+        String<> s;
+        sformat(s, "str{}", i);
+        strs.append(static_cast<String<>&&>(s));
+    }
+    for (u32 i = 0; i < 1000; ++i) {
+        String<> s;
+        sformat(s, "str{}", i);
+        test::assert_eq(strs[i], s);
+    }
+
+    // inline buffer -> heap, and move
+    List<String<>, 4> small;
+    for (u32 i = 0; i < 10; ++i) {
+        small.append(strs[i]);
+    }
+    List<String<>, 4> moved(static_cast<List<String<>, 4>&&>(small));
+    test::assert_eq(moved.count(), 10u);
+    test::assert_eq(moved[9], strs[9]);
+}
+
+nms_test(list_perf) {
+    static const u32 n = 4 * 1000 * 1000;   // 16MB
+
+    const auto t0 = nms::clock();
+    {
+        List<u32> list;
+        for (u32 i = 0; i < n; ++i) {
+            list.append(i);
+        }
+    }
+    const auto t1 = nms::clock();
+    {
+        std::vector<u32> vec;
+        for (u32 i = 0; i < n; ++i) {
+            vec.push_back(i);
+        }
+    }
+    const auto t2 = nms::clock();
+
+    io::log::info("nms.List: append x {}: List={.3}ms, std::vector={.3}ms", n, (t1 - t0)*1e3, (t2 - t1)*1e3);
+}
+
 #pragma endregion
 
-}
\ No newline at end of file
+}
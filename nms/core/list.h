@@ -16,6 +16,16 @@ class Path;
 template<class T, u32 Icapicity = 0>
 class List;
 
+/* geometric growth factor of List::reserve, default: 1.5 */
+NMS_API f32  list_growth();
+
+/* set the growth factor of List::reserve, clamped to [1.125, 4] */
+NMS_API void list_growth(f32 factor);
+
+/* List<T> only holds a pointer to the heap, it can be moved with memcpy */
+template<class T>
+struct Is<$relocatable, List<T, 0> > { static constexpr auto $value = true; };
+
 template<class T>
 class List<T, 0>: public View<T>
 {
@@ -26,6 +36,9 @@ public:
     using Tsize = typename base::Tsize;
     using Tinfo = typename base::Tinfo;
 
+    /* the largest capacity, bit 31 of capacity_ is kept for the inline buffer flag */
+    static constexpr Tsize $max_capacity = Tsize(-1) >> 1;
+
 #pragma region constructor
     constexpr List() noexcept
     {}
@@ -73,14 +86,15 @@ public:
         if (rhs.use_buff()) {
             const auto newcnt = rhs.count();
             reserve(newcnt);
+            _relocate(data_, rhs.data_, newcnt);
             size_ = newcnt;
-            mmov(data(), rhs.data(), newcnt);
         }
         else {
             base::operator=(rhs);
         }
         rhs.data_ = nullptr;
         rhs.size_ = 0;
+        rhs.capacity_ = 0;
     }
 
     List(const List& rhs) noexcept
@@ -90,19 +104,27 @@ public:
     }
 
     List& operator=(List&& rhs) noexcept {
-        if (rhs.use_buff()) {
-            clear();
+        if (this == &rhs) {
+            return *this;
+        }
+        clear();
 
+        if (rhs.use_buff()) {
             auto newcnt = rhs.count();
             reserve(newcnt);
-            mmov(data(), rhs.data(), newcnt);
+            _relocate(data_, rhs.data_, newcnt);
             size_ = newcnt;
         }
         else {
+            // take the heap storage of rhs, the inline buffer (if any) is dropped
+            if (data_ != nullptr && !use_buff()) {
+                mdel(data_);
+            }
             base::operator=(rhs);
         }
         rhs.data_ = nullptr;
         rhs.size_ = 0;
+        rhs.capacity_ = 0;
         return *this;
     }
 
@@ -136,41 +158,42 @@ public:
 
     /* the number of elements that can be held in currently allocated storage */
     Tsize capacity() const noexcept {
-        return capacity_;
+        return capacity_ & $max_capacity;
     }
 #pragma endregion
 
 #pragma region method
+    /*!
+     * make room for at least newcnt elements.
+     * the capacity grows geometrically (@see list_growth), so repeated
+     * reserve(count() + n) calls are amortized O(1) per element.
+     */
     List& reserve(Tsize newcnt) {
-        const auto oldcnt = base::size_;
-        const auto oldcap = capacity_;
+        const auto oldcap = capacity();
         if (newcnt > oldcap) {
-            // caculate new capicity
-            if (newcnt < oldcnt + oldcnt / 8) {
-                newcnt = oldcnt + oldcnt / 8;
-            }
-            const auto newcap = (newcnt +31) / 32 * 32;
-            const auto olddat = data_;
-
-            // realloc
-            const auto newdat = mnew<Tdata>(newcap);
-
-
-            // move olddat -> newdat
-            for(Tsize i = 0; i < oldcnt; ++i) {
-                void* addr = &newdat[i];
-                new (addr)Tdata(static_cast<Tdata&&>(olddat[i]));
-            }
-
-            // try: free old data
-            if (olddat!=nullptr && !use_buff()) {
-                mdel(olddat);
+            if (newcnt > $max_capacity) {
+                NMS_THROW(EBadAlloc{});
             }
+            // caculate new capicity, in u64: the growth of a large list may overflow Tsize
+            const auto growcnt = u64(f64(oldcap) * list_growth());
+            const auto wantcnt = ((growcnt > newcnt ? growcnt : newcnt) + 31) / 32 * 32;
+            _realloc(Tsize(wantcnt < $max_capacity ? wantcnt : $max_capacity));
+        }
+        return *this;
+    }
 
-            // update
-            data_       = newdat;
-            capacity_   = newcap;
+    /*! release the unused capacity */
+    List& shrink_to_fit() {
+        if (data_ == nullptr || use_buff() || size_ == capacity()) {
+            return *this;
         }
+        if (size_ == 0) {
+            mdel(data_);
+            data_     = nullptr;
+            capacity_ = 0;
+            return *this;
+        }
+        _realloc(size_);
         return *this;
     }
 
@@ -228,6 +251,12 @@ public:
     /*! append(copy) elements to the end */
     template<class U>
     List& _appends(const U dat[], Tsize cnt) {
+        if ($is<$pod, Tdata> && $is<Tdata, U>) {
+            _mcpy(data_ + size_, dat, cnt * sizeof(Tdata));
+            size_ += cnt;
+            return *this;
+        }
+
         for (Tsize i = 0; i < cnt; ++i) {
             new(&data_[base::size_++])Tdata(dat[i]);
         }
@@ -294,10 +323,46 @@ protected:
     using   base::capacity_;
 
 
+    /* capacity_ bit 31: data_ is the inline buffer of a List<T, N>, not owned */
+    static constexpr Tsize $buff_flag = ~$max_capacity;
+
+    /*
+     * an explicit flag, not the address of data_: a List<T> is relocated with memcpy,
+     * and its heap block may follow it (an arena), neither changes the owner.
+     */
     bool use_buff() const {
-        const auto pthis = reinterpret_cast<uintptr_t>(&capacity_);
-        const auto pdata = reinterpret_cast<uintptr_t>(data_);
-        return (pdata - pthis) < 16*1024*1024;  // 16MB
+        return (capacity_ & $buff_flag) != 0;
+    }
+
+    /* move cnt elements: src -> dst, the sources are destroyed */
+    static void _relocate(Tdata* dst, Tdata* src, Tsize cnt) {
+        if ($is<$relocatable, Tdata>) {
+            _mcpy(dst, src, cnt * sizeof(Tdata));
+            return;
+        }
+        for (Tsize i = 0; i < cnt; ++i) {
+            new(&dst[i])Tdata(static_cast<Tdata&&>(src[i]));
+            src[i].~Tdata();
+        }
+    }
+
+    /* change the storage to newcap elements, newcap >= size_ */
+    void _realloc(Tsize newcap) {
+        const auto olddat = data_;
+
+        if ($is<$relocatable, Tdata> && olddat != nullptr && !use_buff()) {
+            // realloc may grow in place (or mremap), no copy at all
+            data_ = mrenew(olddat, newcap);
+        }
+        else {
+            const auto newdat = mnew<Tdata>(newcap);
+            _relocate(newdat, olddat, size_);
+            if (olddat != nullptr && !use_buff()) {
+                mdel(olddat);
+            }
+            data_ = newdat;
+        }
+        capacity_ = newcap;
     }
 
     template<class File>
@@ -341,7 +406,7 @@ public:
 #pragma region constructor
     List() noexcept {
         base::data_     = reinterpret_cast<T*>(buff_);
-        base::capacity_ = $capicity;
+        base::capacity_ = $capicity | base::$buff_flag;
     }
 
     template<class ...U>
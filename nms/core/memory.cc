@@ -1,92 +1,163 @@
 #include <nms/test.h>
+#include <nms/core/arena.h>
+#include <nms/core/heap.h>
+#include <nms/core/memstat.h>
+#include <nms/thread/atomic.h>
 
 using namespace nms;
 
-extern "C" {
 #ifdef NMS_OS_WINDOWS
-    enum {
-        PROT_READ      = 0x04,
-        PROT_WRITE     = 0x04,
-    };
-
-    enum {
-        SEC_COMMIT    = 0x8000000,
-        SEC_RESERVE   = 0x4000000
-    };
-
-    enum {
-        MAP_SHARED = 0x1
-    };
-
+extern "C"
+{
     /*!
      * Microsoft Memory Management Functions
      * https://msdn.microsoft.com/en-us/library/aa366781(v=vs.85).aspx
      */
-    int   CloseHandle(void* handle);
-    void* CreateFileMappingA(void* hFile, void* attributes, i32 flProtect, u32 dwMaximumSizeHigh, u32 dwMaximumSizeLow, const char* lpName);
-    void* MapViewOfFile(void* hFileMappingObject, u32 dwDesiredAccess, u32 dwFileOffsetHigh, u32 dwFileOffsetLow, u64 dwNumberOfBytesToMap);
-    int   UnmapViewOfFile(void* lpBaseAddress);
     void* VirtualAlloc(void* addr, size_t size, i32 type, i32 prot);
     void* VirtualFree(void* addr, size_t size, i32 type);
+    struct _SYSTEM_INFO
+    {
+        u32     oem_id;
+        u32     page_size;
+        void*   min_address;
+        void*   max_address;
+        u64     active_processor_mask;
+        u32     number_of_processors;
+        u32     processor_type;
+        u32     allocation_granularity;
+        u16     processor_level;
+        u16     processor_revision;
+    };
+    void  GetSystemInfo(_SYSTEM_INFO* info);
+}
+#endif
 
-    static void* mmap(void* base, u64 size, int prot, int flags, int fid, u64 offset) {
-        (void)base;
-        (void)flags;
+namespace nms
+{
 
-        // map
-        const u32 size_high = (size >> 32);
-        const u32 size_low = (size << 32) >> 32;
+/* read once: a plain load per call, no guard of a function-local static */
+enum MemMode : u32
+{
+    MemModeInit     = 0x1,
+    MemModeDebug    = 0x2,
+    MemModeHeap     = 0x4,
+    MemModeStats    = 0x8,
+};
+
+static thread::Atomic<u32> gMemMode = 0u;
+
+static __forceinline u32 _mem_mode() {
+    const auto mode = gMemMode.load(thread::MemOrder::Relaxed);
+    if (mode != 0) {
+        return mode;
+    }
 
-        auto hfile = reinterpret_cast<void*>(_get_osfhandle(fid));
-        auto hmmap = CreateFileMappingA(hfile, nullptr, prot, size_high, size_low, nullptr);
+    // several threads may get here: they compute the same value
+    const auto str_debug = ::getenv("NMS_MEM_DEBUG");
+    const auto str_alloc = ::getenv("NMS_ALLOC");
+    const auto str_stats = ::getenv("NMS_MEM_STATS");
+    u32 init = MemModeInit;
+    if (str_debug != nullptr && str_debug[0] == '1') {
+        init |= MemModeDebug;
+    }
+    if (str_alloc != nullptr && ::strcmp(str_alloc, "nms") == 0) {
+        init |= MemModeHeap;
+    }
+    if (str_stats != nullptr && ::atoi(str_stats) > 0) {
+        init |= MemModeStats;
+        _memstat_sample_every(u32(::atoi(str_stats) > 1 ? ::atoi(str_stats) : 0));
+    }
+    u32 expect = 0;
+    gMemMode.cas(expect, init, thread::MemOrder::Relaxed);
+    return gMemMode.load(thread::MemOrder::Relaxed);
+}
 
-        // view
-        const u32 offset_high = (offset >> 32);
-        const u32 offset_low = (offset << 32) >> 32;
-        const u32 file_map_write = 0x0002;
-        auto ptr = MapViewOfFile(hmmap, file_map_write, offset_high, offset_low, size);
-        if (ptr == nullptr) {
-            return nullptr;
-        }
+static __forceinline bool _mem_debug() {
+    return (_mem_mode() & MemModeDebug) != 0;
+}
 
-        return ptr;
-    }
+NMS_API Allocator allocator() noexcept {
+    return (_mem_mode() & MemModeHeap) != 0 ? Allocator::Nms : Allocator::System;
+}
 
-    static int munmap(void* ptr, size_t size) {
-        (void)size;
-        auto ret = ::UnmapViewOfFile(ptr);
-        return ret == 0 ? 1 : 0;
+static void _mem_mode(u32 flag, bool on) noexcept {
+    auto mode = _mem_mode();
+    while (true) {
+        const auto next = on ? (mode | flag) : (mode & ~flag);
+        if (gMemMode.cas(mode, next, thread::MemOrder::Relaxed)) {
+            break;
+        }
     }
+}
 
-    static void muse(void *ptr, size_t size) {
-        const auto mem_commit       = 0x00001000;
-        const auto mem_large_pages  = 0x20000000;   // 2MB
-        ::VirtualAlloc(ptr, size, mem_commit | mem_large_pages, PROT_WRITE);
-    }
+NMS_API void allocator(Allocator type) noexcept {
+    _mem_mode(MemModeHeap, type == Allocator::Nms);
+}
 
-    static void munuse(void* ptr, size_t size) {
-        const auto mem_decommit = 0x4000;
-    #pragma warning(push)
-    #pragma warning(disable: 6250)
-        ::VirtualFree(ptr, size, mem_decommit);
-    #pragma warning(pop)
-    }
+NMS_API bool memstat_enabled() noexcept {
+    return (_mem_mode() & MemModeStats) != 0;
+}
 
+NMS_API void memstat_enable(bool on, u32 sample_every) noexcept {
+    _memstat_sample_every(on ? sample_every : 0);
+    _mem_mode(MemModeStats, on);
+}
 
+/* usable size of a block of malloc */
+static __forceinline u64 _msize_sys(const void* ptr) {
+#if     defined(NMS_OS_WINDOWS)
+    return ::_msize(const_cast<void*>(ptr));
+#elif   defined(NMS_OS_APPLE)
+    return ::malloc_size(ptr);
 #else
-    enum {
-        SEC_RESERVE = 0x0
-    };
+    return ::malloc_usable_size(const_cast<void*>(ptr));
 #endif
 }
 
-namespace nms
-{
+/* usable size of a debug block: the size in its header */
+static __forceinline u64 _msize_debug(const void* ptr) {
+    return *reinterpret_cast<const u64*>(static_cast<const char*>(ptr) - 16);
+}
 
-static __forceinline bool _mem_debug() {
-    static const auto str = ::getenv("NMS_MEM_DEBUG");
-    static const auto cond = str != nullptr && str[0] == '1';
-    return cond;
+/* a block of the debug path, the nms heap or malloc: never of the arena */
+static void* _mnew_sys(u64 size) {
+    const auto mode = _mem_mode();
+    if (mode & MemModeDebug) {
+        // [size][8 x '['] data [8 x ']']: the size locates the tail guard (malloc may round it up)
+        auto addr = static_cast<char*>(::malloc(size + 24));
+        if (addr == nullptr) {
+            NMS_THROW(EBadAlloc{});
+        }
+
+        *reinterpret_cast<u64*>(addr) = size;
+        for (auto i = 0u; i < 8; ++i) {
+            addr[8 + i]         = '[';
+            addr[16 + size + i] = ']';
+        }
+        if (mode & MemModeStats) {
+            _memstat_new(size);
+        }
+        return addr + 16;
+    }
+
+    // nullptr: the nms heap is not available, use malloc
+    if (mode & MemModeHeap) {
+        if (auto ptr = _heap_new(size)) {
+            if (mode & MemModeStats) {
+                _memstat_new(_heap_usable(size));
+            }
+            return ptr;
+        }
+    }
+
+    auto ptr = ::malloc(size);
+    if (ptr == nullptr) {
+        NMS_THROW(EBadAlloc{});
+    }
+    if (mode & MemModeStats) {
+        _memstat_new(_msize_sys(ptr));
+    }
+    return ptr;
 }
 
 NMS_API void* _mnew(u64 size) {
@@ -98,29 +169,64 @@ NMS_API void* _mnew(u64 size) {
         return nullptr;
     }
 
-    if (_mem_debug()) {
-        auto msize = size + 16;
-        auto addr = static_cast<char*>(::malloc(msize));
-        if (addr == nullptr) {
-            NMS_THROW(EBadAlloc{});
-        }
+    if (auto arena = arena_current()) {
+        return arena->alloc(size);
+    }
+    return _mnew_sys(size);
+}
 
-        for (auto i = 0u; i < 8; ++i) {
-            addr[i]             = '[';
-            addr[msize - 1 - i] = ']';
-        }
-        auto ptr = addr + 8;
+NMS_API void* _mrenew(void* ptr, u64 size) {
+    if (ptr == nullptr) {
+        return _mnew(size);
+    }
+    if (size == 0) {
+        _mdel(ptr);
+        return nullptr;
+    }
 
-        printf("[++]  mem: %p %lld\n", ptr, ullong(size));
-        return ptr;
+    // an arena block is resized by its own arena.
+    // the other blocks are allocated before the scope: they are moved out of the arena (@see _mnew_sys)
+    if (auto arena = Arena::owner(ptr)) {
+        return arena->realloc(ptr, size);
     }
-    else {
-        auto ptr = static_cast<void*>(::malloc(size));
-        if (ptr == nullptr) {
-            NMS_THROW(EBadAlloc{});
+
+    // the nms heap: in place if the size class (or the pages after the block) allow it, else move
+    const auto stats = (_mem_mode() & MemModeStats) != 0;
+    if (_heap_owns(ptr)) {
+        const auto old_size = _heap_size(ptr);
+        if (_heap_resize(ptr, size)) {
+            // msize changes: the block is freed and allocated again for the counters
+            if (stats) {
+                _memstat_del(old_size);
+                _memstat_new(_heap_size(ptr));
+            }
+            return ptr;
         }
-        return ptr;
+        auto new_ptr = _mnew_sys(size);
+        ::memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+        _mdel(ptr);
+        return new_ptr;
+    }
+
+    if (_mem_debug()) {
+        const auto old_size = _msize_debug(ptr);
+        auto new_ptr = _mnew_sys(size);
+        ::memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+        _mdel(ptr);
+        return new_ptr;
     }
+
+    // large blocks are mmap-ed by glibc, realloc remaps them (mremap) without copying
+    const auto old_size = stats ? _msize_sys(ptr) : 0;
+    auto new_ptr = ::realloc(ptr, size);
+    if (new_ptr == nullptr) {
+        NMS_THROW(EBadAlloc{});
+    }
+    if (stats) {
+        _memstat_del(old_size);
+        _memstat_new(_msize_sys(new_ptr));
+    }
+    return new_ptr;
 }
 
 NMS_API void  _mdel(void* ptr) {
@@ -128,28 +234,53 @@ NMS_API void  _mdel(void* ptr) {
      * @see: http://en.cppreference.com/w/c/memory/free
      * if ptr == nullptr, ::free do nothing.
      */
-    if (_mem_debug()) {
-        auto size = msize(ptr);
-        auto addr = static_cast<char*>(ptr) - 8;
+    if (ptr == nullptr) {
+        return;
+    }
+
+    // any arena: the current one, an outer scope, or a scope already ended
+    if (auto arena = Arena::owner(ptr)) {
+        arena->free(ptr);
+        return;
+    }
+
+    const auto mode = _mem_mode();
+    if (_heap_owns(ptr)) {
+        const auto size = _heap_del(ptr);
+        if (mode & MemModeStats) {
+            _memstat_del(size);
+        }
+        return;
+    }
+
+    if (mode & MemModeDebug) {
+        auto addr = static_cast<char*>(ptr) - 16;
+        auto size = *reinterpret_cast<u64*>(addr);
+        if (mode & MemModeStats) {
+            _memstat_del(size);
+        }
 
         auto s_head = true;
         auto s_tail = true;
         for (auto i = 0u; i < 8u; ++i) {
-            s_head = s_head && (addr[0       + i] == '[');
-            s_tail = s_tail && (addr[size -1 - i] == ']');
+            s_head = s_head && (addr[8         + i] == '[');
+            s_tail = s_tail && (addr[16 + size + i] == ']');
         }
         if (!s_head || !s_tail) {
             printf("[!!]  mem: %p\n", ptr);
         }
         else {
             for (auto i = 0u; i < 8; ++i) {
-                addr[i]             = '(';
-                addr[size -1 - i]   = ')';
+                addr[8 + i]         = '(';
+                addr[16 + size + i] = ')';
             }
             ::free(addr);
         }
     }
     else {
+        if (mode & MemModeStats) {
+            _memstat_del(_msize_sys(ptr));
+        }
         ::free(ptr);
     }
 }
@@ -172,29 +303,60 @@ NMS_API void  _mmov(void* dst, const void* src, u64 size) {
 }
 
 NMS_API u64 msize(const void* ptr) {
-    const auto addr = _mem_debug() ? static_cast<const char*>(ptr) - 8 : ptr;
+    if (Arena::owner(ptr) != nullptr) {
+        return Arena::size_of(ptr);
+    }
+    if (_heap_owns(ptr)) {
+        return _heap_size(ptr);
+    }
 
-#if     defined(NMS_OS_WINDOWS)
-    const auto mem_size = ::_msize(const_cast<void*>(addr));
-#elif   defined(NMS_OS_APPLE)
-    const auto mem_size = ::malloc_size(addr);
-#elif   defined(NMS_OS_UNIX)
-    const auto mem_size = ::malloc_usable_size(const_cast<void*>(addr));
-#endif
-    return mem_size;
+    if (ptr == nullptr) {
+        return 0;
+    }
+    if (_mem_debug()) {
+        return _msize_debug(ptr);
+    }
+    return _msize_sys(ptr);
 }
 
 NMS_API void* _anew (u64 size, u64 align) {
+    const auto mode = _mem_mode();
+    void* ptr = nullptr;
+    if (mode & MemModeHeap) {
+        ptr = _heap_anew(size, align);
+    }
+
+    if (ptr == nullptr) {
 #ifdef NMS_OS_WINDOWS
-    auto ptr = ::_aligned_malloc(size, align);
+        ptr = ::_aligned_malloc(size, align);
 #else
-    void* ptr = nullptr;
-    ::posix_memalign(&ptr, align, size);
+        ::posix_memalign(&ptr, align, size);
 #endif
+    }
+
+    if (ptr != nullptr && (mode & MemModeStats)) {
+        _memstat_new(_heap_owns(ptr) ? _heap_size(ptr) : _msize_sys(ptr));
+    }
     return ptr;
 }
 
 NMS_API void  _adel (void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    const auto stats = (_mem_mode() & MemModeStats) != 0;
+    if (_heap_owns(ptr)) {
+        const auto size = _heap_del(ptr);
+        if (stats) {
+            _memstat_del(size);
+        }
+        return;
+    }
+    if (stats) {
+        _memstat_del(_msize_sys(ptr));
+    }
+
 #ifdef NMS_OS_WINDOWS
     ::_aligned_free(ptr);
 #else
@@ -202,30 +364,77 @@ NMS_API void  _adel (void* ptr) {
 #endif
 }
 
-NMS_API void* vnew(int fid, u64 size) {
-    ::mmap(nullptr, size, PROT_READ | PROT_WRITE | SEC_RESERVE, MAP_SHARED, fid, 0);
-    return nullptr;
+#pragma region virtual memory
+NMS_API u64 vpage() noexcept {
+#ifdef NMS_OS_WINDOWS
+    static const auto size = [] {
+        _SYSTEM_INFO info;
+        ::GetSystemInfo(&info);
+        return u64(info.allocation_granularity);
+    }();
+#else
+    static const auto size = u64(::sysconf(_SC_PAGESIZE));
+#endif
+    return size;
+}
+
+NMS_API void* vnew(u64 size) {
+#ifdef NMS_OS_WINDOWS
+    const auto mem_reserve   = 0x2000;
+    const auto page_noaccess = 0x01;
+    return ::VirtualAlloc(nullptr, size, mem_reserve, page_noaccess);
+#else
+    auto flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif
+    const auto ptr = ::mmap(nullptr, size, PROT_NONE, flags, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+#endif
 }
 
 NMS_API void vdel(void* ptr, u64 size) {
+    if (ptr == nullptr) {
+        return;
+    }
+#ifdef NMS_OS_WINDOWS
+    (void)size;
+    const auto mem_release = 0x8000;
+    ::VirtualFree(ptr, 0, mem_release);
+#else
     ::munmap(ptr, size);
+#endif
 }
 
-NMS_API void vuse(void* base, u64 size) {
-    (void)base;
-    (void)size;
+NMS_API bool vuse(void* ptr, u64 size) {
 #ifdef NMS_OS_WINDOWS
-    ::muse(base, size);
+    const auto mem_commit     = 0x1000;
+    const auto page_readwrite = 0x04;
+    return ::VirtualAlloc(ptr, size, mem_commit, page_readwrite) != nullptr;
+#else
+    return ::mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0;
 #endif
 }
 
-NMS_API void vunuse(void* base, u64 size) {
-    (void)base;
-    (void)size;
+NMS_API void vunuse(void* ptr, u64 size) {
 #ifdef NMS_OS_WINDOWS
-    ::munuse(base, size);
+    const auto mem_decommit = 0x4000;
+#pragma warning(push)
+#pragma warning(disable: 6250)
+    ::VirtualFree(ptr, size, mem_decommit);
+#pragma warning(pop)
+#else
+    ::madvise(ptr, size, MADV_DONTNEED);
 #endif
 }
 
+NMS_API void vhuge(void* ptr, u64 size) {
+    (void)ptr;
+    (void)size;
+#if defined(NMS_OS_LINUX) && defined(MADV_HUGEPAGE)
+    ::madvise(ptr, size, MADV_HUGEPAGE);
+#endif
 }
+#pragma endregion
 
+}
@@ -8,6 +8,7 @@ namespace nms
 {
 
 NMS_API void* _mnew(u64 size);
+NMS_API void* _mrenew(void* dat, u64 size);
 NMS_API void  _mdel(void* dat);
 NMS_API void  _mzero(void* dat, u64 size);
 NMS_API void  _mcpy(void* dst, const void* src, u64 size);
@@ -19,6 +20,49 @@ NMS_API void  _adel(void* dat);
 
 NMS_API u64   msize(const void* ptr);
 
+/*! the heap behind mnew/mdel/anew */
+enum class Allocator
+{
+    System,     // malloc/free
+    Nms,        // the thread-caching nms heap, @see heap.h
+};
+
+/*!
+ * current allocator, default: $NMS_ALLOC ("nms" or "system"), System if unset.
+ * the nms heap is opt-in: a few percent slower than glibc malloc on one thread, faster on frees from another thread.
+ * NMS_MEM_DEBUG=1 always uses malloc.
+ */
+NMS_API Allocator allocator() noexcept;
+
+/*!
+ * switch the allocator.
+ * a block is always freed by the heap it comes from, so the switch is safe at any time.
+ */
+NMS_API void allocator(Allocator type) noexcept;
+
+#pragma region virtual memory
+/* page size of vnew/vuse (allocation granularity on windows) */
+NMS_API u64   vpage() noexcept;
+
+/*! reserve size bytes of address space (no access), nullptr if failed */
+NMS_API void* vnew(u64 size);
+
+/* release a reservation of vnew */
+NMS_API void  vdel(void* ptr, u64 size);
+
+/*! commit pages of a reservation (read/write), @return false if failed */
+NMS_API bool  vuse(void* ptr, u64 size);
+
+/*!
+ * return committed pages to the OS, the contents are lost.
+ * posix: the pages stay accessible and read as 0, windows: they must be vuse-d again.
+ */
+NMS_API void  vunuse(void* ptr, u64 size);
+
+/* back a range by transparent huge pages, if the OS supports it (linux) */
+NMS_API void  vhuge(void* ptr, u64 size);
+#pragma endregion
+
 class EBadAlloc : public IException
 {};
 
@@ -30,6 +74,17 @@ T* mnew(u64 cnt) {
     return static_cast<T*>(addr);
 }
 
+/*!
+ * reallocation: the contents are kept (bit copied, if the block moves).
+ * only for relocatable types, @see $relocatable
+ */
+template<class T>
+T* mrenew(T* ptr, u64 cnt) {
+    const auto size = cnt * sizeof(T);
+    const auto addr = _mrenew(ptr, size);
+    return static_cast<T*>(addr);
+}
+
 /* deallocation */
 template<class T>
 void mdel(T* ptr) {
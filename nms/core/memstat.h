@@ -0,0 +1,58 @@
+#pragma once
+
+#include <nms/core/type.h>
+#include <nms/core/string.h>
+
+namespace nms
+{
+
+/*!
+ * allocation statistics of mnew/mdel/anew.
+ * bytes are usable sizes (msize), so an allocation and its free always match.
+ * an arena is counted by its blocks: the allocations it serves in an ArenaScope are not counted.
+ */
+struct MemStats
+{
+    static constexpr u32 $classes = 32;   // class i: sizes in (2^(i+3), 2^(i+4)], class 0: <= 16
+
+    u64 allocs      = 0;
+    u64 frees       = 0;
+    u64 alloc_bytes = 0;
+    u64 free_bytes  = 0;
+    i64 live        = 0;        // bytes in use
+    u64 peak        = 0;        // max of live (within 256KB per thread)
+    u32 threads     = 0;        // threads with counters
+    u64 classes[$classes] = {}; // allocations by size class
+
+    NMS_API void format(String<>& buf) const;
+};
+
+/*!
+ * turn the statistics on/off (default: $NMS_MEM_STATS).
+ * counters are per thread: an allocation costs a few plain adds to thread local fields.
+ * sample_every > 0: the call stack of 1 in sample_every allocations is recorded.
+ * NMS_MEM_STATS=1: counters only, NMS_MEM_STATS=N: counters and 1 in N samples.
+ */
+NMS_API void memstat_enable(bool on, u32 sample_every = 0) noexcept;
+
+/* test if the statistics are on */
+NMS_API bool memstat_enabled() noexcept;
+
+/* a snapshot of the counters of every thread */
+NMS_API MemStats memstat();
+
+/* clear the counters and the samples, live bytes are kept */
+NMS_API void memstat_reset();
+
+/*!
+ * write the counters and the top call sites (by sampled bytes) to buf.
+ * sampled numbers are scaled by sample_every.
+ */
+NMS_API void memstat_report(String<>& buf, u32 max_sites = 16);
+
+/* hooks of mnew/mdel: size is the usable size of the block, known by the allocator that serves it */
+NMS_API void _memstat_new(u64 size);
+NMS_API void _memstat_del(u64 size);
+NMS_API void _memstat_sample_every(u32 cnt) noexcept;
+
+}
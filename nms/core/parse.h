@@ -20,6 +20,17 @@ NMS_API int _parse(StrView str, StrView fmt, u64&  val);
 NMS_API int _parse(StrView str, StrView fmt, i64&  val);
 NMS_API int _parse(StrView str, StrView fmt, f32&  val);
 NMS_API int _parse(StrView str, StrView fmt, f64&  val);
+
+NMS_API u64 _parses(StrView str, StrView delims, u8*  dst, u64 cnt, i64 step, u64* pos);
+NMS_API u64 _parses(StrView str, StrView delims, i8*  dst, u64 cnt, i64 step, u64* pos);
+NMS_API u64 _parses(StrView str, StrView delims, u16* dst, u64 cnt, i64 step, u64* pos);
+NMS_API u64 _parses(StrView str, StrView delims, i16* dst, u64 cnt, i64 step, u64* pos);
+NMS_API u64 _parses(StrView str, StrView delims, u32* dst, u64 cnt, i64 step, u64* pos);
+NMS_API u64 _parses(StrView str, StrView delims, i32* dst, u64 cnt, i64 step, u64* pos);
+NMS_API u64 _parses(StrView str, StrView delims, u64* dst, u64 cnt, i64 step, u64* pos);
+NMS_API u64 _parses(StrView str, StrView delims, i64* dst, u64 cnt, i64 step, u64* pos);
+NMS_API u64 _parses(StrView str, StrView delims, f32* dst, u64 cnt, i64 step, u64* pos);
+NMS_API u64 _parses(StrView str, StrView delims, f64* dst, u64 cnt, i64 step, u64* pos);
 #pragma endregion
 
 #pragma region parse switch
@@ -73,4 +84,39 @@ T parse(const StrView& str, const T& default_val = T{}) {
     return value;
 }
 
+/*!
+ * parse the numbers in str, separated by runs of delims, into dst (dim 0 first).
+ * stops at the first text that is not a number.
+ * returns the count of numbers parsed.
+ */
+template<class T, u32 N>
+u64 parses(const StrView& str, View<T, N> dst, const StrView& delims = " \t\r\n,;") {
+    const auto len  = dst.size(0);
+    const auto rows = len == 0 ? 0 : dst.count() / len;
+
+    u64 pos = 0;
+    u64 cnt = 0;
+    for (u64 row = 0; row < rows; ++row) {
+        i64  offset = 0;
+        auto idx    = row;
+        for (u32 dim = 1; dim < N; ++dim) {
+            offset += i64(idx % dst.size(dim)) * dst.step(dim);
+            idx    /= dst.size(dim);
+        }
+
+        const auto n = _parses(str, delims, dst.data() + offset, len, dst.step(0), &pos);
+        cnt += n;
+        if (n != len) {
+            break;
+        }
+    }
+    return cnt;
+}
+
+template<class T>
+u64 parses(const StrView& str, View<T> dst, const StrView& delims = " \t\r\n,;") {
+    u64 pos = 0;
+    return _parses(str, delims, dst.data(), dst.count(), 1, &pos);
+}
+
 }
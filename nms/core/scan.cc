@@ -0,0 +1,557 @@
+#include <nms/test.h>
+#include <nms/core/scan.h>
+#include <nms/core/simd.h>
+#include <nms/core/string.h>
+#include <nms/core/time.h>
+#include <nms/io/log.h>
+
+#if defined(NMS_CC_MSVC) && !defined(NMS_CC_CLANG)
+#   include <intrin.h>
+#endif
+
+namespace nms
+{
+
+#pragma region bits
+static __forceinline u32 _scan_ctz(u32 val) {
+#ifdef NMS_CC_MSVC
+    unsigned long idx = 0;
+    _BitScanForward(&idx, val);
+    return u32(idx);
+#else
+    return u32(__builtin_ctz(val));
+#endif
+}
+#pragma endregion
+
+#pragma region scalar
+static u64 _mfind_scalar(const u8* s, u64 n, u8 c) {
+    for (u64 i = 0; i < n; ++i) {
+        if (s[i] == c) {
+            return i;
+        }
+    }
+    return n;
+}
+
+static u64 _mcount_scalar(const u8* s, u64 n, u8 c) {
+    u64 cnt = 0;
+    for (u64 i = 0; i < n; ++i) {
+        cnt += s[i] == c ? 1 : 0;
+    }
+    return cnt;
+}
+
+static u64 _mfind_set_scalar(const u8* s, u64 n, const ByteSet& set, bool in) {
+    for (u64 i = 0; i < n; ++i) {
+        if (set.test(s[i]) == in) {
+            return i;
+        }
+    }
+    return n;
+}
+
+/* m >= 2, from position i */
+static u64 _msearch_scalar(const u8* s, u64 n, const u8* p, u64 m, u64 i = 0) {
+    for (; i + m <= n; ++i) {
+        if (s[i] == p[0] && s[i + m - 1] == p[m - 1] && ::memcmp(s + i + 1, p + 1, m - 2) == 0) {
+            return i;
+        }
+    }
+    return n;
+}
+
+static u64 _mmismatch_scalar(const u8* a, const u8* b, u64 n, u64 i = 0) {
+    for (; i < n; ++i) {
+        if (a[i] != b[i]) {
+            return i;
+        }
+    }
+    return n;
+}
+#pragma endregion
+
+#ifdef NMS_SIMD_SSE2
+
+#pragma region sse
+static u64 _mfind_sse(const u8* s, u64 n, u8 c) {
+    const auto vc = _mm_set1_epi8(char(c));
+    u64 i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        const auto m = u32(_mm_movemask_epi8(_mm_cmpeq_epi8(x, vc)));
+        if (m != 0) {
+            return i + _scan_ctz(m);
+        }
+    }
+    for (; i < n; ++i) {
+        if (s[i] == c) {
+            return i;
+        }
+    }
+    return n;
+}
+
+/* the matches are summed in 8 bit lanes (cmpeq = -1) for up to 255 blocks, then by psadbw */
+static u64 _mcount_sse(const u8* s, u64 n, u8 c) {
+    const auto vc   = _mm_set1_epi8(char(c));
+    const auto zero = _mm_setzero_si128();
+    const auto full = n / 16 * 16;
+
+    u64 cnt = 0;
+    u64 i   = 0;
+    while (i < full) {
+        const auto end = full - i > 255 * 16 ? i + 255 * 16 : full;
+        auto acc = zero;
+        for (; i < end; i += 16) {
+            const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(x, vc));
+        }
+        const auto sum = _mm_sad_epu8(acc, zero);
+        cnt += u64(_mm_extract_epi16(sum, 0)) + u64(_mm_extract_epi16(sum, 4));
+    }
+    for (; i < n; ++i) {
+        cnt += s[i] == c ? 1 : 0;
+    }
+    return cnt;
+}
+
+/*!
+ * pshufb classification: the low nibble selects a row of the bitmap
+ * (bytes >= 0x80 read tbl[1], pshufb gives 0 for the other table),
+ * the high nibble selects the bit of the row.
+ */
+NMS_TARGET("ssse3")
+static u64 _mfind_set_sse(const u8* s, u64 n, const ByteSet& set, bool in) {
+    const auto t0   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.tbl[0]));
+    const auto t1   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.tbl[1]));
+    const auto bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const auto lo4  = _mm_set1_epi8(0x0f);
+    const auto hi1  = _mm_set1_epi8(char(0x80));
+    const auto zero = _mm_setzero_si128();
+    const auto inv  = in ? 0xFFFFu : 0u;
+
+    u64 i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const auto x    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        const auto row  = _mm_or_si128(_mm_shuffle_epi8(t0, x), _mm_shuffle_epi8(t1, _mm_xor_si128(x, hi1)));
+        const auto bit  = _mm_shuffle_epi8(bits, _mm_and_si128(_mm_srli_epi16(x, 4), lo4));
+        const auto miss = _mm_cmpeq_epi8(_mm_and_si128(row, bit), zero);
+        const auto m    = u32(_mm_movemask_epi8(miss)) ^ inv;
+        if (m != 0) {
+            return i + _scan_ctz(m);
+        }
+    }
+    for (; i < n; ++i) {
+        if (set.test(s[i]) == in) {
+            return i;
+        }
+    }
+    return n;
+}
+
+/* candidates: first and last byte of the pattern match, then memcmp */
+static u64 _msearch_sse(const u8* s, u64 n, const u8* p, u64 m) {
+    const auto first = _mm_set1_epi8(char(p[0]));
+    const auto last  = _mm_set1_epi8(char(p[m - 1]));
+
+    u64 i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        const auto bf = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        const auto bl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + m - 1));
+        auto mask = u32(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(bf, first), _mm_cmpeq_epi8(bl, last))));
+        while (mask != 0) {
+            const auto k = _scan_ctz(mask);
+            if (::memcmp(s + i + k + 1, p + 1, m - 2) == 0) {
+                return i + k;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return _msearch_scalar(s, n, p, m, i);
+}
+
+static u64 _mmismatch_sse(const u8* a, const u8* b, u64 n) {
+    u64 i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        const auto y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        const auto m = u32(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y))) ^ 0xFFFFu;
+        if (m != 0) {
+            return i + _scan_ctz(m);
+        }
+    }
+    return _mmismatch_scalar(a, b, n, i);
+}
+#pragma endregion
+
+#pragma region avx2
+/* the tails are done by the sse functions: _mm256_zeroupper avoids the avx-sse transition penalty */
+NMS_TARGET("avx2")
+static u64 _mfind_avx2(const u8* s, u64 n, u8 c) {
+    const auto vc = _mm256_set1_epi8(char(c));
+    u64 i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        const auto m = u32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, vc)));
+        if (m != 0) {
+            _mm256_zeroupper();
+            return i + _scan_ctz(m);
+        }
+    }
+    _mm256_zeroupper();
+    return i + _mfind_sse(s + i, n - i, c);
+}
+
+NMS_TARGET("avx2")
+static u64 _mcount_avx2(const u8* s, u64 n, u8 c) {
+    const auto vc   = _mm256_set1_epi8(char(c));
+    const auto zero = _mm256_setzero_si256();
+    const auto full = n / 32 * 32;
+
+    u64 cnt = 0;
+    u64 i   = 0;
+    while (i < full) {
+        const auto end = full - i > 255 * 32 ? i + 255 * 32 : full;
+        auto acc = zero;
+        for (; i < end; i += 32) {
+            const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+            acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(x, vc));
+        }
+        const auto sad = _mm256_sad_epu8(acc, zero);
+        const auto sum = _mm_add_epi64(_mm256_castsi256_si128(sad), _mm256_extracti128_si256(sad, 1));
+        cnt += u64(_mm_extract_epi16(sum, 0)) + u64(_mm_extract_epi16(sum, 4));
+    }
+    _mm256_zeroupper();
+    return cnt + _mcount_sse(s + i, n - i, c);
+}
+
+NMS_TARGET("avx2")
+static u64 _mfind_set_avx2(const u8* s, u64 n, const ByteSet& set, bool in) {
+    const auto t0   = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(set.tbl[0])));
+    const auto t1   = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(set.tbl[1])));
+    const auto bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                                       1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const auto lo4  = _mm256_set1_epi8(0x0f);
+    const auto hi1  = _mm256_set1_epi8(char(0x80));
+    const auto zero = _mm256_setzero_si256();
+    const auto inv  = in ? 0xFFFFFFFFu : 0u;
+
+    u64 i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const auto x    = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        const auto row  = _mm256_or_si256(_mm256_shuffle_epi8(t0, x), _mm256_shuffle_epi8(t1, _mm256_xor_si256(x, hi1)));
+        const auto bit  = _mm256_shuffle_epi8(bits, _mm256_and_si256(_mm256_srli_epi16(x, 4), lo4));
+        const auto miss = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), zero);
+        const auto m    = u32(_mm256_movemask_epi8(miss)) ^ inv;
+        if (m != 0) {
+            _mm256_zeroupper();
+            return i + _scan_ctz(m);
+        }
+    }
+    _mm256_zeroupper();
+    return i + _mfind_set_sse(s + i, n - i, set, in);
+}
+
+NMS_TARGET("avx2")
+static u64 _msearch_avx2(const u8* s, u64 n, const u8* p, u64 m) {
+    const auto first = _mm256_set1_epi8(char(p[0]));
+    const auto last  = _mm256_set1_epi8(char(p[m - 1]));
+
+    u64 i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32) {
+        const auto bf = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        const auto bl = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i + m - 1));
+        auto mask = u32(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(bf, first), _mm256_cmpeq_epi8(bl, last))));
+        while (mask != 0) {
+            const auto k = _scan_ctz(mask);
+            if (::memcmp(s + i + k + 1, p + 1, m - 2) == 0) {
+                _mm256_zeroupper();
+                return i + k;
+            }
+            mask &= mask - 1;
+        }
+    }
+    _mm256_zeroupper();
+    return _msearch_scalar(s, n, p, m, i);
+}
+
+NMS_TARGET("avx2")
+static u64 _mmismatch_avx2(const u8* a, const u8* b, u64 n) {
+    u64 i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        const auto m = ~u32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+        if (m != 0) {
+            _mm256_zeroupper();
+            return i + _scan_ctz(m);
+        }
+    }
+    _mm256_zeroupper();
+    return i + _mmismatch_sse(a + i, b + i, n - i);
+}
+#pragma endregion
+
+#endif
+
+#pragma region dispatch
+static SimdLevel _simd_cpu() noexcept {
+#if defined(NMS_SIMD_SSE2) && defined(NMS_CC_MSVC) && !defined(NMS_CC_CLANG)
+    int regs[4];
+    __cpuid(regs, 0);
+    const auto max_leaf = regs[0];
+    __cpuid(regs, 1);
+    const auto ssse3   = (regs[2] & (1 << 9))  != 0;
+    const auto osxsave = (regs[2] & (1 << 27)) != 0;
+    auto avx2 = false;
+    if (max_leaf >= 7 && osxsave && (_xgetbv(0) & 6) == 6) {
+        __cpuidex(regs, 7, 0);
+        avx2 = (regs[1] & (1 << 5)) != 0;
+    }
+    return avx2 ? SimdLevel::AVX2 : ssse3 ? SimdLevel::SSE : SimdLevel::Scalar;
+#elif defined(NMS_SIMD_SSE2)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2")  ? SimdLevel::AVX2
+         : __builtin_cpu_supports("ssse3") ? SimdLevel::SSE
+         : SimdLevel::Scalar;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+// zero initialized (Scalar) until the dynamic initialization
+static const SimdLevel gSimdCpu   = _simd_cpu();
+static SimdLevel       gSimdLevel = gSimdCpu;
+
+NMS_API SimdLevel simd_level() noexcept {
+    return gSimdLevel;
+}
+
+NMS_API void simd_level(SimdLevel level) noexcept {
+    gSimdLevel = u32(level) > u32(gSimdCpu) ? gSimdCpu : level;
+}
+
+NMS_API u64 _mfind(const void* s, u64 n, u8 c) noexcept {
+    const auto p = static_cast<const u8*>(s);
+    switch (gSimdLevel) {
+#ifdef NMS_SIMD_SSE2
+    case SimdLevel::AVX2:   return _mfind_avx2(p, n, c);
+    case SimdLevel::SSE:    return _mfind_sse(p, n, c);
+#endif
+    default:                return _mfind_scalar(p, n, c);
+    }
+}
+
+NMS_API u64 _mcount(const void* s, u64 n, u8 c) noexcept {
+    const auto p = static_cast<const u8*>(s);
+    switch (gSimdLevel) {
+#ifdef NMS_SIMD_SSE2
+    case SimdLevel::AVX2:   return _mcount_avx2(p, n, c);
+    case SimdLevel::SSE:    return _mcount_sse(p, n, c);
+#endif
+    default:                return _mcount_scalar(p, n, c);
+    }
+}
+
+NMS_API u64 _mfind_set(const void* s, u64 n, const ByteSet& set, bool in) noexcept {
+    const auto p = static_cast<const u8*>(s);
+    switch (gSimdLevel) {
+#ifdef NMS_SIMD_SSE2
+    case SimdLevel::AVX2:   return _mfind_set_avx2(p, n, set, in);
+    case SimdLevel::SSE:    return _mfind_set_sse(p, n, set, in);
+#endif
+    default:                return _mfind_set_scalar(p, n, set, in);
+    }
+}
+
+NMS_API u64 _msearch(const void* s, u64 n, const void* sub, u64 m) noexcept {
+    if (m == 0) {
+        return 0;
+    }
+    if (m > n) {
+        return n;
+    }
+    const auto p = static_cast<const u8*>(s);
+    const auto q = static_cast<const u8*>(sub);
+    if (m == 1) {
+        return _mfind(p, n, q[0]);
+    }
+    switch (gSimdLevel) {
+#ifdef NMS_SIMD_SSE2
+    case SimdLevel::AVX2:   return _msearch_avx2(p, n, q, m);
+    case SimdLevel::SSE:    return _msearch_sse(p, n, q, m);
+#endif
+    default:                return _msearch_scalar(p, n, q, m);
+    }
+}
+
+NMS_API u64 _mmismatch(const void* a, const void* b, u64 n) noexcept {
+    const auto p = static_cast<const u8*>(a);
+    const auto q = static_cast<const u8*>(b);
+    switch (gSimdLevel) {
+#ifdef NMS_SIMD_SSE2
+    case SimdLevel::AVX2:   return _mmismatch_avx2(p, q, n);
+    case SimdLevel::SSE:    return _mmismatch_sse(p, q, n);
+#endif
+    default:                return _mmismatch_scalar(p, q, n);
+    }
+}
+#pragma endregion
+
+}
+
+namespace nms::core
+{
+
+#pragma region unittest
+static const SimdLevel gScanLevels[] = { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 };
+static const char*     gScanNames[]  = { "scalar", "sse", "avx2" };
+
+nms_test(scan) {
+    const auto cpu = simd_level();
+
+    // random bytes of a small alphabet, so that every function finds something
+    u8 buf[300];
+    u8 cpy[300];
+    u32 seed = 1;
+    for (auto& c : buf) {
+        seed = seed * 1103515245 + 12345;
+        c = u8("abcd,;\x80\xff"[(seed >> 16) & 7]);
+    }
+
+    ByteSet set(",;\xff", 3);
+    const u8 sub[] = { 'a', 'b', 'c' };
+
+    for (auto level : gScanLevels) {
+        simd_level(level);
+        if (simd_level() != level) {
+            continue;
+        }
+
+        for (u64 off = 0; off < 40; ++off) {
+            for (u64 n = 0; off + n <= sizeof(buf); n += 7) {
+                const auto s = buf + off;
+
+                u64 cnt = 0;
+                for (u64 i = 0; i < n; ++i) cnt += s[i] == 'c' ? 1 : 0;
+                test::assert_eq(_mcount(s, n, 'c'), cnt);
+
+                u64 idx = 0;
+                while (idx < n && s[idx] != 0x80) ++idx;
+                test::assert_eq(_mfind(s, n, 0x80), idx);
+
+                idx = 0;
+                while (idx < n && !set.test(s[idx])) ++idx;
+                test::assert_eq(_mfind_set(s, n, set), idx);
+
+                idx = 0;
+                while (idx < n && set.test(s[idx])) ++idx;
+                test::assert_eq(_mfind_set(s, n, set, false), idx);
+
+                idx = 0;
+                while (idx + 3 <= n && ::memcmp(s + idx, sub, 3) != 0) ++idx;
+                test::assert_eq(_msearch(s, n, sub, 3), idx + 3 <= n ? idx : n);
+
+                ::memcpy(cpy, s, n);
+                test::assert_eq(_mmismatch(s, cpy, n), n);
+                if (n > 0) {
+                    cpy[n - 1] ^= 1;
+                    test::assert_eq(_mmismatch(s, cpy, n), n - 1);
+                    cpy[n / 2] ^= 1;
+                    test::assert_eq(_mmismatch(s, cpy, n), n / 2 == n - 1 ? n : n / 2);
+                }
+            }
+        }
+
+        // long input: the counters of _mcount overflow after 255 blocks
+        List<char> big;
+        big.appends(100000, 'x');
+        big[99999] = 'y';
+        test::assert_eq(_mcount(big.data(), big.count(), 'x'), u64(99999));
+        test::assert_eq(_mfind(big.data(), big.count(), 'y'), u64(99999));
+        test::assert_eq(_msearch(big.data(), big.count(), "xxy", 3), u64(99997));
+
+        // strings
+        const auto parts = split("  a,b;;c  ", " ,;");
+        test::assert_eq(parts.count(), 3u);
+        test::assert_eq(parts[2], StrView{ "c" });
+        test::assert_eq(split(",,;", ",;").count(), 0u);
+        test::assert_eq(strfind("hello world", "world"), 6u);
+        test::assert_eq(strfind("hello world", "word"), 11u);
+        test::assert_eq(strcount("a,b,c", ','), 2u);
+        test::assert_true(StrView{ "abc" }.compare("abd") < 0);
+        test::assert_true(StrView{ "abc" } == StrView{ "abc" });
+        test::assert_true(StrView{ "abc" }.contains('c'));
+    }
+
+    simd_level(cpu);
+}
+
+/* log lines (~100 bytes) and a CSV file (~1MB) */
+nms_test(scan_perf) {
+    const auto cpu = simd_level();
+
+    String<> log;
+    for (u32 i = 0; i < 1000; ++i) {
+        sformat(log, "2017-03-01 12:00:{} [{}] nms.io.file: open file 'data/{}.bin', size = {}\n",
+            i % 60, i % 97 == 0 ? "ERROR" : "INFO", i, i * 4096);
+    }
+    String<> csv;
+    for (u32 i = 0; i < 10000; ++i) {
+        sformat(csv, "{},{},{.3},{.6},name{},{}\n", i, i * 7, i * 0.25, i * 1e-3, i % 13, i % 2 == 0 ? "true" : "false");
+    }
+
+    static const u32 loops = 20;
+
+    for (auto level : gScanLevels) {
+        simd_level(level);
+        if (simd_level() != level) {
+            continue;
+        }
+
+        // log lines: split by '\n', find "ERROR" in each line
+        const auto t0 = nms::clock();
+        u32 errors = 0;
+        for (u32 loop = 0; loop < loops; ++loop) {
+            const auto lines = split(log, "\n");
+            for (auto& line : lines) {
+                errors += strfind(line, "ERROR") < line.count() ? 1 : 0;
+            }
+        }
+        const auto t1 = nms::clock();
+
+        // csv: count lines, split each line into fields
+        u64 fields = 0;
+        for (u32 loop = 0; loop < loops; ++loop) {
+            StrView text = csv;
+            fields += strcount(text, '\n');
+            while (text.count() > 0) {
+                const auto e = strfind(text, "\n");
+                const auto line = StrView{ text.data(), e };
+                fields += split(line, ",").count();
+                text = e < text.count() ? StrView{ text.data() + e + 1, text.count() - e - 1 } : StrView{};
+            }
+        }
+        const auto t2 = nms::clock();
+
+        // bulk: count the fields, compare the whole file
+        u64 commas = 0;
+        for (u32 loop = 0; loop < loops; ++loop) {
+            commas += strcount(csv, ',');
+            commas += StrView{ csv }.compare(StrView{ csv.data(), csv.count() }) == 0 ? 1 : 0;
+        }
+        const auto t3 = nms::clock();
+
+        test::assert_eq(errors, 11u * loops);
+        test::assert_eq(fields, u64(7 * 10000 * loops));
+        test::assert_eq(commas, u64(5 * 10000 * loops + loops));
+        io::log::info("nms.scan[{}]: log {}KB: {.3}ms, csv {}KB: {.3}ms, count+compare: {.3}ms", gScanNames[u32(level)],
+            log.count() / 1024, (t1 - t0) * 1e3 / loops, csv.count() / 1024, (t2 - t1) * 1e3 / loops, (t3 - t2) * 1e3 / loops);
+    }
+
+    simd_level(cpu);
+}
+#pragma endregion
+
+}
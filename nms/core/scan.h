@@ -0,0 +1,75 @@
+#pragma once
+
+#include <nms/core/base.h>
+#include <nms/core/trait.h>
+
+namespace nms
+{
+
+/*!
+ * instruction set of the scan functions (_mfind, _msearch, ...).
+ * the default is the best one the cpu supports.
+ */
+enum class SimdLevel
+{
+    Scalar, // byte loops
+    SSE,    // SSE2 + SSSE3 (pshufb)
+    AVX2,
+};
+
+/* instruction set of the scan functions */
+NMS_API SimdLevel simd_level() noexcept;
+
+/* set the instruction set of the scan functions, clamped to what the cpu supports */
+NMS_API void simd_level(SimdLevel level) noexcept;
+
+/*!
+ * a set of bytes, as two 16x8 bitmaps indexed by the low nibble:
+ * bit (hi & 7) of tbl[hi >> 3][lo] tells if byte (hi << 4 | lo) is in the set.
+ * this is the layout of the pshufb classification.
+ */
+struct ByteSet
+{
+    u8 tbl[2][16];
+
+    constexpr ByteSet() noexcept
+        : tbl{}
+    {}
+
+    ByteSet(const char* s, u64 n) noexcept
+        : tbl{} {
+        for (u64 i = 0; i < n; ++i) {
+            add(u8(s[i]));
+        }
+    }
+
+    void add(u8 c) noexcept {
+        tbl[c >> 7][c & 15] |= u8(1u << ((c >> 4) & 7));
+    }
+
+    bool test(u8 c) const noexcept {
+        return (tbl[c >> 7][c & 15] >> ((c >> 4) & 7)) & 1;
+    }
+};
+
+/* index of the first byte c in s[0, n), n if not found */
+NMS_API u64 _mfind(const void* s, u64 n, u8 c) noexcept;
+
+/* number of bytes c in s[0, n) */
+NMS_API u64 _mcount(const void* s, u64 n, u8 c) noexcept;
+
+/* index of the first byte in s[0, n) that is in the set (in=true) or not (in=false), n if not found */
+NMS_API u64 _mfind_set(const void* s, u64 n, const ByteSet& set, bool in = true) noexcept;
+
+/* index of the first occurrence of sub[0, m) in s[0, n), n if not found */
+NMS_API u64 _msearch(const void* s, u64 n, const void* sub, u64 m) noexcept;
+
+/* index of the first byte where a[0, n) and b[0, n) differ, n if equal */
+NMS_API u64 _mmismatch(const void* a, const void* b, u64 n) noexcept;
+
+/* check if type can be compared as bytes: integers and char */
+struct $bytewise;
+template<class T>   struct Is<$bytewise, T>         { static constexpr auto $value = $is<$int, T> || $is<char, T>; };
+template<class T>   struct Is<$bytewise, const T>   { static constexpr auto $value = $is<$bytewise, T>; };
+
+}
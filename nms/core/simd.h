@@ -0,0 +1,439 @@
+#pragma once
+
+#include <nms/core/vec.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#   define NMS_SIMD_SSE2
+#   include <immintrin.h>
+#endif
+
+/* compile a function for an instruction set, picked at runtime (@see simd_level) */
+#if defined(NMS_CC_MSVC) && !defined(NMS_CC_CLANG)
+#   define NMS_TARGET(isa)
+#else
+#   define NMS_TARGET(isa)  __attribute__((target(isa)))
+#endif
+
+namespace nms
+{
+
+#ifdef NMS_SIMD_SSE2
+
+#pragma region simd traits
+/*
+ * _Simd<T, N>: register operations for Vec<T, N>.
+ * SSE2 is the baseline of x86-64, 256 bit types use AVX/AVX2 if the compiler
+ * targets it (-mavx, /arch:AVX), or a pair of SSE registers otherwise.
+ */
+template<class T, u32 N> struct _Simd;
+
+struct _SimdF32x4
+{
+    using T = f32;
+    using R = __m128;
+
+    static __forceinline R    load  (const T* p)    noexcept { return _mm_load_ps(p);  }
+    static __forceinline R    loadu (const T* p)    noexcept { return _mm_loadu_ps(p); }
+    static __forceinline void store (T* p, R a)     noexcept { _mm_store_ps(p, a);     }
+    static __forceinline void storeu(T* p, R a)     noexcept { _mm_storeu_ps(p, a);    }
+
+    static __forceinline R add (R a, R b)           noexcept { return _mm_add_ps(a, b); }
+    static __forceinline R sub (R a, R b)           noexcept { return _mm_sub_ps(a, b); }
+    static __forceinline R mul (R a, R b)           noexcept { return _mm_mul_ps(a, b); }
+    static __forceinline R div (R a, R b)           noexcept { return _mm_div_ps(a, b); }
+    static __forceinline R min (R a, R b)           noexcept { return _mm_min_ps(a, b); }
+    static __forceinline R max (R a, R b)           noexcept { return _mm_max_ps(a, b); }
+    static __forceinline R sqrt(R a)                noexcept { return _mm_sqrt_ps(a);   }
+#ifdef __FMA__
+    static __forceinline R fma (R a, R b, R c)      noexcept { return _mm_fmadd_ps(a, b, c); }
+#else
+    static __forceinline R fma (R a, R b, R c)      noexcept { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+#endif
+
+    static __forceinline R cmpeq(R a, R b)          noexcept { return _mm_cmpeq_ps (a, b); }
+    static __forceinline R cmpne(R a, R b)          noexcept { return _mm_cmpneq_ps(a, b); }
+    static __forceinline R cmplt(R a, R b)          noexcept { return _mm_cmplt_ps (a, b); }
+    static __forceinline R cmple(R a, R b)          noexcept { return _mm_cmple_ps (a, b); }
+    static __forceinline R cmpgt(R a, R b)          noexcept { return _mm_cmpgt_ps (a, b); }
+    static __forceinline R cmpge(R a, R b)          noexcept { return _mm_cmpge_ps (a, b); }
+
+#if defined(__SSE4_1__) || defined(__AVX__)
+    static __forceinline R   select(R m, R a, R b)  noexcept { return _mm_blendv_ps(b, a, m); }
+#else
+    static __forceinline R   select(R m, R a, R b)  noexcept { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+#endif
+    static __forceinline u32 movemask(R m)          noexcept { return u32(_mm_movemask_ps(m)); }
+
+    static __forceinline T hsum(R a) noexcept {
+        const auto s = _mm_add_ps(a, _mm_movehl_ps(a, a));
+        return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+    }
+
+    static __forceinline T hmin(R a) noexcept {
+        const auto s = _mm_min_ps(a, _mm_movehl_ps(a, a));
+        return _mm_cvtss_f32(_mm_min_ss(s, _mm_shuffle_ps(s, s, 1)));
+    }
+
+    static __forceinline T hmax(R a) noexcept {
+        const auto s = _mm_max_ps(a, _mm_movehl_ps(a, a));
+        return _mm_cvtss_f32(_mm_max_ss(s, _mm_shuffle_ps(s, s, 1)));
+    }
+};
+
+struct _SimdF64x2
+{
+    using T = f64;
+    using R = __m128d;
+
+    static __forceinline R    load  (const T* p)    noexcept { return _mm_load_pd(p);  }
+    static __forceinline R    loadu (const T* p)    noexcept { return _mm_loadu_pd(p); }
+    static __forceinline void store (T* p, R a)     noexcept { _mm_store_pd(p, a);     }
+    static __forceinline void storeu(T* p, R a)     noexcept { _mm_storeu_pd(p, a);    }
+
+    static __forceinline R add (R a, R b)           noexcept { return _mm_add_pd(a, b); }
+    static __forceinline R sub (R a, R b)           noexcept { return _mm_sub_pd(a, b); }
+    static __forceinline R mul (R a, R b)           noexcept { return _mm_mul_pd(a, b); }
+    static __forceinline R div (R a, R b)           noexcept { return _mm_div_pd(a, b); }
+    static __forceinline R min (R a, R b)           noexcept { return _mm_min_pd(a, b); }
+    static __forceinline R max (R a, R b)           noexcept { return _mm_max_pd(a, b); }
+    static __forceinline R sqrt(R a)                noexcept { return _mm_sqrt_pd(a);   }
+#ifdef __FMA__
+    static __forceinline R fma (R a, R b, R c)      noexcept { return _mm_fmadd_pd(a, b, c); }
+#else
+    static __forceinline R fma (R a, R b, R c)      noexcept { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+#endif
+
+    static __forceinline R cmpeq(R a, R b)          noexcept { return _mm_cmpeq_pd (a, b); }
+    static __forceinline R cmpne(R a, R b)          noexcept { return _mm_cmpneq_pd(a, b); }
+    static __forceinline R cmplt(R a, R b)          noexcept { return _mm_cmplt_pd (a, b); }
+    static __forceinline R cmple(R a, R b)          noexcept { return _mm_cmple_pd (a, b); }
+    static __forceinline R cmpgt(R a, R b)          noexcept { return _mm_cmpgt_pd (a, b); }
+    static __forceinline R cmpge(R a, R b)          noexcept { return _mm_cmpge_pd (a, b); }
+
+#if defined(__SSE4_1__) || defined(__AVX__)
+    static __forceinline R   select(R m, R a, R b)  noexcept { return _mm_blendv_pd(b, a, m); }
+#else
+    static __forceinline R   select(R m, R a, R b)  noexcept { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+#endif
+    static __forceinline u32 movemask(R m)          noexcept { return u32(_mm_movemask_pd(m)); }
+
+    static __forceinline T hsum(R a) noexcept { return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a))); }
+    static __forceinline T hmin(R a) noexcept { return _mm_cvtsd_f64(_mm_min_sd(a, _mm_unpackhi_pd(a, a))); }
+    static __forceinline T hmax(R a) noexcept { return _mm_cvtsd_f64(_mm_max_sd(a, _mm_unpackhi_pd(a, a))); }
+};
+
+/* i32 x 4: only used as the half of i32 x 8 */
+struct _SimdI32x4
+{
+    using T = i32;
+    using R = __m128i;
+
+    static __forceinline R    load  (const T* p)    noexcept { return _mm_load_si128 (reinterpret_cast<const R*>(p)); }
+    static __forceinline R    loadu (const T* p)    noexcept { return _mm_loadu_si128(reinterpret_cast<const R*>(p)); }
+    static __forceinline void store (T* p, R a)     noexcept { _mm_store_si128 (reinterpret_cast<R*>(p), a); }
+    static __forceinline void storeu(T* p, R a)     noexcept { _mm_storeu_si128(reinterpret_cast<R*>(p), a); }
+
+    static __forceinline R add(R a, R b)            noexcept { return _mm_add_epi32(a, b); }
+    static __forceinline R sub(R a, R b)            noexcept { return _mm_sub_epi32(a, b); }
+
+    static __forceinline R mul(R a, R b) noexcept {
+#ifdef __SSE4_1__
+        return _mm_mullo_epi32(a, b);
+#else
+        const auto e = _mm_mul_epu32(a, b);
+        const auto o = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(e, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(o, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+    }
+
+    static __forceinline R cmpeq(R a, R b)          noexcept { return _mm_cmpeq_epi32(a, b); }
+    static __forceinline R cmplt(R a, R b)          noexcept { return _mm_cmplt_epi32(a, b); }
+    static __forceinline R cmpgt(R a, R b)          noexcept { return _mm_cmpgt_epi32(a, b); }
+    static __forceinline R cmpne(R a, R b)          noexcept { return _mm_xor_si128(cmpeq(a, b), _mm_set1_epi32(-1)); }
+    static __forceinline R cmple(R a, R b)          noexcept { return _mm_xor_si128(cmpgt(a, b), _mm_set1_epi32(-1)); }
+    static __forceinline R cmpge(R a, R b)          noexcept { return _mm_xor_si128(cmplt(a, b), _mm_set1_epi32(-1)); }
+
+#if defined(__SSE4_1__) || defined(__AVX__)
+    static __forceinline R   select(R m, R a, R b)  noexcept { return _mm_blendv_epi8(b, a, m); }
+#else
+    static __forceinline R   select(R m, R a, R b)  noexcept { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+#endif
+    static __forceinline u32 movemask(R m)          noexcept { return u32(_mm_movemask_ps(_mm_castsi128_ps(m))); }
+
+    static __forceinline R min(R a, R b)            noexcept { return select(cmplt(a, b), a, b); }
+    static __forceinline R max(R a, R b)            noexcept { return select(cmpgt(a, b), a, b); }
+
+    static __forceinline T hsum(R a) noexcept {
+        const auto s = _mm_add_epi32(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_cvtsi128_si32(_mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+
+    static __forceinline T hmin(R a) noexcept {
+        const auto s = min(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_cvtsi128_si32(min(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+
+    static __forceinline T hmax(R a) noexcept {
+        const auto s = max(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_cvtsi128_si32(max(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+};
+
+/* 256 bit register emulated by two 128 bit registers */
+template<class S>
+struct _SimdX2
+{
+    using T = typename S::T;
+    struct R { typename S::R lo, hi; };
+
+    static constexpr u32 $half = 16 / sizeof(T);
+
+    static __forceinline R    load  (const T* p)    noexcept { return { S::load (p), S::load (p + $half) }; }
+    static __forceinline R    loadu (const T* p)    noexcept { return { S::loadu(p), S::loadu(p + $half) }; }
+    static __forceinline void store (T* p, R a)     noexcept { S::store (p, a.lo); S::store (p + $half, a.hi); }
+    static __forceinline void storeu(T* p, R a)     noexcept { S::storeu(p, a.lo); S::storeu(p + $half, a.hi); }
+
+    static __forceinline R add (R a, R b)           noexcept { return { S::add(a.lo, b.lo), S::add(a.hi, b.hi) }; }
+    static __forceinline R sub (R a, R b)           noexcept { return { S::sub(a.lo, b.lo), S::sub(a.hi, b.hi) }; }
+    static __forceinline R mul (R a, R b)           noexcept { return { S::mul(a.lo, b.lo), S::mul(a.hi, b.hi) }; }
+    static __forceinline R div (R a, R b)           noexcept { return { S::div(a.lo, b.lo), S::div(a.hi, b.hi) }; }
+    static __forceinline R min (R a, R b)           noexcept { return { S::min(a.lo, b.lo), S::min(a.hi, b.hi) }; }
+    static __forceinline R max (R a, R b)           noexcept { return { S::max(a.lo, b.lo), S::max(a.hi, b.hi) }; }
+    static __forceinline R sqrt(R a)                noexcept { return { S::sqrt(a.lo), S::sqrt(a.hi) }; }
+    static __forceinline R fma (R a, R b, R c)      noexcept { return { S::fma(a.lo, b.lo, c.lo), S::fma(a.hi, b.hi, c.hi) }; }
+
+    static __forceinline R cmpeq(R a, R b)          noexcept { return { S::cmpeq(a.lo, b.lo), S::cmpeq(a.hi, b.hi) }; }
+    static __forceinline R cmpne(R a, R b)          noexcept { return { S::cmpne(a.lo, b.lo), S::cmpne(a.hi, b.hi) }; }
+    static __forceinline R cmplt(R a, R b)          noexcept { return { S::cmplt(a.lo, b.lo), S::cmplt(a.hi, b.hi) }; }
+    static __forceinline R cmple(R a, R b)          noexcept { return { S::cmple(a.lo, b.lo), S::cmple(a.hi, b.hi) }; }
+    static __forceinline R cmpgt(R a, R b)          noexcept { return { S::cmpgt(a.lo, b.lo), S::cmpgt(a.hi, b.hi) }; }
+    static __forceinline R cmpge(R a, R b)          noexcept { return { S::cmpge(a.lo, b.lo), S::cmpge(a.hi, b.hi) }; }
+
+    static __forceinline R   select(R m, R a, R b)  noexcept { return { S::select(m.lo, a.lo, b.lo), S::select(m.hi, a.hi, b.hi) }; }
+    static __forceinline u32 movemask(R m)          noexcept { return S::movemask(m.lo) | (S::movemask(m.hi) << $half); }
+
+    static __forceinline T hsum(R a)                noexcept { return S::hsum(S::add(a.lo, a.hi)); }
+    static __forceinline T hmin(R a)                noexcept { return S::hmin(S::min(a.lo, a.hi)); }
+    static __forceinline T hmax(R a)                noexcept { return S::hmax(S::max(a.lo, a.hi)); }
+};
+
+#ifdef __AVX__
+struct _SimdF32x8
+{
+    using T = f32;
+    using R = __m256;
+
+    static __forceinline R    load  (const T* p)    noexcept { return _mm256_load_ps(p);  }
+    static __forceinline R    loadu (const T* p)    noexcept { return _mm256_loadu_ps(p); }
+    static __forceinline void store (T* p, R a)     noexcept { _mm256_store_ps(p, a);     }
+    static __forceinline void storeu(T* p, R a)     noexcept { _mm256_storeu_ps(p, a);    }
+
+    static __forceinline R add (R a, R b)           noexcept { return _mm256_add_ps(a, b); }
+    static __forceinline R sub (R a, R b)           noexcept { return _mm256_sub_ps(a, b); }
+    static __forceinline R mul (R a, R b)           noexcept { return _mm256_mul_ps(a, b); }
+    static __forceinline R div (R a, R b)           noexcept { return _mm256_div_ps(a, b); }
+    static __forceinline R min (R a, R b)           noexcept { return _mm256_min_ps(a, b); }
+    static __forceinline R max (R a, R b)           noexcept { return _mm256_max_ps(a, b); }
+    static __forceinline R sqrt(R a)                noexcept { return _mm256_sqrt_ps(a);   }
+#ifdef __FMA__
+    static __forceinline R fma (R a, R b, R c)      noexcept { return _mm256_fmadd_ps(a, b, c); }
+#else
+    static __forceinline R fma (R a, R b, R c)      noexcept { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+
+    static __forceinline R cmpeq(R a, R b)          noexcept { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ);  }
+    static __forceinline R cmpne(R a, R b)          noexcept { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+    static __forceinline R cmplt(R a, R b)          noexcept { return _mm256_cmp_ps(a, b, _CMP_LT_OQ);  }
+    static __forceinline R cmple(R a, R b)          noexcept { return _mm256_cmp_ps(a, b, _CMP_LE_OQ);  }
+    static __forceinline R cmpgt(R a, R b)          noexcept { return _mm256_cmp_ps(a, b, _CMP_GT_OQ);  }
+    static __forceinline R cmpge(R a, R b)          noexcept { return _mm256_cmp_ps(a, b, _CMP_GE_OQ);  }
+
+    static __forceinline R   select(R m, R a, R b)  noexcept { return _mm256_blendv_ps(b, a, m); }
+    static __forceinline u32 movemask(R m)          noexcept { return u32(_mm256_movemask_ps(m)); }
+
+    static __forceinline T hsum(R a) noexcept { return _SimdF32x4::hsum(_mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1))); }
+    static __forceinline T hmin(R a) noexcept { return _SimdF32x4::hmin(_mm_min_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1))); }
+    static __forceinline T hmax(R a) noexcept { return _SimdF32x4::hmax(_mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1))); }
+};
+
+struct _SimdF64x4
+{
+    using T = f64;
+    using R = __m256d;
+
+    static __forceinline R    load  (const T* p)    noexcept { return _mm256_load_pd(p);  }
+    static __forceinline R    loadu (const T* p)    noexcept { return _mm256_loadu_pd(p); }
+    static __forceinline void store (T* p, R a)     noexcept { _mm256_store_pd(p, a);     }
+    static __forceinline void storeu(T* p, R a)     noexcept { _mm256_storeu_pd(p, a);    }
+
+    static __forceinline R add (R a, R b)           noexcept { return _mm256_add_pd(a, b); }
+    static __forceinline R sub (R a, R b)           noexcept { return _mm256_sub_pd(a, b); }
+    static __forceinline R mul (R a, R b)           noexcept { return _mm256_mul_pd(a, b); }
+    static __forceinline R div (R a, R b)           noexcept { return _mm256_div_pd(a, b); }
+    static __forceinline R min (R a, R b)           noexcept { return _mm256_min_pd(a, b); }
+    static __forceinline R max (R a, R b)           noexcept { return _mm256_max_pd(a, b); }
+    static __forceinline R sqrt(R a)                noexcept { return _mm256_sqrt_pd(a);   }
+#ifdef __FMA__
+    static __forceinline R fma (R a, R b, R c)      noexcept { return _mm256_fmadd_pd(a, b, c); }
+#else
+    static __forceinline R fma (R a, R b, R c)      noexcept { return _mm256_add_pd(_mm256_mul_pd(a, b), c); }
+#endif
+
+    static __forceinline R cmpeq(R a, R b)          noexcept { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ);  }
+    static __forceinline R cmpne(R a, R b)          noexcept { return _mm256_cmp_pd(a, b, _CMP_NEQ_UQ); }
+    static __forceinline R cmplt(R a, R b)          noexcept { return _mm256_cmp_pd(a, b, _CMP_LT_OQ);  }
+    static __forceinline R cmple(R a, R b)          noexcept { return _mm256_cmp_pd(a, b, _CMP_LE_OQ);  }
+    static __forceinline R cmpgt(R a, R b)          noexcept { return _mm256_cmp_pd(a, b, _CMP_GT_OQ);  }
+    static __forceinline R cmpge(R a, R b)          noexcept { return _mm256_cmp_pd(a, b, _CMP_GE_OQ);  }
+
+    static __forceinline R   select(R m, R a, R b)  noexcept { return _mm256_blendv_pd(b, a, m); }
+    static __forceinline u32 movemask(R m)          noexcept { return u32(_mm256_movemask_pd(m)); }
+
+    static __forceinline T hsum(R a) noexcept { return _SimdF64x2::hsum(_mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1))); }
+    static __forceinline T hmin(R a) noexcept { return _SimdF64x2::hmin(_mm_min_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1))); }
+    static __forceinline T hmax(R a) noexcept { return _SimdF64x2::hmax(_mm_max_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1))); }
+};
+#endif
+
+#ifdef __AVX2__
+struct _SimdI32x8
+{
+    using T = i32;
+    using R = __m256i;
+
+    static __forceinline R    load  (const T* p)    noexcept { return _mm256_load_si256 (reinterpret_cast<const R*>(p)); }
+    static __forceinline R    loadu (const T* p)    noexcept { return _mm256_loadu_si256(reinterpret_cast<const R*>(p)); }
+    static __forceinline void store (T* p, R a)     noexcept { _mm256_store_si256 (reinterpret_cast<R*>(p), a); }
+    static __forceinline void storeu(T* p, R a)     noexcept { _mm256_storeu_si256(reinterpret_cast<R*>(p), a); }
+
+    static __forceinline R add(R a, R b)            noexcept { return _mm256_add_epi32  (a, b); }
+    static __forceinline R sub(R a, R b)            noexcept { return _mm256_sub_epi32  (a, b); }
+    static __forceinline R mul(R a, R b)            noexcept { return _mm256_mullo_epi32(a, b); }
+    static __forceinline R min(R a, R b)            noexcept { return _mm256_min_epi32  (a, b); }
+    static __forceinline R max(R a, R b)            noexcept { return _mm256_max_epi32  (a, b); }
+
+    static __forceinline R cmpeq(R a, R b)          noexcept { return _mm256_cmpeq_epi32(a, b); }
+    static __forceinline R cmpgt(R a, R b)          noexcept { return _mm256_cmpgt_epi32(a, b); }
+    static __forceinline R cmplt(R a, R b)          noexcept { return _mm256_cmpgt_epi32(b, a); }
+    static __forceinline R cmpne(R a, R b)          noexcept { return _mm256_xor_si256(cmpeq(a, b), _mm256_set1_epi32(-1)); }
+    static __forceinline R cmple(R a, R b)          noexcept { return _mm256_xor_si256(cmpgt(a, b), _mm256_set1_epi32(-1)); }
+    static __forceinline R cmpge(R a, R b)          noexcept { return _mm256_xor_si256(cmplt(a, b), _mm256_set1_epi32(-1)); }
+
+    static __forceinline R   select(R m, R a, R b)  noexcept { return _mm256_blendv_epi8(b, a, m); }
+    static __forceinline u32 movemask(R m)          noexcept { return u32(_mm256_movemask_ps(_mm256_castsi256_ps(m))); }
+
+    static __forceinline T hsum(R a) noexcept { return _SimdI32x4::hsum(_mm_add_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1))); }
+    static __forceinline T hmin(R a) noexcept { return _SimdI32x4::hmin(_mm_min_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1))); }
+    static __forceinline T hmax(R a) noexcept { return _SimdI32x4::hmax(_mm_max_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1))); }
+};
+#endif
+
+template<> struct _Simd<f32, 4> : _SimdF32x4 {};
+template<> struct _Simd<f64, 2> : _SimdF64x2 {};
+
+#ifdef __AVX__
+template<> struct _Simd<f32, 8> : _SimdF32x8 {};
+template<> struct _Simd<f64, 4> : _SimdF64x4 {};
+#else
+template<> struct _Simd<f32, 8> : _SimdX2<_SimdF32x4> {};
+template<> struct _Simd<f64, 4> : _SimdX2<_SimdF64x2> {};
+#endif
+
+#ifdef __AVX2__
+template<> struct _Simd<i32, 8> : _SimdI32x8 {};
+#else
+template<> struct _Simd<i32, 8> : _SimdX2<_SimdI32x4> {};
+#endif
+#pragma endregion
+
+#pragma region simd functions
+/*
+ * a Vec may live in memory only 16 bytes aligned (mnew, List, Array), below the
+ * 32 bytes of a 256 bit register: the functions load and store unaligned, which
+ * costs the same as an aligned access when the address is aligned.
+ */
+#define NMS_SIMD_FN1(T, N, name, op)                                                    \
+__forceinline Vec<T, N> name(const Vec<T, N>& a) noexcept {                             \
+    using S = _Simd<T, N>;                                                              \
+    Vec<T, N> c;                                                                        \
+    S::storeu(c.data, S::op(S::loadu(a.data)));                                           \
+    return c;                                                                           \
+}
+
+#define NMS_SIMD_FN2(T, N, name, op)                                                    \
+__forceinline Vec<T, N> name(const Vec<T, N>& a, const Vec<T, N>& b) noexcept {         \
+    using S = _Simd<T, N>;                                                              \
+    Vec<T, N> c;                                                                        \
+    S::storeu(c.data, S::op(S::loadu(a.data), S::loadu(b.data)));                          \
+    return c;                                                                           \
+}
+
+#define NMS_SIMD_FN3(T, N, name, op)                                                    \
+__forceinline Vec<T, N> name(const Vec<T, N>& a, const Vec<T, N>& b, const Vec<T, N>& c) noexcept { \
+    using S = _Simd<T, N>;                                                              \
+    Vec<T, N> d;                                                                        \
+    S::storeu(d.data, S::op(S::loadu(a.data), S::loadu(b.data), S::loadu(c.data)));         \
+    return d;                                                                           \
+}
+
+#define NMS_SIMD_VEC(T, N)                                                              \
+NMS_SIMD_FN2(T, N, operator+, add)                                                      \
+NMS_SIMD_FN2(T, N, operator-, sub)                                                      \
+NMS_SIMD_FN2(T, N, operator*, mul)                                                      \
+NMS_SIMD_FN2(T, N, vmin,  min)                                                          \
+NMS_SIMD_FN2(T, N, vmax,  max)                                                          \
+NMS_SIMD_FN2(T, N, cmpeq, cmpeq)                                                        \
+NMS_SIMD_FN2(T, N, cmpne, cmpne)                                                        \
+NMS_SIMD_FN2(T, N, cmplt, cmplt)                                                        \
+NMS_SIMD_FN2(T, N, cmple, cmple)                                                        \
+NMS_SIMD_FN2(T, N, cmpgt, cmpgt)                                                        \
+NMS_SIMD_FN2(T, N, cmpge, cmpge)                                                        \
+__forceinline Vec<T, N> select(const Vec<T, N>& m, const Vec<T, N>& a, const Vec<T, N>& b) noexcept {  \
+    using S = _Simd<T, N>;                                                              \
+    Vec<T, N> c;                                                                        \
+    S::storeu(c.data, S::select(S::loadu(m.data), S::loadu(a.data), S::loadu(b.data)));     \
+    return c;                                                                           \
+}                                                                                       \
+__forceinline u32 movemask(const Vec<T, N>& m) noexcept { return _Simd<T, N>::movemask(_Simd<T, N>::loadu(m.data)); } \
+__forceinline T   hsum    (const Vec<T, N>& a) noexcept { return _Simd<T, N>::hsum    (_Simd<T, N>::loadu(a.data)); } \
+__forceinline T   hmin    (const Vec<T, N>& a) noexcept { return _Simd<T, N>::hmin    (_Simd<T, N>::loadu(a.data)); } \
+__forceinline T   hmax    (const Vec<T, N>& a) noexcept { return _Simd<T, N>::hmax    (_Simd<T, N>::loadu(a.data)); }
+
+#define NMS_SIMD_VEC_FLOAT(T, N)                                                        \
+NMS_SIMD_VEC(T, N)                                                                      \
+NMS_SIMD_FN2(T, N, operator/, div)                                                      \
+NMS_SIMD_FN1(T, N, vsqrt, sqrt)                                                         \
+NMS_SIMD_FN3(T, N, vfma,  fma)
+
+NMS_SIMD_VEC_FLOAT(f32, 4)
+NMS_SIMD_VEC_FLOAT(f64, 2)
+NMS_SIMD_VEC_FLOAT(f32, 8)
+NMS_SIMD_VEC_FLOAT(f64, 4)
+NMS_SIMD_VEC(i32, 8)
+
+#undef NMS_SIMD_VEC_FLOAT
+#undef NMS_SIMD_VEC
+#undef NMS_SIMD_FN3
+#undef NMS_SIMD_FN2
+#undef NMS_SIMD_FN1
+
+template<u32 I0, u32 I1, u32 I2, u32 I3>
+__forceinline f32x4 _shuffle(const f32x4& a, Tu32<I0, I1, I2, I3>) noexcept {
+    const auto v = _mm_loadu_ps(a.data);
+    f32x4 c;
+    _mm_storeu_ps(c.data, _mm_shuffle_ps(v, v, _MM_SHUFFLE(I3, I2, I1, I0)));
+    return c;
+}
+
+template<u32 I0, u32 I1>
+__forceinline f64x2 _shuffle(const f64x2& a, Tu32<I0, I1>) noexcept {
+    const auto v = _mm_loadu_pd(a.data);
+    f64x2 c;
+    _mm_storeu_pd(c.data, _mm_shuffle_pd(v, v, _MM_SHUFFLE2(I1, I0)));
+    return c;
+}
+#pragma endregion
+
+#endif
+
+}
@@ -13,32 +13,30 @@ NMS_API u32 strlen(const char* s) {
 }
 
 
-NMS_API List<StrView> split(StrView str, StrView delimiters) {
-    List<StrView> list;
-
-    while (true) {
-        const auto n = str.count();
-        if (n == 0) {
-            break;
-        }
+NMS_API u32 strfind(StrView str, StrView sub) {
+    return u32(_msearch(str.data(), str.count(), sub.data(), sub.count()));
+}
 
-        auto b = 0u;
-        while (b < n && delimiters.contains(str[b]) == true) {
-            ++b;
-        }
+NMS_API u32 strcount(StrView str, char c) {
+    return u32(_mcount(str.data(), str.count(), u8(c)));
+}
 
-        auto e = b + 1;
-        while (e < n && delimiters.contains(str[e]) == false) {
-            ++e;
-        }
+NMS_API List<StrView> split(StrView str, StrView delimiters) {
+    List<StrView> list;
 
-        const auto s = str.slice( b, e - 1);
-        list.append(s);
+    const ByteSet set(delimiters.data(), delimiters.count());
+    const auto    ptr = str.data();
+    const auto    n   = u64(str.count());
 
-        if (e + 1 >= n) {
+    u64 pos = 0;
+    while (pos < n) {
+        const auto b = pos + _mfind_set(ptr + pos, n - pos, set, false);
+        if (b == n) {
             break;
         }
-        str = str.slice(e + 1, n - 1);
+        const auto e = b + 1 + _mfind_set(ptr + b + 1, n - b - 1, set, true);
+        list.append(StrView{ ptr + b, u32(e - b) });
+        pos = e + 1;
     }
 
     return list;
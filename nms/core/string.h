@@ -15,7 +15,13 @@ inline StrView mkStrView(const char* s) {
     return {s, strlen(s)};
 }
 
-/* split a TString into pieces */
+/* index of the first occurrence of sub in str, str.count() if not found */
+NMS_API u32 strfind(StrView str, StrView sub);
+
+/* number of c in str */
+NMS_API u32 strcount(StrView str, char c);
+
+/* split a TString into pieces: the runs of non-delimiters */
 NMS_API List<StrView> split(StrView str, StrView delimiters);
 
 }
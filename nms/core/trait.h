@@ -245,12 +245,14 @@ struct $class;      // check if type is class/struct
 struct $pod;        // check if type is POD type
 struct $union;      // check if type is union
 struct $empty;      // check if type is empty
+struct $relocatable;// check if type can be moved with memcpy (move + destroy the source)
 
 template<class T>   struct Is<$enum , T> { static constexpr auto $value = __is_enum(T);  };
 template<class T>   struct Is<$class, T> { static constexpr auto $value = __is_class(T); };
 template<class T>   struct Is<$pod  , T> { static constexpr auto $value = __is_pod(T);   };
 template<class T>   struct Is<$union, T> { static constexpr auto $value = __is_union(T); };
 template<class T>   struct Is<$empty, T> { static constexpr auto $value = __is_empty(T); };
+template<class T>   struct Is<$relocatable, T> { static constexpr auto $value = __is_trivially_copyable(T); };
 
 struct $sint;       // check if type is signed integer
 struct $uint;       // check if type is unsigned integer
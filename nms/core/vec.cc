@@ -18,4 +18,57 @@ nms_test(vec) {
     test::assert_eq(f3[2], 3.0f);
 }
 
+nms_test(vec_simd) {
+    const f32x4 a = { 1.0f, 2.0f, 3.0f, 4.0f };
+    const f32x4 b = { 4.0f, 3.0f, 2.0f, 1.0f };
+
+    test::assert_eq(a + b, f32x4{ 5.0f });
+    test::assert_eq(a * b, f32x4{ 4.0f, 6.0f, 6.0f, 4.0f });
+    test::assert_eq(a / f32x4{ 2.0f }, f32x4{ 0.5f, 1.0f, 1.5f, 2.0f });
+    test::assert_eq(vmin(a, b), f32x4{ 1.0f, 2.0f, 2.0f, 1.0f });
+    test::assert_eq(vsqrt(a * a), a);
+    test::assert_eq(shuffle<3, 2, 1, 0>(a), b);
+
+    test::assert_eq(hsum(a), 10.0f);
+    test::assert_eq(hmin(a), 1.0f);
+    test::assert_eq(hmax(a), 4.0f);
+
+    const auto m = cmplt(a, b);
+    test::assert_eq(movemask(m), 0x3u);
+    test::assert_eq(select(m, a, b), f32x4{ 1.0f, 2.0f, 2.0f, 1.0f });
+
+    alignas(32) f64 buf[4] = { 1.0, -2.0, 3.0, -4.0 };
+    const auto d = f64x4::load(buf);
+    test::assert_eq(hsum(d), -2.0);
+    test::assert_eq(movemask(cmpgt(d, f64x4{ 0.0 })), 0x5u);
+    (d * f64x4{ 2.0 }).store(buf);
+    test::assert_eq(buf[3], -8.0);
+
+    const i32x8 i = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    const i32x8 j = { 8, 7, 6, 5, 4, 3, 2, 1 };
+    test::assert_eq(i * j, i32x8{ 8, 14, 18, 20, 20, 18, 14, 8 });
+    test::assert_eq(hsum(i - j), 0);
+    test::assert_eq(hmax(i), 8);
+    test::assert_eq(movemask(cmpge(i, j)), 0xF0u);
+    test::assert_eq(select(cmpeq(i, i32x8{ 4 }), i32x8{ 0 }, i), i32x8{ 1, 2, 3, 0, 5, 6, 7, 8 });
+
+    const f32x8 f = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f };
+    test::assert_eq(hsum(f - f32x8{ 1.0f }), 28.0f);
+    test::assert_eq(f32x8::loadu(f.data + 0), f);
+
+    // the containers honor the Vec alignment
+    List<f32x8> fl;
+    for (u32 k = 0; k < 7; ++k) fl.append(f);
+    for (u32 k = 0; k < 7; ++k) {
+        test::assert_eq(u64(reinterpret_cast<u64>(&fl[k]) % alignof(f32x8)), u64(0));
+        test::assert_eq(fl[k], f);
+    }
+
+    // generic Vec keeps the same interface
+    const u8   bytes[] = { 1, 2, 3, 4 };
+    const u8x4 u = u8x4::loadu(bytes);
+    test::assert_eq(movemask(cmpgt(u, u8x4{ u8(2) })), 0xCu);
+    test::assert_eq(hsum(u), u8(10));
+}
+
 }
@@ -8,8 +8,19 @@ namespace nms
 
 template<class T, u32 ...Ns> struct Vec;
 
+/*
+ * Vec<T, N> that map to a SSE/AVX register are 16 bytes aligned (see simd.h).
+ * not 32 for the AVX types: mnew/malloc and the containers only give 16, simd.h loads/stores them unaligned.
+ */
+template<class T, u32 N> struct _VecAlign           : Tu32<alignof(T)> {};
+template<>               struct _VecAlign<f32, 4>   : Tu32<16> {};
+template<>               struct _VecAlign<f64, 2>   : Tu32<16> {};
+template<>               struct _VecAlign<f32, 8>   : Tu32<16> {};
+template<>               struct _VecAlign<f64, 4>   : Tu32<16> {};
+template<>               struct _VecAlign<i32, 8>   : Tu32<16> {};
+
 template<class T, u32 N>
-struct Vec<T, N>
+struct alignas(_VecAlign<T, N>::$value) Vec<T, N>
 {
     static constexpr auto $size  = N;
     static constexpr auto $count = N;
@@ -40,6 +51,28 @@ struct Vec<T, N>
     template<class I> __forceinline T&       operator[] (I idx)       noexcept { return data[idx]; }
     template<class I> __forceinline const T& operator[] (I idx) const noexcept { return data[idx]; }
 
+    /* load from aligned memory */
+    static __forceinline Vec load(const T* ptr) noexcept {
+        Vec v;
+        for (u32 i = 0; i < $size; ++i) v.data[i] = ptr[i];
+        return v;
+    }
+
+    /* load from unaligned memory */
+    static __forceinline Vec loadu(const T* ptr) noexcept {
+        return load(ptr);
+    }
+
+    /* store to aligned memory */
+    __forceinline void store(T* ptr) const noexcept {
+        for (u32 i = 0; i < $size; ++i) ptr[i] = data[i];
+    }
+
+    /* store to unaligned memory */
+    __forceinline void storeu(T* ptr) const noexcept {
+        store(ptr);
+    }
+
 protected:
     template<class V, u32 ...I>
     __forceinline constexpr Vec(const V& v, Tu32<I...>) noexcept
@@ -77,6 +110,157 @@ NMS_VEC_OP(*)
 NMS_VEC_OP(/ )
 #undef  NMS_VEC_OP
 
+#pragma region vec functions
+/*
+ * element-wise functions.
+ * the Vec types that map to SSE/AVX registers are overloaded in simd.h.
+ *
+ * comparisons return masks: every bit of an element is set if true, cleared if false.
+ */
+
+template<u32 S> struct _VecBits;
+template<>      struct _VecBits<1> { using U = u8;  };
+template<>      struct _VecBits<2> { using U = u16; };
+template<>      struct _VecBits<4> { using U = u32; };
+template<>      struct _VecBits<8> { using U = u64; };
+
+/* bit cast */
+template<class U, class T>
+__forceinline U _vec_cast(T t) noexcept {
+    static_assert(sizeof(U) == sizeof(T), "nms._vec_cast: size not match");
+    U u;
+    ::memcpy(&u, &t, sizeof(U));
+    return u;
+}
+
+template<class T>
+__forceinline auto _vec_bits(T t) noexcept {
+    return _vec_cast<typename _VecBits<sizeof(T)>::U>(t);
+}
+
+template<class T>
+__forceinline T _vec_mask(bool b) noexcept {
+    using U = typename _VecBits<sizeof(T)>::U;
+    return _vec_cast<T>(b ? U(~U(0)) : U(0));
+}
+
+#define NMS_VEC_CMP(name, op)                                                   \
+template<class T, u32 N>                                                        \
+__forceinline Vec<T, N> name(const Vec<T, N>& a, const Vec<T, N>& b) {          \
+    Vec<T, N> c;                                                                \
+    for (u32 i = 0; i < N; ++i) {                                               \
+        c[i] = _vec_mask<T>(a[i] op b[i]);                                      \
+    }                                                                           \
+    return c;                                                                   \
+}
+NMS_VEC_CMP(cmpeq, ==)
+NMS_VEC_CMP(cmpne, !=)
+NMS_VEC_CMP(cmplt, < )
+NMS_VEC_CMP(cmple, <=)
+NMS_VEC_CMP(cmpgt, > )
+NMS_VEC_CMP(cmpge, >=)
+#undef  NMS_VEC_CMP
+
+/* mask ? a : b */
+template<class T, u32 N>
+__forceinline Vec<T, N> select(const Vec<T, N>& mask, const Vec<T, N>& a, const Vec<T, N>& b) {
+    Vec<T, N> c;
+    for (u32 i = 0; i < N; ++i) {
+        c[i] = _vec_bits(mask[i]) != 0 ? a[i] : b[i];
+    }
+    return c;
+}
+
+/* bit i is the sign bit of mask[i] */
+template<class T, u32 N>
+__forceinline u32 movemask(const Vec<T, N>& mask) {
+    u32 bits = 0;
+    for (u32 i = 0; i < N; ++i) {
+        bits |= u32(_vec_bits(mask[i]) >> (sizeof(T) * 8 - 1)) << i;
+    }
+    return bits;
+}
+
+template<class T, u32 N>
+__forceinline Vec<T, N> vmin(const Vec<T, N>& a, const Vec<T, N>& b) {
+    Vec<T, N> c;
+    for (u32 i = 0; i < N; ++i) {
+        c[i] = a[i] < b[i] ? a[i] : b[i];
+    }
+    return c;
+}
+
+template<class T, u32 N>
+__forceinline Vec<T, N> vmax(const Vec<T, N>& a, const Vec<T, N>& b) {
+    Vec<T, N> c;
+    for (u32 i = 0; i < N; ++i) {
+        c[i] = a[i] > b[i] ? a[i] : b[i];
+    }
+    return c;
+}
+
+/* a * b + c, fused if the target has fma */
+template<class T, u32 N>
+__forceinline Vec<T, N> vfma(const Vec<T, N>& a, const Vec<T, N>& b, const Vec<T, N>& c) {
+    Vec<T, N> d;
+    for (u32 i = 0; i < N; ++i) {
+        d[i] = a[i] * b[i] + c[i];
+    }
+    return d;
+}
+
+template<class T, u32 N>
+__forceinline Vec<T, N> vsqrt(const Vec<T, N>& a) {
+    Vec<T, N> c;
+    for (u32 i = 0; i < N; ++i) {
+        c[i] = T(::sqrt(a[i]));
+    }
+    return c;
+}
+
+/* horizontal sum */
+template<class T, u32 N>
+__forceinline T hsum(const Vec<T, N>& a) {
+    T s = a[0];
+    for (u32 i = 1; i < N; ++i) {
+        s += a[i];
+    }
+    return s;
+}
+
+/* horizontal min */
+template<class T, u32 N>
+__forceinline T hmin(const Vec<T, N>& a) {
+    T s = a[0];
+    for (u32 i = 1; i < N; ++i) {
+        s = a[i] < s ? a[i] : s;
+    }
+    return s;
+}
+
+/* horizontal max */
+template<class T, u32 N>
+__forceinline T hmax(const Vec<T, N>& a) {
+    T s = a[0];
+    for (u32 i = 1; i < N; ++i) {
+        s = a[i] > s ? a[i] : s;
+    }
+    return s;
+}
+
+template<class T, u32 N, u32 ...I>
+__forceinline Vec<T, sizeof...(I)> _shuffle(const Vec<T, N>& a, Tu32<I...>) {
+    const T vals[] = { a[I]... };
+    return Vec<T, sizeof...(I)>::loadu(vals);
+}
+
+/* shuffle<I...>(a) = { a[I]... } */
+template<u32 ...I, class T, u32 N>
+__forceinline Vec<T, sizeof...(I)> shuffle(const Vec<T, N>& a) {
+    return _shuffle(a, Tu32<I...>{});
+}
+#pragma endregion
+
 
 /* --- vec utils --- */
 template<class T, u32 N>
@@ -116,4 +300,6 @@ using i64x8 = Vec<i64, 8>; using u64x8 = Vec<u64, 8>;
 using f32x8 = Vec<f32, 8>; using f64x8 = Vec<f64, 8>;
 
 #pragma endregion
-}
\ No newline at end of file
+}
+
+#include <nms/core/simd.h>
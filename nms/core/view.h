@@ -2,6 +2,7 @@
 
 #include <nms/core/vec.h>
 #include <nms/core/trait.h>
+#include <nms/core/scan.h>
 
 namespace nms
 {
@@ -37,6 +38,17 @@ static constexpr ViewInfo mk_viewinfo() {
 }
 }
 
+/*!
+ * a view with a mask, returned by View::masked.
+ * `y.masked(mask) <<= x` assigns x(i) to y(i) only where mask(i) is true.
+ */
+template<class V, class M>
+struct ViewMasked
+{
+    V   view;
+    M   mask;
+};
+
 template<class T, u32 N>
 struct View
 {
@@ -257,6 +269,12 @@ struct View
         return { data_, new_size, new_step };
     }
 
+    /*! masked view, see ViewMasked. arrays are kept as views of their data */
+    template<class M>
+    ViewMasked<View, typename M::Tview> masked(const M& mask) const noexcept {
+        return { *this, mask };
+    }
+
 #pragma endregion
 
 #pragma region save/load
@@ -489,23 +507,13 @@ struct View<T, 0>
     /*! find */
     template<class U>
     Titr find(const U& val) {
-        for (auto itr = begin(); itr != end(); ++itr) {
-            if (*itr == val) {
-                return itr;
-            }
-        }
-        return end();
+        return const_cast<Titr>(static_cast<const View*>(this)->find(val));
     }
 
-    /*! find */
+    /*! find, bytes are scanned with simd (@see _mfind) */
     template<class U>
     Kitr find(const U& val) const {
-        for (auto itr = begin(); itr != end(); ++itr) {
-            if (*itr == val) {
-                return itr;
-            }
-        }
-        return end();
+        return _find(val, Tbool<$is<$bytewise, Tdata> && sizeof(Tdata) == 1 && $is<$bytewise, U> >{});
     }
 
     /*! replace */
@@ -561,6 +569,16 @@ struct View<T, 0>
             return na > nb ? +1 : -1;
         }
 
+        if ($is<$bytewise, Tdata>) {
+            // the first different byte is in the first different element
+            const auto pos = _mmismatch(a.data_, b.data_, u64(na) * sizeof(Tdata));
+            if (pos == u64(na) * sizeof(Tdata)) {
+                return 0;
+            }
+            const auto i = Tsize(pos / sizeof(Tdata));
+            return a[i] > b[i] ? +1 : -1;
+        }
+
         for (Tsize i = 0; i < na; ++i) {
             if (a[i] != b[i]) {
                 return a[i] > b[i] ? +1 : -1;
@@ -584,6 +602,25 @@ protected:
     Tsize   size_;
     Tsize   capacity_;
 
+    template<class U>
+    Kitr _find(const U& val, Tbool<true>) const {
+        const auto c = Tdata(val);
+        if (U(c) != val) {
+            return end();
+        }
+        return data_ + _mfind(data_, size_, u8(c));
+    }
+
+    template<class U>
+    Kitr _find(const U& val, Tbool<false>) const {
+        for (auto itr = begin(); itr != end(); ++itr) {
+            if (*itr == val) {
+                return itr;
+            }
+        }
+        return end();
+    }
+
     template<class Tidx>
     Tsize index_of(Tidx idx) const {
         return idx >= 0 ? Tsize(idx) : size_ - Tsize(0-idx);
@@ -0,0 +1,129 @@
+#include <nms/test.h>
+#include <nms/core/vlist.h>
+#include <nms/core/list.h>
+#include <nms/core/time.h>
+#include <nms/io/log.h>
+
+#include <vector>
+
+namespace nms::core
+{
+#pragma region unittest
+
+nms_test(vmem) {
+    const auto page = vpage();
+    const auto size = 256 * page;
+
+    const auto ptr = static_cast<u8*>(vnew(size));
+    test::assert_true(ptr != nullptr);
+
+    test::assert_true(vuse(ptr, 2 * page));
+    ptr[0]            = 1;
+    ptr[2 * page - 1] = 2;
+
+    test::assert_true(vuse(ptr + 100 * page, page));
+    ptr[100 * page] = 3;
+
+    vunuse(ptr, 2 * page);
+    test::assert_true(vuse(ptr, 2 * page));
+    test::assert_eq(ptr[0], u8(0));
+    test::assert_eq(ptr[100 * page], u8(3));
+
+    vdel(ptr, size);
+}
+
+nms_test(vlist) {
+    VList<u32> list(1000000);
+    test::assert_true(list.reserved() >= 1000000u);
+    test::assert_eq(list.capacity(), 0u);
+
+    list.append(0u);
+    const auto data = list.data();
+    for (u32 i = 1; i < 1000000; ++i) {
+        list.append(i);
+    }
+    test::assert_true(list.data() == data);
+    for (u32 i = 0; i < 1000000; ++i) {
+        test::assert_eq(list[i], i);
+    }
+
+    // the pages after 1000 elements are returned
+    list.resize(1000);
+    list.shrink_to_fit();
+    test::assert_true(list.capacity() < 1000u + u32(vpage() / sizeof(u32)));
+    list.appends(10, 7u);
+    test::assert_eq(list[1000], 7u);
+    test::assert_eq(list[999], 999u);
+
+    // moved: the storage is taken, the data stays in place
+    VList<u32> moved(static_cast<VList<u32>&&>(list));
+    test::assert_true(moved.data() == data);
+    test::assert_true(list.data() == nullptr);
+    test::assert_eq(moved.count(), 1010u);
+
+    // beyond the reservation
+    VList<u64> small(100);
+    small.resize(small.reserved());
+    try {
+        small.append(0ull);
+        test::assert_true(false);
+    }
+    catch (const EBadAlloc&) {
+    }
+
+    // non-pod elements
+    VList<String<> > strs(1000);
+    for (u32 i = 0; i < 1000; ++i) {
+        String<> s;
+        sformat(s, "str{}", i);
+        strs.append(static_cast<String<>&&>(s));
+    }
+    test::assert_eq(strs[999], String<>("str999"));
+}
+
+/* grow a 16MB buffer by 64KB appends: small enough to run in the default suite */
+nms_test(vlist_perf) {
+    static const u32 block = 64 * 1024;
+    static const u32 count = 256;
+
+    List<u8> src(block);
+    for (u32 i = 0; i < block; ++i) {
+        src[i] = u8(i);
+    }
+
+    auto run = [&](auto&& append) {
+        const auto t0 = nms::clock();
+        for (u32 i = 0; i < count; ++i) {
+            append(src.data());
+        }
+        return nms::clock() - t0;
+    };
+
+    f64 tv = 0;
+    {
+        VList<u8> list(block * count);
+        tv = run([&](const u8* dat) { list.appends(dat, block); });
+    }
+    f64 th = 0;
+    {
+        VList<u8> list(block * count, true);
+        th = run([&](const u8* dat) { list.appends(dat, block); });
+    }
+    f64 tl = 0;
+    {
+        List<u8> list;
+        tl = run([&](const u8* dat) { list.appends(dat, block); });
+    }
+    f64 ts = 0;
+    {
+        std::vector<u8> vec;
+        ts = run([&](const u8* dat) { vec.insert(vec.end(), dat, dat + block); });
+    }
+
+    io::log::info("nms.VList: grow to {}MB: VList={.3}ms, VList(huge)={.3}ms, List={.3}ms, std::vector={.3}ms",
+        u64(block) * count >> 20, tv*1e3, th*1e3, tl*1e3, ts*1e3);
+}
+
+#pragma endregion
+
+}
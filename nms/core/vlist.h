@@ -0,0 +1,236 @@
+#pragma once
+
+#include <nms/core/view.h>
+#include <nms/core/memory.h>
+#include <nms/core/exception.h>
+
+namespace nms
+{
+
+template<class T>
+class VList;
+
+/* VList<T> only holds a pointer to its reservation, it can be moved with memcpy */
+template<class T>
+struct Is<$relocatable, VList<T> > { static constexpr auto $value = true; };
+
+/*!
+ * a list in a reserved range of virtual memory.
+ * the address space of max_count elements is reserved up front, and pages are
+ * committed as the list grows: the elements are never copied, and pointers
+ * to them stay valid until the list is destroyed.
+ * growing beyond max_count throws EBadAlloc.
+ */
+template<class T>
+class VList: public View<T>
+{
+public:
+    using base  = View<T>;
+    using Tdata = typename base::Tdata;
+    using Tsize = typename base::Tsize;
+
+    static constexpr u64 $commit_min = 64 * 1024;           // 64KB
+    static constexpr u64 $commit_max = 64 * 1024 * 1024;    // 64MB
+
+#pragma region constructor
+    constexpr VList() noexcept
+    {}
+
+    /*!
+     * reserve the address space of max_count elements.
+     * huge_pages: ask for transparent huge pages (linux), for multi-MB lists.
+     */
+    explicit VList(Tsize max_count, bool huge_pages = false)
+        : bytes_(_round(u64(max_count) * sizeof(Tdata))) {
+        if (bytes_ == 0) {
+            return;
+        }
+        data_ = static_cast<Tdata*>(vnew(bytes_));
+        if (data_ == nullptr) {
+            bytes_ = 0;
+            NMS_THROW(EBadAlloc{});
+        }
+        if (huge_pages) {
+            vhuge(data_, bytes_);
+        }
+    }
+
+    ~VList() {
+        if (data_ == nullptr) {
+            return;
+        }
+        clear();
+        vdel(data_, bytes_);
+        data_     = nullptr;
+        capacity_ = 0;
+        bytes_    = 0;
+    }
+
+    VList(VList&& rhs) noexcept
+        : base(rhs), bytes_(rhs.bytes_) {
+        rhs.data_     = nullptr;
+        rhs.size_     = 0;
+        rhs.capacity_ = 0;
+        rhs.bytes_    = 0;
+    }
+
+    VList& operator=(VList&& rhs) noexcept {
+        if (this != &rhs) {
+            this->~VList();
+            new(this)VList(static_cast<VList&&>(rhs));
+        }
+        return *this;
+    }
+
+    VList(const VList&)            = delete;
+    VList& operator=(const VList&) = delete;
+
+    operator View<const Tdata>() const noexcept {
+        return { data_, size_ };
+    }
+#pragma endregion
+
+#pragma region property
+    using base::data;
+    using base::size;
+    using base::count;
+
+    /* the number of elements that fit in the committed pages */
+    Tsize capacity() const noexcept {
+        return capacity_;
+    }
+
+    /* the number of elements that fit in the reservation */
+    Tsize reserved() const noexcept {
+        const auto cnt = bytes_ / sizeof(Tdata);
+        return cnt > Tsize(-1) ? Tsize(-1) : Tsize(cnt);
+    }
+#pragma endregion
+
+#pragma region method
+    /*!
+     * commit the pages of at least newcnt elements.
+     * the committed size doubles from 64KB, then grows by 64MB steps.
+     */
+    VList& reserve(Tsize newcnt) {
+        if (newcnt <= capacity_) {
+            return *this;
+        }
+        const auto oldbytes = _round(u64(capacity_) * sizeof(Tdata));
+        if (u64(newcnt) * sizeof(Tdata) > bytes_) {
+            NMS_THROW(EBadAlloc{});
+        }
+
+        auto step = oldbytes < $commit_min ? $commit_min : oldbytes > $commit_max ? $commit_max : oldbytes;
+        auto newbytes = _round(u64(newcnt) * sizeof(Tdata));
+        if (newbytes < oldbytes + step) {
+            newbytes = oldbytes + step;
+        }
+        if (newbytes > bytes_) {
+            newbytes = bytes_;
+        }
+
+        const auto ptr = reinterpret_cast<u8*>(data_) + oldbytes;
+        if (!vuse(ptr, newbytes - oldbytes)) {
+            NMS_THROW(EBadAlloc{});
+        }
+        const auto newcap = newbytes / sizeof(Tdata);
+        capacity_ = newcap > Tsize(-1) ? Tsize(-1) : Tsize(newcap);
+        return *this;
+    }
+
+    /*! return the pages after the last element to the OS */
+    VList& shrink_to_fit() {
+        const auto keep = _round(u64(size_) * sizeof(Tdata));
+        const auto used = _round(u64(capacity_) * sizeof(Tdata));
+        if (keep < used) {
+            vunuse(reinterpret_cast<u8*>(data_) + keep, used - keep);
+            capacity_ = Tsize(keep / sizeof(Tdata));
+        }
+        return *this;
+    }
+
+    template<class Isize>
+    void resize(Isize newsize) {
+        static_assert($is<$pod, Tdata>, "nms.VList.resize: Tdata shold be POD type");
+        reserve(Tsize(newsize));
+        size_ = Tsize(newsize);
+    }
+
+    void clear() {
+        for (Tsize i = 0; i < size_; ++i) {
+            data_[i].~Tdata();
+        }
+        size_ = 0;
+    }
+#pragma endregion
+
+#pragma region append
+    /*! append elements to the end */
+    template<class ...U>
+    VList& append(U&& ...u) {
+        reserve(size_ + 1);
+        new(&data_[size_]) Tdata(fwd<U>(u)...);
+        size_ = size_ + 1;
+        return *this;
+    }
+
+    /*! append elements to the end */
+    template<class ...U>
+    VList& appends(Tsize cnt, U&& ...u) {
+        reserve(size_ + cnt);
+        for (Tsize i = 0; i < cnt; ++i) {
+            new(&data_[size_++])Tdata(fwd<U>(u)...);
+        }
+        return *this;
+    }
+
+    /*! append(copy) elements to the end */
+    template<class U>
+    VList& appends(const U dat[], Tsize cnt) {
+        reserve(size_ + cnt);
+        if ($is<$pod, Tdata> && $is<Tdata, U>) {
+            _mcpy(data_ + size_, dat, cnt * sizeof(Tdata));
+            size_ += cnt;
+            return *this;
+        }
+        for (Tsize i = 0; i < cnt; ++i) {
+            new(&data_[size_++])Tdata(dat[i]);
+        }
+        return *this;
+    }
+
+    template<class U, class = $when_as<Tdata, U> >
+    VList& operator+=(const View<const U>& rhs) {
+        appends(rhs.data(), rhs.count());
+        return *this;
+    }
+
+    template<class U, class = $when_as<Tdata, U> >
+    VList& operator+=(const View<U>& rhs) {
+        appends(rhs.data(), rhs.count());
+        return *this;
+    }
+
+    template<class U, class=$when_as<Tdata, U> >
+    VList& operator+= (U&& u) {
+        append(fwd<U>(u));
+        return *this;
+    }
+#pragma endregion
+
+protected:
+    using   base::data_;
+    using   base::size_;
+    using   base::capacity_;
+
+    u64     bytes_ = 0;     // size of the reservation
+
+    /* round up to the page size */
+    static u64 _round(u64 bytes) {
+        const auto page = vpage();
+        return (bytes + page - 1) / page * page;
+    }
+};
+
+}
@@ -119,7 +119,7 @@ struct Parallel<Tfunc, A>
     constexpr        u32 size(u32 i) const  { return a.size(i); }
 
     template<class ...I>
-    auto operator()(I ...idx) const -> decltype(f(a(idx...))) {
+    auto operator()(I ...idx) const -> decltype(Tfunc::run(a(idx...))) {
         return Tfunc::run(a(idx...));
     }
 };
@@ -134,12 +134,28 @@ struct Parallel<Tfunc, A, B>
     constexpr        u32 size(u32 i) const  { return max(a.size(i), b.size(i)); }
 
     template<class ...I>
-    auto operator()(I ...idx) const noexcept->decltype(f(a(idx...), b(idx...))) {
+    auto operator()(I ...idx) const noexcept->decltype(Tfunc::run(a(idx...), b(idx...))) {
         return Tfunc::run(a(idx...), b(idx...));
     }
 
 };
 
+template<class Tfunc, class A, class B, class C>
+struct Parallel<Tfunc, A, B, C>
+{
+    A   a;
+    B   b;
+    C   c;
+
+    static constexpr u32 rank()             { return max(A::rank(), B::rank(), C::rank()); }
+    constexpr        u32 size(u32 i) const  { return max(a.size(i), b.size(i), c.size(i)); }
+
+    template<class ...I>
+    auto operator()(I ...idx) const noexcept->decltype(Tfunc::run(a(idx...), b(idx...), c(idx...))) {
+        return Tfunc::run(a(idx...), b(idx...), c(idx...));
+    }
+};
+
 template<class Tfunc, class ...Ts>
 struct Reduce;
 
@@ -226,6 +242,11 @@ struct Gt  { template<class A, class B> __device__ static bool run(A a, B b) noe
 struct Le  { template<class A, class B> __device__ static bool run(A a, B b) noexcept { return a <= b; } };
 struct Ge  { template<class A, class B> __device__ static bool run(A a, B b) noexcept { return a >= b; } };
 
+// where, clamp, fma: both sides are evaluated, the select is a predicated instruction (selp)
+struct Where { template<class M, class A, class B> __device__ static auto run(M m, A a, B b) noexcept ->decltype(a+b) { return m ? a : b; } };
+struct Clamp { template<class T, class L, class H> __device__ static T run(T t, L lo, H hi) noexcept { const T x = t < lo ? T(lo) : t; return hi < x ? T(hi) : x; } };
+struct Fma   { template<class A, class B, class C> __device__ static auto run(A a, B b, C c) noexcept ->decltype(a*b+c) { return fma(a, b, c); } };
+
 // sum,min,max
 struct Min { template<class T> __device__ static T run(const T& a, const T& b) noexcept { return a <= b ? a : b; }   };
 struct Max { template<class T> __device__ static T run(const T& a, const T& b) noexcept { return a >= b ? a : b; }   };
@@ -300,7 +321,7 @@ __device__ void foreach_switch(Tret& ret, const Targ& arg, Tver<1>) {
 
     if (x >= ret.size(0)) return;
 
-    Tfunc::run(ret(x), (x));
+    Tfunc::run(ret(x), arg(x));
 }
 
 template<class Tfunc, class Tret, class Targ>
@@ -3,6 +3,21 @@
 #include <nms/io/file.h>
 #include <nms/io/log.h>
 
+#ifdef NMS_OS_WINDOWS
+extern "C"
+{
+    struct _Overlapped
+    {
+        nms::u64    internal;
+        nms::u64    internal_high;
+        nms::u32    offset;
+        nms::u32    offset_high;
+        void*       event;
+    };
+    int WriteFile(void* handle, const void* buff, nms::u32 size, nms::u32* written, _Overlapped* overlapped);
+}
+#endif
+
 namespace nms::io
 {
 
@@ -50,6 +65,58 @@ NMS_API int File::id() const {
     return fid;
 }
 
+NMS_API u64 File::tell() const {
+    if (impl_ == nullptr) {
+        return 0;
+    }
+#ifdef NMS_OS_WINDOWS
+    const auto pos = ::_ftelli64(impl_);
+#else
+    const auto pos = ::ftello(impl_);
+#endif
+    return pos < 0 ? 0 : u64(pos);
+}
+
+NMS_API void File::seek(u64 offset) {
+    if (impl_ == nullptr) {
+        return;
+    }
+#ifdef NMS_OS_WINDOWS
+    ::_fseeki64(impl_, i64(offset), SEEK_SET);
+#else
+    ::fseeko(impl_, off_t(offset), SEEK_SET);
+#endif
+}
+
+NMS_API u64 File::writeAt(const void* dat, u64 size, u64 offset) const {
+    if (impl_ == nullptr || size == 0) {
+        return 0;
+    }
+
+    auto ptr = static_cast<const u8*>(dat);
+    u64  ret = 0;
+    while (ret < size) {
+#ifdef NMS_OS_WINDOWS
+        const auto len = u32(size - ret < 0x40000000u ? size - ret : 0x40000000u);
+        const auto pos = offset + ret;
+        _Overlapped ov = {};
+        ov.offset      = u32(pos);
+        ov.offset_high = u32(pos >> 32);
+        u32 cnt = 0;
+        if (::WriteFile(reinterpret_cast<void*>(::_get_osfhandle(id())), ptr + ret, len, &cnt, &ov) == 0) {
+            break;
+        }
+#else
+        const auto cnt = ::pwrite(id(), ptr + ret, size - ret, off_t(offset + ret));
+        if (cnt <= 0) {
+            break;
+        }
+#endif
+        ret += u64(cnt);
+    }
+    return ret;
+}
+
 NMS_API u64 File::size() const {
     if (impl_ == nullptr) {
         return 0;
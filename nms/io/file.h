@@ -83,6 +83,12 @@ public:
     /*! get virtual-file-system integer descriptor */
     NMS_API int id()   const;
 
+    /*! get the stream position in bytes */
+    NMS_API u64 tell() const;
+
+    /*! set the stream position in bytes */
+    NMS_API void seek(u64 offset);
+
 #pragma region read/write
 
 #pragma region raw
@@ -108,6 +114,12 @@ public:
         return writeRaw(buff, 1, size);
     }
 
+    /*!
+     * write @size bytes at byte @offset, the stream position is not changed.
+     * safe to call from several threads at once (pwrite), flush() buffered writes first.
+     */
+    NMS_API u64 writeAt(const void* buff, u64 size, u64 offset) const;
+
 #pragma endregion
 
 #pragma region array/vec
@@ -2,9 +2,14 @@
 
 #include <nms/math/base.h>
 #include <nms/math/array.h>
+#include <nms/math/batch.h>
+#include <nms/math/complex.h>
+#include <nms/math/linalg.h>
 
 #include <nms/math/view.h>
 #include <nms/math/vrun.h>
+#include <nms/math/bits.h>
+#include <nms/math/csv.h>
 
 namespace nms
 {
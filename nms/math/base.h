@@ -99,14 +99,73 @@ struct Max
 #pragma region logic
 struct Eq  { template<class X, class Y> __forceinline static auto run(X x, Y y) noexcept { return x == y; } };
 struct Neq { template<class X, class Y> __forceinline static auto run(X x, Y y) noexcept { return x != y; } };
-struct Lt  { template<class X, class Y> __forceinline static auto run(X x, Y y) noexcept { return x <  y; } };
-struct Gt  { template<class X, class Y> __forceinline static auto run(X x, Y y) noexcept { return x >  y; } };
-struct Le  { template<class X, class Y> __forceinline static auto run(X x, Y y) noexcept { return x <= y; } };
-struct Ge  { template<class X, class Y> __forceinline static auto run(X x, Y y) noexcept { return x >= y; } };
+
+// Vec elements compare to a lane mask (see cmplt), which Where consumes with select
+#define NMS_MATH_CMP(name, op, cmp)                                                                                     \
+struct name {                                                                                                           \
+    template<class X, class Y>  __forceinline static auto run(X x, Y y) noexcept { return x op y; }                     \
+    template<class T, u32 N>    __forceinline static auto run(const Vec<T, N>& x, const Vec<T, N>& y) noexcept { return cmp(x, y); } \
+};
+NMS_MATH_CMP(Lt, < , cmplt)
+NMS_MATH_CMP(Gt, > , cmpgt)
+NMS_MATH_CMP(Le, <=, cmple)
+NMS_MATH_CMP(Ge, >=, cmpge)
+#undef NMS_MATH_CMP
+
 struct And { template<class X, class Y> __forceinline static auto run(X x, Y y) noexcept { return x && y; } };
 struct Or  { template<class X, class Y> __forceinline static auto run(X x, Y y) noexcept { return x || y; } };
 #pragma endregion
 
+#pragma region conditional
+/*
+ * the conditionals evaluate both sides and select, without branches:
+ * the loops compile to compare + blend, Vec elements use select/vmin/vmax.
+ */
+
+// [where](mask, x, y) = mask ? x : y
+struct Where
+{
+    template<class M, class X, class Y>
+    __forceinline static auto run(M m, X x, Y y) noexcept {
+        return m ? x : y;
+    }
+
+    template<class T, u32 N>
+    __forceinline static auto run(const Vec<T, N>& m, const Vec<T, N>& x, const Vec<T, N>& y) noexcept {
+        return select(m, x, y);
+    }
+};
+
+// [clamp](x, lo, hi) = min(max(x, lo), hi)
+struct Clamp
+{
+    template<class X, class L, class H>
+    __forceinline static auto run(X x, L lo, H hi) noexcept {
+        const X t = x < lo ? X(lo) : x;
+        return hi < t ? X(hi) : t;
+    }
+
+    template<class T, u32 N>
+    __forceinline static auto run(const Vec<T, N>& x, const Vec<T, N>& lo, const Vec<T, N>& hi) noexcept {
+        return nms::vmin(nms::vmax(x, lo), hi);
+    }
+};
+
+// [fma](a, b, c) = a * b + c
+struct Fma
+{
+    template<class A, class B, class C>
+    __forceinline static auto run(A a, B b, C c) noexcept {
+        return a * b + c;
+    }
+
+    template<class T, u32 N>
+    __forceinline static auto run(const Vec<T, N>& a, const Vec<T, N>& b, const Vec<T, N>& c) noexcept {
+        return nms::vfma(a, b, c);
+    }
+};
+#pragma endregion
+
 struct Pos { template<class T> __forceinline static auto run(T t) noexcept { return +t; } };
 struct Neg { template<class T> __forceinline static auto run(T t) noexcept { return -t; } };
 struct Abs { template<class T> __forceinline static auto run(T t) noexcept { return t >= 0 ? +t : -t; } };
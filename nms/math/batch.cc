@@ -0,0 +1,203 @@
+#include <nms/test.h>
+#include <nms/math.h>
+#include <nms/io.h>
+
+namespace nms::math
+{
+
+template<class T, u32 M, u32 N>
+static Mat<T, M, N> _batch_test_mat(u32 idx) {
+    Mat<T, M, N> m;
+    for (u32 i = 0; i < M; ++i) {
+        for (u32 j = 0; j < N; ++j) {
+            // diagonal dominant, so the matrix is invertible
+            m[i][j] = i == j ? T(M + 1 + idx % 7) : T((idx + 3 * i + 5 * j) % 11) / T(11);
+        }
+    }
+    return m;
+}
+
+nms_test(batch_aos) {
+    const u32 count = 37;
+
+    Array<Vec<f32, 3>, 1> aos({ count });
+    for (u32 i = 0; i < count; ++i) {
+        aos(i) = Vec<f32, 3>{ f32(i), f32(i) + 0.5f, f32(i) * 2 };
+    }
+
+    Batch<f32, 3> soa(aos);
+    test::assert_eq(soa.count(), count);
+    test::assert_eq(soa.stride() % Batch<f32, 3>::$lanes, 0u);
+
+    for (u32 i = 0; i < count; ++i) {
+        test::assert_eq(soa(i, 1), f32(i) + 0.5f);
+        test::assert_eq(soa[2](i), f32(i) * 2);
+    }
+
+    auto out = soa.toAos();
+    for (u32 i = 0; i < count; ++i) {
+        test::assert_eq(out(i), aos(i));
+    }
+}
+
+nms_test(batch_matmul) {
+    const u32 count = 21;
+
+    Batch<f64, 3, 3> a(count);
+    Batch<f64, 3, 3> b(count);
+    Batch<f64, 3, 3> c;
+    for (u32 x = 0; x < count; ++x) {
+        a.set(x, _batch_test_mat<f64, 3, 3>(x));
+        b.set(x, _batch_test_mat<f64, 3, 3>(x + 1));
+    }
+    bmatmul(c, a, b);
+    test::assert_eq(c.count(), count);
+
+    for (u32 x = 0; x < count; ++x) {
+        const auto ma = a.get(x);
+        const auto mb = b.get(x);
+        const auto mc = c.get(x);
+        for (u32 i = 0; i < 3; ++i) {
+            for (u32 j = 0; j < 3; ++j) {
+                f64 s = 0;
+                for (u32 k = 0; k < 3; ++k) {
+                    s += ma[i][k] * mb[k][j];
+                }
+                test::assert_eq(mc[i][j], s);
+            }
+        }
+    }
+}
+
+template<u32 N>
+static void _batch_test_inv() {
+    const u32 count = 19;
+
+    Batch<f64, N, N> a(count);
+    Batch<f64, N, N> b;
+    Batch<f64, N, N> c;
+    Batch<f64, 1>    d;
+    for (u32 x = 0; x < count; ++x) {
+        a.set(x, _batch_test_mat<f64, N, N>(x));
+    }
+
+    binv(b, a);
+    bmatmul(c, a, b);
+    bdet(d, c);
+
+    for (u32 x = 0; x < count; ++x) {
+        for (u32 i = 0; i < N; ++i) {
+            for (u32 j = 0; j < N; ++j) {
+                const auto v = c(x, i, j);
+                test::assert_true(fabs(v - (i == j ? 1.0 : 0.0)) < 1e-9);
+            }
+        }
+        test::assert_true(fabs(d(x, 0) - 1.0) < 1e-9);
+    }
+}
+
+nms_test(batch_inv) {
+    _batch_test_inv<2>();
+    _batch_test_inv<3>();
+    _batch_test_inv<4>();
+}
+
+nms_test(batch_vec) {
+    const u32 count = 45;
+
+    Batch<f32, 3> a(count);
+    Batch<f32, 3> b(count);
+    Batch<f32, 4> q(count);
+    for (u32 x = 0; x < count; ++x) {
+        a.set(x, { 1.0f + x, 2.0f, 3.0f });
+        b.set(x, { 0.5f, 1.0f * x, -1.0f });
+
+        // rotate 90 degrees around z
+        q.set(x, { 0.0f, 0.0f, f32(sqrt(0.5)), f32(sqrt(0.5)) });
+    }
+
+    Batch<f32, 1> d;
+    Batch<f32, 3> c;
+    Batch<f32, 3> n;
+    Batch<f32, 3> r;
+    bdot(d, a, b);
+    bcross(c, a, b);
+    bnormalize(n, a);
+    brotate(r, q, a);
+
+    for (u32 x = 0; x < count; ++x) {
+        const auto va = a.get(x);
+        const auto vb = b.get(x);
+
+        test::assert_eq(d(x, 0), va[0] * vb[0] + va[1] * vb[1] + va[2] * vb[2]);
+
+        test::assert_eq(c(x, 0), va[1] * vb[2] - va[2] * vb[1]);
+        test::assert_eq(c(x, 1), va[2] * vb[0] - va[0] * vb[2]);
+        test::assert_eq(c(x, 2), va[0] * vb[1] - va[1] * vb[0]);
+
+        const auto l = n(x, 0) * n(x, 0) + n(x, 1) * n(x, 1) + n(x, 2) * n(x, 2);
+        test::assert_true(fabs(l - 1.0f) < 1e-5f);
+
+        test::assert_true(fabs(r(x, 0) + va[1]) < 1e-4f);
+        test::assert_true(fabs(r(x, 1) - va[0]) < 1e-4f);
+        test::assert_true(fabs(r(x, 2) - va[2]) < 1e-4f);
+    }
+}
+
+nms_test(batch_perf) {
+    // cache resident (3 x 288KB), so the kernels are timed instead of the memory bus
+    const u32 count  = 8 * 1024;
+    const u32 passes = 64;
+
+    Array<Mat<f32, 3, 3>, 1> aos_a({ count });
+    Array<Mat<f32, 3, 3>, 1> aos_b({ count });
+    Array<Mat<f32, 3, 3>, 1> aos_c({ count });
+    for (u32 x = 0; x < count; ++x) {
+        aos_a(x) = _batch_test_mat<f32, 3, 3>(x);
+        aos_b(x) = _batch_test_mat<f32, 3, 3>(x + 1);
+    }
+
+    Batch<f32, 3, 3> a(aos_a);
+    Batch<f32, 3, 3> b(aos_b);
+    Batch<f32, 3, 3> c(count);
+
+    auto aos_time = 1e9;
+    auto soa_time = 1e9;
+    for (auto loop = 0; loop < 5; ++loop) {
+        const auto t0 = nms::clock();
+        for (u32 pass = 0; pass < passes; ++pass) {
+            for (u32 x = 0; x < count; ++x) {
+                const auto& ma = aos_a(x);
+                const auto& mb = aos_b(x);
+                auto&       mc = aos_c(x);
+                for (u32 i = 0; i < 3; ++i) {
+                    for (u32 j = 0; j < 3; ++j) {
+                        mc[i][j] = ma[i][0] * mb[0][j] + ma[i][1] * mb[1][j] + ma[i][2] * mb[2][j];
+                    }
+                }
+            }
+        }
+        const auto t1 = nms::clock();
+        for (u32 pass = 0; pass < passes; ++pass) {
+            bmatmul(c, a, b);
+        }
+        const auto t2 = nms::clock();
+
+        aos_time = nms::min(aos_time, t1 - t0);
+        soa_time = nms::min(soa_time, t2 - t1);
+    }
+
+    for (u32 x = 0; x < count; x += 997) {
+        const auto mc = c.get(x);
+        for (u32 i = 0; i < 3; ++i) {
+            for (u32 j = 0; j < 3; ++j) {
+                test::assert_eq(mc[i][j], aos_c(x)[i][j]);
+            }
+        }
+    }
+
+    io::log::info("nms.math.batch: matmul3x3 x {} x {} passes, best of 5: aos {.3}ms, soa {.3}ms ({.2}x)",
+        count, passes, aos_time * 1000, soa_time * 1000, aos_time / soa_time);
+}
+
+}
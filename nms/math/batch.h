@@ -0,0 +1,668 @@
+#pragma once
+
+#include <nms/math/base.h>
+#include <nms/math/array.h>
+
+namespace nms::math
+{
+
+/* small fixed-size matrix (row-major): M rows of Vec<T, N> */
+template<class T, u32 M, u32 N>
+using Mat = Vec<Vec<T, N>, M>;
+
+template<class T, u32 ...Ns>
+struct _BatchElem;
+
+template<class T, u32 N>
+struct _BatchElem<T, N>     { using U = Vec<T, N>;    };
+
+template<class T, u32 M, u32 N>
+struct _BatchElem<T, M, N>  { using U = Mat<T, M, N>; };
+
+/*!
+ * one block of instances (64 bytes: 16 x f32 or 8 x f64).
+ * Lanes<f32>/Lanes<f64> are two 256 bit Vec registers (f32x8/f64x4, @see simd.h):
+ * AVX registers if the build targets AVX, else pairs of SSE registers (4 x f32 or 2 x f64 per instruction).
+ * other types are fixed trip count loops over the lanes.
+ */
+template<class T>
+struct alignas(64) Lanes
+{
+    static constexpr u32 $count = 64 / sizeof(T);
+
+    T v[$count];
+
+    __forceinline Lanes& operator+=(const Lanes& rhs) noexcept {
+        return *this = *this + rhs;
+    }
+};
+
+#define NMS_LANES_OP(op)                                                                \
+template<class T>                                                                       \
+__forceinline Lanes<T> operator op(const Lanes<T>& a, const Lanes<T>& b) noexcept {     \
+    Lanes<T> r;                                                                         \
+    for (u32 l = 0; l < Lanes<T>::$count; ++l) r.v[l] = a.v[l] op b.v[l];               \
+    return r;                                                                           \
+}                                                                                       \
+template<class T>                                                                       \
+__forceinline Lanes<T> operator op(const Lanes<T>& a, T b) noexcept {                   \
+    Lanes<T> r;                                                                         \
+    for (u32 l = 0; l < Lanes<T>::$count; ++l) r.v[l] = a.v[l] op b;                    \
+    return r;                                                                           \
+}                                                                                       \
+template<class T>                                                                       \
+__forceinline Lanes<T> operator op(T a, const Lanes<T>& b) noexcept {                   \
+    Lanes<T> r;                                                                         \
+    for (u32 l = 0; l < Lanes<T>::$count; ++l) r.v[l] = a op b.v[l];                    \
+    return r;                                                                           \
+}
+NMS_LANES_OP(+)
+NMS_LANES_OP(-)
+NMS_LANES_OP(*)
+NMS_LANES_OP(/)
+#undef NMS_LANES_OP
+
+template<class T>
+__forceinline Lanes<T> operator-(const Lanes<T>& a) noexcept {
+    Lanes<T> r;
+    for (u32 l = 0; l < Lanes<T>::$count; ++l) r.v[l] = -a.v[l];
+    return r;
+}
+
+/* 1/sqrt(a), 0 if a <= 0 */
+template<class T>
+__forceinline Lanes<T> rsqrt(const Lanes<T>& a) noexcept {
+    Lanes<T> r;
+    for (u32 l = 0; l < Lanes<T>::$count; ++l) r.v[l] = a.v[l] > T(0) ? T(1) / sqrt(a.v[l]) : T(0);
+    return r;
+}
+
+#ifdef NMS_SIMD_SSE2
+/* the registers of Lanes<T>: two 256 bit Vec */
+template<class T> struct _LanesSimd;
+template<> struct _LanesSimd<f32> : _Simd<f32, 8> {};
+template<> struct _LanesSimd<f64> : _Simd<f64, 4> {};
+
+template<class T, class F>
+__forceinline Lanes<T> _lanes_simd(const Lanes<T>& a, const Lanes<T>& b, F f) noexcept {
+    using S = _LanesSimd<T>;
+    static constexpr u32 $half = Lanes<T>::$count / 2;
+
+    Lanes<T> r;
+    S::storeu(r.v,         f(S::loadu(a.v),         S::loadu(b.v)));
+    S::storeu(r.v + $half, f(S::loadu(a.v + $half), S::loadu(b.v + $half)));
+    return r;
+}
+
+template<class T, class F>
+__forceinline Lanes<T> _lanes_simd(const Lanes<T>& a, T b, F f) noexcept {
+    using S = _LanesSimd<T>;
+    static constexpr u32 $half = Lanes<T>::$count / 2;
+
+    const auto k = S::loadu(Vec<T, $half>(b).data);
+    Lanes<T> r;
+    S::storeu(r.v,         f(S::loadu(a.v),         k));
+    S::storeu(r.v + $half, f(S::loadu(a.v + $half), k));
+    return r;
+}
+
+#define NMS_LANES_SIMD_OP(T, op, fn)                                                    \
+__forceinline Lanes<T> operator op(const Lanes<T>& a, const Lanes<T>& b) noexcept {     \
+    return _lanes_simd(a, b, [](auto x, auto y) { return _LanesSimd<T>::fn(x, y); });   \
+}                                                                                       \
+__forceinline Lanes<T> operator op(const Lanes<T>& a, T b) noexcept {                   \
+    return _lanes_simd(a, b, [](auto x, auto y) { return _LanesSimd<T>::fn(x, y); });   \
+}                                                                                       \
+__forceinline Lanes<T> operator op(T a, const Lanes<T>& b) noexcept {                   \
+    return _lanes_simd(b, a, [](auto x, auto y) { return _LanesSimd<T>::fn(y, x); });   \
+}
+
+#define NMS_LANES_SIMD(T)                                                               \
+NMS_LANES_SIMD_OP(T, +, add)                                                            \
+NMS_LANES_SIMD_OP(T, -, sub)                                                            \
+NMS_LANES_SIMD_OP(T, *, mul)                                                            \
+NMS_LANES_SIMD_OP(T, /, div)                                                            \
+__forceinline Lanes<T> operator-(const Lanes<T>& a) noexcept {                          \
+    return a * T(-1);                                                                   \
+}                                                                                       \
+__forceinline Lanes<T> rsqrt(const Lanes<T>& a) noexcept {                              \
+    using S = _LanesSimd<T>;                                                            \
+    return _lanes_simd(a, T(1), [](auto x, auto one) {                                  \
+        const auto zero = S::sub(one, one);                                             \
+        return S::select(S::cmpgt(x, zero), S::div(one, S::sqrt(x)), zero);             \
+    });                                                                                 \
+}
+
+NMS_LANES_SIMD(f32)
+NMS_LANES_SIMD(f64)
+
+#undef NMS_LANES_SIMD
+#undef NMS_LANES_SIMD_OP
+#endif
+
+template<class T> struct _BatchLanes            { using U = Lanes<T>;       };
+template<class T> struct _BatchLanes<const T>   { using U = const Lanes<T>; };
+
+/*!
+ * reference to one block of Lanes<T>::$count instances of a Batch.
+ * cheap to pass by value, so the plane pointers stay in registers.
+ */
+template<class T, u32 ...Ns>
+struct BatchRef
+{
+    using Tlanes = typename _BatchLanes<T>::U;
+
+    T*  data_;
+    u32 stride_;
+
+    /* access component ids... of the block */
+    template<class ...I>
+    __forceinline Tlanes& operator()(I ...ids) const noexcept {
+        return *reinterpret_cast<Tlanes*>(data_ + _plane_of(ids...) * stride_);
+    }
+
+    /* reference to the block starting at instance idx */
+    __forceinline BatchRef block(u32 idx) const noexcept {
+        return { data_ + idx, stride_ };
+    }
+
+    template<class ...I>
+    static constexpr u32 _plane_of(I ...ids) noexcept {
+        static_assert(sizeof...(I) == sizeof...(Ns), "nms.math.Batch: unexpect arguments count");
+        const u32 dims[] = { Ns... };
+        const u32 idxs[] = { u32(ids)... };
+
+        u32 k = 0;
+        for (u32 d = 0; d < sizeof...(I); ++d) {
+            k = k * dims[d] + idxs[d];
+        }
+        return k;
+    }
+};
+
+/*!
+ * batch of small fixed-size objects in SoA layout.
+ *
+ * Batch<T, N>    : count x Vec<T, N>,      component (i)    is stored in plane i
+ * Batch<T, M, N> : count x Mat<T, M, N>,   component (i, j) is stored in plane i*N+j
+ *
+ * every plane is contiguous and padded to $lanes elements, so the batch kernels
+ * below process one block of Lanes<T> per step, without tail loops.
+ *
+ * the kernels resize their output, a resize discards its contents.
+ */
+template<class T, u32 ...Ns>
+class Batch
+{
+public:
+    using Tdata = T;
+    using Tsize = u32;
+    using Telem = typename _BatchElem<T, Ns...>::U;
+    using Tref  = BatchRef<T, Ns...>;
+
+    static constexpr u32 $lanes  = Lanes<T>::$count;
+    static constexpr u32 $planes = Tmul<u32, Ns...>::$value;
+
+#pragma region constructors
+    /* default constructor */
+    constexpr Batch() noexcept
+        : data_(nullptr), count_(0), stride_(0)
+    {}
+
+    /* construct a batch with count instances (zero initialized) */
+    explicit Batch(Tsize count)
+        : Batch{} {
+        resize(count);
+    }
+
+    /* construct from AoS elements */
+    explicit Batch(const View<const Telem, 1>& aos)
+        : Batch{ aos.count() } {
+        fromAos(aos);
+    }
+
+    /* destructor */
+    ~Batch() {
+        clear();
+    }
+
+    /* move constructor */
+    Batch(Batch&& rhs) noexcept
+        : data_(rhs.data_), count_(rhs.count_), stride_(rhs.stride_) {
+        rhs.data_   = nullptr;
+        rhs.count_  = 0;
+        rhs.stride_ = 0;
+    }
+
+    /* move assign operator */
+    Batch& operator=(Batch&& rhs) noexcept {
+        if (this != &rhs) {
+            clear();
+            nms::swap(data_,   rhs.data_);
+            nms::swap(count_,  rhs.count_);
+            nms::swap(stride_, rhs.stride_);
+        }
+        return *this;
+    }
+
+    /* copy is disabled, use dup() */
+    Batch(const Batch&)             = delete;
+    Batch& operator=(const Batch&)  = delete;
+
+    /* get copies */
+    Batch dup() const {
+        Batch tmp(count_);
+        if (data_ != nullptr) {
+            _mcpy(tmp.data_, data_, u64($planes) * stride_ * sizeof(T));
+        }
+        return tmp;
+    }
+#pragma endregion
+
+#pragma region properties
+    /* get instances count */
+    Tsize count() const noexcept {
+        return count_;
+    }
+
+    /* get plane stride (count padded to $lanes) */
+    Tsize stride() const noexcept {
+        return stride_;
+    }
+
+    /* get plane data */
+    T* plane(u32 k) noexcept {
+        return data_ + k * stride_;
+    }
+
+    /* get plane data */
+    const T* plane(u32 k) const noexcept {
+        return data_ + k * stride_;
+    }
+
+    /* get plane reference */
+    BatchRef<T, Ns...> ref() noexcept {
+        return { data_, stride_ };
+    }
+
+    /* get plane reference */
+    BatchRef<const T, Ns...> ref() const noexcept {
+        return { data_, stride_ };
+    }
+
+    /* get plane k as view */
+    View<T, 1> operator[](u32 k) noexcept {
+        return { plane(k), { count_ } };
+    }
+
+    /* get plane k as view */
+    View<const T, 1> operator[](u32 k) const noexcept {
+        return { plane(k), { count_ } };
+    }
+#pragma endregion
+
+#pragma region access
+    /* access component ids... of instance idx */
+    template<class ...I>
+    __forceinline T& operator()(Tsize idx, I ...ids) noexcept {
+        return data_[Tref::_plane_of(ids...) * stride_ + idx];
+    }
+
+    /* access component ids... of instance idx */
+    template<class ...I>
+    __forceinline const T& operator()(Tsize idx, I ...ids) const noexcept {
+        return data_[Tref::_plane_of(ids...) * stride_ + idx];
+    }
+
+    /* gather instance idx */
+    Telem get(Tsize idx) const noexcept {
+        Telem elem;
+        auto  dst = reinterpret_cast<T*>(&elem);
+        for (u32 k = 0; k < $planes; ++k) {
+            dst[k] = data_[k * stride_ + idx];
+        }
+        return elem;
+    }
+
+    /* scatter instance idx */
+    void set(Tsize idx, const Telem& elem) noexcept {
+        auto src = reinterpret_cast<const T*>(&elem);
+        for (u32 k = 0; k < $planes; ++k) {
+            data_[k * stride_ + idx] = src[k];
+        }
+    }
+#pragma endregion
+
+#pragma region methods
+    /* count instances, zero initialized: the old contents are discarded, even if count grows */
+    Batch& resize(Tsize count) {
+        if (count == count_) {
+            return *this;
+        }
+        clear();
+
+        const auto stride = (count + $lanes - 1) / $lanes * $lanes;
+        if (stride != 0) {
+            data_ = anew<T>(u64($planes) * stride, 256);
+            if (data_ == nullptr) {
+                NMS_THROW(EBadAlloc{});
+            }
+            // padding lanes are computed by the kernels too, keep them finite.
+            mzero(data_, u64($planes) * stride);
+        }
+        count_  = count;
+        stride_ = stride;
+        return *this;
+    }
+
+    Batch& clear() {
+        if (data_ != nullptr) {
+            adel(data_);
+            data_ = nullptr;
+        }
+        count_  = 0;
+        stride_ = 0;
+        return *this;
+    }
+
+    /* AoS -> SoA */
+    void fromAos(const View<const Telem, 1>& aos) {
+        resize(aos.count());
+
+        for (u32 k = 0; k < $planes; ++k) {
+            const auto src = reinterpret_cast<const T*>(aos.data()) + k;
+            const auto dst = plane(k);
+            const auto step = aos.step(0) * i32($planes);
+            for (Tsize idx = 0; idx < count_; ++idx) {
+                dst[idx] = src[i32(idx) * step];
+            }
+        }
+    }
+
+    /* SoA -> AoS */
+    void toAos(View<Telem, 1> aos) const {
+        const auto n = nms::min(count_, aos.count());
+
+        for (u32 k = 0; k < $planes; ++k) {
+            const auto src = plane(k);
+            const auto dst = reinterpret_cast<T*>(aos.data()) + k;
+            const auto step = aos.step(0) * i32($planes);
+            for (Tsize idx = 0; idx < n; ++idx) {
+                dst[i32(idx) * step] = src[idx];
+            }
+        }
+    }
+
+    /* SoA -> AoS */
+    Array<Telem, 1> toAos() const {
+        Array<Telem, 1> aos({ count_ });
+        toAos(aos);
+        return aos;
+    }
+#pragma endregion
+
+protected:
+    T*      data_;
+    Tsize   count_;
+    Tsize   stride_;
+};
+
+#pragma region kernels
+template<class T, class Tfunc, class ...Trefs>
+__forceinline void _bforeach(u32 stride, Tfunc& func, Trefs ...refs) {
+    for (u32 b = 0; b < stride; b += Lanes<T>::$count) {
+        func(refs.block(b)...);
+    }
+}
+
+/*!
+ * run func(out, args...) for every block of Lanes<T>::$count instances of out.
+ * out/args are passed as BatchRef values, component access yields Lanes<T>.
+ */
+template<class Tfunc, class T, u32 ...Ns, class ...Targs>
+__forceinline void bforeach(Tfunc&& func, Batch<T, Ns...>& out, const Targs& ...args) {
+    _bforeach<T>(out.stride(), func, out.ref(), args.ref()...);
+}
+
+/* c = a * b, c must not alias a or b: c(i, j) is written while a row of a is still read */
+template<class T, u32 M, u32 K, u32 N>
+void bmatmul(Batch<T, M, N>& c, const Batch<T, M, K>& a, const Batch<T, K, N>& b) {
+    c.resize(nms::min(a.count(), b.count()));
+
+    bforeach([](auto c, auto a, auto b) {
+        for (u32 i = 0; i < M; ++i) {
+            for (u32 j = 0; j < N; ++j) {
+                auto s = a(i, 0) * b(0, j);
+                for (u32 k = 1; k < K; ++k) {
+                    s += a(i, k) * b(k, j);
+                }
+                c(i, j) = s;
+            }
+        }
+    }, c, a, b);
+}
+
+/* y = a * v, y must not alias v */
+template<class T, u32 M, u32 N>
+void bmatvec(Batch<T, M>& y, const Batch<T, M, N>& a, const Batch<T, N>& v) {
+    y.resize(nms::min(a.count(), v.count()));
+
+    bforeach([](auto y, auto a, auto v) {
+        for (u32 i = 0; i < M; ++i) {
+            auto s = a(i, 0) * v(0);
+            for (u32 j = 1; j < N; ++j) {
+                s += a(i, j) * v(j);
+            }
+            y(i) = s;
+        }
+    }, y, a, v);
+}
+
+/* d = dot(a, b) */
+template<class T, u32 N>
+void bdot(Batch<T, 1>& d, const Batch<T, N>& a, const Batch<T, N>& b) {
+    d.resize(nms::min(a.count(), b.count()));
+
+    bforeach([](auto d, auto a, auto b) {
+        auto s = a(0) * b(0);
+        for (u32 i = 1; i < N; ++i) {
+            s += a(i) * b(i);
+        }
+        d(0) = s;
+    }, d, a, b);
+}
+
+/* c = cross(a, b) */
+template<class T>
+void bcross(Batch<T, 3>& c, const Batch<T, 3>& a, const Batch<T, 3>& b) {
+    c.resize(nms::min(a.count(), b.count()));
+
+    bforeach([](auto c, auto a, auto b) {
+        const auto ax = a(0), ay = a(1), az = a(2);
+        const auto bx = b(0), by = b(1), bz = b(2);
+        c(0) = ay * bz - az * by;
+        c(1) = az * bx - ax * bz;
+        c(2) = ax * by - ay * bx;
+    }, c, a, b);
+}
+
+/* y = v / |v| */
+template<class T, u32 N>
+void bnormalize(Batch<T, N>& y, const Batch<T, N>& v) {
+    y.resize(v.count());
+
+    bforeach([](auto y, auto v) {
+        auto s = v(0) * v(0);
+        for (u32 i = 1; i < N; ++i) {
+            s += v(i) * v(i);
+        }
+        const auto k = rsqrt(s);
+        for (u32 i = 0; i < N; ++i) {
+            y(i) = v(i) * k;
+        }
+    }, y, v);
+}
+
+/* y = q * v * ~q, q = (x, y, z, w) is a unit quaternion */
+template<class T>
+void brotate(Batch<T, 3>& y, const Batch<T, 4>& q, const Batch<T, 3>& v) {
+    y.resize(nms::min(q.count(), v.count()));
+
+    bforeach([](auto y, auto q, auto v) {
+        const auto qx = q(0), qy = q(1), qz = q(2), qw = q(3);
+        const auto vx = v(0), vy = v(1), vz = v(2);
+
+        // t = 2 * cross(q.xyz, v)
+        const auto tx = T(2) * (qy * vz - qz * vy);
+        const auto ty = T(2) * (qz * vx - qx * vz);
+        const auto tz = T(2) * (qx * vy - qy * vx);
+
+        // v' = v + w * t + cross(q.xyz, t)
+        y(0) = vx + qw * tx + (qy * tz - qz * ty);
+        y(1) = vy + qw * ty + (qz * tx - qx * tz);
+        y(2) = vz + qw * tz + (qx * ty - qy * tx);
+    }, y, q, v);
+}
+
+/* d = det(a) */
+template<class T>
+void bdet(Batch<T, 1>& d, const Batch<T, 2, 2>& a) {
+    d.resize(a.count());
+
+    bforeach([](auto d, auto a) {
+        d(0) = a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0);
+    }, d, a);
+}
+
+/* d = det(a) */
+template<class T>
+void bdet(Batch<T, 1>& d, const Batch<T, 3, 3>& a) {
+    d.resize(a.count());
+
+    bforeach([](auto d, auto a) {
+        const auto c0 = a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1);
+        const auto c1 = a(1, 2) * a(2, 0) - a(1, 0) * a(2, 2);
+        const auto c2 = a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0);
+        d(0) = a(0, 0) * c0 + a(0, 1) * c1 + a(0, 2) * c2;
+    }, d, a);
+}
+
+/* d = det(a) */
+template<class T>
+void bdet(Batch<T, 1>& d, const Batch<T, 4, 4>& a) {
+    d.resize(a.count());
+
+    bforeach([](auto d, auto a) {
+        // 2x2 minors of the lower two rows
+        const auto s0 = a(2, 0) * a(3, 1) - a(2, 1) * a(3, 0);
+        const auto s1 = a(2, 0) * a(3, 2) - a(2, 2) * a(3, 0);
+        const auto s2 = a(2, 0) * a(3, 3) - a(2, 3) * a(3, 0);
+        const auto s3 = a(2, 1) * a(3, 2) - a(2, 2) * a(3, 1);
+        const auto s4 = a(2, 1) * a(3, 3) - a(2, 3) * a(3, 1);
+        const auto s5 = a(2, 2) * a(3, 3) - a(2, 3) * a(3, 2);
+
+        // 2x2 minors of the upper two rows
+        const auto c0 = a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0);
+        const auto c1 = a(0, 0) * a(1, 2) - a(0, 2) * a(1, 0);
+        const auto c2 = a(0, 0) * a(1, 3) - a(0, 3) * a(1, 0);
+        const auto c3 = a(0, 1) * a(1, 2) - a(0, 2) * a(1, 1);
+        const auto c4 = a(0, 1) * a(1, 3) - a(0, 3) * a(1, 1);
+        const auto c5 = a(0, 2) * a(1, 3) - a(0, 3) * a(1, 2);
+
+        d(0) = c0 * s5 - c1 * s4 + c2 * s3 + c3 * s2 - c4 * s1 + c5 * s0;
+    }, d, a);
+}
+
+/* b = inv(a), singular matrices give inf/nan */
+template<class T>
+void binv(Batch<T, 2, 2>& b, const Batch<T, 2, 2>& a) {
+    b.resize(a.count());
+
+    bforeach([](auto b, auto a) {
+        const auto a00 = a(0, 0), a01 = a(0, 1);
+        const auto a10 = a(1, 0), a11 = a(1, 1);
+        const auto k   = T(1) / (a00 * a11 - a01 * a10);
+
+        b(0, 0) =  a11 * k; b(0, 1) = -a01 * k;
+        b(1, 0) = -a10 * k; b(1, 1) =  a00 * k;
+    }, b, a);
+}
+
+/* b = inv(a), singular matrices give inf/nan */
+template<class T>
+void binv(Batch<T, 3, 3>& b, const Batch<T, 3, 3>& a) {
+    b.resize(a.count());
+
+    bforeach([](auto b, auto a) {
+        const auto a00 = a(0, 0), a01 = a(0, 1), a02 = a(0, 2);
+        const auto a10 = a(1, 0), a11 = a(1, 1), a12 = a(1, 2);
+        const auto a20 = a(2, 0), a21 = a(2, 1), a22 = a(2, 2);
+
+        const auto c00 = a11 * a22 - a12 * a21;
+        const auto c01 = a12 * a20 - a10 * a22;
+        const auto c02 = a10 * a21 - a11 * a20;
+        const auto k   = T(1) / (a00 * c00 + a01 * c01 + a02 * c02);
+
+        b(0, 0) = c00 * k;
+        b(0, 1) = (a02 * a21 - a01 * a22) * k;
+        b(0, 2) = (a01 * a12 - a02 * a11) * k;
+        b(1, 0) = c01 * k;
+        b(1, 1) = (a00 * a22 - a02 * a20) * k;
+        b(1, 2) = (a02 * a10 - a00 * a12) * k;
+        b(2, 0) = c02 * k;
+        b(2, 1) = (a01 * a20 - a00 * a21) * k;
+        b(2, 2) = (a00 * a11 - a01 * a10) * k;
+    }, b, a);
+}
+
+/* b = inv(a), singular matrices give inf/nan */
+template<class T>
+void binv(Batch<T, 4, 4>& b, const Batch<T, 4, 4>& a) {
+    b.resize(a.count());
+
+    bforeach([](auto b, auto a) {
+        const auto a00 = a(0, 0), a01 = a(0, 1), a02 = a(0, 2), a03 = a(0, 3);
+        const auto a10 = a(1, 0), a11 = a(1, 1), a12 = a(1, 2), a13 = a(1, 3);
+        const auto a20 = a(2, 0), a21 = a(2, 1), a22 = a(2, 2), a23 = a(2, 3);
+        const auto a30 = a(3, 0), a31 = a(3, 1), a32 = a(3, 2), a33 = a(3, 3);
+
+        const auto s0 = a00 * a11 - a10 * a01;
+        const auto s1 = a00 * a12 - a10 * a02;
+        const auto s2 = a00 * a13 - a10 * a03;
+        const auto s3 = a01 * a12 - a11 * a02;
+        const auto s4 = a01 * a13 - a11 * a03;
+        const auto s5 = a02 * a13 - a12 * a03;
+
+        const auto c5 = a22 * a33 - a32 * a23;
+        const auto c4 = a21 * a33 - a31 * a23;
+        const auto c3 = a21 * a32 - a31 * a22;
+        const auto c2 = a20 * a33 - a30 * a23;
+        const auto c1 = a20 * a32 - a30 * a22;
+        const auto c0 = a20 * a31 - a30 * a21;
+
+        const auto k = T(1) / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+        b(0, 0) = ( a11 * c5 - a12 * c4 + a13 * c3) * k;
+        b(0, 1) = (-a01 * c5 + a02 * c4 - a03 * c3) * k;
+        b(0, 2) = ( a31 * s5 - a32 * s4 + a33 * s3) * k;
+        b(0, 3) = (-a21 * s5 + a22 * s4 - a23 * s3) * k;
+
+        b(1, 0) = (-a10 * c5 + a12 * c2 - a13 * c1) * k;
+        b(1, 1) = ( a00 * c5 - a02 * c2 + a03 * c1) * k;
+        b(1, 2) = (-a30 * s5 + a32 * s2 - a33 * s1) * k;
+        b(1, 3) = ( a20 * s5 - a22 * s2 + a23 * s1) * k;
+
+        b(2, 0) = ( a10 * c4 - a11 * c2 + a13 * c0) * k;
+        b(2, 1) = (-a00 * c4 + a01 * c2 - a03 * c0) * k;
+        b(2, 2) = ( a30 * s4 - a31 * s2 + a33 * s0) * k;
+        b(2, 3) = (-a20 * s4 + a21 * s2 - a23 * s0) * k;
+
+        b(3, 0) = (-a10 * c3 + a11 * c1 - a12 * c0) * k;
+        b(3, 1) = ( a00 * c3 - a01 * c1 + a02 * c0) * k;
+        b(3, 2) = (-a30 * s3 + a31 * s1 - a32 * s0) * k;
+        b(3, 3) = ( a20 * s3 - a21 * s1 + a22 * s0) * k;
+    }, b, a);
+}
+#pragma endregion
+
+}
@@ -0,0 +1,233 @@
+#include <nms/test.h>
+#include <nms/math.h>
+#include <nms/io.h>
+#include <nms/core/simd.h>
+
+namespace nms::math
+{
+
+#pragma region kernels
+NMS_API void _bits_and(u64* dst, const u64* a, const u64* b, u64 n) {
+    for (u64 k = 0; k < n; ++k) {
+        dst[k] = a[k] & b[k];
+    }
+}
+
+NMS_API void _bits_or(u64* dst, const u64* a, const u64* b, u64 n) {
+    for (u64 k = 0; k < n; ++k) {
+        dst[k] = a[k] | b[k];
+    }
+}
+
+NMS_API void _bits_xor(u64* dst, const u64* a, const u64* b, u64 n) {
+    for (u64 k = 0; k < n; ++k) {
+        dst[k] = a[k] ^ b[k];
+    }
+}
+
+NMS_API void _bits_andnot(u64* dst, const u64* a, const u64* b, u64 n) {
+    for (u64 k = 0; k < n; ++k) {
+        dst[k] = a[k] & ~b[k];
+    }
+}
+
+NMS_API void _bits_not(u64* dst, const u64* a, u64 n) {
+    for (u64 k = 0; k < n; ++k) {
+        dst[k] = ~a[k];
+    }
+}
+
+static u64 _bits_popcount_swar(const u64* w, u64 n) {
+    u64 cnt = 0;
+    for (u64 k = 0; k < n; ++k) {
+        auto x = w[k];
+        x = x - ((x >> 1) & 0x5555555555555555ull);
+        x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+        x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+        cnt += (x * 0x0101010101010101ull) >> 56;
+    }
+    return cnt;
+}
+
+#ifdef NMS_SIMD_SSE2
+/* every avx2 cpu has popcnt */
+NMS_TARGET("popcnt")
+static u64 _bits_popcount_hw(const u64* w, u64 n) {
+    u64 cnt = 0;
+    for (u64 k = 0; k < n; ++k) {
+#ifdef NMS_CC_MSVC
+        cnt += __popcnt64(w[k]);
+#else
+        cnt += u64(__builtin_popcountll(w[k]));
+#endif
+    }
+    return cnt;
+}
+#endif
+
+NMS_API u64 _bits_popcount(const u64* w, u64 n) {
+#ifdef NMS_SIMD_SSE2
+    if (simd_level() == SimdLevel::AVX2) {
+        return _bits_popcount_hw(w, n);
+    }
+#endif
+    return _bits_popcount_swar(w, n);
+}
+
+NMS_API u64 _bits_find(const u64* w, u64 cnt, u64 pos) {
+    if (pos >= cnt) {
+        return cnt;
+    }
+    auto k    = pos >> 6;
+    auto bits = w[k] & (~0ull << (pos & 63));
+    const auto last = (cnt - 1) >> 6;
+    while (bits == 0) {
+        if (++k > last) {
+            return cnt;
+        }
+        bits = w[k];
+    }
+    const auto ret = (k << 6) + _bits_ctz(bits);
+    return ret < cnt ? ret : cnt;
+}
+#pragma endregion
+
+#pragma region unittest
+nms_test(bits) {
+    BitArray<1> a({ 200 });
+    test::assert_eq(a.words(), u64(4));
+    test::assert_eq(a.popcount(), u64(0));
+    test::assert_eq(a.find(), u64(200));
+
+    a.set(3);
+    a.set(64);
+    a.set(199);
+    test::assert_true(a(3u) && a(64u) && a(199u) && !a(4u));
+    test::assert_eq(a.popcount(), u64(3));
+    test::assert_eq(a.find(), u64(3));
+    test::assert_eq(a.find(4), u64(64));
+    test::assert_eq(a.find(65), u64(199));
+
+    List<u64> pos;
+    a.each([&](u64 p) { pos.append(p); });
+    test::assert_eq(pos.count(), 3u);
+    test::assert_eq(pos[1], u64(64));
+
+    // the tail bits stay 0
+    a.flip();
+    test::assert_eq(a.popcount(), u64(197));
+    a.fill(true);
+    test::assert_eq(a.popcount(), u64(200));
+
+    auto b = a.dup();
+    b.set(10, false);
+    a ^= b;
+    test::assert_eq(a.popcount(), u64(1));
+    test::assert_eq(a.find(), u64(10));
+    a |= b;
+    a.andnot(b);
+    test::assert_eq(a.find(), u64(10));
+    a &= b;
+    test::assert_eq(a.popcount(), u64(0));
+}
+
+nms_test(bits_expr) {
+    Array<f32, 2> x({ 33, 7 });
+    x <<= vline(1.0f, 0.5f) - 10;
+
+    // pack a comparison
+    BitArray<2> m({ 33, 7 });
+    m <<= x > 0;
+    u64 cnt = 0;
+    for (u32 j = 0; j < x.size(1); ++j) {
+        for (u32 i = 0; i < x.size(0); ++i) {
+            test::assert_eq(m(i, j), x(i, j) > 0);
+            cnt += x(i, j) > 0 ? 1 : 0;
+        }
+    }
+    test::assert_eq(m.popcount(), cnt);
+
+    // an expression smaller than the bits
+    BitArray<2> wide({ 33, 8 });
+    try {
+        wide <<= x > 0;
+        test::assert_true(false);
+    }
+    catch (const Eunexpect<u32>&) {
+    }
+
+    // read as an operand
+    Array<f32, 2> y({ 33, 7 });
+    y <<= vwhere(m, 1.0f, 0.0f);
+    test::assert_eq(y(32, 6), 1.0f);
+    test::assert_eq(y(0, 0), 0.0f);
+
+    // masked assignment
+    y <<= x;
+    y.masked(m) <<= x * 10;
+    for (u32 j = 0; j < x.size(1); ++j) {
+        for (u32 i = 0; i < x.size(0); ++i) {
+            test::assert_eq(y(i, j), x(i, j) > 0 ? x(i, j) * 10 : x(i, j));
+        }
+    }
+
+    // stream compaction
+    List<f32> list;
+    test::assert_eq(vcompact(list, x, m), cnt);
+    test::assert_eq(u64(list.count()), cnt);
+    u32 k = 0;
+    for (u32 j = 0; j < x.size(1); ++j) {
+        for (u32 i = 0; i < x.size(0); ++i) {
+            if (x(i, j) > 0) {
+                test::assert_eq(list[k++], x(i, j));
+            }
+        }
+    }
+
+    // save/load
+    m.save("nms.math.bits.dat");
+    auto n = BitArray<2>::load("nms.math.bits.dat");
+    test::assert_eq(n.size(), m.size());
+    test::assert_eq(n.popcount(), cnt);
+    n ^= m;
+    test::assert_eq(n.popcount(), u64(0));
+}
+
+/* a 4096x4096 mask: BitArray vs Array<bool> */
+nms_test(bits_perf) {
+    static const u32 n = 4096;
+
+    Array<f32, 2> x({ n, n });
+    x <<= vsin(vline(0.01f, 0.37f));
+
+    BitArray<2>    b1({ n, n }), b2({ n, n });
+    Array<bool, 2> m1({ n, n }), m2({ n, n });
+
+    const auto t0 = nms::clock();
+    b1 <<= x < 0.5f;
+    b2 <<= x > -0.5f;
+    const auto t1 = nms::clock();
+    m1 <<= x < 0.5f;
+    m2 <<= x > -0.5f;
+    const auto t2 = nms::clock();
+
+    b1 &= b2;
+    const auto c1 = b1.popcount();
+    const auto t3 = nms::clock();
+
+    u64 c2 = 0;
+    for (u32 j = 0; j < n; ++j) {
+        for (u32 i = 0; i < n; ++i) {
+            m1(i, j) = m1(i, j) && m2(i, j);
+            c2 += m1(i, j) ? 1 : 0;
+        }
+    }
+    const auto t4 = nms::clock();
+    test::assert_eq(c1, c2);
+
+    io::log::info("nms.math.bits: {}x{} mask {}KB vs {}KB: pack {.3}ms vs {.3}ms, and+popcount {.3}ms vs {.3}ms",
+        n, n, b1.words() * 8 / 1024, u64(n) * n / 1024, (t1 - t0) * 1e3 / 2, (t2 - t1) * 1e3 / 2, (t3 - t2) * 1e3, (t4 - t3) * 1e3);
+}
+#pragma endregion
+
+}
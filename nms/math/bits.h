@@ -0,0 +1,465 @@
+#pragma once
+
+#include <nms/math/base.h>
+#include <nms/math/view.h>
+#include <nms/math/vrun.h>
+
+namespace nms::io
+{
+class File;
+class Path;
+}
+
+namespace nms::math
+{
+
+#pragma region kernels
+/* word kernels of BitView, over n words */
+NMS_API void _bits_and   (u64* dst, const u64* a, const u64* b, u64 n);
+NMS_API void _bits_or    (u64* dst, const u64* a, const u64* b, u64 n);
+NMS_API void _bits_xor   (u64* dst, const u64* a, const u64* b, u64 n);
+NMS_API void _bits_andnot(u64* dst, const u64* a, const u64* b, u64 n);     // a & ~b
+NMS_API void _bits_not   (u64* dst, const u64* a, u64 n);
+
+/* number of set bits in n words */
+NMS_API u64  _bits_popcount(const u64* w, u64 n);
+
+/* position of the first set bit in [pos, cnt), cnt if none */
+NMS_API u64  _bits_find(const u64* w, u64 cnt, u64 pos);
+
+/* index of the lowest set bit, val != 0 */
+__forceinline u32 _bits_ctz(u64 val) {
+#ifdef NMS_CC_MSVC
+    unsigned long idx = 0;
+    _BitScanForward64(&idx, val);
+    return u32(idx);
+#else
+    return u32(__builtin_ctzll(val));
+#endif
+}
+
+/* call f(pos) for each set bit in [begin, end), a word at a time */
+template<class F>
+void _bits_each(const u64* w, u64 begin, u64 end, F&& f) {
+    if (begin >= end) {
+        return;
+    }
+    const auto first = begin >> 6;
+    const auto last  = (end - 1) >> 6;
+    for (auto k = first; k <= last; ++k) {
+        auto bits = w[k];
+        if (k == first) {
+            bits &= ~0ull << (begin & 63);
+        }
+        if (k == last && (end & 63) != 0) {
+            bits &= (1ull << (end & 63)) - 1;
+        }
+        while (bits != 0) {
+            f((k << 6) + _bits_ctz(bits));
+            bits &= bits - 1;
+        }
+    }
+}
+
+/* call f(i1, i2, ...) for each row (all indices but the first) */
+template<class F> void _bits_rows(const Vec<u32, 1>&  , F&& f) { f(); }
+template<class F> void _bits_rows(const Vec<u32, 2>& s, F&& f) {
+    for (u32 i1 = 0; i1 < s[1]; ++i1) f(i1);
+}
+template<class F> void _bits_rows(const Vec<u32, 3>& s, F&& f) {
+    for (u32 i2 = 0; i2 < s[2]; ++i2) for (u32 i1 = 0; i1 < s[1]; ++i1) f(i1, i2);
+}
+template<class F> void _bits_rows(const Vec<u32, 4>& s, F&& f) {
+    for (u32 i3 = 0; i3 < s[3]; ++i3) for (u32 i2 = 0; i2 < s[2]; ++i2) for (u32 i1 = 0; i1 < s[1]; ++i1) f(i1, i2, i3);
+}
+#pragma endregion
+
+#pragma region BitView
+struct BitVrun;
+
+/*!
+ * a view of bits: a boolean mask that takes 1 bit per element.
+ * element (i0, i1, ...) is bit pos = i0 + s0 * (i1 + s1 * ...), of word pos / 64.
+ * the bits after count() in the last word are kept 0.
+ *
+ * `mask <<= x < 0` packs a comparison, `y.masked(mask) <<= x` and
+ * vcompact(list, x, mask) only visit the set bits.
+ */
+template<u32 N = 1>
+struct BitView
+{
+    static constexpr auto $rank = N;
+
+    using Tview = BitView;
+    using Tvrun = BitVrun;
+    using Tsize = u32;
+    using Tdims = Vec<Tsize, N>;
+    using Tinfo = ViewInfo;
+
+    /* type 'b': bits, packed 64 per u64 word */
+    static constexpr Tinfo $info = { '$', 'b', '0', char('0' + N) };
+
+#pragma region constructors
+    constexpr BitView() noexcept
+        : data_{ nullptr }, size_{ 0u }
+    {}
+
+    BitView(u64* data, const Tsize(&size)[N]) noexcept
+        : data_{ data }, size_{ size }
+    {}
+#pragma endregion
+
+#pragma region properties
+    u64* data() noexcept {
+        return data_;
+    }
+
+    const u64* data() const noexcept {
+        return data_;
+    }
+
+    Tdims size() const noexcept {
+        return size_;
+    }
+
+    Tsize size(u32 dim) const noexcept {
+        return size_[dim];
+    }
+
+    /* number of elements (bits) */
+    u64 count() const noexcept {
+        u64 cnt = 1;
+        for (u32 k = 0; k < N; ++k) {
+            cnt *= size_[k];
+        }
+        return cnt;
+    }
+
+    /* number of u64 words */
+    u64 words() const noexcept {
+        return (count() + 63) / 64;
+    }
+#pragma endregion
+
+#pragma region access
+    /* bit position of element (i0, i1, ...) */
+    template<class ...I>
+    __forceinline u64 index(I ...idx) const noexcept {
+        static_assert(u32(sizeof...(I)) == N, "nms.math.BitView: unexpect indices count");
+        const u64 ids[] = { u64(idx)... };
+        u64 pos = ids[N - 1];
+        for (u32 k = N - 1; k > 0; --k) {
+            pos = pos * size_[k - 1] + ids[k - 1];
+        }
+        return pos;
+    }
+
+    __forceinline bool test(u64 pos) const noexcept {
+        return (data_[pos >> 6] >> (pos & 63)) & 1;
+    }
+
+    __forceinline void set(u64 pos, bool val = true) noexcept {
+        const auto bit = 1ull << (pos & 63);
+        data_[pos >> 6] = val ? data_[pos >> 6] | bit : data_[pos >> 6] & ~bit;
+    }
+
+    template<class ...I>
+    __forceinline bool operator()(I ...idx) const noexcept {
+        return test(index(idx...));
+    }
+#pragma endregion
+
+#pragma region methods
+    /* number of set bits */
+    u64 popcount() const noexcept {
+        return _bits_popcount(data_, words());
+    }
+
+    /* position of the first set bit >= pos, count() if none */
+    u64 find(u64 pos = 0) const noexcept {
+        return _bits_find(data_, count(), pos);
+    }
+
+    /* call f(pos) for each set bit */
+    template<class F>
+    void each(F&& f) const {
+        _bits_each(data_, 0, count(), fwd<F>(f));
+    }
+
+    BitView& fill(bool val) {
+        const auto n = words();
+        for (u64 k = 0; k < n; ++k) {
+            data_[k] = val ? ~0ull : 0ull;
+        }
+        _clear_tail();
+        return *this;
+    }
+
+    BitView& flip() {
+        _bits_not(data_, data_, words());
+        _clear_tail();
+        return *this;
+    }
+
+    BitView& operator&=(const BitView& rhs) {
+        _bits_and(data_, data_, rhs.data_, _words(rhs));
+        return *this;
+    }
+
+    BitView& operator|=(const BitView& rhs) {
+        _bits_or(data_, data_, rhs.data_, _words(rhs));
+        return *this;
+    }
+
+    BitView& operator^=(const BitView& rhs) {
+        _bits_xor(data_, data_, rhs.data_, _words(rhs));
+        return *this;
+    }
+
+    /* this & ~rhs */
+    BitView& andnot(const BitView& rhs) {
+        _bits_andnot(data_, data_, rhs.data_, _words(rhs));
+        return *this;
+    }
+#pragma endregion
+
+protected:
+    u64*    data_;
+    Tdims   size_;
+
+    u64 _words(const BitView& rhs) const noexcept {
+        const auto a = words();
+        const auto b = rhs.words();
+        return a < b ? a : b;
+    }
+
+    void _clear_tail() noexcept {
+        const auto cnt = count();
+        if ((cnt & 63) != 0) {
+            data_[cnt >> 6] &= (1ull << (cnt & 63)) - 1;
+        }
+    }
+};
+
+/*!
+ * runutor of `bits <<= expr`: the results are packed into words,
+ * 64 elements per store.
+ */
+struct BitVrun
+{
+    template<class Tfunc, u32 N, class Targ>
+    void foreach(Tfunc, BitView<N>& ret, const Targ& arg) {
+        static_assert($is<Ass2, Tfunc>, "nms.math.BitVrun: only assignment (<<=) to a BitView");
+
+        // the expression covers every bit: a smaller one would be read out of range (size 0: any)
+        static_assert(Targ::$rank == N || Targ::$rank == 0, "nms.math.BitVrun: $rank not match");
+        for (u32 i = 0; i < Targ::$rank; ++i) {
+            if (arg.size(i) != 0 && arg.size(i) != ret.size(i)) {
+                NMS_THROW(Eunexpect<u32>(ret.size(i), u32(arg.size(i))));
+            }
+        }
+
+        const auto w  = ret.data();
+        const auto s0 = ret.size(0);
+
+        u64 acc = 0;
+        u64 pos = 0;
+        _bits_rows(ret.size(), [&](auto ...outer) {
+            for (u32 i0 = 0; i0 < s0; ) {
+                // the bits up to the end of the word (or the row)
+                const auto room = 64 - u32(pos & 63);
+                const auto take = s0 - i0 < room ? s0 - i0 : room;
+
+                u64 bits = 0;
+                for (u32 k = 0; k < take; ++k) {
+                    bits |= u64(bool(arg(i0 + k, outer...))) << k;
+                }
+                acc |= bits << (pos & 63);
+                i0  += take;
+                pos += take;
+                if ((pos & 63) == 0) {
+                    w[(pos >> 6) - 1] = acc;
+                    acc = 0;
+                }
+            }
+        });
+        if ((pos & 63) != 0) {
+            w[pos >> 6] = acc;
+        }
+    }
+};
+
+/* the destination picks the runutor: BitView operands are read by Vrun */
+inline BitVrun operator||(const BitVrun&, const BitVrun&) { return {}; }
+inline BitVrun operator||(const BitVrun&, const Vrun&   ) { return {}; }
+inline Vrun    operator||(const Vrun&,    const BitVrun&) { return {}; }
+#pragma endregion
+
+#pragma region BitArray
+/* a BitView that owns its words */
+template<u32 N = 1>
+class BitArray
+    : public BitView<N>
+{
+public:
+    using base  = BitView<N>;
+    using Tsize = typename base::Tsize;
+    using Tdims = typename base::Tdims;
+    using Tinfo = typename base::Tinfo;
+
+#pragma region constructors
+    constexpr BitArray() noexcept
+        : base{}
+    {}
+
+    /* all bits 0 */
+    explicit BitArray(const Tsize(&dims)[N])
+        : base{ nullptr, dims } {
+        const auto n = this->words();
+        if (n != 0) {
+            this->data_ = anew<u64>(n, 64);
+            mzero(this->data_, n);
+        }
+    }
+
+    ~BitArray() {
+        clear();
+    }
+
+    BitArray(BitArray&& rhs) noexcept
+        : base{ rhs } {
+        static_cast<base&>(rhs) = base{};
+    }
+
+    BitArray& operator=(BitArray&& rhs) noexcept {
+        if (this != &rhs) {
+            clear();
+            base::operator=(rhs);
+            static_cast<base&>(rhs) = base{};
+        }
+        return *this;
+    }
+
+    BitArray(const BitArray&)            = delete;
+    BitArray& operator=(const BitArray&) = delete;
+
+    BitArray dup() const {
+        BitArray tmp(this->size_.data);
+        const auto n = this->words();
+        for (u64 k = 0; k < n; ++k) {
+            tmp.data_[k] = this->data_[k];
+        }
+        return tmp;
+    }
+
+    BitArray& clear() {
+        if (this->data_ != nullptr) {
+            adel(this->data_);
+        }
+        static_cast<base&>(*this) = base{};
+        return *this;
+    }
+#pragma endregion
+
+#pragma region save/load
+    void save(io::File& file) const {
+        return this->saveFile(file);
+    }
+
+    static auto load(const io::File& file) {
+        return BitArray::loadFile(file);
+    }
+
+    void save(const io::Path& path) const {
+        return this->savePath<io::File>(path);
+    }
+
+    static auto load(const io::Path& path) {
+        return BitArray::loadPath<io::File>(path);
+    }
+#pragma endregion
+
+private:
+    template<class File>
+    void saveFile(File& file) const {
+        const Tinfo info = base::$info;
+        const Tdims size = this->size();
+
+        file.write(&info, 1);
+        file.write(&size, 1);
+        file.write(this->data(), this->words());
+    }
+
+    template<class File>
+    static auto loadFile(const File& file) {
+        Tinfo info;
+        Tdims size;
+
+        file.read(&info, 1);
+        if (info != base::$info) {
+            NMS_THROW(Eunexpect<Tinfo>(base::$info, info));
+        }
+
+        file.read(&size, 1);
+
+        BitArray tmp(size.data);
+        file.read(tmp.data(), tmp.words());
+        return tmp;
+    }
+
+    template<class File, class Path>
+    void savePath(const Path& path) const {
+        File file(path, File::Write);
+        saveFile(file);
+    }
+
+    template<class File, class Path>
+    static auto loadPath(const Path& path) {
+        File file(path, File::Read);
+        return BitArray::loadFile(file);
+    }
+};
+#pragma endregion
+
+#pragma region masked/compact
+/* y.masked(mask) <<= x, with a bit mask: only the set bits are visited */
+template<class X, class Y, u32 N>
+void operator<<=(ViewMasked<Y, BitView<N> > y, const X& x) {
+    const auto vx   = view_cast(x);
+    const auto& m   = y.mask;
+    const auto  s0  = m.size(0);
+    if (!check_size(y.view, m, vx)) {
+        return;
+    }
+
+    _bits_rows(m.size(), [&](auto ...outer) {
+        const auto base = m.index(0u, outer...);
+        _bits_each(m.data(), base, base + s0, [&](u64 pos) {
+            const auto i0 = u32(pos - base);
+            y.view(i0, outer...) = vx(i0, outer...);
+        });
+    });
+}
+
+/*!
+ * stream compaction: append x(i) to dst for each set bit of mask, in order.
+ * @return number of appended elements
+ */
+template<class T, class X, u32 N>
+u64 vcompact(List<T>& dst, const X& x, const BitView<N>& mask) {
+    const auto vx = view_cast(x);
+    const auto s0 = mask.size(0);
+    const auto n  = mask.popcount();
+    dst.reserve(dst.count() + u32(n));
+
+    _bits_rows(mask.size(), [&](auto ...outer) {
+        const auto base = mask.index(0u, outer...);
+        _bits_each(mask.data(), base, base + s0, [&](u64 pos) {
+            dst.append(vx(u32(pos - base), outer...));
+        });
+    });
+    return n;
+}
+#pragma endregion
+
+}
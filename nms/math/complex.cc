@@ -0,0 +1,580 @@
+#include <nms/test.h>
+#include <nms/math.h>
+#include <nms/math/complex.h>
+
+namespace nms::math
+{
+
+namespace
+{
+
+using V = f32x8;
+
+static constexpr u32 $lanes = V::$size;
+
+/* 8 complex numbers, split into real and imaginary registers */
+struct CV
+{
+    V re;
+    V im;
+};
+
+void _check_size(u32 expect, u32 value) {
+    if (expect != value) {
+        NMS_THROW(Eunexpect<u32>(expect, value));
+    }
+}
+
+#pragma region vector math
+__forceinline V _vneg(V x) {
+    return V(0.0f) - x;
+}
+
+__forceinline V _vabs(V x) {
+    return vmax(x, _vneg(x));
+}
+
+/* round to nearest, |x| < 2^22 */
+__forceinline V _vround(V x) {
+    const V magic(12582912.0f);     // 1.5 * 2^23
+    return (x + magic) - magic;
+}
+
+__forceinline V _vfloor(V x) {
+    const auto t = _vround(x);
+    return t - select(cmpgt(t, x), V(1.0f), V(0.0f));
+}
+
+/* 2^n, n is integral in [-126, 127] */
+__forceinline V _vexp2i(V n) {
+    V r;
+    for (u32 l = 0; l < $lanes; ++l) {
+        r[l] = _vec_cast<f32>(u32(i32(n[l]) + 127) << 23);
+    }
+    return r;
+}
+
+/* e^x (cephes expf) */
+__forceinline V _vexp(V x) {
+    x = vmin(vmax(x, V(-87.0f)), V(88.0f));
+
+    const auto n = _vround(x * V(1.44269504088896341f));
+    const auto r = x - n * V(0.693359375f) - n * V(-2.12194440e-4f);
+
+    auto p = V(1.9875691500e-4f);
+    p = vfma(p, r, V(1.3981999507e-3f));
+    p = vfma(p, r, V(8.3334519073e-3f));
+    p = vfma(p, r, V(4.1665795894e-2f));
+    p = vfma(p, r, V(1.6666665459e-1f));
+    p = vfma(p, r, V(5.0000001201e-1f));
+    p = vfma(p, r * r, r + V(1.0f));
+
+    return p * _vexp2i(n);
+}
+
+/* sin(x), cos(x) (cephes sinf/cosf polynomials, 3 part pi/2 reduction) */
+__forceinline void _vsincos(V x, V& s, V& c) {
+    const auto q = _vround(x * V(0.636619772367581343f));
+    const auto r = ((x - q * V(1.5703125f)) - q * V(4.837512969970703125e-4f)) - q * V(7.54978995489188216e-8f);
+    const auto z = r * r;
+
+    auto ps = V(-1.9515295891e-4f);
+    ps = vfma(ps, z, V(8.3321608736e-3f));
+    ps = vfma(ps, z, V(-1.6666654611e-1f));
+    ps = vfma(ps * z, r, r);
+
+    auto pc = V(2.443315711809948e-5f);
+    pc = vfma(pc, z, V(-1.388731625493765e-3f));
+    pc = vfma(pc, z, V(4.166664568298827e-2f));
+    pc = vfma(pc * z, z, V(1.0f) - V(0.5f) * z);
+
+    // quadrant: q mod 4
+    const auto k  = q - V(4.0f) * _vfloor(q * V(0.25f));
+    const auto k0 = cmpeq(k, V(0.0f));
+    const auto k1 = cmpeq(k, V(1.0f));
+    const auto k2 = cmpeq(k, V(2.0f));
+
+    s = select(k0, ps, select(k1, pc,        select(k2, _vneg(ps), _vneg(pc))));
+    c = select(k0, pc, select(k1, _vneg(ps), select(k2, _vneg(pc), ps)));
+}
+
+/* atan2(y, x) (cephes atanf polynomial) */
+__forceinline V _vatan2(V y, V x) {
+    const auto ax = _vabs(x);
+    const auto ay = _vabs(y);
+    const auto lo = vmin(ax, ay);
+    const auto hi = vmax(ax, ay);
+
+    // t = lo / hi in [0, 1], reduced to [0, tan(pi/8)]
+    const auto t0  = lo / select(cmpeq(hi, V(0.0f)), V(1.0f), hi);
+    const auto big = cmpgt(t0, V(0.414213562373095f));
+    const auto t   = select(big, (t0 - V(1.0f)) / (t0 + V(1.0f)), t0);
+    const auto z   = t * t;
+
+    auto p = V(8.05374449538e-2f);
+    p = vfma(p, z, V(-1.38776856032e-1f));
+    p = vfma(p, z, V(1.99777106478e-1f));
+    p = vfma(p, z, V(-3.33329491539e-1f));
+    p = vfma(p * z, t, t) + select(big, V(0.785398163397448f), V(0.0f));
+
+    p = select(cmpgt(ay, ax),      V(1.57079632679490f) - p, p);
+    p = select(cmplt(x, V(0.0f)),  V(3.14159265358979f) - p, p);
+    p = select(cmplt(y, V(0.0f)),  _vneg(p), p);
+    return p;
+}
+#pragma endregion
+
+#pragma region kernels
+__forceinline CV _cmul(const CV& a, const CV& b) {
+    return { a.re * b.re - a.im * b.im, vfma(a.re, b.im, a.im * b.re) };
+}
+
+__forceinline CV _cmulc(const CV& a, const CV& b) {
+    return { vfma(a.re, b.re, a.im * b.im), a.im * b.re - a.re * b.im };
+}
+
+__forceinline V _cabs(const CV& a) {
+    return vsqrt(vfma(a.re, a.re, a.im * a.im));
+}
+
+__forceinline V _carg(const CV& a) {
+    return _vatan2(a.im, a.re);
+}
+
+__forceinline CV _cexp(const CV& a) {
+    const auto m = _vexp(a.re);
+    V s, c;
+    _vsincos(a.im, s, c);
+    return { m * c, m * s };
+}
+#pragma endregion
+
+#pragma region load/store
+/* interleaved: k <= 8 elements, the rest is zero */
+__forceinline CV _load(const cf32* p, u32 k) {
+    CV v = { V(0.0f), V(0.0f) };
+    if (k == $lanes) {
+        for (u32 l = 0; l < $lanes; ++l) {
+            v.re[l] = p[l].r;
+            v.im[l] = p[l].i;
+        }
+    }
+    else {
+        for (u32 l = 0; l < k; ++l) {
+            v.re[l] = p[l].r;
+            v.im[l] = p[l].i;
+        }
+    }
+    return v;
+}
+
+__forceinline void _store(cf32* p, u32 k, const CV& v) {
+    if (k == $lanes) {
+        for (u32 l = 0; l < $lanes; ++l) {
+            p[l].r = v.re[l];
+            p[l].i = v.im[l];
+        }
+    }
+    else {
+        for (u32 l = 0; l < k; ++l) {
+            p[l].r = v.re[l];
+            p[l].i = v.im[l];
+        }
+    }
+}
+
+__forceinline V _load(const f32* p, u32 k) {
+    if (k == $lanes) {
+        return V::loadu(p);
+    }
+    V v(0.0f);
+    for (u32 l = 0; l < k; ++l) {
+        v[l] = p[l];
+    }
+    return v;
+}
+
+__forceinline void _store(f32* p, u32 k, const V& v) {
+    if (k == $lanes) {
+        v.storeu(p);
+        return;
+    }
+    for (u32 l = 0; l < k; ++l) {
+        p[l] = v[l];
+    }
+}
+
+/* split */
+__forceinline CV _load(const f32* re, const f32* im, u32 k) {
+    return { _load(re, k), _load(im, k) };
+}
+
+__forceinline void _store(f32* re, f32* im, u32 k, const CV& v) {
+    _store(re, k, v.re);
+    _store(im, k, v.im);
+}
+
+/* run func(idx, k) on blocks of 8 */
+template<class Tfunc>
+__forceinline void _blocks(u32 n, Tfunc&& func) {
+    for (u32 i = 0; i < n; i += $lanes) {
+        func(i, nms::min($lanes, n - i));
+    }
+}
+
+template<class ...T>
+bool _contiguous(const T& ...v) {
+    const bool steps[] = { (v.step(0) == 1 || v.count() <= 1)... };
+    for (auto s : steps) {
+        if (!s) return false;
+    }
+    return true;
+}
+#pragma endregion
+
+/* dst(i) = func(a(i), b(i)), complex -> complex */
+template<class Tvec, class Tone>
+void _cbinary(View<cf32, 1> dst, View<const cf32, 1> a, View<const cf32, 1> b, Tvec fvec, Tone fone) {
+    const auto n = dst.count();
+    _check_size(n, a.count());
+    _check_size(n, b.count());
+
+    if (!_contiguous(dst, a, b)) {
+        for (u32 i = 0; i < n; ++i) {
+            dst(i) = fone(a(i), b(i));
+        }
+        return;
+    }
+
+    const auto pa = a.data();
+    const auto pb = b.data();
+    const auto pd = dst.data();
+    _blocks(n, [&](u32 i, u32 k) {
+        _store(pd + i, k, fvec(_load(pa + i, k), _load(pb + i, k)));
+    });
+}
+
+/* dst(i) = func(a(i)) */
+template<class Tout, class Tvec, class Tone>
+void _cunary(View<Tout, 1> dst, View<const cf32, 1> a, Tvec fvec, Tone fone) {
+    const auto n = dst.count();
+    _check_size(n, a.count());
+
+    if (!_contiguous(dst, a)) {
+        for (u32 i = 0; i < n; ++i) {
+            dst(i) = fone(a(i));
+        }
+        return;
+    }
+
+    const auto pa = a.data();
+    const auto pd = dst.data();
+    _blocks(n, [&](u32 i, u32 k) {
+        _store(pd + i, k, fvec(_load(pa + i, k)));
+    });
+}
+
+template<class T>
+SplitArray<T> _csplit(View<const complex<T>, 1> src) {
+    const auto n = src.count();
+
+    SplitArray<T> dst(n);
+    auto re = dst.real().data();
+    auto im = dst.imag().data();
+    for (u32 i = 0; i < n; ++i) {
+        re[i] = src(i).r;
+        im[i] = src(i).i;
+    }
+    return dst;
+}
+
+template<class T>
+void _cmerge(const SplitArray<T>& src, View<complex<T>, 1> dst) {
+    const auto n = dst.count();
+    _check_size(n, src.count());
+
+    const auto re = src.real().data();
+    const auto im = src.imag().data();
+    for (u32 i = 0; i < n; ++i) {
+        dst(i) = { re[i], im[i] };
+    }
+}
+
+}
+
+#pragma region interleaved
+NMS_API void cmul(View<cf32, 1> dst, View<const cf32, 1> a, View<const cf32, 1> b) {
+    _cbinary(dst, a, b, _cmul, [](cf32 x, cf32 y) { return x * y; });
+}
+
+NMS_API void cmulc(View<cf32, 1> dst, View<const cf32, 1> a, View<const cf32, 1> b) {
+    _cbinary(dst, a, b, _cmulc, [](cf32 x, cf32 y) { return x * ~y; });
+}
+
+NMS_API void cabs(View<f32, 1> dst, View<const cf32, 1> a) {
+    _cunary(dst, a, _cabs, [](cf32 x) { return abs(x); });
+}
+
+NMS_API void carg(View<f32, 1> dst, View<const cf32, 1> a) {
+    _cunary(dst, a, _carg, [](cf32 x) { return arg(x); });
+}
+
+NMS_API void cexp(View<cf32, 1> dst, View<const cf32, 1> a) {
+    _cunary(dst, a, _cexp, [](cf32 x) { return exp(x); });
+}
+#pragma endregion
+
+#pragma region split
+NMS_API void cmul(SplitArray<f32>& dst, const SplitArray<f32>& a, const SplitArray<f32>& b) {
+    const auto n = dst.count();
+    _check_size(n, a.count());
+    _check_size(n, b.count());
+
+    const auto ar = a.real().data(),   ai = a.imag().data();
+    const auto br = b.real().data(),   bi = b.imag().data();
+    const auto dr = dst.real().data(), di = dst.imag().data();
+    _blocks(n, [&](u32 i, u32 k) {
+        _store(dr + i, di + i, k, _cmul(_load(ar + i, ai + i, k), _load(br + i, bi + i, k)));
+    });
+}
+
+NMS_API void cmulc(SplitArray<f32>& dst, const SplitArray<f32>& a, const SplitArray<f32>& b) {
+    const auto n = dst.count();
+    _check_size(n, a.count());
+    _check_size(n, b.count());
+
+    const auto ar = a.real().data(),   ai = a.imag().data();
+    const auto br = b.real().data(),   bi = b.imag().data();
+    const auto dr = dst.real().data(), di = dst.imag().data();
+    _blocks(n, [&](u32 i, u32 k) {
+        _store(dr + i, di + i, k, _cmulc(_load(ar + i, ai + i, k), _load(br + i, bi + i, k)));
+    });
+}
+
+NMS_API void cabs(View<f32, 1> dst, const SplitArray<f32>& a) {
+    const auto n = dst.count();
+    _check_size(n, a.count());
+    _check_size(1, u32(dst.step(0)));
+
+    const auto ar = a.real().data(), ai = a.imag().data();
+    const auto pd = dst.data();
+    _blocks(n, [&](u32 i, u32 k) {
+        _store(pd + i, k, _cabs(_load(ar + i, ai + i, k)));
+    });
+}
+
+NMS_API void carg(View<f32, 1> dst, const SplitArray<f32>& a) {
+    const auto n = dst.count();
+    _check_size(n, a.count());
+    _check_size(1, u32(dst.step(0)));
+
+    const auto ar = a.real().data(), ai = a.imag().data();
+    const auto pd = dst.data();
+    _blocks(n, [&](u32 i, u32 k) {
+        _store(pd + i, k, _carg(_load(ar + i, ai + i, k)));
+    });
+}
+
+NMS_API void cexp(SplitArray<f32>& dst, const SplitArray<f32>& a) {
+    const auto n = dst.count();
+    _check_size(n, a.count());
+
+    const auto ar = a.real().data(),   ai = a.imag().data();
+    const auto dr = dst.real().data(), di = dst.imag().data();
+    _blocks(n, [&](u32 i, u32 k) {
+        _store(dr + i, di + i, k, _cexp(_load(ar + i, ai + i, k)));
+    });
+}
+
+NMS_API SplitArray<f32> csplit(View<const cf32, 1> src) {
+    return _csplit(src);
+}
+
+NMS_API SplitArray<f64> csplit(View<const cf64, 1> src) {
+    return _csplit(src);
+}
+
+NMS_API void cmerge(const SplitArray<f32>& src, View<cf32, 1> dst) {
+    _cmerge(src, dst);
+}
+
+NMS_API void cmerge(const SplitArray<f64>& src, View<cf64, 1> dst) {
+    _cmerge(src, dst);
+}
+#pragma endregion
+
+#pragma region unittest
+static Array<cf32> _complex_samples(u32 n) {
+    Array<cf32> a({ n });
+
+    u32 seed = 1;
+    for (u32 i = 0; i < n; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        const auto r = f32(seed >> 8) / f32(1u << 22) - 2.0f;
+        seed = seed * 1664525u + 1013904223u;
+        const auto m = f32(seed >> 8) / f32(1u << 22) - 2.0f;
+        a(i) = cf32(r, m * 10.0f);
+    }
+    a(0) = cf32(0.0f, 0.0f);
+    a(1) = cf32(-1.0f, 0.0f);
+    a(2) = cf32(0.0f, -3.0f);
+    return a;
+}
+
+nms_test(complex_scalar) {
+    const cf32 a(3.0f, 4.0f);
+    const cf32 b(1.0f, -2.0f);
+
+    test::assert_eq(abs(a), 5.0f);
+    test::assert_eq(norm(a), 25.0f);
+
+    const auto c = a / b;
+    test::assert_eq(c.r, -1.0f);
+    test::assert_eq(c.i,  2.0f);
+
+    const auto d = (a * b) / b;
+    test::assert_eq(d.r, a.r);
+    test::assert_eq(d.i, a.i);
+
+    const auto e = a * 2.0f;
+    test::assert_eq(e.i, 8.0f);
+
+    const auto f = 1.0f / b;
+    test::assert_eq(f.r, 0.2f);
+    test::assert_eq(f.i, 0.4f);
+}
+
+nms_test(complex_kernels) {
+    const u32 n = 1003;
+
+    auto a = _complex_samples(n);
+    auto b = _complex_samples(n + 7);
+    auto bv = b.slice({ 7, -1 });
+
+    Array<cf32> y({ n });
+    Array<f32>  m({ n });
+
+    cmul(y, a, bv);
+    for (u32 i = 0; i < n; ++i) {
+        const auto ref = a(i) * bv(i);
+        test::assert_true(abs(y(i) - ref) <= 1e-5f * (1.0f + abs(ref)));
+    }
+
+    cmulc(y, a, bv);
+    for (u32 i = 0; i < n; ++i) {
+        const auto ref = a(i) * ~bv(i);
+        test::assert_true(abs(y(i) - ref) <= 1e-5f * (1.0f + abs(ref)));
+    }
+
+    cabs(m, a);
+    for (u32 i = 0; i < n; ++i) {
+        test::assert_true(fabs(m(i) - abs(a(i))) <= 1e-6f * (1.0f + abs(a(i))));
+    }
+
+    carg(m, a);
+    for (u32 i = 0; i < n; ++i) {
+        test::assert_true(fabs(m(i) - arg(a(i))) <= 1e-6f);
+    }
+
+    cexp(y, a);
+    for (u32 i = 0; i < n; ++i) {
+        const auto ref = exp(a(i));
+        test::assert_true(abs(y(i) - ref) <= 2e-6f * abs(ref));
+    }
+
+    // strided views use the scalar path
+    View<cf32, 1> ys(y.data(), { n / 2 }, { 2 });
+    View<cf32, 1> as(a.data(), { n / 2 }, { 2 });
+    cmul(ys, as, as);
+    for (u32 i = 0; i < ys.count(); ++i) {
+        const auto ref = as(i) * as(i);
+        test::assert_true(abs(ys(i) - ref) <= 1e-5f * (1.0f + abs(ref)));
+    }
+}
+
+nms_test(complex_split) {
+    const u32 n = 100;
+
+    auto a = _complex_samples(n);
+    auto s = csplit(a);
+    test::assert_eq(s.count(), n);
+    for (u32 i = 0; i < n; ++i) {
+        test::assert_eq(s(i).r, a(i).r);
+        test::assert_eq(s(i).i, a(i).i);
+    }
+
+    // same results as the interleaved kernels
+    Array<cf32> y({ n });
+    Array<cf32> z({ n });
+    auto t = s.dup();
+
+    cmulc(t, s, s);
+    cmulc(y, a, a);
+    cmerge(t, z);
+    for (u32 i = 0; i < n; ++i) {
+        test::assert_eq(z(i).r, y(i).r);
+        test::assert_eq(z(i).i, y(i).i);
+    }
+
+    cexp(t, s);
+    cexp(y, a);
+    cmerge(t, z);
+    for (u32 i = 0; i < n; ++i) {
+        test::assert_eq(z(i).r, y(i).r);
+        test::assert_eq(z(i).i, y(i).i);
+    }
+
+    Array<f32> m({ n });
+    carg(m, s);
+    for (u32 i = 0; i < n; ++i) {
+        test::assert_true(fabs(m(i) - arg(a(i))) <= 1e-6f);
+    }
+}
+
+nms_test(complex_perf) {
+    const u32 n = 1u << 16;
+
+    auto a = _complex_samples(n);
+    auto b = a.dup();
+    auto s = csplit(a);
+    auto t = s.dup();
+    Array<cf32> y({ n });
+    Array<f32>  m({ n });
+
+    for (auto loop = 0; loop < 2; ++loop) {
+        auto t0 = nms::clock();
+        for (u32 i = 0; i < n; ++i) {
+            y(i) = a(i) * ~b(i);
+        }
+        auto t1 = nms::clock();
+        cmulc(y, a, b);
+        auto t2 = nms::clock();
+        cmulc(t, s, s);
+        auto t3 = nms::clock();
+        io::log::info("nms.math.complex: cmulc x {}: scalar={.3}ms, interleaved={.3}ms, split={.3}ms", n, (t1 - t0)*1e3, (t2 - t1)*1e3, (t3 - t2)*1e3);
+
+        t0 = nms::clock();
+        for (u32 i = 0; i < n; ++i) {
+            y(i) = exp(a(i));
+        }
+        t1 = nms::clock();
+        cexp(y, a);
+        t2 = nms::clock();
+        cexp(t, s);
+        t3 = nms::clock();
+        io::log::info("nms.math.complex: cexp  x {}: scalar={.3}ms, interleaved={.3}ms, split={.3}ms", n, (t1 - t0)*1e3, (t2 - t1)*1e3, (t3 - t2)*1e3);
+
+        t0 = nms::clock();
+        cabs(m, a);
+        t1 = nms::clock();
+        carg(m, a);
+        t2 = nms::clock();
+        auto u = csplit(a);
+        cmerge(u, y);
+        t3 = nms::clock();
+        io::log::info("nms.math.complex: cabs={.3}ms, carg={.3}ms, csplit+cmerge={.3}ms", (t1 - t0)*1e3, (t2 - t1)*1e3, (t3 - t2)*1e3);
+    }
+}
+#pragma endregion
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <nms/core/type.h>
+#include <nms/math/base.h>
+#include <nms/math/array.h>
 
 namespace nms::math
 {
@@ -19,29 +20,131 @@ public:
 using cf32 = complex<f32>;
 using cf64 = complex<f64>;
 
-template<class T> constexpr T abs(complex<T> t) { return t.r*t.r + t.i*t.i; }
+/* squared magnitude */
+template<class T> constexpr T norm(complex<T> t) { return t.r*t.r + t.i*t.i; }
 
+/* magnitude */
+template<class T> inline    T abs(complex<T> t) { return T(::sqrt(norm(t))); }
+
+/* phase, in (-pi, pi] */
+template<class T> inline    T arg(complex<T> t) { return atan2(t.i, t.r); }
+
+/* e^t */
+template<class T> inline complex<T> exp(complex<T> t) {
+    const auto m = exp(t.r);
+    return { m * cos(t.i), m * sin(t.i) };
+}
+
+/* conjugate */
 template<class T> constexpr complex<T> operator~(complex<T> t) { return { t.r, -t.i }; }
 
 template<class T> constexpr complex<T> operator+(complex<T> a, T b) { return { a.r + b, a.i }; }
 template<class T> constexpr complex<T> operator-(complex<T> a, T b) { return { a.r - b, a.i }; }
-template<class T> constexpr complex<T> operator*(complex<T> a, T b) { return { a.r * b, a.i }; }
-template<class T> constexpr complex<T> operator/(complex<T> a, T b) { return { a.r / b, a.i }; }
+template<class T> constexpr complex<T> operator*(complex<T> a, T b) { return { a.r * b, a.i * b }; }
+template<class T> constexpr complex<T> operator/(complex<T> a, T b) { return { a.r / b, a.i / b }; }
 
 template<class T> constexpr complex<T> operator+(T a, complex<T> b) { return { a + b.r, b.i }; }
-template<class T> constexpr complex<T> operator-(T a, complex<T> b) { return { a - b.r, b.i }; }
+template<class T> constexpr complex<T> operator-(T a, complex<T> b) { return { a - b.r, -b.i }; }
 template<class T> constexpr complex<T> operator*(T a, complex<T> b) { return { a * b.r, a * b.i }; }
-template<class T> constexpr complex<T> operator/(T a, complex<T> b) { return { a * b.r/(b.r*b.r+b.i*b.i), a * b.i/(b.r*b.r+b.i*b.i)}; }
+template<class T> constexpr complex<T> operator/(T a, complex<T> b) { return { a * b.r/norm(b), -a * b.i/norm(b) }; }
 
 template<class T> constexpr complex<T> operator+(complex<T> a, complex<T> b) { return { a.r + b.r, a.i + b.i }; }
 template<class T> constexpr complex<T> operator-(complex<T> a, complex<T> b) { return { a.r - b.r, a.i - b.i }; }
 template<class T> constexpr complex<T> operator*(complex<T> a, complex<T> b) { return { a.r * b.r-a.i*b.i, a.r*b.i + a.i*b.r }; }
-template<class T> constexpr complex<T> operator/(complex<T> a, complex<T> b) { return { (a*~b) / abs(b) }; }
+template<class T> constexpr complex<T> operator/(complex<T> a, complex<T> b) { return { (a*~b) / norm(b) }; }
 
 template<class T, class U> complex<T> operator+=(complex<T>& a, U b) { a = a + b;  return a; }
 template<class T, class U> complex<T> operator-=(complex<T>& a, U b) { a = a - b;  return a; }
 template<class T, class U> complex<T> operator*=(complex<T>& a, U b) { a = a * b;  return a; }
 template<class T, class U> complex<T> operator/=(complex<T>& a, U b) { a = a / b;  return a; }
 
-}
+#pragma region split layout
+/*!
+ * complex array in split layout: the real and the imaginary parts are two planes.
+ * each plane is a contiguous Array<T>, so the kernels load full SIMD registers
+ * without shuffling (interleaved cf32 has to be de-interleaved first).
+ */
+template<class T>
+class SplitArray
+{
+public:
+    SplitArray() = default;
+
+    explicit SplitArray(u32 count)
+        : real_({ count }), imag_({ count })
+    {}
+
+    SplitArray(SplitArray&&)            = default;
+    SplitArray& operator=(SplitArray&&) = default;
+
+    u32 count() const noexcept {
+        return real_.count();
+    }
+
+    View<T, 1>         real()       noexcept { return real_; }
+    View<const T, 1>   real() const noexcept { return real_; }
+    View<T, 1>         imag()       noexcept { return imag_; }
+    View<const T, 1>   imag() const noexcept { return imag_; }
+
+    complex<T> operator()(u32 idx) const noexcept {
+        return { real_(idx), imag_(idx) };
+    }
+
+    void set(u32 idx, complex<T> val) noexcept {
+        real_(idx) = val.r;
+        imag_(idx) = val.i;
+    }
 
+    SplitArray dup() const {
+        SplitArray tmp;
+        tmp.real_ = real_.dup();
+        tmp.imag_ = imag_.dup();
+        return tmp;
+    }
+
+protected:
+    Array<T>    real_;
+    Array<T>    imag_;
+};
+#pragma endregion
+
+#pragma region kernels
+/*!
+ * complex kernels, f32.
+ * contiguous views run 8 elements at a time in SIMD registers (f32x8),
+ * strided views fall back to the scalar operators.
+ * dst may alias the sources, sizes must match (@throw Eunexpect<u32>).
+ */
+
+/*! dst = a * b */
+NMS_API void cmul(View<cf32, 1> dst, View<const cf32, 1> a, View<const cf32, 1> b);
+
+/*! dst = a * ~b (multiply by the conjugate) */
+NMS_API void cmulc(View<cf32, 1> dst, View<const cf32, 1> a, View<const cf32, 1> b);
+
+/*! dst = abs(a) */
+NMS_API void cabs(View<f32, 1> dst, View<const cf32, 1> a);
+
+/*! dst = arg(a), max error ~2e-7 rad */
+NMS_API void carg(View<f32, 1> dst, View<const cf32, 1> a);
+
+/*! dst = exp(a), relative error ~1e-6 for |a.i| < 1e4 */
+NMS_API void cexp(View<cf32, 1> dst, View<const cf32, 1> a);
+
+/* split layout */
+NMS_API void cmul (SplitArray<f32>& dst, const SplitArray<f32>& a, const SplitArray<f32>& b);
+NMS_API void cmulc(SplitArray<f32>& dst, const SplitArray<f32>& a, const SplitArray<f32>& b);
+NMS_API void cabs (View<f32, 1>     dst, const SplitArray<f32>& a);
+NMS_API void carg (View<f32, 1>     dst, const SplitArray<f32>& a);
+NMS_API void cexp (SplitArray<f32>& dst, const SplitArray<f32>& a);
+
+/*! interleaved -> split */
+NMS_API SplitArray<f32> csplit(View<const cf32, 1> src);
+NMS_API SplitArray<f64> csplit(View<const cf64, 1> src);
+
+/*! split -> interleaved */
+NMS_API void cmerge(const SplitArray<f32>& src, View<cf32, 1> dst);
+NMS_API void cmerge(const SplitArray<f64>& src, View<cf64, 1> dst);
+#pragma endregion
+
+}
@@ -0,0 +1,312 @@
+#include <nms/test.h>
+#include <nms/math.h>
+#include <nms/math/csv.h>
+#include <nms/io.h>
+#include <nms/thread/parallel.h>
+
+namespace nms::math
+{
+
+using thread::parallel_for;
+using thread::parallel_threads;
+
+#pragma region load
+/* bytes read per block */
+static const u32 gCsvBlock = 64 * 1024 * 1024;
+
+/* a piece of a block: the rows that start in [beg, end) */
+struct CsvPiece
+{
+    const char* beg;
+    const char* end;
+    u64         rows;   // non-empty rows
+    u64         row0;   // index of the first value row
+    u64         error;  // text row (in the piece) of the first bad row, u64(-1): none
+};
+
+static bool _csv_blank(const ByteSet& blanks, const char* s, const char* e) {
+    while (s < e && blanks.test(u8(*s))) {
+        ++s;
+    }
+    return s == e;
+}
+
+/* the first row start at or after pos */
+static const char* _csv_row_start(const char* beg, const char* end, const char* pos) {
+    if (pos <= beg) {
+        return beg;
+    }
+    const auto p = pos - 1;
+    const auto n = u64(end - p);
+    return p + min(n, _mfind(p, n, '\n') + 1);
+}
+
+template<class T>
+static void _csv_load_impl(const io::Path& path, char delim, u32 skip_rows, Array<T, 2>& dst) {
+    io::File file(path, io::File::Read);
+    if (!file) {
+        dst.clear();
+        return;
+    }
+
+    const char delims[] = { delim, ' ', '\t', '\r' };
+    const auto delim_str = StrView(delims, 4);
+    const auto blanks    = ByteSet(delims, 4);
+
+    // every number takes at least 2 bytes: a digit and a delimiter
+    const auto fsize = file.size();
+    const auto limit = fsize / 2 + 1 < 0xFFFFFFFFull ? u32(fsize / 2 + 1) : 0xFFFFFFFFu;
+    VList<T> vals(limit);
+
+    const auto npieces = parallel_threads() * 4;
+    List<CsvPiece> pieces;
+    pieces.appends(npieces, CsvPiece{});
+
+    String<> buf;
+    u32 cols     = 0;
+    u64 text_row = 0;       // text rows before this block
+    auto skip    = skip_rows;
+    auto eof     = false;
+
+    while (!eof) {
+        const auto carry = buf.count();
+        buf.reserve(carry + gCsvBlock);
+        const auto nread = file.read(buf.data() + carry, gCsvBlock);
+        buf.resize(carry + u32(nread));
+        eof = nread < gCsvBlock;
+
+        // the whole rows of the block
+        const auto data = buf.data();
+        auto beg = data;
+        auto end = data + buf.count();
+        if (!eof) {
+            auto last = end;
+            while (last > beg && last[-1] != '\n') {
+                --last;
+            }
+            if (last == beg) {
+                continue;   // a row longer than a block
+            }
+            end = last;
+        }
+
+        // header rows
+        while (skip > 0 && beg < end) {
+            beg += _mfind(beg, u64(end - beg), '\n');
+            beg += beg < end ? 1 : 0;
+            ++text_row;
+            --skip;
+        }
+
+        // the column count: numbers in the first non-empty row
+        while (cols == 0 && beg < end) {
+            const auto row_end = beg + _mfind(beg, u64(end - beg), '\n');
+            if (!_csv_blank(blanks, beg, row_end)) {
+                const auto row = StrView(beg, u32(row_end - beg));
+                List<T> tmp(row.count() / 2 + 1);
+                tmp.resize(row.count() / 2 + 1);
+                u64 pos = 0;
+                cols = u32(_parses(row, delim_str, tmp.data(), tmp.count(), 1, &pos));
+                if (cols == 0) {
+                    NMS_THROW(ECsvParse{ text_row });
+                }
+                break;
+            }
+            beg = row_end < end ? row_end + 1 : end;
+            ++text_row;
+        }
+
+        // pass 1: each piece finds and counts its rows
+        const auto step = u64(end - beg) / npieces + 1;
+        parallel_for(npieces, [&](u32 k) {
+            auto& piece = pieces[k];
+            piece.beg   = _csv_row_start(beg, end, beg + min(u64(end - beg), step * k));
+            piece.end   = _csv_row_start(beg, end, beg + min(u64(end - beg), step * (k + 1)));
+            piece.rows  = 0;
+            piece.error = u64(-1);
+
+            for (auto s = piece.beg; s < piece.end; ) {
+                const auto e = s + _mfind(s, u64(piece.end - s), '\n');
+                piece.rows += _csv_blank(blanks, s, e) ? 0 : 1;
+                s = e + 1;
+            }
+        });
+
+        u64 rows = vals.count() / (cols == 0 ? 1 : cols);
+        for (auto& piece : pieces) {
+            piece.row0 = rows;
+            rows += piece.rows;
+        }
+        if (rows * cols > vals.reserved()) {
+            NMS_THROW(EBadAlloc{});
+        }
+        vals.resize(u32(rows * cols));
+
+        // pass 2: parse the rows into place
+        const auto pvals = vals.data();
+        parallel_for(npieces, [&](u32 k) {
+            auto& piece = pieces[k];
+            auto  out   = pvals + piece.row0 * cols;
+            auto  line  = u64(0);
+
+            for (auto s = piece.beg; s < piece.end; ++line) {
+                const auto e = s + _mfind(s, u64(piece.end - s), '\n');
+                if (!_csv_blank(blanks, s, e)) {
+                    u64 pos = 0;
+                    const auto row = StrView(s, u32(e - s));
+                    const auto cnt = _parses(row, delim_str, out, cols, 1, &pos);
+                    if (cnt != cols || !_csv_blank(blanks, s + pos, e)) {
+                        piece.error = line;
+                        return;
+                    }
+                    out += cols;
+                }
+                s = e + 1;
+            }
+        });
+
+        // stitch: the text rows of the block, and the first error
+        for (auto& piece : pieces) {
+            if (piece.error != u64(-1)) {
+                NMS_THROW(ECsvParse{ text_row + piece.error });
+            }
+            text_row += _mcount(piece.beg, u64(piece.end - piece.beg), '\n');
+        }
+
+        // keep the partial row for the next block
+        const auto rest = u32(data + buf.count() - end);
+        ::memmove(data, end, rest);
+        buf.resize(rest);
+    }
+
+    const auto rows = cols == 0 ? 0u : vals.count() / cols;
+    if (rows == 0) {
+        dst.clear();
+        return;
+    }
+    dst.resize({ cols, rows });
+    mcpy(dst.data(), vals.data(), vals.count());
+}
+#pragma endregion
+
+#pragma region save
+template<class T>
+static void _csv_save_impl(const io::Path& path, char delim, const View<T, 2>& src) {
+    io::File file(path, io::File::Write);
+
+    const auto cols = src.size(0);
+    const auto rows = src.size(1);
+
+    // rows per piece: about 64K numbers
+    const auto npieces = parallel_threads() * 4;
+    const auto nrows   = max(1u, 65536u / max(1u, cols));
+
+    List<String<> > bufs;
+    for (u32 k = 0; k < npieces; ++k) {
+        bufs.append(String<>{});
+    }
+
+    for (u32 r0 = 0; r0 < rows; r0 += npieces * nrows) {
+        parallel_for(npieces, [&](u32 k) {
+            auto& buf = bufs[k];
+            buf.clear();
+
+            const auto rbeg = min(rows, r0 + k * nrows);
+            const auto rend = min(rows, rbeg + nrows);
+            for (auto r = rbeg; r < rend; ++r) {
+                for (u32 c = 0; c < cols; ++c) {
+                    _format(buf, {}, src(c, r));
+                    buf += c + 1 == cols ? '\n' : delim;
+                }
+            }
+        });
+
+        for (auto& buf : bufs) {
+            file.write(buf.data(), buf.count());
+        }
+    }
+}
+#pragma endregion
+
+NMS_API void _csv_load(const io::Path& path, char delim, u32 skip_rows, Array<i32, 2>& dst) { _csv_load_impl(path, delim, skip_rows, dst); }
+NMS_API void _csv_load(const io::Path& path, char delim, u32 skip_rows, Array<u32, 2>& dst) { _csv_load_impl(path, delim, skip_rows, dst); }
+NMS_API void _csv_load(const io::Path& path, char delim, u32 skip_rows, Array<i64, 2>& dst) { _csv_load_impl(path, delim, skip_rows, dst); }
+NMS_API void _csv_load(const io::Path& path, char delim, u32 skip_rows, Array<u64, 2>& dst) { _csv_load_impl(path, delim, skip_rows, dst); }
+NMS_API void _csv_load(const io::Path& path, char delim, u32 skip_rows, Array<f32, 2>& dst) { _csv_load_impl(path, delim, skip_rows, dst); }
+NMS_API void _csv_load(const io::Path& path, char delim, u32 skip_rows, Array<f64, 2>& dst) { _csv_load_impl(path, delim, skip_rows, dst); }
+
+NMS_API void _csv_save(const io::Path& path, char delim, const View<i32, 2>& src) { _csv_save_impl(path, delim, src); }
+NMS_API void _csv_save(const io::Path& path, char delim, const View<u32, 2>& src) { _csv_save_impl(path, delim, src); }
+NMS_API void _csv_save(const io::Path& path, char delim, const View<i64, 2>& src) { _csv_save_impl(path, delim, src); }
+NMS_API void _csv_save(const io::Path& path, char delim, const View<u64, 2>& src) { _csv_save_impl(path, delim, src); }
+NMS_API void _csv_save(const io::Path& path, char delim, const View<f32, 2>& src) { _csv_save_impl(path, delim, src); }
+NMS_API void _csv_save(const io::Path& path, char delim, const View<f64, 2>& src) { _csv_save_impl(path, delim, src); }
+
+#pragma region unittest
+nms_test(csv) {
+    {
+        io::TxtFile file("nms.math.csv.csv", io::File::Write);
+        file.write("a,b,c\r\n1, 2.5, -3\r\n\r\n4,5e1,6\n7,8,9");
+    }
+    auto x = csv_load<f64>("nms.math.csv.csv", ',', 1);
+    test::assert_eq(x.size(), { 3u, 3u });
+    test::assert_eq(x(1, 0), 2.5);
+    test::assert_eq(x(2, 0), -3.0);
+    test::assert_eq(x(1, 1), 50.0);
+    test::assert_eq(x(2, 2), 9.0);
+
+    // tsv, round trip
+    Array<f32, 2> y({ 5, 1000 });
+    y <<= vsin(vline(0.1f, 0.37f)) * 1000;
+    csv_save("nms.math.csv.tsv", y, '\t');
+    auto z = csv_load<f32>("nms.math.csv.tsv", '\t');
+    test::assert_eq(z.size(), y.size());
+    for (u32 j = 0; j < 1000; ++j) {
+        for (u32 i = 0; i < 5; ++i) {
+            test::assert_eq(z(i, j), y(i, j));
+        }
+    }
+
+    // a short row
+    {
+        io::TxtFile file("nms.math.csv.csv", io::File::Write);
+        file.write("1,2,3\n4,5,6\n7,8\n");
+    }
+    try {
+        csv_load<i32>("nms.math.csv.csv");
+        test::assert_true(false);
+    }
+    catch (const ECsvParse& e) {
+        test::assert_eq(e.row(), u64(2));
+    }
+
+    io::remove("nms.math.csv.csv");
+    io::remove("nms.math.csv.tsv");
+}
+
+/* write and read a 2M numbers matrix */
+nms_test(csv_perf) {
+    static const u32 cols = 64;
+    static const u32 rows = 32 * 1024;
+
+    Array<f32, 2> x({ cols, rows });
+    x <<= vsin(vline(0.001f, 0.37f)) * 100;
+
+    const auto t0 = nms::clock();
+    csv_save("nms.math.csv_perf.csv", x);
+    const auto t1 = nms::clock();
+    auto y = csv_load<f32>("nms.math.csv_perf.csv");
+    const auto t2 = nms::clock();
+
+    test::assert_eq(y.size(), x.size());
+    test::assert_eq(y(cols - 1, rows - 1), x(cols - 1, rows - 1));
+
+    const auto mb = f64(io::fsize("nms.math.csv_perf.csv")) / (1024 * 1024);
+    io::log::info("nms.math.csv: {}x{} f32, {.1}MB, threads={}: save {.1}MB/s, load {.1}MB/s",
+        cols, rows, mb, parallel_threads(), mb / (t1 - t0), mb / (t2 - t1));
+
+    io::remove("nms.math.csv_perf.csv");
+}
+#pragma endregion
+
+}
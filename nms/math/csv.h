@@ -0,0 +1,71 @@
+#pragma once
+
+#include <nms/math/array.h>
+
+namespace nms::math
+{
+
+/*! a row of a delimited text file has not the same count of numbers as the first row */
+class ECsvParse
+    : public IException
+{
+public:
+    explicit ECsvParse(u64 row)
+        : row_(row)
+    {}
+
+    /* index of the row, the skipped rows included */
+    u64 row() const noexcept {
+        return row_;
+    }
+
+    void format(String<>& buf) const override {
+        sformat(buf, "row={}", row_);
+    }
+
+protected:
+    u64 row_;
+};
+
+#pragma region csv impl
+NMS_API void _csv_load(const io::Path& path, char delim, u32 skip_rows, Array<i32, 2>& dst);
+NMS_API void _csv_load(const io::Path& path, char delim, u32 skip_rows, Array<u32, 2>& dst);
+NMS_API void _csv_load(const io::Path& path, char delim, u32 skip_rows, Array<i64, 2>& dst);
+NMS_API void _csv_load(const io::Path& path, char delim, u32 skip_rows, Array<u64, 2>& dst);
+NMS_API void _csv_load(const io::Path& path, char delim, u32 skip_rows, Array<f32, 2>& dst);
+NMS_API void _csv_load(const io::Path& path, char delim, u32 skip_rows, Array<f64, 2>& dst);
+
+NMS_API void _csv_save(const io::Path& path, char delim, const View<i32, 2>& src);
+NMS_API void _csv_save(const io::Path& path, char delim, const View<u32, 2>& src);
+NMS_API void _csv_save(const io::Path& path, char delim, const View<i64, 2>& src);
+NMS_API void _csv_save(const io::Path& path, char delim, const View<u64, 2>& src);
+NMS_API void _csv_save(const io::Path& path, char delim, const View<f32, 2>& src);
+NMS_API void _csv_save(const io::Path& path, char delim, const View<f64, 2>& src);
+#pragma endregion
+
+/*!
+ * load a delimited text file (csv: ',', tsv: '\t') of numbers.
+ * a text row is x(:, row): dim 0 is the column.
+ * the file is read in blocks; each block is cut into pieces, one per task,
+ * every task finds its own rows and parses them into place.
+ * blanks and '\r' around the numbers are ignored, empty lines are skipped.
+ * throws ECsvParse if a row has not the column count of the first one.
+ */
+template<class T>
+Array<T, 2> csv_load(const io::Path& path, char delim = ',', u32 skip_rows = 0) {
+    Array<T, 2> dst;
+    _csv_load(path, delim, skip_rows, dst);
+    return dst;
+}
+
+/*!
+ * save x as a delimited text file, a text row per x(:, row).
+ * blocks of rows are formatted in parallel, then written in order.
+ * floats are written as the shortest text that reads back the same.
+ */
+template<class T>
+void csv_save(const io::Path& path, const View<T, 2>& src, char delim = ',') {
+    _csv_save(path, delim, src);
+}
+
+}
@@ -0,0 +1,1142 @@
+#include <nms/test.h>
+#include <nms/math.h>
+#include <nms/math/linalg.h>
+#include <nms/thread/atomic.h>
+#include <nms/thread/parallel.h>
+
+namespace nms::math
+{
+
+using thread::parallel_for;
+using thread::parallel_threads;
+
+#pragma region matrix
+/* strided matrix reference used by the kernels */
+template<class T>
+struct _Mat
+{
+    T*  data;
+    i32 rs;     // row step
+    i32 cs;     // column step
+    u32 rows;
+    u32 cols;
+
+    __forceinline T& operator()(u32 i, u32 j) const noexcept {
+        return data[i32(i) * rs + i32(j) * cs];
+    }
+
+    /* sub matrix */
+    __forceinline _Mat sub(u32 i, u32 j, u32 m, u32 n) const noexcept {
+        return { data + i32(i) * rs + i32(j) * cs, rs, cs, m, n };
+    }
+
+    /* transposed matrix */
+    __forceinline _Mat t() const noexcept {
+        return { data, cs, rs, cols, rows };
+    }
+
+    operator _Mat<const T>() const noexcept {
+        return { data, rs, cs, rows, cols };
+    }
+};
+
+template<class T>
+static _Mat<T> _mat(View<T, 2> v) {
+    return { v.data(), v.step(0), v.step(1), v.size(0), v.size(1) };
+}
+
+template<class T>
+static _Mat<T> _mat(Array<T, 2>& v) {
+    return { v.data(), v.step(0), v.step(1), v.size(0), v.size(1) };
+}
+
+static void _check_size(u32 expect, u32 value) {
+    if (expect != value) {
+        NMS_THROW(Eunexpect<u32>(expect, value));
+    }
+}
+#pragma endregion
+
+#pragma region gemm
+/*
+ * gemm: c = alpha * a * b + beta * c
+ *
+ * goto/blis style: b is packed in kc x nc panels (shared), a in mc x kc blocks
+ * (per tile), a mr x nr micro kernel accumulates in SIMD registers (Vec<T, 32/sizeof(T)>).
+ */
+template<class T>
+struct _Gemm
+{
+    using V = Vec<T, 32 / sizeof(T)>;
+
+    static constexpr u32 $vr = V::$size;
+    static constexpr u32 $mr = 2 * $vr;
+    static constexpr u32 $nr = 4;
+    static constexpr u32 $mc = 128;
+    static constexpr u32 $kc = 256;
+    static constexpr u32 $nc = 4096;
+};
+
+template<class T>
+static u32 _round_up(T x, T y) {
+    return (x + y - 1) / y * y;
+}
+
+/* pack a(0:m, 0:k) into panels of mr rows, scaled by alpha */
+template<class T>
+static void _gemm_pack_a(T alpha, _Mat<const T> a, T* ap) {
+    constexpr auto $mr = _Gemm<T>::$mr;
+
+    for (u32 ir = 0; ir < a.rows; ir += $mr) {
+        const auto mr = nms::min($mr, a.rows - ir);
+        for (u32 p = 0; p < a.cols; ++p) {
+            for (u32 i = 0; i < mr; ++i) {
+                ap[i] = alpha * a(ir + i, p);
+            }
+            for (u32 i = mr; i < $mr; ++i) {
+                ap[i] = T(0);
+            }
+            ap += $mr;
+        }
+    }
+}
+
+/* pack b(0:k, jr:jr+nr) into one panel of nr columns */
+template<class T>
+static void _gemm_pack_b(_Mat<const T> b, u32 jr, T* bp) {
+    constexpr auto $nr = _Gemm<T>::$nr;
+
+    const auto nr = nms::min($nr, b.cols - jr);
+    for (u32 p = 0; p < b.rows; ++p) {
+        for (u32 j = 0; j < nr; ++j) {
+            bp[j] = b(p, jr + j);
+        }
+        for (u32 j = nr; j < $nr; ++j) {
+            bp[j] = T(0);
+        }
+        bp += $nr;
+    }
+}
+
+/* c(0:mr, 0:nr) = beta * c + ap * bp */
+template<class T>
+static void _gemm_kernel(u32 k, const T* ap, const T* bp, T beta, _Mat<T> c) {
+    using V = typename _Gemm<T>::V;
+    constexpr auto $vr = _Gemm<T>::$vr;
+    constexpr auto $mr = _Gemm<T>::$mr;
+    constexpr auto $nr = _Gemm<T>::$nr;
+
+    V c0[$nr];
+    V c1[$nr];
+    for (u32 j = 0; j < $nr; ++j) {
+        c0[j] = V(T(0));
+        c1[j] = V(T(0));
+    }
+
+    for (u32 p = 0; p < k; ++p) {
+        const auto a0 = V::load(ap);
+        const auto a1 = V::load(ap + $vr);
+        for (u32 j = 0; j < $nr; ++j) {
+            const auto bj = V(bp[j]);
+            c0[j] = c0[j] + a0 * bj;
+            c1[j] = c1[j] + a1 * bj;
+        }
+        ap += $mr;
+        bp += $nr;
+    }
+
+    alignas(64) T acc[$nr][$mr];
+    for (u32 j = 0; j < $nr; ++j) {
+        c0[j].store(acc[j]);
+        c1[j].store(acc[j] + $vr);
+    }
+
+    for (u32 j = 0; j < c.cols; ++j) {
+        for (u32 i = 0; i < c.rows; ++i) {
+            auto& cij = c(i, j);
+            cij = beta == T(0) ? acc[j][i] : beta == T(1) ? cij + acc[j][i] : beta * cij + acc[j][i];
+        }
+    }
+}
+
+template<class T>
+static void _gemm_scale(T beta, _Mat<T> c) {
+    for (u32 j = 0; j < c.cols; ++j) {
+        for (u32 i = 0; i < c.rows; ++i) {
+            c(i, j) = beta == T(0) ? T(0) : beta * c(i, j);
+        }
+    }
+}
+
+template<class T>
+static void _gemm(T alpha, _Mat<const T> a, _Mat<const T> b, T beta, _Mat<T> c) {
+    constexpr auto $mr = _Gemm<T>::$mr;
+    constexpr auto $nr = _Gemm<T>::$nr;
+    constexpr auto $kc = _Gemm<T>::$kc;
+    constexpr auto $nc = _Gemm<T>::$nc;
+
+    const auto m = c.rows;
+    const auto n = c.cols;
+    const auto k = a.cols;
+    _check_size(m, a.rows);
+    _check_size(k, b.rows);
+    _check_size(n, b.cols);
+
+    if (m == 0 || n == 0) {
+        return;
+    }
+    if (k == 0 || alpha == T(0)) {
+        _gemm_scale(beta, c);
+        return;
+    }
+
+    // make enough tiles for every thread
+    const auto threads = parallel_threads();
+    auto mc = _Gemm<T>::$mc;
+    if ((m + mc - 1) / mc < threads) {
+        mc = nms::max($mr, _round_up((m + threads - 1) / threads, $mr));
+    }
+    const auto tiles = (m + mc - 1) / mc;
+
+    const auto nc_max = nms::min($nc, _round_up(n, $nr));
+    const auto kc_max = nms::min($kc, k);
+    auto bp = anew<T>(u64(kc_max) * nc_max, 64);
+
+    for (u32 jc = 0; jc < n; jc += $nc) {
+        const auto nb = nms::min($nc, n - jc);
+
+        for (u32 pc = 0; pc < k; pc += $kc) {
+            const auto kb = nms::min($kc, k - pc);
+            const auto bb = b.sub(pc, jc, kb, nb);
+            const auto beta_p = pc == 0 ? beta : T(1);
+
+            const auto panels = (nb + $nr - 1) / $nr;
+            parallel_for(panels, [&](u32 jp) {
+                _gemm_pack_b(bb, jp * $nr, bp + jp * $nr * kb);
+            });
+
+            parallel_for(tiles, [&](u32 tile) {
+                const auto ic = tile * mc;
+                const auto mb = nms::min(mc, m - ic);
+
+                auto ap = anew<T>(u64(_round_up(mb, $mr)) * kb, 64);
+                _gemm_pack_a(alpha, a.sub(ic, pc, mb, kb), ap);
+
+                for (u32 jr = 0; jr < nb; jr += $nr) {
+                    const auto nr = nms::min($nr, nb - jr);
+                    for (u32 ir = 0; ir < mb; ir += $mr) {
+                        const auto mr = nms::min($mr, mb - ir);
+                        _gemm_kernel(kb, ap + ir * kb, bp + jr * kb, beta_p, c.sub(ic + ir, jc + jr, mr, nr));
+                    }
+                }
+                adel(ap);
+            });
+        }
+    }
+
+    adel(bp);
+}
+#pragma endregion
+
+#pragma region trsm
+/* unblocked trsm on columns [j0, j1) of b */
+template<class T>
+static void _trsm_cols(Uplo uplo, Diag diag, _Mat<const T> a, _Mat<T> b, u32 j0, u32 j1) {
+    const auto n = a.rows;
+
+    for (u32 j = j0; j < j1; ++j) {
+        if (uplo == Uplo::Lower) {
+            for (u32 k = 0; k < n; ++k) {
+                auto& x = b(k, j);
+                if (diag == Diag::NonUnit) {
+                    x /= a(k, k);
+                }
+                const auto t = x;
+                for (u32 i = k + 1; i < n; ++i) {
+                    b(i, j) -= a(i, k) * t;
+                }
+            }
+        }
+        else {
+            for (u32 k = n; k-- > 0; ) {
+                auto& x = b(k, j);
+                if (diag == Diag::NonUnit) {
+                    x /= a(k, k);
+                }
+                const auto t = x;
+                for (u32 i = 0; i < k; ++i) {
+                    b(i, j) -= a(i, k) * t;
+                }
+            }
+        }
+    }
+}
+
+template<class T>
+static void _trsm_unblocked(Uplo uplo, Diag diag, _Mat<const T> a, _Mat<T> b) {
+    constexpr u32 $cols = 16;
+    const auto chunks = (b.cols + $cols - 1) / $cols;
+
+    parallel_for(chunks, [&](u32 chunk) {
+        const auto j0 = chunk * $cols;
+        const auto j1 = nms::min(j0 + $cols, b.cols);
+        _trsm_cols(uplo, diag, a, b, j0, j1);
+    });
+}
+
+template<class T>
+static void _trsm(Uplo uplo, Diag diag, _Mat<const T> a, _Mat<T> b) {
+    constexpr u32 $nb = 64;
+
+    const auto n = a.rows;
+    _check_size(n, a.cols);
+    _check_size(n, b.rows);
+
+    if (n <= $nb) {
+        _trsm_unblocked(uplo, diag, a, b);
+        return;
+    }
+
+    if (uplo == Uplo::Lower) {
+        for (u32 i = 0; i < n; i += $nb) {
+            const auto ib = nms::min($nb, n - i);
+            auto bi = b.sub(i, 0, ib, b.cols);
+            _trsm_unblocked(uplo, diag, a.sub(i, i, ib, ib), bi);
+
+            if (i + ib < n) {
+                _gemm(T(-1), a.sub(i + ib, i, n - i - ib, ib), _Mat<const T>(bi), T(1), b.sub(i + ib, 0, n - i - ib, b.cols));
+            }
+        }
+    }
+    else {
+        for (u32 e = n; e > 0; ) {
+            const auto ib = nms::min($nb, e);
+            const auto i  = e - ib;
+            auto bi = b.sub(i, 0, ib, b.cols);
+            _trsm_unblocked(uplo, diag, a.sub(i, i, ib, ib), bi);
+
+            if (i > 0) {
+                _gemm(T(-1), a.sub(0, i, i, ib), _Mat<const T>(bi), T(1), b.sub(0, 0, i, b.cols));
+            }
+            e = i;
+        }
+    }
+}
+#pragma endregion
+
+#pragma region lu
+/* unblocked LU of a (m x n), returns k+1 of the first zero pivot, or 0 */
+template<class T>
+static u32 _getf2(_Mat<T> a, u32* piv) {
+    const auto m  = a.rows;
+    const auto n  = a.cols;
+    const auto mn = nms::min(m, n);
+
+    u32 info = 0;
+    for (u32 k = 0; k < mn; ++k) {
+        // find pivot
+        auto p = k;
+        auto v = fabs(a(k, k));
+        for (u32 i = k + 1; i < m; ++i) {
+            const auto t = fabs(a(i, k));
+            if (t > v) {
+                p = i;
+                v = t;
+            }
+        }
+        piv[k] = p;
+
+        if (a(p, k) != T(0)) {
+            if (p != k) {
+                for (u32 j = 0; j < n; ++j) {
+                    nms::swap(a(k, j), a(p, j));
+                }
+            }
+            const auto r = T(1) / a(k, k);
+            for (u32 i = k + 1; i < m; ++i) {
+                a(i, k) *= r;
+            }
+        }
+        else if (info == 0) {
+            info = k + 1;
+        }
+
+        // rank-1 update
+        for (u32 j = k + 1; j < n; ++j) {
+            const auto t = a(k, j);
+            if (t == T(0)) {
+                continue;
+            }
+            for (u32 i = k + 1; i < m; ++i) {
+                a(i, j) -= a(i, k) * t;
+            }
+        }
+    }
+    return info;
+}
+
+/* apply the row swaps piv[k0:k1] to columns [j0, j1) */
+template<class T>
+static void _laswp(_Mat<T> a, const u32* piv, u32 k0, u32 k1, u32 j0, u32 j1) {
+    for (u32 j = j0; j < j1; ++j) {
+        for (u32 k = k0; k < k1; ++k) {
+            const auto p = piv[k];
+            if (p != k) {
+                nms::swap(a(k, j), a(p, j));
+            }
+        }
+    }
+}
+
+template<class T>
+static void _laswp_parallel(_Mat<T> a, const u32* piv, u32 k0, u32 k1, u32 j0, u32 j1) {
+    constexpr u32 $cols = 32;
+    if (j1 <= j0) {
+        return;
+    }
+
+    const auto chunks = (j1 - j0 + $cols - 1) / $cols;
+    parallel_for(chunks, [&](u32 chunk) {
+        const auto c0 = j0 + chunk * $cols;
+        const auto c1 = nms::min(c0 + $cols, j1);
+        _laswp(a, piv, k0, k1, c0, c1);
+    });
+}
+
+template<class T>
+static u32 _getrf(_Mat<T> a, u32* piv) {
+    constexpr u32 $nb = 64;
+
+    const auto m  = a.rows;
+    const auto n  = a.cols;
+    const auto mn = nms::min(m, n);
+
+    if (mn <= $nb) {
+        return _getf2(a, piv);
+    }
+
+    u32 info = 0;
+    for (u32 j = 0; j < mn; j += $nb) {
+        const auto jb = nms::min($nb, mn - j);
+
+        // factor panel
+        const auto panel_info = _getf2(a.sub(j, j, m - j, jb), piv + j);
+        if (info == 0 && panel_info != 0) {
+            info = panel_info + j;
+        }
+        for (u32 k = j; k < j + jb; ++k) {
+            piv[k] += j;
+        }
+
+        // apply swaps to the left and the right columns
+        _laswp_parallel(a, piv, j, j + jb, 0, j);
+        _laswp_parallel(a, piv, j, j + jb, j + jb, n);
+
+        if (j + jb < n) {
+            // U12 = L11^-1 * A12
+            auto a12 = a.sub(j, j + jb, jb, n - j - jb);
+            _trsm(Uplo::Lower, Diag::Unit, _Mat<const T>(a.sub(j, j, jb, jb)), a12);
+
+            // A22 -= L21 * U12
+            if (j + jb < m) {
+                _gemm(T(-1), _Mat<const T>(a.sub(j + jb, j, m - j - jb, jb)), _Mat<const T>(a12), T(1), a.sub(j + jb, j + jb, m - j - jb, n - j - jb));
+            }
+        }
+    }
+    return info;
+}
+
+template<class T>
+static void _lu(_Mat<T> a, View<u32, 1> piv) {
+    _check_size(nms::min(a.rows, a.cols), piv.count());
+    _check_size(1, u32(piv.step(0)));
+
+    const auto info = _getrf(a, piv.data());
+    if (info != 0) {
+        NMS_THROW(ESingular{ info - 1 });
+    }
+}
+
+template<class T>
+static void _lu_solve(_Mat<const T> lu, const u32* piv, _Mat<T> b, bool parallel) {
+    const auto n = lu.rows;
+    _check_size(n, lu.cols);
+    _check_size(n, b.rows);
+
+    if (parallel) {
+        _laswp_parallel(b, piv, 0, n, 0, b.cols);
+        _trsm(Uplo::Lower, Diag::Unit,    lu, b);
+        _trsm(Uplo::Upper, Diag::NonUnit, lu, b);
+    }
+    else {
+        _laswp(b, piv, 0, n, 0, b.cols);
+        _trsm_cols(Uplo::Lower, Diag::Unit,    lu, b, 0, b.cols);
+        _trsm_cols(Uplo::Upper, Diag::NonUnit, lu, b, 0, b.cols);
+    }
+}
+#pragma endregion
+
+#pragma region cholesky
+/* unblocked lower Cholesky (left-looking), returns k+1 of the first non-positive pivot, or 0 */
+template<class T>
+static u32 _potf2(_Mat<T> a) {
+    const auto n = a.rows;
+
+    for (u32 j = 0; j < n; ++j) {
+        auto d = a(j, j);
+        for (u32 k = 0; k < j; ++k) {
+            d -= a(j, k) * a(j, k);
+        }
+        if (!(d > T(0))) {
+            return j + 1;
+        }
+        d = T(::sqrt(d));
+        a(j, j) = d;
+
+        const auto r = T(1) / d;
+        for (u32 i = j + 1; i < n; ++i) {
+            auto s = a(i, j);
+            for (u32 k = 0; k < j; ++k) {
+                s -= a(i, k) * a(j, k);
+            }
+            a(i, j) = s * r;
+        }
+    }
+    return 0;
+}
+
+template<class T>
+static u32 _potrf(_Mat<T> a) {
+    constexpr u32 $nb = 64;
+
+    const auto n = a.rows;
+
+    u32 info = 0;
+    if (n <= $nb) {
+        info = _potf2(a);
+    }
+    else {
+        for (u32 j = 0; j < n; j += $nb) {
+            const auto jb = nms::min($nb, n - j);
+
+            const auto diag_info = _potf2(a.sub(j, j, jb, jb));
+            if (diag_info != 0) {
+                info = diag_info + j;
+                break;
+            }
+
+            if (j + jb < n) {
+                const auto rows = n - j - jb;
+                const auto l11  = a.sub(j, j, jb, jb);
+                auto       l21  = a.sub(j + jb, j, rows, jb);
+
+                // L21 = A21 * L11^-T  <=>  L21^T = L11^-1 * A21^T
+                _trsm(Uplo::Lower, Diag::NonUnit, _Mat<const T>(l11), l21.t());
+
+                // A22 -= L21 * L21^T (lower part, by column blocks)
+                for (u32 jj = 0; jj < rows; jj += $nb) {
+                    const auto jjb = nms::min($nb, rows - jj);
+                    _gemm(T(-1), _Mat<const T>(l21.sub(jj, 0, rows - jj, jb)), _Mat<const T>(l21.sub(jj, 0, jjb, jb).t()), T(1), a.sub(j + jb + jj, j + jb + jj, rows - jj, jjb));
+                }
+            }
+        }
+    }
+
+    // L only
+    for (u32 j = 1; j < n; ++j) {
+        for (u32 i = 0; i < j; ++i) {
+            a(i, j) = T(0);
+        }
+    }
+    return info;
+}
+
+template<class T>
+static void _cholesky(_Mat<T> a) {
+    _check_size(a.rows, a.cols);
+
+    const auto info = _potrf(a);
+    if (info != 0) {
+        NMS_THROW(ESingular{ info - 1 });
+    }
+}
+
+template<class T>
+static void _cholesky_solve(_Mat<const T> l, _Mat<T> b, bool parallel) {
+    const auto n = l.rows;
+    _check_size(n, l.cols);
+    _check_size(n, b.rows);
+
+    if (parallel) {
+        _trsm(Uplo::Lower, Diag::NonUnit, l,     b);
+        _trsm(Uplo::Upper, Diag::NonUnit, l.t(), b);
+    }
+    else {
+        _trsm_cols(Uplo::Lower, Diag::NonUnit, l,     b, 0, b.cols);
+        _trsm_cols(Uplo::Upper, Diag::NonUnit, l.t(), b, 0, b.cols);
+    }
+}
+#pragma endregion
+
+#pragma region qr
+/* unblocked householder QR of a (m x n), m >= n */
+template<class T>
+static void _geqr2(_Mat<T> a, T* tau) {
+    const auto m = a.rows;
+    const auto n = a.cols;
+
+    for (u32 k = 0; k < n; ++k) {
+        // householder vector of a(k:m, k)
+        const auto alpha = a(k, k);
+        T xnorm2 = 0;
+        for (u32 i = k + 1; i < m; ++i) {
+            xnorm2 += a(i, k) * a(i, k);
+        }
+
+        if (xnorm2 == T(0)) {
+            tau[k] = T(0);
+            continue;
+        }
+
+        const auto norm = T(::sqrt(alpha * alpha + xnorm2));
+        const auto beta = alpha >= T(0) ? -norm : norm;
+        tau[k] = (beta - alpha) / beta;
+
+        const auto r = T(1) / (alpha - beta);
+        for (u32 i = k + 1; i < m; ++i) {
+            a(i, k) *= r;
+        }
+        a(k, k) = beta;
+
+        // apply H = I - tau * v * v^T to a(k:m, k+1:n)
+        for (u32 j = k + 1; j < n; ++j) {
+            auto w = a(k, j);
+            for (u32 i = k + 1; i < m; ++i) {
+                w += a(i, k) * a(i, j);
+            }
+            w *= tau[k];
+
+            a(k, j) -= w;
+            for (u32 i = k + 1; i < m; ++i) {
+                a(i, j) -= a(i, k) * w;
+            }
+        }
+    }
+}
+
+/*
+ * apply H^T = (I - V * T * V^T)^T to c from the left,
+ * V is the (m x k) unit lower part of v, T is formed from tau (larft + larfb).
+ */
+template<class T>
+static void _larfb(_Mat<const T> v, const T* tau, _Mat<T> c) {
+    const auto m = v.rows;
+    const auto k = v.cols;
+    const auto n = c.cols;
+
+    // explicit V
+    Array<T, 2> vv({ m, k });
+    auto mv = _mat(vv);
+    for (u32 j = 0; j < k; ++j) {
+        for (u32 i = 0; i < m; ++i) {
+            mv(i, j) = i < j ? T(0) : i == j ? T(1) : v(i, j);
+        }
+    }
+
+    // triangular factor T (upper)
+    Array<T, 2> tt({ k, k });
+    auto mt = _mat(tt);
+    for (u32 i = 0; i < k; ++i) {
+        for (u32 j = 0; j < k; ++j) {
+            mt(j, i) = T(0);
+        }
+        if (tau[i] == T(0)) {
+            continue;
+        }
+
+        // T(0:i, i) = -tau[i] * V(:, 0:i)^T * V(:, i)
+        for (u32 j = 0; j < i; ++j) {
+            T s = 0;
+            for (u32 r = i; r < m; ++r) {
+                s += mv(r, j) * mv(r, i);
+            }
+            mt(j, i) = -tau[i] * s;
+        }
+
+        // T(0:i, i) = T(0:i, 0:i) * T(0:i, i)
+        for (u32 j = 0; j < i; ++j) {
+            T s = 0;
+            for (u32 l = j; l < i; ++l) {
+                s += mt(j, l) * mt(l, i);
+            }
+            mt(j, i) = s;
+        }
+        mt(i, i) = tau[i];
+    }
+
+    // W = V^T * C
+    Array<T, 2> ww({ k, n });
+    auto mw = _mat(ww);
+    _gemm(T(1), _Mat<const T>(mv.t()), _Mat<const T>(c), T(0), mw);
+
+    // W = T^T * W
+    parallel_for(n, [&](u32 j) {
+        for (u32 i = k; i-- > 0; ) {
+            T s = 0;
+            for (u32 l = 0; l <= i; ++l) {
+                s += mt(l, i) * mw(l, j);
+            }
+            mw(i, j) = s;
+        }
+    });
+
+    // C -= V * W
+    _gemm(T(-1), _Mat<const T>(mv), _Mat<const T>(mw), T(1), c);
+}
+
+template<class T>
+static void _qr(_Mat<T> a, View<T, 1> tau) {
+    constexpr u32 $nb = 32;
+
+    const auto m = a.rows;
+    const auto n = a.cols;
+    _check_size(n, tau.count());
+    _check_size(1, u32(tau.step(0)));
+    if (m < n) {
+        NMS_THROW(Eunexpect<u32>(n, m));
+    }
+
+    for (u32 j = 0; j < n; j += $nb) {
+        const auto jb = nms::min($nb, n - j);
+        auto panel = a.sub(j, j, m - j, jb);
+        _geqr2(panel, tau.data() + j);
+
+        if (j + jb < n) {
+            _larfb(_Mat<const T>(panel), tau.data() + j, a.sub(j, j + jb, m - j, n - j - jb));
+        }
+    }
+}
+
+template<class T>
+static void _qr_solve(_Mat<const T> qr, View<const T, 1> tau, _Mat<T> b) {
+    constexpr u32 $nb = 32;
+
+    const auto m = qr.rows;
+    const auto n = qr.cols;
+    _check_size(n, tau.count());
+    _check_size(1, u32(tau.step(0)));
+    _check_size(m, b.rows);
+
+    // b = Q^T * b
+    for (u32 j = 0; j < n; j += $nb) {
+        const auto jb = nms::min($nb, n - j);
+        _larfb(qr.sub(j, j, m - j, jb), tau.data() + j, b.sub(j, 0, m - j, b.cols));
+    }
+
+    // x = R^-1 * b
+    for (u32 k = 0; k < n; ++k) {
+        if (qr(k, k) == T(0)) {
+            NMS_THROW(ESingular{ k });
+        }
+    }
+    _trsm(Uplo::Upper, Diag::NonUnit, qr.sub(0, 0, n, n), b.sub(0, 0, n, b.cols));
+}
+#pragma endregion
+
+#pragma region batched
+template<class T>
+static _Mat<T> _mat_of(View<T, 3>& v, u32 s) {
+    return { v.data() + i32(s) * v.step(2), v.step(0), v.step(1), v.size(0), v.size(1) };
+}
+
+template<class T>
+static u32 _lu_batched(View<T, 3> a, View<u32, 2> piv, View<i32, 1> info) {
+    const auto n   = a.size(0);
+    const auto cnt = a.size(2);
+    _check_size(n, a.size(1));
+    _check_size(n, piv.size(0));
+    _check_size(cnt, piv.size(1));
+    _check_size(cnt, info.count());
+    _check_size(1, u32(piv.step(0)));
+
+    thread::Atomic<u32> failed = 0;
+    parallel_for(cnt, [&](u32 s) {
+        const auto ret = _getf2(_mat_of(a, s), &piv(0u, s));
+        info(s) = i32(ret);
+        if (ret != 0) {
+            ++failed;
+        }
+    });
+    return failed.load();
+}
+
+template<class T>
+static void _lu_solve_batched(View<const T, 3> lu, View<const u32, 2> piv, View<T, 3> b) {
+    const auto cnt = lu.size(2);
+    _check_size(lu.size(0), piv.size(0));
+    _check_size(cnt, piv.size(1));
+    _check_size(cnt, b.size(2));
+    _check_size(1, u32(piv.step(0)));
+
+    parallel_for(cnt, [&](u32 s) {
+        _lu_solve(_Mat<const T>(_mat_of(lu, s)), &piv(0u, s), _mat_of(b, s), false);
+    });
+}
+
+template<class T>
+static u32 _cholesky_batched(View<T, 3> a, View<i32, 1> info) {
+    const auto cnt = a.size(2);
+    _check_size(a.size(0), a.size(1));
+    _check_size(cnt, info.count());
+
+    thread::Atomic<u32> failed = 0;
+    parallel_for(cnt, [&](u32 s) {
+        const auto ret = _potrf(_mat_of(a, s));
+        info(s) = i32(ret);
+        if (ret != 0) {
+            ++failed;
+        }
+    });
+    return failed.load();
+}
+
+template<class T>
+static void _cholesky_solve_batched(View<const T, 3> l, View<T, 3> b) {
+    const auto cnt = l.size(2);
+    _check_size(cnt, b.size(2));
+
+    parallel_for(cnt, [&](u32 s) {
+        _cholesky_solve(_Mat<const T>(_mat_of(l, s)), _mat_of(b, s), false);
+    });
+}
+#pragma endregion
+
+#pragma region api
+#define NMS_LINALG_API(T)                                                                                   \
+NMS_API void gemm(T alpha, View<const T, 2> a, View<const T, 2> b, T beta, View<T, 2> c) {                  \
+    _gemm(alpha, _mat(a), _mat(b), beta, _mat(c));                                                          \
+}                                                                                                           \
+NMS_API void trsm(Uplo uplo, Diag diag, View<const T, 2> a, View<T, 2> b) {                                 \
+    _trsm(uplo, diag, _mat(a), _mat(b));                                                                    \
+}                                                                                                           \
+NMS_API void lu(View<T, 2> a, View<u32, 1> piv) {                                                           \
+    _lu(_mat(a), piv);                                                                                      \
+}                                                                                                           \
+NMS_API void lu_solve(View<const T, 2> lu, View<const u32, 1> piv, View<T, 2> b) {                          \
+    _check_size(lu.size(0), piv.count());                                                                   \
+    _check_size(1, u32(piv.step(0)));                                                                       \
+    _lu_solve(_mat(lu), piv.data(), _mat(b), true);                                                         \
+}                                                                                                           \
+NMS_API void cholesky(View<T, 2> a) {                                                                       \
+    _cholesky(_mat(a));                                                                                     \
+}                                                                                                           \
+NMS_API void cholesky_solve(View<const T, 2> l, View<T, 2> b) {                                             \
+    _cholesky_solve(_mat(l), _mat(b), true);                                                                \
+}                                                                                                           \
+NMS_API void qr(View<T, 2> a, View<T, 1> tau) {                                                             \
+    _qr(_mat(a), tau);                                                                                      \
+}                                                                                                           \
+NMS_API void qr_solve(View<const T, 2> qr, View<const T, 1> tau, View<T, 2> b) {                            \
+    _qr_solve(_mat(qr), tau, _mat(b));                                                                      \
+}                                                                                                           \
+NMS_API u32 lu_batched(View<T, 3> a, View<u32, 2> piv, View<i32, 1> info) {                                 \
+    return _lu_batched(a, piv, info);                                                                       \
+}                                                                                                           \
+NMS_API void lu_solve_batched(View<const T, 3> lu, View<const u32, 2> piv, View<T, 3> b) {                  \
+    _lu_solve_batched(lu, piv, b);                                                                          \
+}                                                                                                           \
+NMS_API u32 cholesky_batched(View<T, 3> a, View<i32, 1> info) {                                             \
+    return _cholesky_batched(a, info);                                                                      \
+}                                                                                                           \
+NMS_API void cholesky_solve_batched(View<const T, 3> l, View<T, 3> b) {                                     \
+    _cholesky_solve_batched(l, b);                                                                          \
+}
+
+NMS_LINALG_API(f32)
+NMS_LINALG_API(f64)
+#undef NMS_LINALG_API
+#pragma endregion
+
+#pragma region unittest
+/* deterministic pseudo random numbers in [-1, 1) */
+static f64 _linalg_rand(u32& seed) {
+    seed = seed * 1664525u + 1013904223u;
+    return f64(seed >> 8) / f64(1u << 23) - 1.0;
+}
+
+template<class T>
+static void _linalg_fill(View<T, 2> a, u32 seed, T diag = T(0)) {
+    for (u32 j = 0; j < a.size(1); ++j) {
+        for (u32 i = 0; i < a.size(0); ++i) {
+            a(i, j) = T(_linalg_rand(seed)) + (i == j ? diag : T(0));
+        }
+    }
+}
+
+/* max |a * x - b| */
+template<class T>
+static f64 _linalg_residual(View<const T, 2> a, View<const T, 2> x, View<const T, 2> b) {
+    f64 err = 0;
+    for (u32 j = 0; j < b.size(1); ++j) {
+        for (u32 i = 0; i < b.size(0); ++i) {
+            f64 s = 0;
+            for (u32 k = 0; k < a.size(1); ++k) {
+                s += f64(a(i, k)) * f64(x(k, j));
+            }
+            err = nms::max(err, fabs(s - f64(b(i, j))));
+        }
+    }
+    return err;
+}
+
+nms_test(linalg_gemm) {
+    const u32 m = 70, n = 90, k = 300;
+
+    Array<f64, 2> a({ m, k });
+    Array<f64, 2> b({ n, k });      // used as b^T
+    Array<f64, 2> c({ m, n });
+    _linalg_fill<f64>(a, 1);
+    _linalg_fill<f64>(b, 2);
+    _linalg_fill<f64>(c, 3);
+
+    auto c0 = c.dup();
+    gemm(2.0, a, b.permute({ 1, 0 }), 0.5, c);
+
+    for (u32 i = 0; i < m; ++i) {
+        for (u32 j = 0; j < n; ++j) {
+            f64 s = 0;
+            for (u32 p = 0; p < k; ++p) {
+                s += a(i, p) * b(j, p);
+            }
+            test::assert_true(fabs(c(i, j) - (2.0 * s + 0.5 * c0(i, j))) < 1e-10);
+        }
+    }
+}
+
+nms_test(linalg_lu) {
+    const u32 n = 150, k = 3;
+
+    Array<f64, 2> a({ n, n });
+    Array<f64, 2> x({ n, k });
+    Array<u32, 1> piv({ n });
+    _linalg_fill<f64>(a, 4);
+    _linalg_fill<f64>(x, 5);
+
+    Array<f64, 2> b({ n, k });
+    gemm(1.0, a, x, 0.0, b);
+
+    auto f = a.dup();
+    auto y = b.dup();
+    lu(f, piv);
+    lu_solve(f, piv, y);
+    test::assert_true(_linalg_residual<f64>(a, y, b) < 1e-9);
+
+    // f32
+    Array<f32, 2> a32({ n, n });
+    Array<f32, 2> b32({ n, 1 });
+    _linalg_fill<f32>(a32, 6, f32(n));
+    _linalg_fill<f32>(b32, 7);
+    auto f32s = a32.dup();
+    auto y32  = b32.dup();
+    lu(f32s, piv);
+    lu_solve(f32s, piv, y32);
+    test::assert_true(_linalg_residual<f32>(a32, y32, b32) < 1e-3);
+
+    // singular
+    Array<f64, 2> s({ 3, 3 });
+    s <<= 1.0;
+    Array<u32, 1> spiv({ 3 });
+    try {
+        lu(s, spiv);
+        test::assert_true(false);
+    }
+    catch (const ESingular& e) {
+        test::assert_eq(e.index(), 1u);
+    }
+}
+
+nms_test(linalg_cholesky) {
+    const u32 n = 150, k = 2;
+
+    // a = m * m^T + n * I
+    Array<f64, 2> m({ n, n });
+    Array<f64, 2> a({ n, n });
+    _linalg_fill<f64>(m, 8);
+    for (u32 j = 0; j < n; ++j) {
+        for (u32 i = 0; i < n; ++i) {
+            a(i, j) = i == j ? f64(n) : 0.0;
+        }
+    }
+    gemm(1.0, m, m.permute({ 1, 0 }), 1.0, a);
+
+    Array<f64, 2> b({ n, k });
+    _linalg_fill<f64>(b, 9);
+
+    auto l = a.dup();
+    auto x = b.dup();
+    cholesky(l);
+    cholesky_solve(l, x);
+    test::assert_true(_linalg_residual<f64>(a, x, b) < 1e-9);
+    test::assert_eq(l(0, n - 1), 0.0);
+
+    // not positive definite
+    Array<f64, 2> s({ 2, 2 });
+    s <<= 1.0;
+    try {
+        cholesky(s);
+        test::assert_true(false);
+    }
+    catch (const ESingular& e) {
+        test::assert_eq(e.index(), 1u);
+    }
+}
+
+nms_test(linalg_qr) {
+    const u32 m = 170, n = 100, k = 2;
+
+    Array<f64, 2> a({ m, n });
+    Array<f64, 2> x({ n, k });
+    Array<f64, 1> tau({ n });
+    _linalg_fill<f64>(a, 10);
+    _linalg_fill<f64>(x, 11);
+
+    // consistent system: b = a * x
+    Array<f64, 2> b({ m, k });
+    gemm(1.0, a, x, 0.0, b);
+
+    auto f = a.dup();
+    auto y = b.dup();
+    qr(f, tau);
+    qr_solve(f, tau, y);
+
+    for (u32 j = 0; j < k; ++j) {
+        for (u32 i = 0; i < n; ++i) {
+            test::assert_true(fabs(y(i, j) - x(i, j)) < 1e-9);
+        }
+    }
+}
+
+nms_test(linalg_batched) {
+    const u32 n = 8, k = 2, cnt = 100;
+
+    Array<f64, 3> a({ n, n, cnt });
+    Array<f64, 3> b({ n, k, cnt });
+    Array<u32, 2> piv({ n, cnt });
+    Array<i32, 1> info({ cnt });
+
+    u32 seed = 12;
+    for (u32 s = 0; s < cnt; ++s) {
+        for (u32 j = 0; j < n; ++j) {
+            for (u32 i = 0; i < n; ++i) {
+                a(i, j, s) = _linalg_rand(seed) + (i == j ? f64(n) : 0.0);
+            }
+            for (u32 i = 0; j < k && i < n; ++i) {
+                b(i, j, s) = _linalg_rand(seed);
+            }
+        }
+    }
+
+    auto f = a.dup();
+    auto x = b.dup();
+    test::assert_eq(lu_batched(f, piv, info), 0u);
+    lu_solve_batched(f, piv, x);
+
+    // symmetric positive definite: a + a^T
+    auto c = a.dup();
+    for (u32 s = 0; s < cnt; ++s) {
+        for (u32 j = 0; j < n; ++j) {
+            for (u32 i = 0; i < n; ++i) {
+                c(i, j, s) = a(i, j, s) + a(j, i, s);
+            }
+        }
+    }
+    auto y = b.dup();
+    auto l = c.dup();
+    test::assert_eq(cholesky_batched(l, info), 0u);
+    cholesky_solve_batched(l, y);
+
+    for (u32 s = 0; s < cnt; ++s) {
+        const auto as = _mat_of<f64>(a, s);
+        const auto cs = _mat_of<f64>(c, s);
+        for (u32 j = 0; j < k; ++j) {
+            for (u32 i = 0; i < n; ++i) {
+                f64 sa = 0, sc = 0;
+                for (u32 p = 0; p < n; ++p) {
+                    sa += as(i, p) * x(p, j, s);
+                    sc += cs(i, p) * y(p, j, s);
+                }
+                test::assert_true(fabs(sa - b(i, j, s)) < 1e-10);
+                test::assert_true(fabs(sc - b(i, j, s)) < 1e-10);
+            }
+        }
+    }
+}
+
+nms_test(linalg_perf) {
+    const u32 n = 256;
+
+    Array<f64, 2> a({ n, n });
+    Array<f64, 2> c({ n, n });
+    Array<f64, 1> tau({ n });
+    Array<u32, 1> piv({ n });
+    _linalg_fill<f64>(a, 13, f64(n));
+
+    auto gflops = [](f64 flops, f64 t) { return flops / t * 1e-9; };
+    const auto n3 = f64(n) * n * n;
+
+    for (auto loop = 0; loop < 2; ++loop) {
+        auto t0 = nms::clock();
+        gemm(1.0, a, a, 0.0, c);
+        auto t1 = nms::clock();
+        io::log::info("nms.math.linalg: gemm     {}x{}: {.3}s {.2} GFlops", n, n, t1 - t0, gflops(2 * n3, t1 - t0));
+
+        auto f = a.dup();
+        t0 = nms::clock();
+        lu(f, piv);
+        t1 = nms::clock();
+        io::log::info("nms.math.linalg: lu       {}x{}: {.3}s {.2} GFlops", n, n, t1 - t0, gflops(2 * n3 / 3, t1 - t0));
+
+        // a * a^T + n * I is positive definite
+        gemm(1.0, a, a.permute({ 1, 0 }), 0.0, c);
+        t0 = nms::clock();
+        cholesky(c);
+        t1 = nms::clock();
+        io::log::info("nms.math.linalg: cholesky {}x{}: {.3}s {.2} GFlops", n, n, t1 - t0, gflops(n3 / 3, t1 - t0));
+
+        f = a.dup();
+        t0 = nms::clock();
+        qr(f, tau);
+        t1 = nms::clock();
+        io::log::info("nms.math.linalg: qr       {}x{}: {.3}s {.2} GFlops", n, n, t1 - t0, gflops(4 * n3 / 3, t1 - t0));
+    }
+
+    // batched: many small systems
+    const u32 m = 16, cnt = 2000;
+    Array<f64, 3> sa({ m, m, cnt });
+    Array<f64, 3> sb({ m, 1, cnt });
+    Array<u32, 2> spiv({ m, cnt });
+    Array<i32, 1> info({ cnt });
+
+    u32 seed = 14;
+    for (u32 s = 0; s < cnt; ++s) {
+        for (u32 j = 0; j < m; ++j) {
+            for (u32 i = 0; i < m; ++i) {
+                sa(i, j, s) = _linalg_rand(seed) + (i == j ? f64(m) : 0.0);
+            }
+            sb(j, 0u, s) = _linalg_rand(seed);
+        }
+    }
+
+    for (auto loop = 0; loop < 2; ++loop) {
+        auto fa = sa.dup();
+        auto fb = sb.dup();
+        const auto t0 = nms::clock();
+        lu_batched(fa, spiv, info);
+        lu_solve_batched(fa, spiv, fb);
+        const auto t1 = nms::clock();
+        io::log::info("nms.math.linalg: lu_batched {} x {}x{}: {.3}s", cnt, m, m, t1 - t0);
+    }
+}
+#pragma endregion
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <nms/math/base.h>
+
+/*!
+ * dense linear algebra on View<T, 2>, T = f32/f64.
+ *
+ * a(i, j) is row i, column j. dim0 is contiguous for Array<T, 2>, so the
+ * storage is column-major (lapack layout). transposed operands are passed as
+ * permuted views: a.permute({ 1, 0 }).
+ */
+namespace nms::math
+{
+
+/*! the matrix is singular, or not positive definite */
+class ESingular
+    : public IException
+{
+public:
+    explicit ESingular(u32 idx)
+        : idx_(idx)
+    {}
+
+    /* index of the first zero pivot / non-positive diagonal */
+    u32 index() const noexcept {
+        return idx_;
+    }
+
+    void format(String<>& buf) const override {
+        sformat(buf, "index={}", idx_);
+    }
+
+protected:
+    u32 idx_;
+};
+
+enum class Uplo
+{
+    Lower,
+    Upper,
+};
+
+enum class Diag
+{
+    NonUnit,
+    Unit,
+};
+
+#pragma region level 3
+/*!
+ * c = alpha * a * b + beta * c
+ * blocked and packed, tiles of c are computed in parallel.
+ */
+NMS_API void gemm(f32 alpha, View<const f32, 2> a, View<const f32, 2> b, f32 beta, View<f32, 2> c);
+NMS_API void gemm(f64 alpha, View<const f64, 2> a, View<const f64, 2> b, f64 beta, View<f64, 2> c);
+
+/*!
+ * solve a * x = b, a is triangular, b is replaced by x.
+ */
+NMS_API void trsm(Uplo uplo, Diag diag, View<const f32, 2> a, View<f32, 2> b);
+NMS_API void trsm(Uplo uplo, Diag diag, View<const f64, 2> a, View<f64, 2> b);
+#pragma endregion
+
+#pragma region factorizations
+/*!
+ * LU with partial pivoting: P * a = L * U (blocked, right-looking).
+ * a is replaced by L (unit diagonal, not stored) and U.
+ * piv[k] is the row swapped with row k, piv.count() = min(rows, cols).
+ * @throw ESingular if U has a zero diagonal (the factors are still computed)
+ */
+NMS_API void lu(View<f32, 2> a, View<u32, 1> piv);
+NMS_API void lu(View<f64, 2> a, View<u32, 1> piv);
+
+/*! solve a * x = b with the result of lu, b is replaced by x */
+NMS_API void lu_solve(View<const f32, 2> lu, View<const u32, 1> piv, View<f32, 2> b);
+NMS_API void lu_solve(View<const f64, 2> lu, View<const u32, 1> piv, View<f64, 2> b);
+
+/*!
+ * Cholesky: a = L * L^T, a is symmetric positive definite (only the lower triangle is read).
+ * a is replaced by L, the strict upper triangle is set to zero.
+ * @throw ESingular if a is not positive definite
+ */
+NMS_API void cholesky(View<f32, 2> a);
+NMS_API void cholesky(View<f64, 2> a);
+
+/*! solve a * x = b with the result of cholesky, b is replaced by x */
+NMS_API void cholesky_solve(View<const f32, 2> l, View<f32, 2> b);
+NMS_API void cholesky_solve(View<const f64, 2> l, View<f64, 2> b);
+
+/*!
+ * Householder QR: a = Q * R, rows >= cols (blocked, compact WY updates).
+ * R is stored in the upper triangle, the householder vectors below the diagonal.
+ * tau.count() = cols.
+ */
+NMS_API void qr(View<f32, 2> a, View<f32, 1> tau);
+NMS_API void qr(View<f64, 2> a, View<f64, 1> tau);
+
+/*!
+ * least squares min |a * x - b| with the result of qr.
+ * b is (rows x k), x is returned in the first cols rows of b.
+ * @throw ESingular if R has a zero diagonal
+ */
+NMS_API void qr_solve(View<const f32, 2> qr, View<const f32, 1> tau, View<f32, 2> b);
+NMS_API void qr_solve(View<const f64, 2> qr, View<const f64, 1> tau, View<f64, 2> b);
+#pragma endregion
+
+#pragma region batched
+/*!
+ * factorize many small systems in parallel: a is (n, n, count), piv is (n, count).
+ * info[s] = 0 on success, k + 1 if system s has a zero pivot at column k.
+ * @return number of singular systems
+ */
+NMS_API u32 lu_batched(View<f32, 3> a, View<u32, 2> piv, View<i32, 1> info);
+NMS_API u32 lu_batched(View<f64, 3> a, View<u32, 2> piv, View<i32, 1> info);
+
+/*! b is (n, k, count) */
+NMS_API void lu_solve_batched(View<const f32, 3> lu, View<const u32, 2> piv, View<f32, 3> b);
+NMS_API void lu_solve_batched(View<const f64, 3> lu, View<const u32, 2> piv, View<f64, 3> b);
+
+/*!
+ * Cholesky of many small systems in parallel: a is (n, n, count).
+ * info[s] = 0 on success, k + 1 if system s is not positive definite at column k.
+ * @return number of failed systems
+ */
+NMS_API u32 cholesky_batched(View<f32, 3> a, View<i32, 1> info);
+NMS_API u32 cholesky_batched(View<f64, 3> a, View<i32, 1> info);
+
+/*! b is (n, k, count) */
+NMS_API void cholesky_solve_batched(View<const f32, 3> l, View<f32, 3> b);
+NMS_API void cholesky_solve_batched(View<const f64, 3> l, View<f64, 3> b);
+#pragma endregion
+
+}
@@ -97,6 +97,40 @@ protected:
     Y   y_;
 };
 
+template<class F, class X, class Y, class Z>
+struct Parallel<F, X, Y, Z>
+{
+    using Tview = Parallel;
+
+    constexpr static const auto $rank = X::$rank | Y::$rank | Z::$rank;
+
+    Parallel(const X& x, const Y& y, const Z& z)
+        : x_(x), y_(y), z_(z) {}
+
+    template<class I>
+    __forceinline auto size(I idx) const noexcept {
+        const auto sx = X::$rank == 0 ? 0u : u32(x_.size(idx));
+        const auto sy = Y::$rank == 0 ? 0u : u32(y_.size(idx));
+        const auto sz = Z::$rank == 0 ? 0u : u32(z_.size(idx));
+        return _size_of(_size_of(sx, sy), sz);
+    }
+
+    template<class ...I>
+    __forceinline auto operator()(I ...idx) const noexcept {
+        return F::run(x_(idx...), y_(idx...), z_(idx...));
+    }
+
+protected:
+    X   x_;
+    Y   y_;
+    Z   z_;
+
+    /* 0 is the size of a scalar (any size) */
+    static constexpr u32 _size_of(u32 a, u32 b) noexcept {
+        return a == 0 ? b : b == 0 ? a : nms::min(a, b);
+    }
+};
+
 /* make Parallel<F(x)> */
 template<class F, class X>
 auto mkParallel(const X& x) {
@@ -112,6 +146,15 @@ auto mkParallel(const X& x, const Y& y) {
     return Parallel<F, Vx, Vy>{ x, y };
 }
 
+/* make Parallel<F(A,B,C)> */
+template<class F, class X, class Y, class Z>
+auto mkParallel(const X& x, const Y& y, const Z& z) {
+    using Vx = decltype(view_cast(x));
+    using Vy = decltype(view_cast(y));
+    using Vz = decltype(view_cast(z));
+    return Parallel<F, Vx, Vy, Vz>{ x, y, z };
+}
+
 #pragma endregion
 
 #pragma region Reduce
@@ -74,4 +74,56 @@ nms_test(vreduce_1d) {
     }
 }
 
+nms_test(vwhere) {
+    Array<f32, 1> x({ 11 });
+    Array<f32, 1> y({ 11 });
+    x <<= vline(1.0f) - 5;
+
+    // threshold
+    y <<= vwhere(x < 0, 0.0f, x);
+    for (u32 i = 0; i < y.size(0); ++i) {
+        test::assert_eq(y(i), x(i) < 0 ? 0.0f : x(i));
+    }
+
+    // clip
+    y <<= vclamp(x, -2.0f, 3.0f);
+    for (u32 i = 0; i < y.size(0); ++i) {
+        test::assert_eq(y(i), nms::min(nms::max(x(i), -2.0f), 3.0f));
+    }
+
+    // a * b + c
+    y <<= vfma(x, x, 1.0f);
+    for (u32 i = 0; i < y.size(0); ++i) {
+        test::assert_eq(y(i), x(i) * x(i) + 1.0f);
+    }
+
+    // masked assignment: only where the mask is true
+    y <<= x;
+    y.masked(vabs(x) > 2) <<= x * 10;
+    for (u32 i = 0; i < y.size(0); ++i) {
+        test::assert_eq(y(i), abs(x(i)) > 2 ? x(i) * 10 : x(i));
+    }
+}
+
+nms_test(vwhere_simd) {
+    Array<f32x4, 1> x({ 4 });
+    Array<f32x4, 1> y({ 4 });
+    Array<f32x4, 1> z({ 4 });
+    for (u32 i = 0; i < x.size(0); ++i) {
+        x(i) = f32x4{ f32(i), -f32(i), 1.0f, -1.0f };
+        z(i) = f32x4{ 0.0f, 0.0f, 0.0f, 0.0f };
+    }
+
+    // lane masks + select
+    y <<= vwhere(x < z, z - x, x);
+    for (u32 i = 0; i < y.size(0); ++i) {
+        test::assert_eq(y(i), f32x4{ f32(i), f32(i), 1.0f, 1.0f });
+    }
+
+    y <<= vclamp(x, f32x4{ 0.0f, 0.0f, 0.0f, 0.0f }, f32x4{ 2.0f, 2.0f, 2.0f, 2.0f });
+    for (u32 i = 0; i < y.size(0); ++i) {
+        test::assert_eq(y(i), f32x4{ f32(i > 2 ? 2 : i), 0.0f, 1.0f, 0.0f });
+    }
+}
+
 }
\ No newline at end of file
@@ -181,6 +181,18 @@ Y& operator<<=(Y& y, const Reduce<F, T...>& x) {
     return y;
 }
 
+/* y.masked(mask) <<= x: y(i) = mask(i) ? x(i) : y(i), in one pass */
+template<class X, class Y, class M>
+void operator<<=(ViewMasked<Y, M> y, const X& x) {
+#ifndef NMS_CC_INTELLISENSE
+    const auto expr = mkParallel<Where>(y.mask, x, y.view);
+    if (!check_size(y.view, view_cast(y.mask), view_cast(x))) {
+        return;
+    }
+    get_vrun(y.view, x).foreach(Ass2{}, y.view, expr);
+#endif
+}
+
 #define NMS_IVIEW_FOREACH(op, type)                     \
 template<class X, class Y, class=typename Y::Tview >    \
 Y& operator op(Y& y, const X& x) {                      \
@@ -215,6 +227,16 @@ NMS_IVIEW_FOREACH(vacos,   Acos)
 NMS_IVIEW_FOREACH(vatan,   Atan)
 #undef NMS_IVIEW_FOREACH
 
+#define NMS_IVIEW_FOREACH(func, type)                                  \
+template<class X, class Y, class Z>                                     \
+constexpr auto func(const X& x, const Y& y, const Z& z) noexcept {      \
+    return math::mkParallel<type>(x, y, z);                             \
+}
+NMS_IVIEW_FOREACH(vwhere,  Where)   // mask ? x : y
+NMS_IVIEW_FOREACH(vclamp,  Clamp)   // min(max(x, lo), hi)
+NMS_IVIEW_FOREACH(vfma,    Fma)     // x * y + z
+#undef NMS_IVIEW_FOREACH
+
 #define NMS_IVIEW_REDUCE(func, type)        \
 template<class T>                           \
 constexpr auto func(const T& t) noexcept {  \
@@ -8,11 +8,14 @@ namespace nms::serialization
 enum DOMType
 {
     $json,
-    $xml
+    $xml,
+    $bin
 };
 
 struct DOM;
 struct XDOM;
+class  JsonReader;
+class  JsonWriter;
 
 NMS_ENUM_EX(enum class Type : u16, Type,
     null,
@@ -82,9 +85,60 @@ protected:
     StrView key_;
 };
 
+/*! the text is not valid json */
+class EJsonParse
+    : public IException
+{
+public:
+    EJsonParse(u64 offset, const char* what)
+        : offset_(offset)
+        , what_(what)
+    {}
+
+    /* byte offset of the error in the text */
+    u64 offset() const noexcept {
+        return offset_;
+    }
+
+    void format(String<>& buf) const override {
+        sformat(buf, "offset={}, {}", offset_, what_);
+    }
+
+protected:
+    u64         offset_;
+    const char* what_;
+};
+
+/*! the bytes are not a valid binary dom */
+class EBinParse
+    : public IException
+{
+public:
+    EBinParse(u64 offset, const char* what)
+        : offset_(offset)
+        , what_(what)
+    {}
+
+    /* offset of the error in the bytes */
+    u64 offset() const noexcept {
+        return offset_;
+    }
+
+    void format(String<>& buf) const override {
+        sformat(buf, "offset={}, {}", offset_, what_);
+    }
+
+protected:
+    u64         offset_;
+    const char* what_;
+};
+
 struct ISerializable
 {
     friend struct XDOM;
+    friend class  JsonReader;
+    friend class  JsonWriter;
+class  JsonWriter;
 
 protected:
     template<class T>
@@ -105,6 +159,28 @@ protected:
 #endif
     }
 
+    /* write each property to a writer: its name, then its value */
+    template<class Twriter, class T>
+    static void _serialize_properties(Twriter& writer, const T& obj) {
+#ifndef NMS_CC_INTELLISENSE
+#define call_serialize_property_impl(n, ...)    _serialize_property_impl(Ti32<n>{}, &obj, &writer);
+        NMSCPP_LOOP(99, call_serialize_property_impl);
+#undef call_serialize_property_impl
+#endif
+    }
+
+    /* read the value of the property named key, false if none */
+    template<class Treader, class T>
+    static bool _deserialize_property(Treader& reader, T& obj, const StrView& key) {
+        auto found = false;
+#ifndef NMS_CC_INTELLISENSE
+#define call_deserialize_property_impl(n, ...)    found = found || _deserialize_property_impl(Ti32<n>{}, &obj, &reader, key);
+        NMSCPP_LOOP(99, call_deserialize_property_impl);
+#undef call_deserialize_property_impl
+#endif
+        return found;
+    }
+
 private:
     // serialize-impl
     template<class T, i32 I>
@@ -137,6 +213,39 @@ private:
         (void)pobj;
         return;
     }
+
+    // serialize-property-impl
+    template<class T, i32 I, class Twriter>
+    static auto _serialize_property_impl(Ti32<I> idx, const T* pobj, Twriter* pwriter)->$when<(I < T::_$property_cnt)> {
+        auto obj_item = (*pobj)[idx];
+        pwriter->key(obj_item.name);
+        pwriter->put(*obj_item.pval);
+    }
+
+    // serialize-property-impl
+    template<class T, i32 I >
+    static auto _serialize_property_impl(Ti32<I>, const T* pobj, ...) -> $when<(I >= T::_$property_cnt)> {
+        (void)pobj;
+    }
+
+    // deserialize-property-impl
+    template<class T, i32 I, class Treader>
+    static auto _deserialize_property_impl(Ti32<I> idx, T* pobj, Treader* preader, const StrView& key)->$when<(I < T::_$property_cnt), bool> {
+        auto obj_item = (*pobj)[idx];
+        if (obj_item.name != key) {
+            return false;
+        }
+        preader->next();
+        preader->get(*obj_item.pval);
+        return true;
+    }
+
+    // deserialize-property-impl
+    template<class T, i32 I >
+    static auto _deserialize_property_impl(Ti32<I>, T* pobj, ...) -> $when<(I >= T::_$property_cnt), bool> {
+        (void)pobj;
+        return false;
+    }
 };
 
 }
@@ -0,0 +1,590 @@
+#include <nms/test.h>
+#include <nms/serialization/dom.h>
+#include <nms/math/array.h>
+
+namespace nms::serialization
+{
+
+#pragma region bin
+/*
+ * a value is a tag byte, then its data:
+ * - tag & 0x1F: the Type of the value, or $bin_view for a typed array.
+ * - tag >> 5: boolean: the value; string, number, key: the length; array, object: the count.
+ *   7 is a varint after the tag (7 bits per byte, low bits first).
+ * - i8 ... f64, datetime: the bytes of the value, little endian.
+ * - string, number, key: the bytes of the text.
+ * - array: the values; object: the key and the value of each entry.
+ * - typed array: a ViewInfo, the dims (varints, dim 0 first), the bytes of the values.
+ *   nested arrays of numbers of one type, with the same count at each level, are written so.
+ */
+static const u8 $bin_view   = 0x1F;
+static const u8 $bin_inline = 7;
+
+/* an array of as many values or more is written as a typed array, if it can be */
+static const u32 gBinViewMin = 4;
+
+/* the bytes of a Type, 0: no fixed size */
+static u32 _bin_size(Type type) {
+    switch (type) {
+    case Type::i8:  case Type::u8:  return 1;
+    case Type::i16: case Type::u16: return 2;
+    case Type::i32: case Type::u32: case Type::f32: return 4;
+    case Type::i64: case Type::u64: case Type::f64: case Type::datetime: return 8;
+    default:        return 0;
+    }
+}
+
+static ViewInfo _bin_info(Type type, u32 rank) {
+    const auto kind = (type == Type::f32 || type == Type::f64) ? 'f' :
+                      (type == Type::u8 || type == Type::u16 || type == Type::u32 || type == Type::u64) ? 'u' : 'i';
+    return { '$', kind, char('0' + _bin_size(type)), char('0' + rank) };
+}
+
+/* the Type of a ViewInfo, Type::null: none */
+static Type _bin_type(const ViewInfo& info) {
+    if (info.mask != '$') {
+        return Type::null;
+    }
+    const Type types[] = { Type::i8, Type::u8, Type::i16, Type::u16, Type::i32, Type::u32, Type::i64, Type::u64, Type::f32, Type::f64 };
+    for (auto t : types) {
+        const auto x = _bin_info(t, 1);
+        if (x.type == info.type && x.size == info.size) {
+            return t;
+        }
+    }
+    return Type::null;
+}
+
+static void _bin_put(String<>& buf, u8 type, u64 len) {
+    if (len < $bin_inline) {
+        buf += char(type | (len << 5));
+        return;
+    }
+    buf += char(type | ($bin_inline << 5));
+    for (; len >= 0x80; len >>= 7) {
+        buf += char(0x80 | (len & 0x7F));
+    }
+    buf += char(len);
+}
+
+/* the node is a rectangular array of numbers of one type, of the dims */
+static bool _bin_shape(const List<DOM>& nodes, i32 idx, Type& type, const u32* dims, u32 rank);
+
+NMS_API void XDOM::_format_bin(String<>& buf) const {
+    const auto& v = val();
+    const auto  t = u8(v.type());
+
+    switch (v.type()) {
+    case Type::null:
+        buf += char(t);
+        break;
+
+    case Type::boolean:
+        buf += char(t | (v.bool_val_ ? 0x20 : 0));
+        break;
+
+    case Type::i8:  case Type::u8:  case Type::i16: case Type::u16:
+    case Type::i32: case Type::u32: case Type::i64: case Type::u64:
+    case Type::f32: case Type::f64: case Type::datetime:
+        buf += char(t);
+        buf += StrView{ reinterpret_cast<const char*>(&v.u64_val_), _bin_size(v.type()) };
+        break;
+
+    case Type::number: case Type::string: case Type::key:
+        _bin_put(buf, t, v.size_);
+        buf += StrView{ v.str_val_, v.size_ };
+        break;
+
+    case Type::array: {
+        // a typed array: the dims, then the values in the order of the nodes
+        const auto n = v.count();
+        u32  dims[8] = {};
+        auto leaf    = Type::null;
+        auto rank    = 0u;
+        if (n != 0) {
+            // the dims are the counts of the first arrays
+            auto r = 0u;
+            for (auto i = index_; r < 8 && (*pnodes_)[i].type_ == Type::array; i = i + 1) {
+                ++r;
+                if ((*pnodes_)[i].count() == 0) {
+                    break;
+                }
+            }
+            u64 cnt = 1;
+            for (auto k = 0u; k < r; ++k) {
+                dims[r - 1 - k] = (*pnodes_)[index_ + i32(k)].count();
+                cnt *= dims[r - 1 - k];
+            }
+            if (cnt >= gBinViewMin && _bin_shape(*pnodes_, index_, leaf, dims, r) && leaf != Type::null) {
+                rank = r;
+            }
+        }
+        if (rank == 0) {
+            _bin_put(buf, t, n);
+            for (auto e : *this) {
+                e._format_bin(buf);
+            }
+            break;
+        }
+
+        const auto info = _bin_info(leaf, rank);
+        const auto size = _bin_size(leaf);
+        buf += char($bin_view);
+        buf += StrView{ reinterpret_cast<const char*>(&info), 4 };
+        u64 count = 1;
+        for (u32 k = 0; k < rank; ++k) {
+            count *= dims[k];
+            auto len = dims[k];
+            for (; len >= 0x80; len >>= 7) {
+                buf += char(0x80 | (len & 0x7F));
+            }
+            buf += char(len);
+        }
+
+        const auto pos = buf.count();
+        buf.resize(u32(pos + count * size));
+        auto out = buf.data() + pos;
+
+        // the leaves, by the links
+        List<i32> stack;
+        stack.append(index_);
+        while (stack.count() != 0) {
+            const auto top = stack[stack.count() - 1];
+            stack.resize(stack.count() - 1);
+            const auto& nodes = *pnodes_;
+            if (nodes[top].con_val_.count == 0) {
+                continue;
+            }
+            if (nodes[top + 1].type_ != Type::array) {
+                for (auto i = top + 1; ; i += nodes[i].next_) {
+                    ::memcpy(out, &nodes[i].u64_val_, size);
+                    out += size;
+                    if (nodes[i].next_ == 0) {
+                        break;
+                    }
+                }
+                continue;
+            }
+            // the children, the first one on top
+            const auto base = stack.count();
+            for (auto i = top + 1; ; i += nodes[i].next_) {
+                stack.append(i);
+                if (nodes[i].next_ == 0) {
+                    break;
+                }
+            }
+            for (auto a = base, b = stack.count() - 1; a < b; ++a, --b) {
+                nms::swap(stack[a], stack[b]);
+            }
+        }
+        break;
+    }
+
+    case Type::object:
+        _bin_put(buf, t, v.count());
+        for (auto itr = begin(); itr != end(); ++itr) {
+            const auto key = itr.key();
+            _bin_put(buf, u8(Type::key), key.count());
+            buf += key;
+            (*itr)._format_bin(buf);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+static bool _bin_shape(const List<DOM>& nodes, i32 idx, Type& type, const u32* dims, u32 rank) {
+    const auto& v = nodes[idx];
+    if (v.type() != Type::array || v.count() != dims[rank - 1]) {
+        return false;
+    }
+    if (v.count() == 0) {
+        return true;
+    }
+
+    for (auto i = idx + 1; ; i += nodes[i].next()) {
+        if (rank == 1) {
+            const auto t = nodes[i].type();
+            if (_bin_size(t) == 0 || t == Type::datetime) {
+                return false;
+            }
+            if (type == Type::null) {
+                type = t;
+            }
+            if (t != type) {
+                return false;
+            }
+        }
+        else if (!_bin_shape(nodes, i, type, dims, rank - 1)) {
+            return false;
+        }
+        if (nodes[i].next() == 0) {
+            break;
+        }
+    }
+    return true;
+}
+
+NMS_API void XDOM::_parse_bin(const StrView& bytes) {
+    const auto s = reinterpret_cast<const u8*>(bytes.data());
+    const auto n = u64(bytes.count());
+
+    auto& nodes = *pnodes_;
+    if (nodes.count() == 0) {
+        nodes.append(DOM{ Type::null, 0 });
+        this->index_ = 1;
+    }
+
+    u64 pos = 0;
+    auto fail = [&](u64 at, const char* what) {
+        NMS_THROW(EBinParse{ at, what });
+    };
+    auto need = [&](u64 cnt) {
+        if (cnt > n - pos) {
+            fail(pos, "unexpected end");
+        }
+    };
+    auto varint = [&]() {
+        u64 val = 0;
+        for (u32 shift = 0; ; shift += 7) {
+            need(1);
+            if (shift > 63) {
+                fail(pos, "invalid length");
+            }
+            const auto c = s[pos++];
+            val |= u64(c & 0x7F) << shift;
+            if ((c & 0x80) == 0) {
+                return val;
+            }
+        }
+    };
+    auto length = [&](u8 tag) {
+        const u64 len = tag >> 5;
+        return len < $bin_inline ? len : varint();
+    };
+
+    // the container being filled, as the json parser does: prev is the last key of an object, the last value of an array.
+    // the nodes of a typed array are made from its dims: dim > 0 makes arrays, dim 0 reads the values.
+    struct Frame
+    {
+        i32  node;
+        i32  prev;
+        u32  rest;
+        bool obj;
+        bool view;
+        u32  dim;
+    };
+    List<Frame> stack;
+    auto top = Frame{ -1, -1, 1, false, false, 0 };
+
+    u32  view_dims[8] = {};
+    auto view_type    = Type::null;
+    auto view_size    = 0u;
+
+    // the containers that get a lookup table, built at the end: the tape is complete
+    List<i32> large;
+
+    auto push = [&](i32 x, u32 count, bool obj, bool view, u32 dim) {
+        nodes[x].con_val_.count = count;
+        if (count >= $index_min) {
+            large.append(x);
+        }
+        if (count != 0) {
+            stack.append(top);
+            top = Frame{ x, -1, count, obj, view, dim };
+        }
+    };
+
+    while (true) {
+        // the end of the containers
+        while (top.rest == 0) {
+            if (stack.count() == 0) {
+                if (pos != n) {
+                    fail(pos, "expect the end");
+                }
+                for (auto x : large) {
+                    XDOM{ pnodes_, x }._index();
+                }
+                return;
+            }
+            top = stack[stack.count() - 1];
+            stack.resize(stack.count() - 1);
+        }
+
+        // the values of a typed array
+        if (top.view && top.dim == 0) {
+            const auto cnt = top.rest;
+            const auto x   = i32(nodes.count());
+            nodes.reserve(x + cnt);
+            for (u32 k = 0; k < cnt; ++k) {
+                DOM leaf;
+                leaf.type_    = view_type;
+                leaf.next_    = k + 1 < cnt ? 1 : 0;
+                leaf.u64_val_ = 0;
+                ::memcpy(&leaf.u64_val_, s + pos, view_size);
+                pos += view_size;
+                nodes._append(leaf);
+            }
+            top.rest = 0;
+            continue;
+        }
+
+        --top.rest;
+        if (top.obj) {
+            need(1);
+            const auto tag = s[pos];
+            if ((tag & 0x1F) != u8(Type::key)) {
+                fail(pos, "expect a key");
+            }
+            ++pos;
+            const auto len = length(tag);
+            need(len);
+            if (len > DOM::Tsize(-1)) {
+                fail(pos, "key too long");
+            }
+            const auto k = i32(nodes.count());
+            if (top.prev > 0) {
+                const auto offset = k - top.prev;
+                nodes[top.prev + 0].next_ = offset;
+                nodes[top.prev + 1].next_ = offset;
+            }
+            top.prev = k;
+            nodes.append(StrView{ bytes.data() + pos, u32(len) }, Type::key);
+            pos += len;
+        }
+
+        const auto x = i32(nodes.count());
+        if (top.node > 0 && !top.obj) {
+            if (top.prev > 0) {
+                nodes[top.prev].next_ = x - top.prev;
+            }
+            top.prev = x;
+        }
+
+        // an array of a typed array
+        if (top.view) {
+            nodes.append(Type::array);
+            push(x, view_dims[top.dim - 1], false, true, top.dim - 1);
+            continue;
+        }
+
+        need(1);
+        const auto at   = pos;
+        const auto tag  = s[pos++];
+        const auto type = Type(tag & 0x1F);
+
+        if (tag == $bin_view) {
+            ViewInfo info;
+            need(4);
+            ::memcpy(&info, s + pos, 4);
+            pos += 4;
+            view_type = _bin_type(info);
+            view_size = _bin_size(view_type);
+            const auto rank = u32(info.rank - '0');
+            if (view_type == Type::null || rank < 1 || rank > 8) {
+                fail(at, "invalid typed array");
+            }
+            u64 count = 1;
+            for (u32 k = 0; k < rank; ++k) {
+                const auto dim = varint();
+                if (dim > u32(-1)) {
+                    fail(at, "invalid typed array");
+                }
+                view_dims[k] = u32(dim);
+                count = count * dim;
+                if (count > n) {
+                    fail(at, "unexpected end");
+                }
+            }
+            need(count * view_size);
+            nodes.append(Type::array);
+            push(x, view_dims[rank - 1], false, true, rank - 1);
+            continue;
+        }
+
+        switch (type) {
+        case Type::null:
+            nodes.append(Type::null);
+            break;
+        case Type::boolean:
+            nodes.append((tag & 0x20) != 0);
+            break;
+        case Type::i8:  case Type::u8:  case Type::i16: case Type::u16:
+        case Type::i32: case Type::u32: case Type::i64: case Type::u64:
+        case Type::f32: case Type::f64: case Type::datetime: {
+            const auto size = _bin_size(type);
+            need(size);
+            DOM val;
+            val.type_    = type;
+            val.u64_val_ = 0;
+            ::memcpy(&val.u64_val_, s + pos, size);
+            pos += size;
+            nodes.append(val);
+            break;
+        }
+        case Type::number: case Type::string: {
+            const auto len = length(tag);
+            need(len);
+            if (len > DOM::Tsize(-1)) {
+                fail(at, "string too long");
+            }
+            nodes.append(StrView{ bytes.data() + pos, u32(len) }, type);
+            nodes[0].size_ += DOM::Tsize(len);
+            pos += len;
+            break;
+        }
+        case Type::array: case Type::object: {
+            const auto count = length(tag);
+            if (count > u32(-1)) {
+                fail(at, "too many elements");
+            }
+            nodes.append(type);
+            push(x, u32(count), type == Type::object, false, 0);
+            break;
+        }
+        default:
+            fail(at, "invalid tag");
+        }
+    }
+}
+#pragma endregion
+
+#pragma region unittest
+struct TestBin
+    : public ISerializable
+{
+    NMS_PROPERTY_BEGIN;
+    typedef u32                 NMS_PROPERTY(id);
+    typedef String<32>          NMS_PROPERTY(name);
+    typedef f64                 NMS_PROPERTY(price);
+    typedef bool                NMS_PROPERTY(active);
+    typedef DateTime            NMS_PROPERTY(time);
+    typedef List<String<> >     NMS_PROPERTY(tags);
+    typedef List<f32>           NMS_PROPERTY(samples);
+    NMS_PROPERTY_END;
+};
+
+nms_test(bin) {
+    TestBin obj;
+    obj.id      = 7;
+    obj.name    = "seven";
+    obj.price   = -1.25;
+    obj.active  = true;
+    obj.time    = DateTime(2017, 9, 3, 8, 30, 12);
+    obj.tags.append(String<>("x"));
+    obj.tags.append(String<>("a long tag, longer than 7 bytes"));
+    for (u32 i = 0; i < 100; ++i) {
+        obj.samples.append(f32(i) * 0.5f);
+    }
+
+    Tree<> tree;
+    tree << obj;
+    String<> bytes;
+    tree.format(bytes, $bin);
+
+    TestBin res;
+    Tree<>(bytes, $bin) >> res;
+    test::assert_eq(res.id, 7u);
+    test::assert_true(StrView(res.name) == StrView("seven"));
+    test::assert_eq(res.price, -1.25);
+    test::assert_eq(res.active, true);
+    test::assert_eq(res.time.stamp(), obj.time.stamp());
+    test::assert_eq(res.tags.count(), 2u);
+    test::assert_true(StrView(res.tags[1]) == StrView(obj.tags[1]));
+    test::assert_eq(res.samples.count(), 100u);
+    test::assert_eq(res.samples[99], 49.5f);
+
+    // the same tree as json
+    String<> json0;
+    String<> json1;
+    sformat(json0, "{:json}", tree);
+    sformat(json1, "{:json}", Tree<>(bytes, $bin));
+    test::assert_true(StrView(json0) == StrView(json1));
+
+    // a typed array: the values are the payload
+    math::Array<i16, 2> x({ 5, 3 });
+    for (u32 j = 0; j < 3; ++j) {
+        for (u32 i = 0; i < 5; ++i) {
+            x(i, j) = i16(i * 10 - j);
+        }
+    }
+    Tree<> xtree;
+    xtree << x;
+    bytes.clear();
+    xtree.format(bytes, $bin);
+    test::assert_eq(bytes.count(), 1u + 4u + 2u + 15u * 2u);
+
+    math::Array<i16, 2> y;
+    Tree<>(bytes, $bin) >> y;
+    test::assert_eq(y.size(), { 5u, 3u });
+    test::assert_eq(y(4, 2), i16(38));
+
+    // errors
+    const char bad[] = { char(u8(Type::array) | (2 << 5)), char(Type::i32), 1, 0, 0 };
+    try {
+        Tree<>(StrView{ bad, sizeof(bad) }, $bin);
+        test::assert_true(false);
+    }
+    catch (const EBinParse& e) {
+        test::assert_eq(e.offset(), u64(2));
+    }
+}
+
+/* 4096 records, each with 64 samples: json vs bin */
+nms_test(bin_perf) {
+    List<TestBin> list;
+    for (u32 i = 0; i < 4096; ++i) {
+        TestBin obj;
+        obj.id     = i;
+        obj.name   = "item";
+        obj.price  = i * 0.37;
+        obj.active = i % 2 == 0;
+        obj.time   = DateTime(2017, 9, 3, 8, 30, 12);
+        obj.tags.append(String<>("red"));
+        obj.tags.append(String<>("large"));
+        for (u32 k = 0; k < 64; ++k) {
+            obj.samples.append(f32(i + k) * 0.25f);
+        }
+        list.append(move(obj));
+    }
+
+    Tree<> tree;
+    tree << list;
+
+    static const u32 loops = 4;
+    String<> json;
+    String<> bin;
+
+    const auto t0 = nms::clock();
+    for (u32 i = 0; i < loops; ++i) {
+        json.clear();
+        tree.format(json, $json);
+    }
+    const auto t1 = nms::clock();
+    for (u32 i = 0; i < loops; ++i) {
+        bin.clear();
+        tree.format(bin, $bin);
+    }
+    const auto t2 = nms::clock();
+    for (u32 i = 0; i < loops; ++i) {
+        List<TestBin> res;
+        Tree<>(json, $json) >> res;
+        test::assert_eq(res[4095].samples[63], list[4095].samples[63]);
+    }
+    const auto t3 = nms::clock();
+    for (u32 i = 0; i < loops; ++i) {
+        List<TestBin> res;
+        Tree<>(bin, $bin) >> res;
+        test::assert_eq(res[4095].samples[63], list[4095].samples[63]);
+    }
+    const auto t4 = nms::clock();
+
+    io::log::info("nms.serialization.bin: json {.1}KB, encode {.3}ms, decode {.3}ms; bin {.1}KB, encode {.3}ms, decode {.3}ms",
+        json.count() / 1024.0, (t1 - t0) * 1e3 / loops, (t3 - t2) * 1e3 / loops,
+        bin.count() / 1024.0, (t2 - t1) * 1e3 / loops, (t4 - t3) * 1e3 / loops);
+}
+#pragma endregion
+
+}
@@ -4,6 +4,123 @@
 namespace nms::serialization
 {
 
+#pragma region index
+/*
+ * a lookup table takes raw nodes at the end of the tape: a header, then the
+ * entries, the nodes of the elements of an array or the hash and the value
+ * node of the keys of an object (open addressing, linear probing).
+ * the tables are only appended by the calls that may move the tape anyway:
+ * the parsers, build_index and the non const lookups and inserts.
+ * a const lookup reads the table, or walks the container if it has none.
+ * the appends at the end of the container are added while there is room,
+ * else the table is built again twice as large by the append.
+ * the nodes of a dropped table are left in the tape.
+ */
+struct DOMIndex
+{
+    u32 cap;    // entries
+    u32 used;   // entries in use
+    i32 last;   // the last element, or the value of the last key
+    u32 reserved;
+};
+
+struct DOMIndexKey
+{
+    u32 hash;
+    i32 node;   // the value of the key, 0: empty
+};
+
+static_assert(sizeof(DOMIndex) == sizeof(DOM), "nms.serialization.DOMIndex: should be a node");
+
+static DOMIndex& _index_head(List<DOM>& nodes, u32 table) {
+    return *reinterpret_cast<DOMIndex*>(&nodes[table]);
+}
+
+template<class T>
+static T* _index_items(List<DOM>& nodes, u32 table) {
+    return reinterpret_cast<T*>(&nodes[table + 1]);
+}
+
+static u32 _index_hash(const StrView& key) {
+    return u32(hash(key.data(), key.count()));
+}
+
+static void _index_put(DOMIndexKey* items, u32 cap, u32 hash, i32 node) {
+    auto i = hash & (cap - 1);
+    while (items[i].node != 0) {
+        i = (i + 1) & (cap - 1);
+    }
+    items[i] = { hash, node };
+}
+
+NMS_API u32 XDOM::_index() {
+    auto& nodes = *pnodes_;
+
+    auto table = nodes[index_].con_val_.table;
+    if (table != 0) {
+        return table;
+    }
+
+    const auto type = this->type();
+    const auto n    = count();
+    table = nodes.count();
+
+    if (type == Type::array) {
+        // room for as many appends
+        const auto cap = n < 16 ? 32 : n * 2;
+        nodes.appends(1 + (cap + 3) / 4, DOM{});
+
+        auto items = _index_items<i32>(nodes, table);
+        auto x     = index_ + 1;
+        auto last  = 0;
+        for (u32 k = 0; k < n; ++k) {
+            items[k] = last = x;
+            x += nodes[x].next_;
+        }
+        _index_head(nodes, table) = { cap, n, last, 0 };
+    }
+    else if (type == Type::object) {
+        // at most half full
+        u32 cap = 32;
+        while (cap < n * 2) {
+            cap *= 2;
+        }
+        nodes.appends(1 + cap / 2, DOM{});
+
+        auto items = _index_items<DOMIndexKey>(nodes, table);
+        auto x     = index_ + 2;
+        auto last  = 0;
+        for (u32 k = 0; k < n; ++k) {
+            const auto& key = nodes[x - 1];
+            _index_put(items, cap, _index_hash({ key.key_val_, key.size_ }), x);
+            last = x;
+            x   += nodes[x].next_;
+        }
+        _index_head(nodes, table) = { cap, n, last, 0 };
+    }
+    else {
+        NMS_THROW(EUnexpectType{ Type::object, type });
+    }
+
+    nodes[index_].con_val_.table = table;
+    return table;
+}
+
+NMS_API void XDOM::build_index() {
+    const auto type = this->type();
+    if (type != Type::array && type != Type::object) {
+        return;
+    }
+    if (count() >= $index_min) {
+        _index();
+    }
+    for (auto itr = begin(); itr != end(); ++itr) {
+        (*itr).build_index();
+    }
+}
+#pragma endregion
+
+#pragma region array
 NMS_API XDOM XDOM::operator[](u32 k) const {
     if ( type() != Type::array) {
         NMS_THROW(EUnexpectType{ Type::array, type() });
@@ -14,6 +131,11 @@ NMS_API XDOM XDOM::operator[](u32 k) const {
         NMS_THROW(EUnexpectElementCount{ k + 1, n });
     }
 
+    const auto table = (*pnodes_)[index_].con_val_.table;
+    if (table != 0) {
+        return { pnodes_, _index_items<i32>(*pnodes_, table)[k] };
+    }
+
     // find index
     auto itr = begin();
     for (auto i = 0u; i < k; ++i) {
@@ -34,25 +156,56 @@ NMS_API XDOM XDOM::operator[](u32 k) {
         NMS_THROW(EUnexpectType{ Type::array, type() });
     }
 
-    // find index
-    auto itr = begin();
-    for (auto i = 0u; i < k; ++i) {
-        // out of range, insert new val
-        if (i >= count()) {
-            auto pnode = add(index_, itr.idx_, DOM());
-            (void)pnode;
+    const auto n = count();
+    if (n >= $index_min) {
+        _index();
+    }
+    if (k < n) {
+        return static_cast<const XDOM&>(*this)[k];
+    }
+
+    // out of range: append null values, up to k
+    auto last = 0;
+    if (n >= $index_min) {
+        last = _index_head(node_list, _index()).last;
+    }
+    else if (n > 0) {
+        for (auto itr = begin(); itr != end(); ++itr) {
+            last = itr.idx_;
         }
-        ++itr;
     }
-    return *itr;
+    for (auto i = n; i <= k; ++i) {
+        last = add(index_, last, DOM());
+    }
+    return { pnodes_, last };
 }
+#pragma endregion
 
+#pragma region object
 NMS_API XDOM::Iterator XDOM::find(StrView expect) const {
     if (type() != Type::object) {
         NMS_THROW(EUnexpectType{ Type::object, type() });
     }
 
-    auto n      = count();
+    auto& nodes = *pnodes_;
+    auto  n     = count();
+    const auto table = nodes[index_].con_val_.table;
+    if (table != 0) {
+        const auto cap   = _index_head(nodes, table).cap;
+        const auto items = _index_items<DOMIndexKey>(nodes, table);
+        const auto h     = _index_hash(expect);
+        for (auto i = h & (cap - 1); items[i].node != 0; i = (i + 1) & (cap - 1)) {
+            if (items[i].hash != h) {
+                continue;
+            }
+            const auto& key = nodes[items[i].node - 1];
+            if (StrView{ key.key_val_, key.size_ } == expect) {
+                return { pnodes_, items[i].node };
+            }
+        }
+        return { pnodes_, 0 };
+    }
+
     auto itr    = begin();
     for (u32 i = 0; i < n; ++i, ++itr) {
         auto key = itr.key();
@@ -93,6 +246,16 @@ NMS_API XDOM XDOM::operator[](StrView key) {
     }
 
     auto n      = v.count();
+    if (n >= $index_min) {
+        const auto table = _index();
+        auto itr = find(key);
+        if (itr != end()) {
+            return *itr;
+        }
+        const auto last = _index_head(node_list, table).last;
+        return { pnodes_, add(index_, last, key, DOM(Type::null)) };
+    }
+
     auto itr    = begin();
     auto last   = itr.idx_;
 
@@ -108,7 +271,9 @@ NMS_API XDOM XDOM::operator[](StrView key) {
 
     return XDOM{ pnodes_, pval };
 }
+#pragma endregion
 
+#pragma region add
 NMS_API i32 XDOM::add(i32 root, i32 prev, const DOM& val) {
     auto& node_list = *pnodes_;
 
@@ -121,8 +286,23 @@ NMS_API i32 XDOM::add(i32 root, i32 prev, const DOM& val) {
     }
     node_list.append(val);
 
+    auto rebuild = false;
     if (root > 0) {
-        node_list[root].size_ += 1;
+        auto& r = node_list[root];
+        r.con_val_.count += 1;
+
+        // keep the table of the array, if the value is appended at the end
+        if (r.con_val_.table != 0) {
+            auto& head = _index_head(node_list, r.con_val_.table);
+            if (prev == head.last && head.used < head.cap) {
+                _index_items<i32>(node_list, r.con_val_.table)[head.used++] = xpos;
+                head.last = xpos;
+            }
+            else {
+                r.con_val_.table = 0;
+                rebuild = true;
+            }
+        }
     }
     if (prev > 0) {
         node_list[prev].next_ = xpos - prev;
@@ -130,6 +310,9 @@ NMS_API i32 XDOM::add(i32 root, i32 prev, const DOM& val) {
     if (val.type() == Type::string) {
         node_list[0].size_ += u16(val.size());
     }
+    if (rebuild) {
+        XDOM{ pnodes_, root }._index();
+    }
     return i32(xpos);
 }
 
@@ -145,8 +328,24 @@ NMS_API i32 XDOM::add(i32 root, i32 prev, const StrView& key, const DOM& val) {
     node_list.append(DOM(key, Type::key));
     node_list.append(val);
 
+    auto rebuild = false;
     if (root > 0) {
-        node_list[root].size_++;
+        auto& r = node_list[root];
+        r.con_val_.count += 1;
+
+        // keep the table of the object, if the key is appended at the end and it is at most 3/4 full
+        if (r.con_val_.table != 0) {
+            auto& head = _index_head(node_list, r.con_val_.table);
+            if (prev == head.last && (head.used + 1) * 4 <= head.cap * 3) {
+                _index_put(_index_items<DOMIndexKey>(node_list, r.con_val_.table), head.cap, _index_hash(key), xpos);
+                head.used += 1;
+                head.last  = xpos;
+            }
+            else {
+                r.con_val_.table = 0;
+                rebuild = true;
+            }
+        }
     }
     if (prev > 0) {
         const auto offset = xpos - prev;
@@ -154,8 +353,175 @@ NMS_API i32 XDOM::add(i32 root, i32 prev, const StrView& key, const DOM& val) {
         node_list[prev - 1].next_ = offset;
     }
     node_list[0].size_ += DOM::Tsize(key.count() + u32(val.size()));
+    if (rebuild) {
+        XDOM{ pnodes_, root }._index();
+    }
     return xpos;
 }
+#pragma endregion
+
+
+#pragma region unittest
+nms_test(dom_index) {
+    // an object: the table follows the inserts
+    // the keys are views: they should live as long as the tree
+    List<String<> > keys;
+    for (u32 i = 0; i < 100; ++i) {
+        String<> key;
+        sformat(key, "k{}", i);
+        keys.append(move(key));
+    }
+
+    Tree<> obj;
+    for (u32 i = 0; i < 100; ++i) {
+        obj[StrView(keys[i])] = i;
+    }
+    test::assert_eq(obj.count(), 100u);
+    for (u32 i = 0; i < 100; ++i) {
+        test::assert_eq(u32(obj[StrView(keys[i])]), i);
+    }
+    test::assert_true(obj.find("k100") == obj.end());
+
+    // an array: appends after the table is built
+    String<> text;
+    text += "[";
+    for (u32 i = 0; i < 1000; ++i) {
+        sformat(text, "{}{}", i == 0 ? "" : ",", i);
+    }
+    text += "]";
+    Tree<> arr(text, $json);
+    test::assert_eq(i32(arr[999]), 999);
+    arr[1005] = 1005;
+    test::assert_eq(arr.count(), 1006u);
+    test::assert_eq(arr[1002].type(), Type::null);
+    test::assert_eq(i32(arr[1005]), 1005);
+    u32 k = 0;
+    for (auto e : arr) {
+        (void)e;
+        ++k;
+    }
+    test::assert_eq(k, 1006u);
+
+    // the first of the same keys
+    text.clear();
+    text += "{";
+    for (u32 i = 0; i < 20; ++i) {
+        sformat(text, "\"k{}\": {}, ", i % 15, i);
+    }
+    text += "\"end\": 0}";
+    Tree<> dup(text, $json);
+    dup.build_index();
+    const auto& cdup = dup;
+    test::assert_eq(i32(cdup["k3"]), 3);
+    test::assert_eq(i32(cdup["k14"]), 14);
+    test::assert_eq(i32(cdup["end"]), 0);
+
+    // a const lookup does not move the tape: the parse built the tables
+    const Tree<> big(text, $json);
+    const auto& first = big["k0"].val();
+    for (u32 i = 0; i < 15; ++i) {
+        String<> key;
+        sformat(key, "k{}", i);
+        test::assert_eq(i32(big[StrView(key)]), i32(i));
+    }
+    test::assert_true(&big["k0"].val() == &first);
+
+    text.clear();
+    text += "[";
+    for (u32 i = 0; i < 1000; ++i) {
+        sformat(text, "{}{}", i == 0 ? "" : ",", i);
+    }
+    text += "]";
+    const Tree<> carr(text, $json);
+    const auto& elem = carr[0].val();
+    test::assert_eq(i32(carr[999]), 999);
+    test::assert_true(&carr[0].val() == &elem);
+}
 
+struct IndexConfig
+    : public ISerializable
+{
+    NMS_PROPERTY_BEGIN;
+    typedef i32         NMS_PROPERTY(x);
+    typedef f64         NMS_PROPERTY(y);
+    typedef String<32>  NMS_PROPERTY(name);
+    NMS_PROPERTY_END;
+};
+
+/* a struct out of an object of 500 keys, and the elements of a 64K elements array */
+nms_test(dom_index_perf) {
+    String<> text;
+    text += "{";
+    for (u32 i = 0; i < 500; ++i) {
+        sformat(text, "\"option_{}\": {}, ", i, i);
+    }
+    text += "\"x\": 1, \"y\": 2.5, \"name\": \"config\"}";
+    Tree<> obj(text, $json);
+
+    static const u32 loops = 10000;
+
+    // the keys of the struct, by walking the keys
+    const StrView names[] = { "x", "y", "name" };
+    const auto t0 = nms::clock();
+    u64 found = 0;
+    for (u32 i = 0; i < loops; ++i) {
+        for (auto& name : names) {
+            for (auto itr = obj.begin(); itr != obj.end(); ++itr) {
+                if (itr.key() == name) {
+                    ++found;
+                    break;
+                }
+            }
+        }
+    }
+    const auto t1 = nms::clock();
+    IndexConfig cfg;
+    for (u32 i = 0; i < loops; ++i) {
+        obj >> cfg;
+    }
+    const auto t2 = nms::clock();
+    test::assert_eq(found, u64(loops) * 3);
+    test::assert_true(StrView(cfg.name) == StrView("config"));
+
+    // read every element of an array, by index
+    static const u32 n = 64 * 1024;
+    text.clear();
+    text += "[";
+    for (u32 i = 0; i < n; ++i) {
+        sformat(text, "{}{}", i == 0 ? "" : ",", i % 1000);
+    }
+    text += "]";
+    Tree<> arr(text, $json);
+
+    // the same m elements spread over the array: by walking from the start, then by index (the parse built the table)
+    static const u32 m    = 1024;
+    static const u32 step = n / m;
+    const auto& carr = arr;
+    const auto t3 = nms::clock();
+    u64 sum0 = 0;
+    for (u32 i = 0; i < m; ++i) {
+        auto itr = carr.begin();
+        for (u32 j = 0; j < i * step; ++j) {
+            ++itr;
+        }
+        sum0 += u32(*itr);
+    }
+    const auto t4 = nms::clock();
+    u64 sum1 = 0;
+    for (u32 i = 0; i < m; ++i) {
+        sum1 += u32(carr[i * step]);
+    }
+    const auto t5 = nms::clock();
+    u64 expect = 0;
+    for (u32 i = 0; i < m; ++i) {
+        expect += (i * step) % 1000;
+    }
+    test::assert_eq(sum0, expect);
+    test::assert_eq(sum1, expect);
+
+    io::log::info("nms.serialization.dom: 500 keys: 3 keys by walking {.3}us, struct by index {.3}us", (t1 - t0) * 1e6 / loops, (t2 - t1) * 1e6 / loops);
+    io::log::info("nms.serialization.dom: {} elements, {} of them: by walking {.3}ms, by index {.3}ms", n, m, (t4 - t3) * 1e3, (t5 - t4) * 1e3);
 }
+#pragma endregion
 
+}
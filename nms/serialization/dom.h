@@ -1,6 +1,13 @@
 #pragma once
 
 #include <nms/serialization/base.h>
+#include <nms/util/hashmap.h>
+
+namespace nms::math
+{
+template<class T, u32 N>
+class Array;
+}
 
 namespace  nms::serialization
 {
@@ -44,12 +51,13 @@ public:
         return type_;
     }
 
-    Tsize count() const {
-        return size_;
+    /* the elements of an array, the keys of an object, else the length of the text */
+    u32 count() const {
+        return (type_ == Type::array || type_ == Type::object) ? con_val_.count : size_;
     }
 
-    Tsize size() const {
-        return size_;
+    u32 size() const {
+        return count();
     }
 
     Tnext next() const {
@@ -99,6 +107,12 @@ protected:
 
         DOM*   arr_val_;
         DOM*   obj_val_ = nullptr;
+
+        struct
+        {
+            u32 count;  // elements of an array, keys of an object
+            u32 table;  // the node of the lookup table, 0: none (@see XDOM::find)
+        } con_val_;
     };
 };
 
@@ -205,11 +219,11 @@ public:
     }
 
     u32 size() const {
-        return val().size_;
+        return val().count();
     }
 
     u32 count() const {
-        return val().size_;
+        return val().count();
     }
 
     /* get key */
@@ -267,6 +281,21 @@ public:
     }
 #pragma endregion
 
+#pragma region index
+    /* the containers with less entries are searched without a table */
+    static constexpr u32 $index_min = 16;
+
+    /*!
+     * build the lookup tables of the large containers of the subtree:
+     * the nodes of the elements of an array, a hash of the keys of an object.
+     * the tables are kept in the tape, after the nodes, and follow the appends.
+     * the parsers build them, a non const lookup builds the table of its container.
+     * a const lookup never appends to the tape: without a table, it walks the container.
+     * build_index may move the tape: the DOM references taken before are invalid.
+     */
+    NMS_API void build_index();
+#pragma endregion
+
 #pragma region get/set
     template<class T>
     const XDOM& operator>>(T& x) {
@@ -403,6 +432,75 @@ public:
     }
 #pragma endregion
 
+#pragma region view
+    /* node -> array: nested arrays, the innermost one is dim 0 */
+    template<class T, u32 N>
+    void get(math::Array<T, N>& x) const {
+        u32  dims[N] = {};
+        XDOM node    = *this;
+        for (auto k = N; k-- > 0; ) {
+            if (node.type() != Type::array) {
+                NMS_THROW(EUnexpectType{ Type::array, node.type() });
+            }
+            dims[k] = node.count();
+            if (dims[k] == 0) {
+                break;
+            }
+            node = *node.begin();
+        }
+        x.resize(dims);
+        auto out = x.data();
+        get_view(out, dims, N - 1);
+    }
+
+    /* node <- view */
+    template<class T>
+    void set(const View<T>& x) {
+        const u32 size[] = { x.count() };
+        const i32 step[] = { 1 };
+        set_node(DOM(Type::array));
+        set_view(x.data(), size, step, 0);
+    }
+
+    /* node <- view: nested arrays, the innermost one is dim 0 */
+    template<class T, u32 N>
+    void set(const View<T, N>& x) {
+        set_node(DOM(Type::array));
+        const auto size = x.size();
+        const auto step = x.step();
+        set_view(x.data(), &size[0], &step[0], N - 1);
+    }
+#pragma endregion
+
+#pragma region map
+    /* node -> map */
+    template<class T, u32 S>
+    void get(HashMap<List<char, S>, T>& x) const {
+        if (type() != Type::object) {
+            NMS_THROW(EUnexpectType{ Type::object, type() });
+        }
+        x.reserve(x.count() + count());
+        for (auto itr = begin(); itr != end(); ++itr) {
+            T val;
+            (*itr).get(val);
+            x.set(itr.key(), move(val));
+        }
+    }
+
+    /* node <- map */
+    template<class T, u32 S>
+    void set(const HashMap<List<char, S>, T>& x) {
+        set_node(DOM(Type::object));
+
+        auto root = index_;
+        auto prev = 0;
+        for (auto& e : x) {
+            prev = add(root, prev, StrView(e.key), DOM(Type::null));
+            XDOM{ pnodes_, prev }.set(e.value);
+        }
+    }
+#pragma endregion
+
 #pragma region enum
     /* node -> enum */
     template<class Tenum>
@@ -456,6 +554,9 @@ public:
     NMS_API i32 add(i32 root, i32 prev, const DOM& val);
 
     NMS_API i32 add(i32 root, i32 prev, const StrView& key, const DOM& val);
+
+    /* the node of the lookup table of this container, built if none: may move the tape */
+    NMS_API u32 _index();
 #pragma endregion
 
 #pragma region format
@@ -463,6 +564,9 @@ public:
         if (fmt == "xml") {
             format(buf, $xml);
         }
+        else if (fmt == "bin") {
+            format(buf, $bin);
+        }
         else {
             format(buf, $json);
         }
@@ -478,6 +582,9 @@ public:
             _format_xml(buf);
             _format_xml_end(buf);
             break;
+        case $bin:
+            _format_bin(buf);
+            break;
         }
     }
 #pragma endregion
@@ -488,6 +595,14 @@ protected:
     i32         index_;
 
     void set_node(const DOM& x) {
+        // empty tree: node 0 is the root of all nodes, like operator[]
+        if (pnodes_->count() == 0) {
+            pnodes_->append(DOM{ Type::null, 0 });
+            pnodes_->append(x);
+            index_ = 1;
+            return;
+        }
+
         auto& v = val();
 
         if (v.type() == Type::null || v.type() == x.type() ) {
@@ -557,6 +672,40 @@ protected:
         NMS_THROW(EUnexpectType{ Type::string, v.type() });
     }
 
+    template<class T>
+    void get_view(T*& out, const u32* dims, u32 dim) const {
+        if (type() != Type::array) {
+            NMS_THROW(EUnexpectType{ Type::array, type() });
+        }
+        if (count() != dims[dim]) {
+            NMS_THROW(EUnexpectElementCount{ dims[dim], count() });
+        }
+        for (auto e : *this) {
+            if (dim == 0) {
+                e.get(*out++);
+            }
+            else {
+                e.get_view(out, dims, dim - 1);
+            }
+        }
+    }
+
+    template<class T>
+    void set_view(const T* data, const u32* size, const i32* step, u32 dim) {
+        auto root = index_;
+        auto prev = 0;
+        for (u32 i = 0; i < size[dim]; ++i) {
+            const auto p = data + i64(i) * step[dim];
+            if (dim == 0) {
+                prev = add(root, prev, DOM(*p));
+            }
+            else {
+                prev = add(root, prev, DOM(Type::array));
+                XDOM{ pnodes_, prev }.set_view(p, size, step, dim - 1);
+            }
+        }
+    }
+
     bool get_time(DateTime& x) const {
         auto v = val();
         // type: match
@@ -591,6 +740,9 @@ protected:
         case $json:
             _parse_json(str);
             break;
+        case $bin:
+            _parse_bin(str);
+            break;
         case $xml:
         default:
             break;
@@ -604,6 +756,9 @@ private:
     NMS_API void _format_xml      (String<>& buf, u32 level = 0) const;
 
     NMS_API void _parse_json(const StrView& str);
+
+    NMS_API void _format_bin(String<>& buf) const;
+    NMS_API void _parse_bin(const StrView& bytes);
 #pragma endregion
 
 };
@@ -1,5 +1,10 @@
 #include <nms/test.h>
 #include <nms/serialization/dom.h>
+#include <nms/serialization/jsonreader.h>
+#include <nms/serialization/jsonwriter.h>
+#include <nms/core/memstat.h>
+#include <nms/core/simd.h>
+#include <nms/math/array.h>
 
 namespace nms::serialization
 {
@@ -77,248 +82,1110 @@ NMS_API void XDOM::_format_json(String<>& buf, u32 level) const {
 #pragma endregion
 
 #pragma region parse:json
-// parse
-static bool expect(const StrView& expect, const StrView& text) {
-    for (u32 i = 1; i < expect.count(); ++i) {
-        if (expect[i] != text[i]) {
-            return false;
+/*
+ * the text is parsed in two stages, as simdjson does:
+ * 1. index: each 64 bytes block is classified into bit masks by simd,
+ *    the quotes are paired by a prefix xor (escaped quotes skipped), and the
+ *    offsets of the operators ({}[]:,), of the quotes and of the first byte
+ *    of each scalar (number, true, false, null) are listed.
+ *    utf-8 and the control characters in the strings are checked here.
+ * 2. tape: the list is walked without recursion, each value appends a DOM.
+ *    a value takes at least one offset, the tape is reserved for each batch.
+ * the stages run a batch of blocks at a time: the offsets of a batch are walked
+ * while they are in the cache, the list never holds the whole text.
+ * a string is the bytes between its quotes, escapes are kept as they are.
+ *
+ * known limitation: the target is 1GB/s, the 3.9MB json_parse_perf document
+ * parses at 0.35-0.8GB/s on a shared core (stage 1 alone: 1.2-1.9GB/s).
+ * stage 2 and the first write of each page of the tape take most of the time.
+ */
+
+/* the bit masks of a 64 bytes block, bit k is byte k */
+struct JsonBlock
+{
+    u64 quote;      // '"'
+    u64 bslash;     // backslash
+    u64 op;         // { } [ ] : ,
+    u64 space;      // ' ' \t \r \n
+    u64 ctrl;       // < 0x20
+    u64 high;       // >= 0x80
+};
+
+enum JsonClass : u8
+{
+    $json_quote  = 0x01,
+    $json_bslash = 0x02,
+    $json_op     = 0x04,
+    $json_space  = 0x08,
+    $json_ctrl   = 0x10,
+};
+
+struct JsonTable
+{
+    u8 cls[256];
+
+    JsonTable() {
+        for (u32 c = 0; c < 256; ++c) {
+            cls[c] = c < 0x20 ? $json_ctrl : 0;
+        }
+        cls[u8('"')]  |= $json_quote;
+        cls[u8('\\')] |= $json_bslash;
+        for (auto p = "{}[]:,"; *p != 0; ++p) {
+            cls[u8(*p)] |= $json_op;
+        }
+        for (auto p = " \t\r\n"; *p != 0; ++p) {
+            cls[u8(*p)] |= $json_space;
         }
     }
-    return true;
+};
+
+static const JsonTable gJsonTable;
+
+static __forceinline u32 _json_ctz(u64 val) {
+#ifdef NMS_CC_MSVC
+    unsigned long idx = 0;
+    _BitScanForward64(&idx, val);
+    return u32(idx);
+#else
+    return u32(__builtin_ctzll(val));
+#endif
+}
+
+/* bit k: the count of the bits [0, k] is odd */
+static __forceinline u64 _json_prefix_xor(u64 x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
 }
 
-// test if blank
-static bool isBlank(char c) {
-    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') return true;
-    return false;
+static void _json_classify_scalar(const u8* s, u32 cnt, JsonBlock* out) {
+    for (u32 i = 0; i < cnt; ++i, s += 64) {
+        auto& b = out[i];
+        b = JsonBlock{};
+        for (u32 k = 0; k < 64; ++k) {
+            const auto c   = gJsonTable.cls[s[k]];
+            const auto bit = 1ull << k;
+            b.quote  |= (c & $json_quote)  ? bit : 0;
+            b.bslash |= (c & $json_bslash) ? bit : 0;
+            b.op     |= (c & $json_op)     ? bit : 0;
+            b.space  |= (c & $json_space)  ? bit : 0;
+            b.ctrl   |= (c & $json_ctrl)   ? bit : 0;
+            b.high   |= (s[k] >= 0x80)     ? bit : 0;
+        }
+    }
 }
 
-static char peekChar(StrView& text) {
-    u32 pos = 0;
-    u32 len = u32(text.count());
-    while (pos < len && isBlank(text[pos])) pos++;
+#ifdef NMS_SIMD_SSE2
+/* ('[' | 0x20) == '{', (']' | 0x20) == '}' */
+static void _json_classify_sse(const u8* s, u32 cnt, JsonBlock* out) {
+    const auto v20    = _mm_set1_epi8(0x20);
+    const auto v1f    = _mm_set1_epi8(0x1f);
+    const auto vlb    = _mm_set1_epi8('{');
+    const auto vrb    = _mm_set1_epi8('}');
+    const auto vcolon = _mm_set1_epi8(':');
+    const auto vcomma = _mm_set1_epi8(',');
+    const auto vquote = _mm_set1_epi8('"');
+    const auto vbs    = _mm_set1_epi8('\\');
+    const auto vtab   = _mm_set1_epi8('\t');
+    const auto vcr    = _mm_set1_epi8('\r');
+    const auto vlf    = _mm_set1_epi8('\n');
 
-    auto c = text[pos];
-    text = text.slice(pos, u32(text.count() - 1));
-    return c;
+    for (u32 i = 0; i < cnt; ++i, s += 64) {
+        auto& b = out[i];
+        b = JsonBlock{};
+        for (u32 k = 0; k < 64; k += 16) {
+            const auto x  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + k));
+            const auto lo = _mm_or_si128(x, v20);
+            const auto op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(lo, vlb), _mm_cmpeq_epi8(lo, vrb)),
+                                         _mm_or_si128(_mm_cmpeq_epi8(x, vcolon), _mm_cmpeq_epi8(x, vcomma)));
+            const auto sp = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, v20), _mm_cmpeq_epi8(x, vtab)),
+                                         _mm_or_si128(_mm_cmpeq_epi8(x, vcr), _mm_cmpeq_epi8(x, vlf)));
+            const auto ct = _mm_cmpeq_epi8(_mm_min_epu8(x, v1f), x);
+
+            b.quote  |= u64(u32(_mm_movemask_epi8(_mm_cmpeq_epi8(x, vquote)))) << k;
+            b.bslash |= u64(u32(_mm_movemask_epi8(_mm_cmpeq_epi8(x, vbs))))    << k;
+            b.op     |= u64(u32(_mm_movemask_epi8(op)))                         << k;
+            b.space  |= u64(u32(_mm_movemask_epi8(sp)))                         << k;
+            b.ctrl   |= u64(u32(_mm_movemask_epi8(ct)))                         << k;
+            b.high   |= u64(u32(_mm_movemask_epi8(x)))                          << k;
+        }
+    }
 }
 
-static char parseChar(StrView& text) {
-    auto c = peekChar(text);
-    text=text.slice(1u, u32(text.count()) - 1);
-    return c;
+NMS_TARGET("avx2")
+static void _json_classify_avx2(const u8* s, u32 cnt, JsonBlock* out) {
+    const auto v20    = _mm256_set1_epi8(0x20);
+    const auto v1f    = _mm256_set1_epi8(0x1f);
+    const auto vlb    = _mm256_set1_epi8('{');
+    const auto vrb    = _mm256_set1_epi8('}');
+    const auto vcolon = _mm256_set1_epi8(':');
+    const auto vcomma = _mm256_set1_epi8(',');
+    const auto vquote = _mm256_set1_epi8('"');
+    const auto vbs    = _mm256_set1_epi8('\\');
+    const auto vtab   = _mm256_set1_epi8('\t');
+    const auto vcr    = _mm256_set1_epi8('\r');
+    const auto vlf    = _mm256_set1_epi8('\n');
+
+    for (u32 i = 0; i < cnt; ++i, s += 64) {
+        auto& b = out[i];
+        b = JsonBlock{};
+        for (u32 k = 0; k < 64; k += 32) {
+            const auto x  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + k));
+            const auto lo = _mm256_or_si256(x, v20);
+            const auto op = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(lo, vlb), _mm256_cmpeq_epi8(lo, vrb)),
+                                            _mm256_or_si256(_mm256_cmpeq_epi8(x, vcolon), _mm256_cmpeq_epi8(x, vcomma)));
+            const auto sp = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, v20), _mm256_cmpeq_epi8(x, vtab)),
+                                            _mm256_or_si256(_mm256_cmpeq_epi8(x, vcr), _mm256_cmpeq_epi8(x, vlf)));
+            const auto ct = _mm256_cmpeq_epi8(_mm256_min_epu8(x, v1f), x);
+
+            b.quote  |= u64(u32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, vquote)))) << k;
+            b.bslash |= u64(u32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, vbs))))    << k;
+            b.op     |= u64(u32(_mm256_movemask_epi8(op)))                            << k;
+            b.space  |= u64(u32(_mm256_movemask_epi8(sp)))                            << k;
+            b.ctrl   |= u64(u32(_mm256_movemask_epi8(ct)))                            << k;
+            b.high   |= u64(u32(_mm256_movemask_epi8(x)))                             << k;
+        }
+    }
+    _mm256_zeroupper();
 }
+#endif
 
-static i32 parseAny(StrView& text, XDOM* nodes, i32 proot, i32 pleft);
+static bool _json_is_hex(u8 c) {
+    return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f');
+}
 
-static i32 parseNum(StrView& text, XDOM* nodes, i32 proot, i32 pleft) {
-    // 0123456789,
-    // ^         ^
-    // s         p
-    auto s = text.data();
-    auto p = s;
-    while (*p != ',' && *p != '}' && *p != ']' && *p != '\n') {
-        ++p;
+/* s[pos] is a backslash: the escape is valid */
+static bool _json_is_escape(const u8* s, u64 n, u64 pos) {
+    if (pos + 1 >= n) {
+        return false;
     }
+    switch (s[pos + 1]) {
+    case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+        return true;
+    case 'u':
+        return pos + 6 <= n && _json_is_hex(s[pos + 2]) && _json_is_hex(s[pos + 3]) && _json_is_hex(s[pos + 4]) && _json_is_hex(s[pos + 5]);
+    default:
+        return false;
+    }
+}
 
-    auto ret = nodes->add(proot, pleft, DOM(StrView{ s, u32(p - s) }, Type::number));
-    text     = StrView{ p, u32(text.count() - 1) };
-    return ret;
+static void _json_check_escape(const u8* s, u64 n, u64 pos) {
+    if (!_json_is_escape(s, n, pos)) {
+        NMS_THROW(EJsonParse{ pos, pos + 1 >= n ? "unexpected end in escape" : "invalid escape" });
+    }
 }
 
-static i32 parseStr(StrView& text, XDOM* nodes, i32 proot, i32 pleft) {
-    // "abcdefg"
-    // ^ ......^
-    // b       e
-    auto ptr    = text.data();
-    auto pos    = text.data() + 1;
+/* the length of the utf-8 sequence at s[pos] >= 0x80, 0: invalid */
+static u32 _json_utf8_len(const u8* s, u64 n, u64 pos) {
+    const auto c = s[pos];
 
-    while (true) {
-        auto c = *pos;
+    // the range of the second byte depends on the first one (overlong, surrogates, > U+10FFFF)
+    u32 len = 0;
+    u8  lo  = 0x80;
+    u8  hi  = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF) {
+        len = 2;
+    }
+    else if (c >= 0xE0 && c <= 0xEF) {
+        len = 3;
+        lo  = c == 0xE0 ? 0xA0 : lo;
+        hi  = c == 0xED ? 0x9F : hi;
+    }
+    else if (c >= 0xF0 && c <= 0xF4) {
+        len = 4;
+        lo  = c == 0xF0 ? 0x90 : lo;
+        hi  = c == 0xF4 ? 0x8F : hi;
+    }
 
-        if (c == '\\') {
-            pos += 2;
+    auto ok = len != 0 && pos + len <= n && s[pos + 1] >= lo && s[pos + 1] <= hi;
+    for (u32 k = 2; ok && k < len; ++k) {
+        ok = (s[pos + k] & 0xC0) == 0x80;
+    }
+    return ok ? len : 0;
+}
+
+/* check the utf-8 sequence at s[pos] >= 0x80, returns its end */
+static u64 _json_check_utf8(const u8* s, u64 n, u64 pos) {
+    const auto len = _json_utf8_len(s, n, pos);
+    if (len == 0) {
+        NMS_THROW(EJsonParse{ pos, "invalid utf-8" });
+    }
+    return pos + len;
+}
+
+/* blocks classified per call */
+static const u32 gJsonBatch = 16;
+
+/* stage 1: the offsets of the operators, the quotes and the scalars, a batch of blocks per call */
+struct JsonIndex
+{
+    using Tclassify = void(*)(const u8* s, u32 cnt, JsonBlock* out);
+
+    const u8*   s;
+    u64         n;
+    u64         pos      = 0;   // the next block
+    Tclassify   classify = &_json_classify_scalar;
+
+    u64 in_str   = 0;   // ~0: the previous block ends in a string
+    u64 escaped  = 0;   // 1: the first byte of the block is escaped
+    u64 scalar   = 0;   // 1: the previous block ends in a scalar
+    u64 utf8_end = 0;   // the bytes before are valid utf-8
+    u64 open_base  = 0; // the last block with a quote
+    u64 open_quote = 0;
+
+    JsonBlock blocks[gJsonBatch];
+    u8        tail[64];
+
+    JsonIndex(const u8* s, u64 n)
+        : s(s), n(n) {
+#ifdef NMS_SIMD_SSE2
+        switch (simd_level()) {
+        case SimdLevel::AVX2:   classify = &_json_classify_avx2;  break;
+        case SimdLevel::SSE:    classify = &_json_classify_sse;   break;
+        default:                break;
         }
-        else if (c == '"') {
-            break;
+#endif
+    }
+
+    bool done() const {
+        return pos >= n;
+    }
+
+    /* append the offsets of the next batch to idx */
+    void next(List<u32>& idx);
+};
+
+void JsonIndex::next(List<u32>& idx) {
+    // the full blocks, then the last one padded with blanks
+    const auto rest = n - pos;
+    auto cnt = rest >= 64 * gJsonBatch ? gJsonBatch : u32(rest / 64);
+    classify(s + pos, cnt, blocks);
+    if (cnt < gJsonBatch && rest % 64 != 0) {
+        ::memset(tail, ' ', 64);
+        ::memcpy(tail, s + pos + cnt * 64, rest % 64);
+        classify(tail, 1, blocks + cnt);
+        ++cnt;
+    }
+
+    // room for all the bytes
+    auto count = idx.count();
+    idx.resize(count + cnt * 64);
+    const auto out = idx.data();
+
+    for (u32 i = 0; i < cnt; ++i) {
+        const auto& b    = blocks[i];
+        const auto  base = pos + i * 64;
+
+        // a backslash escapes the next byte, unless it is escaped itself
+        auto esc = escaped;
+        auto bs  = b.bslash & ~escaped;
+        escaped  = 0;
+        while (bs != 0) {
+            const auto k = _json_ctz(bs);
+            _json_check_escape(s, n, base + k);
+            if (k == 63) {
+                escaped = 1;
+                break;
+            }
+            esc |= 2ull << k;
+            bs  &= ~(3ull << k);
         }
-        else {
-            pos += 1;
+
+        // in the strings: from an opening quote to the byte before the closing one
+        const auto quote = b.quote & ~esc;
+        const auto str   = _json_prefix_xor(quote) ^ in_str;
+        in_str = u64(i64(str) >> 63);
+        if (quote != 0) {
+            open_base  = base;
+            open_quote = quote;
         }
+
+        if ((b.ctrl & str) != 0) {
+            NMS_THROW(EJsonParse{ base + _json_ctz(b.ctrl & str), "control character in string" });
+        }
+
+        // the sequences that start in the block, the continuations are skipped
+        for (auto high = b.high; high != 0; high &= high - 1) {
+            const auto k = base + _json_ctz(high);
+            if (k >= utf8_end) {
+                utf8_end = _json_check_utf8(s, n, k);
+            }
+        }
+
+        // a scalar is a run of the other bytes out of the strings
+        const auto other  = ~(b.op | b.space | quote | str);
+        const auto starts = other & ~(other << 1 | scalar);
+        scalar = other >> 63;
+
+        auto bits = (b.op & ~str) | quote | starts;
+        auto dst  = out + count;
+        while (bits != 0) {
+            *dst++ = u32(base + _json_ctz(bits));
+            bits &= bits - 1;
+        }
+        count = u32(dst - out);
     }
+    idx.resize(count);
+    pos += 64 * gJsonBatch;
 
-    const auto b = 0;
-    const auto e = u32(pos - ptr);
-    const auto ret = nodes->add(proot, pleft, DOM(StrView{ text.data() + b + 1, e - b - 1 }, Type::string));
-    text = text.slice(e + 1, u32(text.count()) - 1);
-    return ret;
+    if (done() && in_str != 0) {
+        while ((open_quote & (open_quote - 1)) != 0) {
+            open_quote &= open_quote - 1;
+        }
+        NMS_THROW(EJsonParse{ open_base + _json_ctz(open_quote), "unterminated string" });
+    }
 }
 
-static i32 parseKey(StrView& text, XDOM* nodes, i32 proot, i32 pleft) {
-    // "abcdefg"
-    // ^ ......^
-    // b       e
+/* the length of the number at s[0, n), 0: not a number. a leading '+' is accepted */
+static u32 _json_number(const u8* s, u32 n) {
+    auto is_digit = [&](u32 k) { return k < n && s[k] >= '0' && s[k] <= '9'; };
+
+    u32 k = 0;
+    if (k < n && (s[k] == '-' || s[k] == '+')) {
+        ++k;
+    }
+    if (!is_digit(k)) {
+        return 0;
+    }
+    if (s[k++] != '0') {
+        while (is_digit(k)) ++k;
+    }
+    if (k < n && s[k] == '.') {
+        if (!is_digit(++k)) {
+            return 0;
+        }
+        while (is_digit(k)) ++k;
+    }
+    if (k < n && (s[k] | 0x20) == 'e') {
+        ++k;
+        if (k < n && (s[k] == '-' || s[k] == '+')) {
+            ++k;
+        }
+        if (!is_digit(k)) {
+            return 0;
+        }
+        while (is_digit(k)) ++k;
+    }
+    return k;
+}
 
-    u32 b = 0;
-    u32 e = 1;
-    while (text[e] != '"' && text[e - 1] != '\\') ++e;
-    auto ret = nodes->add(proot, pleft, DOM(StrView{ text.data() + b + 1,  e - b - 1 }, Type::key));
-    text = text.slice(e + 1, u32(text.count()) - 1);
-    return ret;
+/* a scalar ends at an operator, a blank or the end of the text */
+static bool _json_is_end(const u8* s, u64 n, u64 pos) {
+    return pos == n || (gJsonTable.cls[s[pos]] & ($json_op | $json_space)) != 0;
 }
 
-static i32 parseArray(StrView& text, XDOM* nodes, i32 proot, i32 pleft) {
-    auto parr = nodes->add(proot, pleft, DOM(Type::array));
+/* the offsets a step of stage 2 looks at: "key" : value */
+static const u32 gJsonAhead = 4;
 
-    text = text.slice(1u, u32(text.count()) - 1);
-    if (peekChar(text) == ']') {
-        parseChar(text);
-        return parr;
+/* stage 2: the tape, the offsets of a batch are walked while they are in the cache */
+NMS_API void XDOM::_parse_json(const StrView& text) {
+    const auto s = reinterpret_cast<const u8*>(text.data());
+    const auto n = u64(text.count());
+
+    JsonIndex index(s, n);
+    List<u32> idx;
+    idx.reserve(64 * gJsonBatch + gJsonAhead);
+
+    u32  m    = 0;
+    u32* pidx = idx.data();
+
+    auto& nodes = *pnodes_;
+    if (nodes.count() == 0) {
+        nodes.append(DOM{ Type::null, 0 });
+        this->index_ = 1;
     }
 
-    auto prev_val = -1;
-    while (true) {
-        auto this_val = parseAny(text, nodes, parr, prev_val);
-        prev_val = this_val;
+    // a value takes at least one offset: the tape is kept reserved for the offsets of the window
+    auto refill = [&](u32& i) {
+        const auto rest = m - i;
+        ::memmove(pidx, pidx + i, rest * sizeof(u32));
+        idx.resize(rest);
+        i = 0;
+        do {
+            index.next(idx);
+        } while (idx.count() < gJsonAhead && !index.done());
+
+        m    = idx.count();
+        pidx = idx.data();
+        nodes.reserve(nodes.count() + m);
+    };
 
-        auto next_char = parseChar(text);
-        if (next_char == ']') {
-            return parr;
+    auto fail = [&](u32 i, const char* what) {
+        NMS_THROW(EJsonParse{ i < m ? pidx[i] : n, what });
+    };
+
+    // the container being filled: prev is the last key of an object, the last value of an array
+    struct Frame
+    {
+        i32  node;
+        i32  prev;
+        bool obj;
+    };
+    List<Frame> stack;
+    auto top = Frame{ -1, -1, false };
+
+    // the containers that get a lookup table, built at the end: the tape is complete
+    List<i32> large;
+
+    auto grow = [&](u32 i) {
+        auto& count = nodes[top.node].con_val_.count;
+        if (count == u32(-1)) {
+            fail(i, "too many elements");
         }
-        if (next_char == ',') {
+        ++count;
+    };
+
+    // "key": offsets i, i+1 and i+2
+    auto parse_key = [&](u32 i) {
+        if (i >= m || s[pidx[i]] != '"') {
+            fail(i, "expect a key");
+        }
+        if (i + 2 >= m || s[pidx[i + 2]] != ':') {
+            fail(i + 2, "expect ':'");
+        }
+        const auto len = pidx[i + 1] - pidx[i] - 1;
+        if (len > DOM::Tsize(-1)) {
+            fail(i, "key too long");
+        }
+
+        const auto k = i32(nodes.count());
+        grow(i);
+        if (top.prev > 0) {
+            const auto offset = k - top.prev;
+            nodes[top.prev + 0].next_ = offset;
+            nodes[top.prev + 1].next_ = offset;
+        }
+        top.prev = k;
+        nodes._append(StrView{ text.data() + pidx[i] + 1, len }, Type::key);
+    };
+
+    u32 i = 0;
+    while (true) {
+        // a value
+        if (i + gJsonAhead > m && !index.done()) {
+            refill(i);
+        }
+        if (i >= m) {
+            fail(i, "expect a value");
+        }
+        const auto pos = pidx[i];
+        const auto x   = i32(nodes.count());
+        if (top.node > 0 && !top.obj) {
+            grow(i);
+            if (top.prev > 0) {
+                nodes[top.prev].next_ = x - top.prev;
+            }
+            top.prev = x;
+        }
+
+        switch (s[pos]) {
+        case '{': case '[': {
+            const auto obj = s[pos] == '{';
+            nodes._append(obj ? Type::object : Type::array);
+            stack.append(top);
+            top = Frame{ x, -1, obj };
+            ++i;
+            if (i < m && s[pidx[i]] == (obj ? '}' : ']')) {
+                break;
+            }
+            if (obj) {
+                parse_key(i);
+                i += 3;
+            }
             continue;
         }
-        return -1;
+        case '"': {
+            const auto len = pidx[i + 1] - pos - 1;
+            if (len > DOM::Tsize(-1)) {
+                fail(i, "string too long");
+            }
+            nodes._append(StrView{ text.data() + pos + 1, len }, Type::string);
+            nodes[0].size_ += DOM::Tsize(len);
+            i += 2;
+            break;
+        }
+        case 't': case 'f': case 'n': {
+            const auto word = s[pos] == 't' ? StrView{ "true" } : s[pos] == 'f' ? StrView{ "false" } : StrView{ "null" };
+            const auto len  = word.count();
+            if (pos + len > n || ::memcmp(s + pos, word.data(), len) != 0 || !_json_is_end(s, n, pos + len)) {
+                fail(i, "invalid literal");
+            }
+            if (s[pos] == 'n') {
+                nodes._append(Type::null);
+            }
+            else {
+                nodes._append(s[pos] == 't');
+            }
+            ++i;
+            break;
+        }
+        default: {
+            const auto len = _json_number(s + pos, u32(n - pos));
+            if (len == 0 || !_json_is_end(s, n, pos + len)) {
+                fail(i, "invalid value");
+            }
+            nodes._append(StrView{ text.data() + pos, len }, Type::number);
+            ++i;
+            break;
+        }
+        }
+
+        // after a value: ',' or the end of the containers
+        while (true) {
+            if (i + gJsonAhead > m && !index.done()) {
+                refill(i);
+            }
+            if (top.node < 0) {
+                if (i != m) {
+                    fail(i, "expect the end");
+                }
+                for (auto x : large) {
+                    XDOM{ pnodes_, x }._index();
+                }
+                return;
+            }
+            if (i >= m) {
+                fail(i, "unexpected end");
+            }
+
+            const auto c = s[pidx[i]];
+            if (c == ',') {
+                ++i;
+                if (top.obj) {
+                    parse_key(i);
+                    i += 3;
+                }
+                break;
+            }
+            if (c != (top.obj ? '}' : ']')) {
+                fail(i, top.obj ? "expect ',' or '}'" : "expect ',' or ']'");
+            }
+            ++i;
+            if (nodes[top.node].con_val_.count >= $index_min) {
+                large.append(top.node);
+            }
+            top = stack[stack.count() - 1];
+            stack.resize(stack.count() - 1);
+        }
     }
 }
 
-static i32 parseObject(StrView& text, XDOM* nodes, i32 proot, i32 pleft) {
-    // add new node
-    auto pobj = nodes->add(proot, pleft, DOM(Type::object));
+#pragma endregion
+
+#pragma region stream:json
+/*
+ * the reader scans the bytes of a block, there is no index:
+ * the blanks, the strings and the scalars are passed over in a tight loop,
+ * 8 bytes at a time in the strings.
+ * the offsets (pos_, tok_, str_) are in the text, base_ is the offset of the block.
+ */
 
-    text = text.slice(1, -1);
-    if (peekChar(text) == '}') {
-        return pobj;
+enum JsonState : u8
+{
+    $json_root,
+    $json_first_key,        // after '{': a key or '}'
+    $json_key,              // after ',' in an object
+    $json_first_value,      // after '[': a value or ']'
+    $json_value,            // after ':', or after ',' in an array
+    $json_next,             // after a value: ',' or the end of the container
+    $json_done,
+};
+
+/* a high bit per byte of x equal to c, the bytes after the first one may be wrong */
+static __forceinline u64 _json_swar_eq(u64 x, u8 c) {
+    const auto y = x ^ (0x0101010101010101ull * c);
+    return (y - 0x0101010101010101ull) & ~y & 0x8080808080808080ull;
+}
+
+/* the 8 bytes at s hold a quote, a backslash, a control character or a non-ascii byte */
+static __forceinline bool _json_swar_special(const u8* s) {
+    u64 x;
+    ::memcpy(&x, s, 8);
+    const auto ctrl = (x - 0x2020202020202020ull) & ~x;
+    return ((_json_swar_eq(x, '"') | _json_swar_eq(x, '\\') | ctrl | x) & 0x8080808080808080ull) != 0;
+}
+
+NMS_API JsonReader::JsonReader(io::File&& file, u32 block_size)
+    : file_(move(file))
+    , block_(block_size == 0 ? 1 : block_size)
+    , eof_(false)
+{
+    buf_.reserve(block_ * 2);
+}
+
+NMS_API JsonReader::JsonReader(const StrView& text)
+    : data_(reinterpret_cast<const u8*>(text.data()))
+    , count_(text.count())
+{}
+
+NMS_API u64 JsonReader::fill(u64 n) {
+    const auto avail = base_ + count_ - pos_;
+    if (avail >= n || eof_) {
+        return min(avail, n);
     }
 
-    auto prev_key = -1;
-    auto prev_val = -1;
+    // keep the current token, read the blocks after it
+    const auto keep = u32(tok_ - base_);
+    const auto rest = u32(count_ - keep);
+    if (keep != 0) {
+        ::memmove(buf_.data(), buf_.data() + keep, rest);
+    }
+    buf_.resize(rest);
+    base_ = tok_;
+
+    while (!eof_ && base_ + buf_.count() < pos_ + n) {
+        const auto cnt = buf_.count();
+        buf_.reserve(cnt + block_);
+        const auto nread = file_.read(buf_.data() + cnt, block_);
+        buf_.resize(cnt + u32(nread));
+        eof_ = nread < block_;
+    }
+    data_  = reinterpret_cast<const u8*>(buf_.data());
+    count_ = buf_.count();
+    return min(base_ + count_ - pos_, n);
+}
 
+NMS_API bool JsonReader::_skip_blanks(bool keep) {
     while (true) {
-        // key
-        const auto next_quota  = peekChar(text);
-        if (next_quota != '"') {
-            return -1;
+        if (!keep) {
+            tok_ = pos_;
         }
-        const auto this_key  = parseKey(text, nodes, pobj, prev_key);
+        const auto avail = fill(64);
+        const auto s     = data_ + (pos_ - base_);
 
-        const auto next_colon = parseChar(text);
-        if (next_colon != ':') {
-            io::log::error("nms.serialization.json.parse_object: expect ':', but '{:c}' ", next_colon);
-            return -1;
+        u64 k = 0;
+        while (k < avail && (gJsonTable.cls[s[k]] & $json_space) != 0) {
+            ++k;
+        }
+        pos_ += k;
+        if (k < avail || avail == 0) {
+            return k < avail;
         }
-        const auto this_val  = parseAny(text, nodes, -1, prev_val);
-        (void)this_val;
+    }
+}
 
-        prev_key = this_key;
-        prev_val = this_val;
+/* the string at tok_ */
+NMS_API void JsonReader::_read_string() {
+    auto i = tok_ + 1;
+    while (true) {
+        pos_ = i;
+        const auto avail = fill(64);
+        if (avail == 0) {
+            NMS_THROW(EJsonParse{ tok_, "unterminated string" });
+        }
+        const auto s = data_ + (i - base_);
 
-        const auto next_char = parseChar(text);
-        if (next_char == '}') {
-            break;
+        u64 k = 0;
+        while (k + 8 <= avail && !_json_swar_special(s + k)) {
+            k += 8;
+        }
+        for (; k < avail; ++k) {
+            const auto c = s[k];
+            if ((gJsonTable.cls[c] & ($json_quote | $json_bslash | $json_ctrl)) != 0 || c >= 0x80) {
+                break;
+            }
         }
-        if (next_char == ',') {
+        i += k;
+        if (k == avail) {
             continue;
         }
-        io::log::error("nms.serialization.json.parse_object: expect ',' or '}', but '{:c}' ", next_char);
-        return -1;
+
+        const auto c = s[k];
+        if (c == '"') {
+            if (i - tok_ - 1 > u32(-1)) {
+                NMS_THROW(EJsonParse{ tok_, "string too long" });
+            }
+            str_     = tok_ + 1;
+            str_len_ = u32(i - str_);
+            pos_     = i + 1;
+            return;
+        }
+        if (c < 0x20) {
+            NMS_THROW(EJsonParse{ i, "control character in string" });
+        }
+
+        // an escape or a utf-8 sequence: the bytes may be in the next block
+        pos_ = i;
+        const auto n = fill(6);
+        const auto p = data_ + (i - base_);
+        if (c == '\\') {
+            if (!_json_is_escape(p, n, 0)) {
+                NMS_THROW(EJsonParse{ i, n < 2 ? "unexpected end in escape" : "invalid escape" });
+            }
+            i += 2;
+        }
+        else {
+            const auto len = _json_utf8_len(p, n, 0);
+            if (len == 0) {
+                NMS_THROW(EJsonParse{ i, "invalid utf-8" });
+            }
+            i += len;
+        }
     }
-    return pobj;
 }
 
-static i32 parseAny(StrView& text, XDOM* nodes, i32 proot, i32 pleft) {
-    auto result = -1;
-
-    const auto text_len    = text.count();
+/* the number or the literal at tok_ */
+NMS_API void JsonReader::_read_scalar() {
+    auto i = tok_;
+    while (true) {
+        pos_ = i;
+        const auto avail = fill(64);
+        const auto s     = data_ + (i - base_);
 
-    // peek next char
-    const auto next_char = peekChar(text);
+        u64 k = 0;
+        while (k < avail && (gJsonTable.cls[s[k]] & ($json_op | $json_space)) == 0) {
+            ++k;
+        }
+        i += k;
+        if (k < avail || avail == 0) {
+            break;
+        }
+    }
+    pos_ = i;
 
-    // test char
-    switch (next_char) {
-    case 'n':
-    {
-        if (expect("null", text)) {
-            text    = text.slice(4u, text_len - 1);
-            result  = nodes->add(proot, pleft, DOM{ Type::null });
+    const auto p   = data_ + (tok_ - base_);
+    const auto len = i - tok_;
+    if (p[0] == 't' || p[0] == 'f' || p[0] == 'n') {
+        const auto word = p[0] == 't' ? StrView{ "true" } : p[0] == 'f' ? StrView{ "false" } : StrView{ "null" };
+        if (len != word.count() || ::memcmp(p, word.data(), len) != 0) {
+            NMS_THROW(EJsonParse{ tok_, "invalid literal" });
         }
+        type_ = p[0] == 'n' ? Type::null : Type::boolean;
+        bool_ = p[0] == 't';
+        return;
+    }
+    if (len > u32(-1) || _json_number(p, u32(len)) != len) {
+        NMS_THROW(EJsonParse{ tok_, "invalid value" });
+    }
+    type_    = Type::number;
+    str_     = tok_;
+    str_len_ = u32(len);
+}
+
+/* the value at pos_ */
+NMS_API void JsonReader::_read_value() {
+    const auto c = data_[pos_ - base_];
+    switch (c) {
+    case '{': case '[':
+        ++pos_;
+        stack_.append(c);
+        event_ = c == '{' ? JsonEvent::object_begin : JsonEvent::array_begin;
+        type_  = c == '{' ? Type::object : Type::array;
+        state_ = c == '{' ? $json_first_key : $json_first_value;
+        return;
+    case '}': case ']': case ':': case ',':
+        NMS_THROW(EJsonParse{ pos_, "expect a value" });
+    case '"':
+        _read_string();
+        type_ = Type::string;
+        break;
+    default:
+        _read_scalar();
         break;
     }
-    case 't':
-    {
-        if (expect("true", text)) {
-            text    = text.slice(4u, text_len - 1);
-            result  = nodes->add(proot, pleft, DOM{ true });
+    event_ = JsonEvent::value;
+    state_ = $json_next;
+}
+
+/* the bracket at pos_ ends the container */
+NMS_API void JsonReader::_close() {
+    const auto top = stack_[stack_.count() - 1];
+    stack_.resize(stack_.count() - 1);
+    ++pos_;
+    event_ = top == '{' ? JsonEvent::object_end : JsonEvent::array_end;
+    type_  = top == '{' ? Type::object : Type::array;
+    state_ = $json_next;
+}
+
+NMS_API JsonEvent JsonReader::next() {
+    while (true) {
+        const auto more = _skip_blanks(false);
+        const auto c    = more ? data_[pos_ - base_] : u8(0);
+        const auto top  = stack_.count() == 0 ? u8(0) : stack_[stack_.count() - 1];
+        tok_ = pos_;
+
+        switch (state_) {
+        case $json_done:
+            return event_;
+
+        case $json_next:
+            if (top == 0) {
+                if (more) {
+                    NMS_THROW(EJsonParse{ pos_, "expect the end" });
+                }
+                state_ = $json_done;
+                event_ = JsonEvent::eof;
+                type_  = Type::null;
+                return event_;
+            }
+            if (!more) {
+                NMS_THROW(EJsonParse{ pos_, "unexpected end" });
+            }
+            if (c == ',') {
+                ++pos_;
+                state_ = top == '{' ? $json_key : $json_value;
+                continue;
+            }
+            if (c != (top == '{' ? '}' : ']')) {
+                NMS_THROW(EJsonParse{ pos_, top == '{' ? "expect ',' or '}'" : "expect ',' or ']'" });
+            }
+            _close();
+            return event_;
+
+        case $json_first_key:
+            if (c == '}') {
+                _close();
+                return event_;
+            }
+            // fallthrough
+        case $json_key:
+            if (c != '"') {
+                NMS_THROW(EJsonParse{ pos_, "expect a key" });
+            }
+            _read_string();
+            if (!_skip_blanks(true) || data_[pos_ - base_] != ':') {
+                NMS_THROW(EJsonParse{ pos_, "expect ':'" });
+            }
+            ++pos_;
+            event_ = JsonEvent::key;
+            type_  = Type::key;
+            state_ = $json_value;
+            return event_;
+
+        case $json_first_value:
+            if (c == ']') {
+                _close();
+                return event_;
+            }
+            // fallthrough
+        default:
+            if (!more) {
+                NMS_THROW(EJsonParse{ pos_, "expect a value" });
+            }
+            _read_value();
+            return event_;
         }
-        break;
     }
-    case 'f':
-    {
-        if (expect("false", text)) {
-            text    = text.slice(5u, text_len - 1);
-            result  = nodes->add(proot, pleft, DOM{ false });
+}
+
+NMS_API void JsonReader::skip() {
+    if (event_ == JsonEvent::key) {
+        next();
+    }
+    if (event_ != JsonEvent::object_begin && event_ != JsonEvent::array_begin) {
+        return;
+    }
+
+    // pair the brackets up to the end of the container
+    const auto depth = stack_.count();
+    while (true) {
+        tok_ = pos_;
+        const auto avail = fill(64);
+        if (avail == 0) {
+            NMS_THROW(EJsonParse{ pos_, "unexpected end" });
+        }
+        const auto s = data_ + (pos_ - base_);
+
+        u64 k = 0;
+        while (k < avail && (gJsonTable.cls[s[k]] & ($json_quote | $json_op)) == 0) {
+            ++k;
+        }
+        pos_ += k;
+        if (k == avail) {
+            continue;
+        }
+
+        const auto c = s[k];
+        if (c == '"') {
+            tok_ = pos_;
+            _read_string();
+        }
+        else if (c == '{' || c == '[') {
+            stack_.append(c);
+            ++pos_;
+        }
+        else if (c == '}' || c == ']') {
+            if (c != (stack_[stack_.count() - 1] == '{' ? '}' : ']')) {
+                NMS_THROW(EJsonParse{ pos_, "unpaired bracket" });
+            }
+            tok_ = pos_;
+            if (stack_.count() == depth) {
+                _close();
+                return;
+            }
+            stack_.resize(stack_.count() - 1);
+            ++pos_;
+        }
+        else {
+            ++pos_;
         }
-        break;
     }
+}
 
-    case '[':
-    {
-        result = parseArray(text, nodes, proot, pleft);
-        break;
+#pragma endregion
+
+#pragma region write:json
+static const u32 gJsonIndent = 4;
+
+/* the quoted string, " \ and the control characters escaped */
+static void _json_escape(String<>& buf, const StrView& str) {
+    static const char hex[] = "0123456789abcdef";
+
+    buf += '"';
+    const auto s = str.data();
+    const auto n = str.count();
+    u32 run = 0;
+    for (u32 i = 0; i < n; ++i) {
+        const auto c = u8(s[i]);
+        if ((gJsonTable.cls[c] & ($json_quote | $json_bslash | $json_ctrl)) == 0) {
+            continue;
+        }
+        buf += StrView{ s + run, i - run };
+        run = i + 1;
+        switch (c) {
+        case '"':   buf += "\\\"";  break;
+        case '\\':  buf += "\\\\";  break;
+        case '\b':  buf += "\\b";   break;
+        case '\f':  buf += "\\f";   break;
+        case '\n':  buf += "\\n";   break;
+        case '\r':  buf += "\\r";   break;
+        case '\t':  buf += "\\t";   break;
+        default:
+            buf += "\\u00";
+            buf += hex[c >> 4];
+            buf += hex[c & 15];
+            break;
+        }
     }
+    buf += StrView{ s + run, n - run };
+    buf += '"';
+}
 
-    case '{':
-    {
-        result = parseObject(text, nodes, proot, pleft);
-        break;
+NMS_API JsonWriter::JsonWriter(String<>& buf, bool pretty)
+    : out_(&buf)
+    , pretty_(pretty)
+{}
+
+NMS_API JsonWriter::JsonWriter(io::File& file, bool pretty)
+    : out_(&buf_)
+    , file_(&file)
+    , pretty_(pretty)
+{
+    buf_.reserve($block_size * 2);
+}
+
+NMS_API void JsonWriter::flush() {
+    if (file_ != nullptr && buf_.count() != 0) {
+        file_->write(buf_.data(), buf_.count());
+        buf_.clear();
     }
+}
 
-    case '"':
-    {
-        result = parseStr(text, nodes, proot, pleft);
-        break;
+NMS_API void JsonWriter::_value() {
+    if (keyed_) {
+        keyed_ = false;
+        return;
+    }
+    if (file_ != nullptr && buf_.count() >= $block_size) {
+        flush();
     }
 
-    case '+':
-    case '-':
-    case '0':
-    case '1':
-    case '2':
-    case '3':
-    case '4':
-    case '5':
-    case '6':
-    case '7':
-    case '8':
-    case '9':
-    {
-        result = parseNum(text, nodes, proot, pleft);
-        break;
+    const auto depth = count_.count();
+    if (depth == 0) {
+        return;
+    }
+    auto& cnt = count_[depth - 1];
+    if (cnt != 0) {
+        *out_ += ',';
+    }
+    cnt = 1;
+    if (pretty_) {
+        *out_ += '\n';
+        out_->appends(depth * gJsonIndent, ' ');
     }
+}
 
-    default:
-        break;
+NMS_API void JsonWriter::_end(char c) {
+    const auto depth = count_.count();
+    const auto cnt   = count_[depth - 1];
+    count_.resize(depth - 1);
+    if (pretty_ && cnt != 0) {
+        *out_ += '\n';
+        out_->appends((depth - 1) * gJsonIndent, ' ');
     }
+    *out_ += c;
+}
 
-    return result;
+NMS_API void JsonWriter::object_begin() {
+    _value();
+    *out_ += '{';
+    count_.append(u8(0));
 }
 
-// wraper
-NMS_API void XDOM::_parse_json(const StrView& text) {
-    auto str = text;
-    parseAny(str, this, -1, -1);
+NMS_API void JsonWriter::object_end() {
+    _end('}');
+}
+
+NMS_API void JsonWriter::array_begin() {
+    _value();
+    *out_ += '[';
+    count_.append(u8(0));
+}
+
+NMS_API void JsonWriter::array_end() {
+    _end(']');
+}
+
+NMS_API void JsonWriter::key(const StrView& name) {
+    _value();
+    _json_escape(*out_, name);
+    *out_ += pretty_ ? StrView{ ": " } : StrView{ ":" };
+    keyed_ = true;
 }
 
+NMS_API void JsonWriter::null() {
+    _value();
+    *out_ += "null";
+}
+
+NMS_API void JsonWriter::put(f32 x) {
+    if (x - x != 0) {
+        null();
+        return;
+    }
+    _value();
+    _format(*out_, {}, x);
+}
+
+NMS_API void JsonWriter::put(f64 x) {
+    if (x - x != 0) {
+        null();
+        return;
+    }
+    _value();
+    _format(*out_, {}, x);
+}
+
+NMS_API void JsonWriter::put(bool x) {
+    _value();
+    *out_ += x ? StrView{ "true" } : StrView{ "false" };
+}
+
+NMS_API void JsonWriter::put(StrView x) {
+    _value();
+    _json_escape(*out_, x);
+}
+
+NMS_API void JsonWriter::put(DateTime x) {
+    _value();
+    *out_ += '"';
+    x.format(*out_, {});
+    *out_ += '"';
+}
 #pragma endregion
 
 #pragma region unittest
@@ -364,6 +1231,587 @@ nms_test(deserialization) {
     io::log::debug("obj = {}", val);
 }
 
+nms_test(json_map) {
+    HashMap<String<>, u32> map;
+    map.set("x", 1u);
+    map.set("y", 2u);
+    map.set("z", 3u);
+
+    Tree<> tree;
+    tree << map;
+
+    String<> text;
+    sformat(text, "{:json}", tree);
+    io::log::info("json = {}", text);
+
+    HashMap<String<>, u32> res;
+    Tree<>(text, $json) >> res;
+    test::assert_eq(res.count(), 3u);
+    test::assert_eq(*res.find("x"), 1u);
+    test::assert_eq(*res.find("z"), 3u);
+}
+
+nms_test(json_arena) {
+    // [ {"id": 0, "name": "item0", "tags": [0, 1, 2]}, ... ]
+    String<> text;
+    text += "[";
+    for (u32 i = 0; i < 1000; ++i) {
+        sformat(text, "{}{{\"id\": {}, \"name\": \"item{}\", \"tags\": [{}, {}, {}]}}", i == 0 ? "" : ",", i, i, i, i + 1, i + 2);
+    }
+    text += "]";
+
+    static const u32 loops = 20;
+
+    auto run = [&] {
+        Tree<> tree(text, $json);
+        String<> out;
+        sformat(out, "{:json}", tree);
+        return out.count();
+    };
+
+    Arena arena;
+    auto run_arena = [&] {
+        u64 size = 0;
+        {
+            ArenaScope scope(arena);
+            size = run();
+        }
+        arena.reset();      // O(1), the block is kept for the next loop
+        return size;
+    };
+
+    // heap allocations of one loop (arena blocks included), counted by memstat
+    const auto was_on = memstat_enabled();
+    memstat_enable(true);
+    const auto m0 = memstat().allocs;
+    const u64  heap_size = run();
+    const auto m1 = memstat().allocs;
+    run_arena();            // the first loop allocates the block
+    const auto m2 = memstat().allocs;
+    const auto arena_size = run_arena();
+    const auto m3 = memstat().allocs;
+    memstat_enable(was_on);
+
+    test::assert_eq(heap_size, arena_size);
+    test::assert_true(m3 - m2 < m1 - m0);
+
+    // the same parse+format, timed without the counters: the best loop of each
+    f64 t_heap  = 1e9;
+    f64 t_arena = 1e9;
+    for (u32 i = 0; i < loops; ++i) {
+        const auto t0 = nms::clock();
+        run();
+        const auto t1 = nms::clock();
+        run_arena();
+        const auto t2 = nms::clock();
+        t_heap  = nms::min(t_heap,  t1 - t0);
+        t_arena = nms::min(t_arena, t2 - t1);
+    }
+
+    io::log::info("nms.serialization.json: parse+format, best of {}: heap={.3}ms, {} heap allocations; arena={.3}ms, {} heap allocations (first loop: {})",
+        loops, t_heap*1e3, m1 - m0, t_arena*1e3, m3 - m2, m2 - m1);
+}
+
+nms_test(json_parse) {
+    const char text[] = "{\"k\\\"ey\": [1, -2.5e3, true, false, null, {}, []],\n"
+                        " \"s\": \"tab\\t \\u00e9 \xc3\xa9 \xe4\xb8\xad \xf0\x9f\x98\x80\", \"o\": {\"x\": {\"y\": 3}}}";
+    auto tree = Tree<>(text, $json);
+
+    test::assert_eq(tree.count(), 3u);
+    auto arr = tree[R"(k\"ey)"];
+    test::assert_eq(arr.count(), 7u);
+    test::assert_eq(i32(arr[0]), 1);
+    test::assert_eq(f64(arr[1]), -2500.0);
+    test::assert_eq(bool(arr[2]), true);
+    test::assert_eq(bool(arr[3]), false);
+    test::assert_eq(arr[4].type(), Type::null);
+    test::assert_eq(arr[5].type(), Type::object);
+    test::assert_eq(arr[6].count(), 0u);
+    test::assert_eq(StrView(tree["s"]), StrView(R"(tab\t \u00e9 )" "\xc3\xa9 \xe4\xb8\xad \xf0\x9f\x98\x80"));
+    test::assert_eq(i32(tree["o"]["x"]["y"]), 3);
+
+    // the blocks: a string across 64 bytes, a backslash at the end of a block
+    String<> long_text;
+    long_text += "[\"";
+    long_text.appends(61, 'a');
+    long_text += "\\\\\", \"";
+    long_text.appends(100, 'b');
+    long_text += "\\\"\"]";
+    auto tree2 = Tree<>(long_text, $json);
+    test::assert_eq(tree2.count(), 2u);
+    test::assert_eq(StrView(tree2[0]).count(), 63u);
+    test::assert_eq(StrView(tree2[1]).count(), 102u);
+}
+
+/* a bad text, the offset of the error */
+static const struct
+{
+    const char* text;
+    u64         offset;
+} gJsonErrors[] = {
+    { "[1, 2",              5 },
+    { "{\"a\" 1}",          5 },
+    { "[1 2]",              3 },
+    { "[1,]",               3 },
+    { "{\"a\":1,}",         7 },
+    { "\"abc",              0 },
+    { "[\"a\x01\"]",        3 },
+    { "[\"\xc3\x28\"]",     2 },
+    { "[\"\xed\xa0\x80\"]", 2 },
+    { "[tru]",              1 },
+    { "[\"\\q\"]",          2 },
+    { "[1]x",               3 },
+    { "[01]",               1 },
+    { "[1.]",               1 },
+    { "",                   0 },
+};
+
+nms_test(json_error) {
+    // the last block is padded: the same errors after 64 blanks
+    String<> text;
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 };
+    const auto cpu = simd_level();
+
+    for (auto level : levels) {
+        simd_level(level);
+        if (simd_level() != level) {
+            continue;
+        }
+        for (auto& c : gJsonErrors) {
+            for (u32 pad = 0; pad <= 64; pad += 64) {
+                text.clear();
+                text.appends(pad, ' ');
+                text += StrView{ c.text, u32(strlen(c.text)) };
+                try {
+                    Tree<> tree(text, $json);
+                    test::assert_true(false);
+                }
+                catch (const EJsonParse& e) {
+                    test::assert_eq(e.offset(), c.offset + pad);
+                }
+            }
+        }
+    }
+    simd_level(cpu);
+}
+
+/* parse a 4MB array of records */
+nms_test(json_parse_perf) {
+    String<> text;
+    text += "[";
+    for (u32 i = 0; i < 16384; ++i) {
+        sformat(text, "{}\n  {{\"id\": {}, \"name\": \"item {}\", \"price\": {.2}, \"tags\": [\"red\", \"large\", \"\\u00e9t\xc3\xa9\"], "
+            "\"active\": {}, \"owner\": {{\"first\": \"John\", \"last\": \"Smith\", \"email\": \"john.smith{}@example.com\"}}, "
+            "\"text\": \"a \\\"quoted\\\" word in a short description\"}}", i == 0 ? "" : ",", i, i, i * 0.37, i % 2 == 0, i);
+    }
+    text += "\n]";
+
+    static const u32 loops = 20;
+
+    // the best of the loops: the machine is shared. stage 1 (the index) is timed alone too
+    auto parse_time = 1e9;
+    auto index_time = 1e9;
+    u64  nodes = 0;
+    for (u32 i = 0; i < loops; ++i) {
+        const auto t0 = nms::clock();
+        {
+            Tree<> tree(text, $json);
+            nodes += tree.count();
+        }
+        const auto t1 = nms::clock();
+        {
+            JsonIndex index(reinterpret_cast<const u8*>(text.data()), text.count());
+            List<u32> idx;
+            while (!index.done()) {
+                idx.resize(0);
+                index.next(idx);
+            }
+        }
+        const auto t2 = nms::clock();
+        parse_time = nms::min(parse_time, t1 - t0);
+        index_time = nms::min(index_time, t2 - t1);
+    }
+    test::assert_eq(nodes, u64(16384) * loops);
+
+    const auto gb = f64(text.count()) / (1024 * 1024 * 1024);
+    io::log::info("nms.serialization.json: parse {.1}MB, best of {}: {.3}GB/s, stage 1 alone {.3}GB/s (target > 1GB/s)",
+        f64(text.count()) / (1024 * 1024), loops, gb / parse_time, gb / index_time);
+}
+
+/* the events of a reader as text */
+static void _json_events(JsonReader& reader, String<>& out) {
+    while (true) {
+        switch (reader.next()) {
+        case JsonEvent::eof:            return;
+        case JsonEvent::object_begin:   out += "{"; break;
+        case JsonEvent::object_end:     out += "}"; break;
+        case JsonEvent::array_begin:    out += "["; break;
+        case JsonEvent::array_end:      out += "]"; break;
+        case JsonEvent::key:
+            out += reader.str();
+            out += ":";
+            break;
+        case JsonEvent::value:
+            if (reader.type() == Type::boolean) {
+                out += reader.boolean() ? "T" : "F";
+            }
+            else if (reader.type() == Type::null) {
+                out += "N";
+            }
+            else {
+                out += reader.str();
+            }
+            out += ",";
+            break;
+        }
+    }
+}
+
+struct TestRecord
+    : public ISerializable
+{
+    NMS_PROPERTY_BEGIN;
+    typedef u32             NMS_PROPERTY(id);
+    typedef String<32>      NMS_PROPERTY(name);
+    typedef f64             NMS_PROPERTY(price);
+    typedef List<String<> > NMS_PROPERTY(tags);
+    typedef bool            NMS_PROPERTY(active);
+    typedef Type            NMS_PROPERTY(kind);
+    NMS_PROPERTY_END;
+};
+
+nms_test(json_reader) {
+    const char text[] = "{\"k\\\"ey\": [1, -2.5e3, true, false, null, {}, []],\n"
+                        " \"s\": \"tab\\t \\u00e9 \xc3\xa9 \xf0\x9f\x98\x80\", \"o\": {\"x\": {\"y\": 3}}}";
+    const StrView expect = R"({k\"ey:[1,-2.5e3,T,F,N,{}[]]s:tab\t \u00e9 )" "\xc3\xa9 \xf0\x9f\x98\x80" R"(,o:{x:{y:3,}}})";
+
+    String<> events;
+    JsonReader reader(text);
+    _json_events(reader, events);
+    test::assert_eq(StrView(events), expect);
+
+    // from a file: the tokens across the blocks
+    {
+        io::File file("nms.serialization.json.json", io::File::Write);
+        file.write(text, sizeof(text) - 1);
+    }
+    for (u32 block = 1; block <= 64; block *= 4) {
+        events.clear();
+        JsonReader file_reader(io::File("nms.serialization.json.json", io::File::Read), block);
+        _json_events(file_reader, events);
+        test::assert_eq(StrView(events), expect);
+    }
+    io::remove("nms.serialization.json.json");
+
+    // skip
+    JsonReader skip_reader(text);
+    skip_reader.next();
+    skip_reader.next();
+    skip_reader.skip();
+    test::assert_eq(skip_reader.event(), JsonEvent::array_end);
+    test::assert_eq(skip_reader.next(), JsonEvent::key);
+    test::assert_eq(skip_reader.str(), StrView("s"));
+    skip_reader.skip();
+    test::assert_eq(skip_reader.next(), JsonEvent::key);
+    test::assert_eq(skip_reader.next(), JsonEvent::object_begin);
+    skip_reader.skip();
+    test::assert_eq(skip_reader.event(), JsonEvent::object_end);
+    test::assert_eq(skip_reader.depth(), 1u);
+    test::assert_eq(skip_reader.next(), JsonEvent::object_end);
+    test::assert_eq(skip_reader.next(), JsonEvent::eof);
+}
+
+nms_test(json_reader_get) {
+    // struct: the unknown keys are skipped
+    const char records[] = R"([
+        {"id": 1, "name": "a", "price": 1.5, "tags": ["x", "y"], "active": true,
+         "owner": {"name": "b", "list": [1, [2, {"3": "]"}]]}, "kind": "string"},
+        {"id": 2, "name": "c", "price": -2, "tags": [], "active": false, "kind": 6}
+    ])";
+    List<TestRecord> list;
+    JsonReader(records) >> list;
+    test::assert_eq(list.count(), 2u);
+    test::assert_eq(list[0].id, 1u);
+    test::assert_true(StrView(list[0].name) == StrView("a"));
+    test::assert_eq(list[0].price, 1.5);
+    test::assert_eq(list[0].tags.count(), 2u);
+    test::assert_true(StrView(list[0].tags[1]) == StrView("y"));
+    test::assert_eq(list[0].active, true);
+    test::assert_eq(list[0].kind, Type::string);
+    test::assert_eq(list[1].price, -2.0);
+    test::assert_eq(list[1].tags.count(), 0u);
+    test::assert_eq(list[1].kind, Type::i32);
+
+    // struct: the same as from a tree
+    const char object[] = R"({"a": "hello", "b": [1.1, +2.2, -3.3, 4.4e2], "c": "2017-09-03T08:30:12"})";
+    TestObject x;
+    TestObject y;
+    JsonReader(object) >> x;
+    Tree<>(object, $json) >> y;
+    test::assert_true(StrView(x.a) == StrView(y.a));
+    test::assert_eq(x.b[3], y.b[3]);
+    test::assert_eq(x.c.stamp(), y.c.stamp());
+
+    // array: the innermost is dim 0
+    math::Array<f32, 2> arr;
+    JsonReader("[[1, 2, 3], [4, 5, 6]]") >> arr;
+    test::assert_eq(arr.size(), { 3u, 2u });
+    test::assert_eq(arr(2, 0), 3.0f);
+    test::assert_eq(arr(0, 1), 4.0f);
+    try {
+        JsonReader("[[1, 2, 3], [4, 5]]") >> arr;
+        test::assert_true(false);
+    }
+    catch (const EUnexpectElementCount&) {
+    }
+
+    // map
+    HashMap<String<>, i32> map;
+    JsonReader(R"({"x": 1, "y": -2})") >> map;
+    test::assert_eq(map.count(), 2u);
+    test::assert_eq(*map.find("y"), -2);
+}
+
+nms_test(json_reader_error) {
+    String<> text;
+    for (auto& c : gJsonErrors) {
+        for (u32 pad = 0; pad <= 64; pad += 64) {
+            text.clear();
+            text.appends(pad, ' ');
+            text += StrView{ c.text, u32(strlen(c.text)) };
+            {
+                io::File file("nms.serialization.json.json", io::File::Write);
+                file.write(text.data(), text.count());
+            }
+
+            for (u32 block = 0; block <= 1; ++block) {
+                try {
+                    if (block == 0) {
+                        JsonReader reader(text);
+                        while (reader.next() != JsonEvent::eof) {}
+                    }
+                    else {
+                        JsonReader reader(io::File("nms.serialization.json.json", io::File::Read), block);
+                        while (reader.next() != JsonEvent::eof) {}
+                    }
+                    test::assert_true(false);
+                }
+                catch (const EJsonParse& e) {
+                    test::assert_eq(e.offset(), c.offset + pad);
+                }
+            }
+        }
+    }
+    io::remove("nms.serialization.json.json");
+}
+
+/* read 8MB of records from a file: by a tree, by the events, into structs, skipped */
+nms_test(json_reader_perf) {
+    static const u32 count = 32768;
+    {
+        io::TxtFile file("nms.serialization.json_perf.json", io::File::Write);
+        String<> text;
+        text += "[";
+        for (u32 i = 0; i < count; ++i) {
+            sformat(text, "{}\n  {{\"id\": {}, \"name\": \"item {}\", \"price\": {.2}, \"tags\": [\"red\", \"large\", \"\\u00e9t\xc3\xa9\"], "
+                "\"active\": {}, \"owner\": {{\"first\": \"John\", \"last\": \"Smith\", \"email\": \"john.smith{}@example.com\"}}, "
+                "\"text\": \"a \\\"quoted\\\" word in a short description\", \"kind\": \"object\"}}", i == 0 ? "" : ",", i, i, i * 0.37, i % 2 == 0, i);
+            if (text.count() > 1024 * 1024) {
+                file.write(text);
+                text.clear();
+            }
+        }
+        text += "\n]";
+        file.write(text);
+    }
+    const io::Path path("nms.serialization.json_perf.json");
+    const auto mb   = f64(io::fsize(path)) / (1024 * 1024);
+
+    const auto t0 = nms::clock();
+    List<TestRecord> tree_list;
+    {
+        io::TxtFile file(path, io::File::Read);
+        String<> text;
+        file.readall(text);
+        Tree<>(text, $json) >> tree_list;
+    }
+
+    const auto t1 = nms::clock();
+    u64 events = 0;
+    {
+        JsonReader reader(io::File(path, io::File::Read));
+        while (reader.next() != JsonEvent::eof) {
+            ++events;
+        }
+    }
+
+    const auto t2 = nms::clock();
+    List<TestRecord> list;
+    JsonReader(io::File(path, io::File::Read)) >> list;
+
+    const auto t3 = nms::clock();
+    u32 skipped = 0;
+    {
+        JsonReader reader(io::File(path, io::File::Read));
+        reader.next();
+        while (reader.next() != JsonEvent::array_end) {
+            reader.skip();
+            ++skipped;
+        }
+    }
+    const auto t4 = nms::clock();
+    io::remove(path);
+
+    test::assert_eq(list.count(), count);
+    test::assert_eq(skipped, count);
+    test::assert_eq(list[count - 1].id, tree_list[count - 1].id);
+    test::assert_eq(list[count - 1].price, tree_list[count - 1].price);
+
+    io::log::info("nms.serialization.json: read {.1}MB: tree {.1}MB/s, events {.1}MB/s ({} events), structs {.1}MB/s, skip {.1}MB/s",
+        mb, mb / (t1 - t0), mb / (t2 - t1), events, mb / (t3 - t2), mb / (t4 - t3));
+}
+
+struct TestStatus
+    : public ISerializable
+{
+    NMS_PROPERTY_BEGIN;
+    typedef u64             NMS_PROPERTY(seq);
+    typedef String<32>      NMS_PROPERTY(host);
+    typedef Type            NMS_PROPERTY(mode);
+    typedef DateTime        NMS_PROPERTY(time);
+    typedef f64             NMS_PROPERTY(load);
+    typedef f32x4           NMS_PROPERTY(quat);
+    typedef List<f32>       NMS_PROPERTY(temps);
+    typedef List<String<> > NMS_PROPERTY(flags);
+    typedef bool            NMS_PROPERTY(ok);
+    NMS_PROPERTY_END;
+};
+
+nms_test(json_writer) {
+    TestStatus st;
+    st.seq  = 3;
+    st.host = "node-1";
+    st.mode = Type::object;
+    st.time = DateTime(2017, 9, 3, 8, 30, 12);
+    st.load = 0.25;
+    st.quat = { 1.0f, 0.0f, 0.0f, 0.5f };
+    st.temps.append(36.5f);
+    st.temps.append(-1.0f);
+    st.flags.append(String<>("a\"b"));
+    st.flags.append(String<>("tab\t"));
+    st.ok   = true;
+
+    String<> text;
+    JsonWriter(text) << st;
+    test::assert_eq(StrView(text), StrView(R"({"seq":3,"host":"node-1","mode":"object","time":"2017-09-03T08:30:12","load":0.25,)"
+        R"("quat":[1.0,0.0,0.0,0.5],"temps":[36.5,-1.0],"flags":["a\"b","tab\t"],"ok":true})"));
+
+    TestStatus res;
+    Tree<>(text, $json) >> res;
+    test::assert_eq(res.seq, st.seq);
+    test::assert_eq(res.mode, st.mode);
+    test::assert_eq(res.quat[3], st.quat[3]);
+    test::assert_eq(res.temps[1], st.temps[1]);
+
+    // pretty: as a tree is formatted
+    TestObject obj;
+    obj.a = "hello";
+    obj.b = { 1.1f, +2.2f, -3.3f, 4.4e2f };
+    obj.c = DateTime(2017, 9, 3, 8, 30, 12);
+    Tree<> tree;
+    tree << obj;
+    String<> tree_text;
+    sformat(tree_text, "{:json}", tree);
+    text.clear();
+    JsonWriter(text, true) << obj;
+    test::assert_eq(StrView(text), StrView(tree_text));
+
+    // view, empty containers, nan
+    math::Array<i32, 2> x({ 2, 2 });
+    x(0, 0) = 0;  x(1, 0) = 1;
+    x(0, 1) = 10; x(1, 1) = 11;
+    text.clear();
+    {
+        JsonWriter writer(text);
+        writer.array_begin();
+        writer << x << List<i32>{} << f64(0.0 / 0.0);
+        writer.object_begin();
+        writer.object_end();
+        writer.array_end();
+    }
+    test::assert_eq(StrView(text), StrView("[[[0,1],[10,11]],[],null,{}]"));
+
+    // to a file, by blocks
+    List<TestStatus> list;
+    for (u32 i = 0; i < 2000; ++i) {
+        st.seq = i;
+        list.append(st);
+    }
+    {
+        io::File file("nms.serialization.json.json", io::File::Write);
+        JsonWriter(file, true) << list;
+    }
+    List<TestStatus> list2;
+    JsonReader(io::File("nms.serialization.json.json", io::File::Read)) >> list2;
+    io::remove("nms.serialization.json.json");
+    test::assert_eq(list2.count(), 2000u);
+    test::assert_eq(list2[1999].seq, u64(1999));
+    test::assert_true(StrView(list2[1999].host) == StrView("node-1"));
+}
+
+/* a status struct: by a tree, and by the writer */
+nms_test(json_writer_perf) {
+    TestStatus st;
+    st.host = "node-1";
+    st.mode = Type::object;
+    st.time = DateTime(2017, 9, 3, 8, 30, 12);
+    st.quat = { 0.1f, 0.2f, 0.3f, 0.9f };
+    for (u32 i = 0; i < 16; ++i) {
+        st.temps.append(36.0f + i * 0.37f);
+    }
+    st.flags.append(String<>("ready"));
+    st.flags.append(String<>("charging"));
+    st.ok = true;
+
+    static const u32 loops = 10000;
+    u64 tree_size  = 0;
+    u64 write_size = 0;
+    u64 pretty_size = 0;
+
+    String<> text;
+    const auto t0 = nms::clock();
+    for (u32 i = 0; i < loops; ++i) {
+        st.seq  = i;
+        st.load = i * 0.01;
+        Tree<> tree;
+        tree << st;
+        text.clear();
+        tree.format(text, $json);
+        tree_size += text.count();
+    }
+    const auto t1 = nms::clock();
+    for (u32 i = 0; i < loops; ++i) {
+        st.seq  = i;
+        st.load = i * 0.01;
+        text.clear();
+        JsonWriter(text, true) << st;
+        pretty_size += text.count();
+    }
+    const auto t2 = nms::clock();
+    for (u32 i = 0; i < loops; ++i) {
+        st.seq  = i;
+        st.load = i * 0.01;
+        text.clear();
+        JsonWriter(text) << st;
+        write_size += text.count();
+    }
+    const auto t3 = nms::clock();
+
+    test::assert_eq(tree_size, pretty_size);
+    io::log::info("nms.serialization.json: status x {}: tree+format {.3}us, writer pretty {.3}us, compact {.3}us ({} bytes)",
+        loops, (t1 - t0) * 1e6 / loops, (t2 - t1) * 1e6 / loops, (t3 - t2) * 1e6 / loops, write_size / loops);
+}
+
 #pragma endregion
 
 }
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <nms/serialization/base.h>
+#include <nms/util/hashmap.h>
+#include <nms/io/file.h>
+
+namespace nms::math
+{
+template<class T, u32 N>
+class Array;
+}
+
+namespace nms::serialization
+{
+
+NMS_ENUM_EX(enum class JsonEvent : u8, JsonEvent,
+    eof,
+    object_begin,
+    object_end,
+    array_begin,
+    array_end,
+    key,
+    value
+    );
+
+/*!
+ * a pull json reader: the text is read from a file in fixed size blocks,
+ * each call to next() returns the next event, no DOM is built.
+ * a key, a string or a number is a view of the block, valid until next() is called.
+ * a string is the bytes between its quotes, escapes are kept as they are (as in Tree).
+ * the text is checked as Tree does, but the subtrees passed by skip().
+ * throws EJsonParse on a bad text.
+ */
+class JsonReader
+{
+public:
+    /* bytes read per block, a token longer than a block grows it */
+    static constexpr u32 $block_size = 1024 * 1024;
+
+    /* read an open file, from its stream position */
+    NMS_API explicit JsonReader(io::File&& file, u32 block_size = $block_size);
+
+    /* read a text in memory, the views point to the text */
+    NMS_API explicit JsonReader(const StrView& text);
+
+    JsonReader(const JsonReader&)            = delete;
+    JsonReader& operator=(const JsonReader&) = delete;
+
+#pragma region event
+    /* the next event */
+    NMS_API JsonEvent next();
+
+    /*!
+     * skip the current value: the rest of the object or the array after a begin event,
+     * the value of the key after a key event. only the strings and the brackets of the
+     * skipped text are read and checked, the rest is passed over.
+     */
+    NMS_API void skip();
+
+    /* the current event */
+    JsonEvent event() const {
+        return event_;
+    }
+
+    /*!
+     * the type of the current event:
+     * key, object or array (at a begin event), or a value: string, number, boolean or null.
+     */
+    Type type() const {
+        return type_;
+    }
+
+    /* the containers open */
+    u32 depth() const {
+        return stack_.count();
+    }
+
+    /* the byte offset of the current token in the text */
+    u64 offset() const {
+        return tok_;
+    }
+
+    /* key, string or number: the text of the token */
+    StrView str() const {
+        if (type_ != Type::key && type_ != Type::string && type_ != Type::number) {
+            NMS_THROW(EUnexpectType(Type::string, type_));
+        }
+        return { reinterpret_cast<const char*>(data_ + (str_ - base_)), str_len_ };
+    }
+
+    /* boolean: the value */
+    bool boolean() const {
+        if (type_ != Type::boolean) {
+            NMS_THROW(EUnexpectType(Type::boolean, type_));
+        }
+        return bool_;
+    }
+#pragma endregion
+
+#pragma region get
+    /* read the next value */
+    template<class T>
+    JsonReader& operator>>(T& x) {
+        next();
+#ifndef NMS_CC_INTELLISENSE
+        get(x);
+#endif
+        return *this;
+    }
+
+    /* read the value at the current event into x, a null keeps x */
+    void get(i8&  x) { get_num(x); }
+    void get(u8&  x) { get_num(x); }
+    void get(i16& x) { get_num(x); }
+    void get(u16& x) { get_num(x); }
+    void get(i32& x) { get_num(x); }
+    void get(u32& x) { get_num(x); }
+    void get(i64& x) { get_num(x); }
+    void get(u64& x) { get_num(x); }
+    void get(f32& x) { get_num(x); }
+    void get(f64& x) { get_num(x); }
+
+    void get(bool& x) {
+        if (type_ != Type::null) {
+            x = boolean();
+        }
+    }
+
+    void get(DateTime& x) {
+        if (type_ != Type::null) {
+            x = DateTime::parse(str());
+        }
+    }
+
+#pragma region string
+    template<u32 Icapicity>
+    void get(List<char, Icapicity>& x) {
+        if (type_ != Type::null) {
+            expect(Type::string);
+            x = str();
+        }
+    }
+#pragma endregion
+
+#pragma region vec
+    template<class T, u32 N>
+    void get(Vec<T, N>& x) {
+        expect(Type::array);
+        u32 n = 0;
+        while (next() != JsonEvent::array_end) {
+            if (n == N) {
+                NMS_THROW(EUnexpectElementCount{ N, n + 1 });
+            }
+            get(x[n++]);
+        }
+        if (n != N) {
+            NMS_THROW(EUnexpectElementCount{ N, n });
+        }
+    }
+#pragma endregion
+
+#pragma region list
+    template<class T, u32 S>
+    void get(List<T, S>& x) {
+        expect(Type::array);
+        while (next() != JsonEvent::array_end) {
+            T val;
+            get(val);
+            x.append(move(val));
+        }
+    }
+#pragma endregion
+
+#pragma region array
+    /* nested arrays: the innermost one is dim 0, as x(:, row) of a csv */
+    template<class T, u32 N>
+    void get(math::Array<T, N>& x) {
+        List<T> vals;
+        u32     dims[N] = {};
+        bool    seen[N] = {};
+        get_dims(vals, dims, seen, N - 1);
+        x.resize(dims);
+        mcpy(x.data(), vals.data(), vals.count());
+    }
+#pragma endregion
+
+#pragma region map
+    template<class T, u32 S>
+    void get(HashMap<List<char, S>, T>& x) {
+        expect(Type::object);
+        while (next() != JsonEvent::object_end) {
+            const List<char, S> key = str();
+            next();
+            T val;
+            get(val);
+            x.set(key, move(val));
+        }
+    }
+#pragma endregion
+
+#pragma region enum
+    template<class Tenum>
+    void get(Tenum& x, $when_is<$enum, Tenum>* = nullptr) {
+        if (type_ == Type::number) {
+            i32 val = 0;
+            get(val);
+            x = Tenum(val);
+        }
+        else if (type_ == Type::string) {
+            x = Enum<Tenum>::parse(str());
+        }
+    }
+#pragma endregion
+
+#pragma region serializable
+    /* the keys are matched to the properties, the unknown ones are skipped */
+    template<class Tserializable>
+    void get(Tserializable& x, $when_is<ISerializable, Tserializable>* = nullptr) {
+        expect(Type::object);
+        while (next() != JsonEvent::object_end) {
+            if (!ISerializable::_deserialize_property(*this, x, str())) {
+                skip();
+            }
+        }
+    }
+#pragma endregion
+
+#pragma endregion
+
+protected:
+    io::File    file_;
+    String<>    buf_;
+    List<u8>    stack_;             // '{' or '[' per container open
+
+    const u8*   data_    = nullptr; // the bytes [base_, base_ + count_) of the text
+    u64         base_    = 0;
+    u64         count_   = 0;
+    u64         pos_     = 0;       // the next byte to read
+    u64         tok_     = 0;       // the current token, kept by fill()
+    u64         str_     = 0;       // the text of the token
+    u32         str_len_ = 0;
+    u32         block_   = 0;
+    bool        eof_     = true;    // no bytes after count_
+
+    JsonEvent   event_   = JsonEvent::eof;
+    Type        type_    = Type::null;
+    u8          state_   = 0;
+    bool        bool_    = false;
+
+    /* ensure the bytes [pos_, pos_ + n) are read, unless the text ends: returns the bytes available */
+    NMS_API u64  fill(u64 n);
+
+    void expect(Type type) const {
+        if (type_ != type) {
+            NMS_THROW(EUnexpectType(type, type_));
+        }
+    }
+
+    template<class T>
+    void get_num(T& x) {
+        if (type_ != Type::null) {
+            expect(Type::number);
+            nms::parse(str(), x);
+        }
+    }
+
+    template<class T>
+    void get_dims(List<T>& vals, u32* dims, bool* seen, u32 dim) {
+        expect(Type::array);
+        u32 n = 0;
+        while (next() != JsonEvent::array_end) {
+            if (dim == 0) {
+                T val = {};
+                get(val);
+                vals.append(val);
+            }
+            else {
+                get_dims(vals, dims, seen, dim - 1);
+            }
+            ++n;
+        }
+        if (!seen[dim]) {
+            seen[dim] = true;
+            dims[dim] = n;
+        }
+        else if (dims[dim] != n) {
+            NMS_THROW(EUnexpectElementCount{ dims[dim], n });
+        }
+    }
+
+private:
+    NMS_API bool _skip_blanks(bool keep);
+    NMS_API void _read_value();
+    NMS_API void _read_string();
+    NMS_API void _read_scalar();
+    NMS_API void _close();
+};
+
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <nms/serialization/base.h>
+#include <nms/util/hashmap.h>
+#include <nms/io/file.h>
+
+namespace nms::serialization
+{
+
+/*!
+ * a json writer: the values are formatted as they come, no DOM is built.
+ * the text is appended to a string, or to a block written to a file when full.
+ * compact: no blanks; pretty: a line per value, as Tree formats.
+ * the strings are escaped, a nan or an inf is written as null.
+ */
+class JsonWriter
+{
+public:
+    /* bytes formatted before a write to the file */
+    static constexpr u32 $block_size = 64 * 1024;
+
+    /* append to buf */
+    NMS_API explicit JsonWriter(String<>& buf, bool pretty = false);
+
+    /* write to an open file */
+    NMS_API explicit JsonWriter(io::File& file, bool pretty = false);
+
+    ~JsonWriter() {
+        flush();
+    }
+
+    JsonWriter(const JsonWriter&)            = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    /* write the block to the file */
+    NMS_API void flush();
+
+#pragma region event
+    NMS_API void object_begin();
+    NMS_API void object_end();
+    NMS_API void array_begin();
+    NMS_API void array_end();
+
+    /* the key of the next value */
+    NMS_API void key(const StrView& name);
+
+    NMS_API void null();
+#pragma endregion
+
+#pragma region put
+    template<class T>
+    JsonWriter& operator<<(const T& x) {
+#ifndef NMS_CC_INTELLISENSE
+        put(x);
+#endif
+        return *this;
+    }
+
+    void put(i8  x) { put_num(x); }
+    void put(u8  x) { put_num(x); }
+    void put(i16 x) { put_num(x); }
+    void put(u16 x) { put_num(x); }
+    void put(i32 x) { put_num(x); }
+    void put(u32 x) { put_num(x); }
+    void put(i64 x) { put_num(x); }
+    void put(u64 x) { put_num(x); }
+
+    NMS_API void put(f32      x);
+    NMS_API void put(f64      x);
+    NMS_API void put(bool     x);
+    NMS_API void put(StrView  x);
+    NMS_API void put(DateTime x);
+
+#pragma region string
+    template<u32 Icapicity>
+    void put(const List<char, Icapicity>& x) {
+        put(StrView(x));
+    }
+#pragma endregion
+
+#pragma region vec
+    template<class T, u32 N>
+    void put(const Vec<T, N>& x) {
+        array_begin();
+        for (u32 i = 0; i < N; ++i) {
+            put(x[i]);
+        }
+        array_end();
+    }
+#pragma endregion
+
+#pragma region list
+    template<class T, u32 S>
+    void put(const List<T, S>& x) {
+        array_begin();
+        const auto n = x.count();
+        for (u32 i = 0; i < n; ++i) {
+            put(x[i]);
+        }
+        array_end();
+    }
+#pragma endregion
+
+#pragma region view
+    template<class T>
+    void put(const View<T>& x) {
+        array_begin();
+        const auto n = x.count();
+        for (u32 i = 0; i < n; ++i) {
+            put(x[i]);
+        }
+        array_end();
+    }
+
+    /* nested arrays, the innermost one is dim 0 */
+    template<class T, u32 N>
+    void put(const View<T, N>& x) {
+        const auto size = x.size();
+        const auto step = x.step();
+        put_view(x.data(), &size[0], &step[0], N - 1);
+    }
+#pragma endregion
+
+#pragma region map
+    template<class T, u32 S>
+    void put(const HashMap<List<char, S>, T>& x) {
+        object_begin();
+        for (auto& e : x) {
+            key(StrView(e.key));
+            put(e.value);
+        }
+        object_end();
+    }
+#pragma endregion
+
+#pragma region enum
+    template<class Tenum>
+    void put(const Tenum& x, $when_is<$enum, Tenum>* = nullptr) {
+        put(mkEnum(x).name());
+    }
+#pragma endregion
+
+#pragma region serializable
+    /* the properties, in the order they are declared */
+    template<class Tserializable>
+    void put(const Tserializable& x, $when_is<ISerializable, Tserializable>* = nullptr) {
+        object_begin();
+        ISerializable::_serialize_properties(*this, x);
+        object_end();
+    }
+#pragma endregion
+
+#pragma endregion
+
+protected:
+    String<>*   out_;
+    String<>    buf_;
+    io::File*   file_   = nullptr;
+    List<u8>    count_;             // 0: the container open has no value yet
+    bool        pretty_ = false;
+    bool        keyed_  = false;    // a key is waiting for its value
+
+    /* the separator and the indent before a value */
+    NMS_API void _value();
+    NMS_API void _end(char c);
+
+    template<class T>
+    void put_num(T x) {
+        _value();
+        _format(*out_, {}, x);
+    }
+
+    template<class T>
+    void put_view(const T* data, const u32* size, const i32* step, u32 dim) {
+        array_begin();
+        for (u32 i = 0; i < size[dim]; ++i) {
+            const auto p = data + i64(i) * step[dim];
+            if (dim == 0) {
+                put(*p);
+            }
+            else {
+                put_view(p, size, step, dim - 1);
+            }
+        }
+        array_end();
+    }
+};
+
+}
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <nms/thread/atomic.h>
 #include <nms/thread/thread.h>
 #include <nms/thread/mutex.h>
+#include <nms/thread/rwlock.h>
+#include <nms/thread/hashmap.h>
+#include <nms/thread/queue.h>
+#include <nms/thread/arraylist.h>
 #include <nms/thread/condvar.h>
 #include <nms/thread/semaphore.h>
 #include <nms/thread/task.h>
+#include <nms/thread/parallel.h>
@@ -0,0 +1,169 @@
+#include <nms/test.h>
+#include <nms/thread.h>
+#include <nms/thread/arraylist.h>
+#include <nms/util/arraylist.h>
+#include <nms/util/system.h>
+
+namespace nms::thread
+{
+
+#pragma region unittest
+
+nms_test(ConcurrentArrayList) {
+    static const u32 producers = 4;
+    static const u32 n         = 20000;     // per producer
+
+    // value: producer id in the high bits, sequence in the low bits
+    // the odd producers push runs of 7 values
+    ConcurrentArrayList<u32, 1024, 256> list;
+
+    Atomic<u32> done = 0u;
+    Atomic<u32> fail = 0u;
+    List<Thread> threads;
+    for (u32 p = 0; p < producers; ++p) {
+        threads.append(Thread([&, p] {
+            for (u32 i = 0; i < n; ) {
+                if (p % 2 == 0) {
+                    list.push((p << 24) | (i + 1));
+                    ++i;
+                    continue;
+                }
+                u32 run[7];
+                const auto cnt = nms::min(7u, n - i);
+                for (u32 k = 0; k < cnt; ++k) {
+                    run[k] = (p << 24) | (i + k + 1);
+                }
+                list.pushs(run, cnt);
+                i += cnt;
+            }
+            done.fetch_add(1u);
+        }));
+    }
+
+    // reader: the published prefix never has a hole, and each producer is in order
+    threads.append(Thread([&] {
+        while (done.load() < producers) {
+            u32  last[producers] = {};
+            list.each([&](u32 val) {
+                const auto p = val >> 24;
+                const auto i = val & 0xFFFFFF;
+                if (p >= producers || i != last[p] + 1) {
+                    fail.fetch_add(1u);
+                }
+                last[p] = i;
+            });
+            yield();
+        }
+    }));
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    test::assert_eq(fail.load(), 0u);
+    test::assert_eq(list.count(), producers * n);
+
+    // each value once
+    List<u32> flags;
+    flags.resize(producers * n);
+    for (auto& f : flags) f = 0;
+    list.each([&](u32 val) {
+        ++flags[(val >> 24) * n + (val & 0xFFFFFF) - 1];
+    });
+    for (auto f : flags) {
+        test::assert_eq(f, 1u);
+    }
+
+    // save: same format as ArrayList, pages written in parallel
+    const StrView path = "nms.thread.arraylist.dat";
+    list.save(path);
+
+    List<u32> data;
+    data.resize(list.count());
+    list.getData(data.data());
+    {
+        io::File file(path, io::File::Read);
+        test::assert_eq(file.size(), sizeof(ViewInfo) + sizeof(u32) + list.count() * sizeof(u32));
+
+        ViewInfo info;
+        u32      count = 0;
+        file.read(&info, 1);
+        file.read(&count, 1);
+        test::assert_eq(count, list.count());
+
+        List<u32> read;
+        read.resize(count);
+        file.read(read.data(), count);
+        for (u32 i = 0; i < count; ++i) {
+            test::assert_eq(read[i], data[i]);
+        }
+    }
+    io::remove(path);
+}
+
+nms_test(ConcurrentArrayList_perf) {
+    static const u32 n   = 409600;   // a multiple of 8 threads x run
+    static const u32 run = 64;
+
+    // lock-free, push or pushs runs
+    auto lockfree = [](u32 threads, u32 per, u32 len) {
+        ConcurrentArrayList<u64, 1024, 4096> list;
+        Atomic<u32> start = 0u;
+        List<Thread, 8> workers;
+        for (u32 t = 0; t < threads; ++t) {
+            workers.append(Thread([&] {
+                u64 values[run];
+                while (start.load() == 0) yield();
+                for (u32 i = 0; i < per; i += len) {
+                    if (len == 1) {
+                        list.push(u64(i));
+                        continue;
+                    }
+                    for (u32 k = 0; k < len; ++k) values[k] = u64(i + k);
+                    list.pushs(values, len);
+                }
+            }));
+        }
+        const auto t0 = nms::clock();
+        start.store(1u);
+        for (auto& worker : workers) worker.join();
+        const auto dt = nms::clock() - t0;
+        test::assert_eq(list.count(), per * threads);
+        return dt;
+    };
+
+    for (u32 threads = 1; threads <= 8; threads *= 2) {
+        const auto per = n / threads;
+
+        const auto dt0 = lockfree(threads, per, 1);
+        const auto dt1 = lockfree(threads, per, run);
+
+        // ArrayList + Mutex
+        f64 dt2 = 0;
+        {
+            ArrayList<u64, 1024, 4096> list;
+            Mutex mutex;
+            Atomic<u32> start = 0u;
+            List<Thread, 8> workers;
+            for (u32 t = 0; t < threads; ++t) {
+                workers.append(Thread([&] {
+                    while (start.load() == 0) yield();
+                    for (u32 i = 0; i < per; ++i) {
+                        LockGuard lock(mutex);
+                        list.push(u64(i));
+                    }
+                }));
+            }
+            const auto t0 = nms::clock();
+            start.store(1u);
+            for (auto& worker : workers) worker.join();
+            dt2 = nms::clock() - t0;
+        }
+
+        io::log::info("nms.thread.ConcurrentArrayList: threads={} on {} cpus: push {.2}M/s, pushs x {}: {.2}M/s, ArrayList+Mutex: {.2}M/s",
+            threads, system::cpu_count(), (per * threads) / dt0 / 1e6, run, (per * threads) / dt1 / 1e6, (per * threads) / dt2 / 1e6);
+    }
+}
+
+#pragma endregion
+
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <nms/core.h>
+#include <nms/io/file.h>
+#include <nms/thread/atomic.h>
+#include <nms/thread/parallel.h>
+
+namespace nms::thread
+{
+
+/*!
+ * concurrent append-only paged list, same layout and file format as ArrayList.
+ *
+ * push claims an index with one fetch_add, pushs claims a run of slots with one
+ * fetch_add. the page is allocated on first touch and installed with a CAS
+ * (the loser frees its page).
+ * each slot has a ready flag: after writing its slots, a producer moves the
+ * published count over every ready slot with one CAS, so readers see a
+ * consistent prefix [0, count()) without any lock, and no producer waits for
+ * a slower one.
+ * the constructor of T should not throw.
+ */
+template<class T, u32 BookSize, u32 PageSize>
+class ConcurrentArrayList final
+{
+public:
+    using Type = T;
+    constexpr static u32 $BookSize  = BookSize;     // count max pages in book
+    constexpr static u32 $PageSize  = PageSize;     // count max items in page
+    constexpr static u32 $capicity  = BookSize * PageSize;
+
+    ConcurrentArrayList()
+    {}
+
+    ~ConcurrentArrayList() {
+        const auto cnt = count();
+        for (u32 bid = 0; bid < $BookSize; ++bid) {
+            const auto page = book_[bid].load(MemOrder::Relaxed);
+            if (page == nullptr) {
+                continue;
+            }
+            for (u32 pid = 0; pid < $PageSize && bid * $PageSize + pid < cnt; ++pid) {
+                page->data()[pid].~T();
+            }
+            mdel(page);
+        }
+    }
+
+    ConcurrentArrayList(const ConcurrentArrayList&)            = delete;
+    ConcurrentArrayList& operator=(const ConcurrentArrayList&) = delete;
+
+    /* number of published elements */
+    u32 count() const noexcept {
+        return published_.load(MemOrder::Acquire);
+    }
+
+    u32 getPageCount() const noexcept {
+        return (count() + $PageSize - 1) / $PageSize;
+    }
+
+    /* idx should be less than count() */
+    const Type& operator[](u32 idx) const {
+        const auto page = book_[idx / $PageSize].load(MemOrder::Relaxed);
+        return page->data()[idx % $PageSize];
+    }
+
+    /*! append value, thread safe, @return the index of value */
+    template<class U>
+    u32 push(U&& value) {
+        const auto idx = reserved_.fetch_add(1u, MemOrder::Relaxed);
+        if (idx >= $capicity) {
+            NMS_THROW(EOutOfRange<u32>(0u, $capicity - 1, idx));
+        }
+
+        const auto page = _page(idx / $PageSize);
+        new(&page->data()[idx % $PageSize])T(fwd<U>(value));
+        page->ready[idx % $PageSize].store(1u, MemOrder::Release);
+        _publish();
+        return idx;
+    }
+
+    /*! append cnt values as a run of slots, thread safe, @return the index of the first value */
+    template<class U>
+    u32 pushs(const U values[], u32 cnt) {
+        const auto idx = reserved_.fetch_add(cnt, MemOrder::Relaxed);
+        if (idx + u64(cnt) > $capicity) {
+            NMS_THROW(EOutOfRange<u32>(0u, $capicity - 1, idx + cnt - 1));
+        }
+
+        // a page lookup per page of the run
+        for (u32 pos = 0; pos < cnt; ) {
+            const auto pid  = (idx + pos) % $PageSize;
+            const auto len  = nms::min(cnt - pos, $PageSize - pid);
+            const auto page = _page((idx + pos) / $PageSize);
+            for (u32 k = 0; k < len; ++k) {
+                new(&page->data()[pid + k])T(values[pos + k]);
+                page->ready[pid + k].store(1u, MemOrder::Release);
+            }
+            pos += len;
+        }
+        _publish();
+        return idx;
+    }
+
+    /*! call func(const T&) on a snapshot [0, count()), @return the snapshot count */
+    template<class F>
+    u32 each(F&& func) const {
+        const auto cnt = count();
+        for (u32 bid = 0; bid * $PageSize < cnt; ++bid) {
+            const auto page = book_[bid].load(MemOrder::Relaxed)->data();
+            const auto len  = _page_count(cnt, bid);
+            for (u32 pid = 0; pid < len; ++pid) {
+                func(page[pid]);
+            }
+        }
+        return cnt;
+    }
+
+    /*! copy a snapshot to buff (count() elements at least), @return the snapshot count */
+    u32 getData(Type* buff) const {
+        const auto cnt = count();
+        for (u32 bid = 0; bid * $PageSize < cnt; ++bid) {
+            const auto page = book_[bid].load(MemOrder::Relaxed)->data();
+            mcpy(buff + bid * $PageSize, page, _page_count(cnt, bid));
+        }
+        return cnt;
+    }
+
+#pragma region save/load
+    /*!
+     * save a snapshot in the ArrayList format.
+     * pages are written in parallel with positioned writes.
+     */
+    void save(io::File& file) const {
+        const auto info  = View<T, 1>::$info;
+        const auto cnt   = count();
+
+        file.write(&info, 1);
+        file.write(&cnt,  1);
+        file.flush();
+
+        const auto base  = file.tell();
+        const auto pages = (cnt + $PageSize - 1) / $PageSize;
+        parallel_for(pages, [&](u32 bid) {
+            const auto page = book_[bid].load(MemOrder::Relaxed)->data();
+            const auto pos  = base + u64(bid) * $PageSize * sizeof(T);
+            file.writeAt(page, u64(_page_count(cnt, bid)) * sizeof(T), pos);
+        });
+        file.seek(base + u64(cnt) * sizeof(T));
+    }
+
+    void save(const io::Path& path) const {
+        io::File file(path, io::File::Write);
+        save(file);
+    }
+#pragma endregion
+
+private:
+    struct Page
+    {
+        Atomic<u32>         ready[$PageSize];
+        alignas(T) u8       items[$PageSize * sizeof(T)];
+
+        T* data() noexcept {
+            return reinterpret_cast<T*>(items);
+        }
+    };
+
+    Atomic<Page*>           book_[$BookSize];
+    alignas(64) Atomic<u32> reserved_  = 0u;    // claimed by push
+    alignas(64) Atomic<u32> published_ = 0u;    // visible to readers
+
+    static u32 _page_count(u32 cnt, u32 bid) noexcept {
+        const auto left = cnt - bid * $PageSize;
+        return left < $PageSize ? left : $PageSize;
+    }
+
+    Page* _page(u32 bid) {
+        auto page = book_[bid].load(MemOrder::Acquire);
+        if (page != nullptr) {
+            return page;
+        }
+
+        auto next = mnew<Page>(1);
+        for (auto& flag : next->ready) {
+            new(&flag) Atomic<u32>(0u);
+        }
+
+        Page* prev = nullptr;
+        if (book_[bid].cas(prev, next, MemOrder::AcqRel)) {
+            return next;
+        }
+        mdel(next);
+        return prev;
+    }
+
+    /* the end of the run of ready slots from pos */
+    u32 _ready_end(u32 pos) const {
+        while (pos < $capicity) {
+            const auto page = book_[pos / $PageSize].load(MemOrder::Acquire);
+            if (page == nullptr) {
+                return pos;
+            }
+            const auto end = (pos / $PageSize + 1) * $PageSize;
+            while (pos < end && page->ready[pos % $PageSize].load(MemOrder::Acquire) != 0) {
+                ++pos;
+            }
+            if (pos < end) {
+                return pos;
+            }
+        }
+        return pos;
+    }
+
+    /*
+     * move published_ over the ready slots, a CAS per run.
+     * a producer that stops at a slot not ready yet rescans after a read-modify-write
+     * of published_: either it sees the flag of the slot, or the owner of the slot
+     * (whose own read-modify-write comes later) sees its flags and moves over them.
+     */
+    void _publish() {
+        auto pos    = published_.load(MemOrder::Acquire);
+        auto synced = false;   // the last access to published_ was a read-modify-write
+        while (true) {
+            const auto end = _ready_end(pos);
+            if (end != pos) {
+                // on failure, another producer moved it: pos is reloaded
+                synced = published_.cas(pos, end, MemOrder::AcqRel);
+                if (synced) {
+                    pos = end;
+                }
+                continue;
+            }
+            if (synced) {
+                return;
+            }
+            pos    = published_.fetch_add(0u, MemOrder::AcqRel);
+            synced = true;
+        }
+    }
+};
+
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <nms/core.h>
+
+#ifdef NMS_CC_MSVC
+#include <intrin.h>
+#endif
+
+namespace nms::thread
+{
+
+/*! memory order of atomic operations */
+enum class MemOrder
+{
+    Relaxed,
+    Acquire,
+    Release,
+    AcqRel,
+    SeqCst,
+};
+
+#ifndef NMS_CC_MSVC
+constexpr int _atomic_order(MemOrder order) {
+    return order == MemOrder::Relaxed ? __ATOMIC_RELAXED
+         : order == MemOrder::Acquire ? __ATOMIC_ACQUIRE
+         : order == MemOrder::Release ? __ATOMIC_RELEASE
+         : order == MemOrder::AcqRel  ? __ATOMIC_ACQ_REL
+         : __ATOMIC_SEQ_CST;
+}
+#endif
+
+/*!
+ * atomic integer or pointer (4 or 8 bytes), fetch_add/fetch_sub are for integers only.
+ * on msvc every read-modify-write is a full barrier (Interlocked*), loads and
+ * stores are plain accesses fenced against compiler reordering (x86/x64 only).
+ */
+template<class T>
+class Atomic
+{
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "nms.thread.Atomic: unsupported type size");
+
+public:
+    constexpr Atomic() noexcept
+        : value_{}
+    {}
+
+    constexpr Atomic(T value) noexcept
+        : value_(value)
+    {}
+
+    Atomic(const Atomic&)           = delete;
+    Atomic& operator=(const Atomic&)= delete;
+
+    __forceinline T load(MemOrder order = MemOrder::SeqCst) const noexcept {
+#ifdef NMS_CC_MSVC
+        (void)order;
+        const T value = value_;
+        _ReadWriteBarrier();
+        return value;
+#else
+        return __atomic_load_n(&value_, _atomic_order(order));
+#endif
+    }
+
+    __forceinline void store(T value, MemOrder order = MemOrder::SeqCst) noexcept {
+#ifdef NMS_CC_MSVC
+        if (order == MemOrder::SeqCst) {
+            exchange(value);
+        }
+        else {
+            _ReadWriteBarrier();
+            value_ = value;
+        }
+#else
+        __atomic_store_n(&value_, value, _atomic_order(order));
+#endif
+    }
+
+    __forceinline T exchange(T value, MemOrder order = MemOrder::SeqCst) noexcept {
+#ifdef NMS_CC_MSVC
+        (void)order;
+        return _msvc_cast(sizeof(T) == 4
+            ? _InterlockedExchange  (_msvc_ptr32(), _msvc_val32(value))
+            : _InterlockedExchange64(_msvc_ptr64(), _msvc_val64(value)));
+#else
+        return __atomic_exchange_n(&value_, value, _atomic_order(order));
+#endif
+    }
+
+    /*! compare and swap: if value == expect then value = desire, else expect = value */
+    __forceinline bool cas(T& expect, T desire, MemOrder order = MemOrder::SeqCst) noexcept {
+#ifdef NMS_CC_MSVC
+        (void)order;
+        const auto old = _msvc_cast(sizeof(T) == 4
+            ? _InterlockedCompareExchange  (_msvc_ptr32(), _msvc_val32(desire), _msvc_val32(expect))
+            : _InterlockedCompareExchange64(_msvc_ptr64(), _msvc_val64(desire), _msvc_val64(expect)));
+        if (old == expect) {
+            return true;
+        }
+        expect = old;
+        return false;
+#else
+        const auto fail = order == MemOrder::AcqRel || order == MemOrder::Release ? MemOrder::Acquire : order;
+        return __atomic_compare_exchange_n(&value_, &expect, desire, false, _atomic_order(order), _atomic_order(fail));
+#endif
+    }
+
+    /*! value += delta, returns the old value */
+    template<class U>
+    __forceinline T fetch_add(U delta, MemOrder order = MemOrder::SeqCst) noexcept {
+#ifdef NMS_CC_MSVC
+        (void)order;
+        return _msvc_cast(sizeof(T) == 4
+            ? _InterlockedExchangeAdd  (_msvc_ptr32(), _msvc_val32(delta))
+            : _InterlockedExchangeAdd64(_msvc_ptr64(), _msvc_val64(delta)));
+#else
+        return __atomic_fetch_add(&value_, T(delta), _atomic_order(order));
+#endif
+    }
+
+    /*! value -= delta, returns the old value */
+    template<class U>
+    __forceinline T fetch_sub(U delta, MemOrder order = MemOrder::SeqCst) noexcept {
+        return fetch_add(T(0) - T(delta), order);
+    }
+
+    __forceinline T operator++()    noexcept { return fetch_add(1) + 1; }
+    __forceinline T operator--()    noexcept { return fetch_sub(1) - 1; }
+    __forceinline T operator++(int) noexcept { return fetch_add(1); }
+    __forceinline T operator--(int) noexcept { return fetch_sub(1); }
+
+    __forceinline operator T() const noexcept {
+        return load();
+    }
+
+    __forceinline Atomic& operator=(T value) noexcept {
+        store(value);
+        return *this;
+    }
+
+private:
+    volatile T value_;
+
+#ifdef NMS_CC_MSVC
+    volatile long*    _msvc_ptr32() noexcept { return reinterpret_cast<volatile long*>(&value_);    }
+    volatile __int64* _msvc_ptr64() noexcept { return reinterpret_cast<volatile __int64*>(&value_); }
+
+    template<class U> static long    _msvc_val32(U u) noexcept { return long(i64(u));    }
+    template<class U> static __int64 _msvc_val64(U u) noexcept { return __int64(i64(u)); }
+    template<class U> static T       _msvc_cast (U u) noexcept { return T(i64(u));       }
+#endif
+};
+
+}
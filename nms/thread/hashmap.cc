@@ -0,0 +1,132 @@
+#include <nms/test.h>
+#include <nms/thread.h>
+#include <nms/thread/hashmap.h>
+
+namespace nms::thread
+{
+
+#pragma region unittest
+
+nms_test(ConcurrentHashMap) {
+    ConcurrentHashMap<u32, u32> map;
+
+    // 8 threads, disjoint keys + one shared counter key
+    List<Thread> threads;
+    Atomic<u32>  computed = 0;
+    for (u32 t = 0; t < 8; ++t) {
+        threads.append(Thread([&, t] {
+            for (u32 i = 0; i < 1000; ++i) {
+                map.insert_or_assign(t * 1000 + i, i);
+            }
+            for (u32 i = 0; i < 1000; i += 2) {
+                map.erase(t * 1000 + i);
+            }
+            map.compute_if_absent(~0u, [&] {
+                ++computed;
+                return 42u;
+            });
+        }));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    test::assert_eq(map.count(), 8u * 500u + 1u);
+    test::assert_eq(computed.load(), 1u);
+
+    u32 val = 0;
+    test::assert_true(map.find(3001u, val));
+    test::assert_eq(val, 1u);
+    test::assert_false(map.find(3002u, val));
+    test::assert_true(map.find(~0u, val));
+    test::assert_eq(val, 42u);
+
+    // string keys, lookup by StrView
+    ConcurrentHashMap<String<>, u32> names;
+    names.insert_or_assign("abc", 1u);
+    test::assert_true(names.contains(StrView("abc")));
+    test::assert_true(names.visit("abc", [](u32 v) { test::assert_eq(v, 1u); }));
+}
+
+/* ops/s of a read/write mix, over [1, 64] threads */
+template<class Tmap>
+static void _concurrent_map_bench(const char* name, u32 write_percent) {
+    static const u32 keys = 64 * 1024;
+    static const u32 ops  = 256 * 1024;     // total, split over the threads
+
+    Tmap map;
+    for (u32 i = 0; i < keys; i += 2) {
+        map.insert_or_assign(i, i);
+    }
+
+    String<> line;
+    for (u32 nthreads = 1; nthreads <= 64; nthreads *= 2) {
+        List<Thread> threads;
+        Atomic<u32>  ready = 0;
+        Atomic<u32>  start = 0;
+        for (u32 t = 0; t < nthreads; ++t) {
+            threads.append(Thread([&, t] {
+                ++ready;
+                while (start.load() == 0) {
+                    yield();
+                }
+                u32 x = 2463534242u + t * 7919u;
+                u32 val = 0;
+                for (u32 i = 0; i < ops / nthreads; ++i) {
+                    x ^= x << 13; x ^= x >> 17; x ^= x << 5;    // xorshift
+                    const auto key = x % keys;
+                    if (x / keys % 100 < write_percent) {
+                        map.insert_or_assign(key, i);
+                    }
+                    else {
+                        map.find(key, val);
+                    }
+                }
+            }));
+        }
+        while (ready.load() != nthreads) {
+            yield();
+        }
+        const auto t0 = nms::clock();
+        start.store(1);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        const auto t1 = nms::clock();
+        sformat(line, " {}:{.2}M/s", nthreads, ops / (t1 - t0) / 1e6);
+    }
+    io::log::info("nms.thread.{}: {}% write, threads:ops ->{}", name, write_percent, line);
+}
+
+/* the baseline: one Mutex around a HashMap */
+template<class K, class V>
+class _MutexHashMap
+{
+public:
+    bool insert_or_assign(K key, V val) {
+        LockGuard guard(mutex_);
+        return map_.set(key, val), true;
+    }
+
+    bool find(K key, V& val) {
+        LockGuard guard(mutex_);
+        const auto pval = map_.find(key);
+        if (pval != nullptr) val = *pval;
+        return pval != nullptr;
+    }
+
+private:
+    Mutex           mutex_;
+    HashMap<K, V>   map_;
+};
+
+nms_test(ConcurrentHashMap_perf) {
+    _concurrent_map_bench<ConcurrentHashMap<u32, u32> >("ConcurrentHashMap", 5);
+    _concurrent_map_bench<ConcurrentHashMap<u32, u32> >("ConcurrentHashMap", 50);
+    _concurrent_map_bench<_MutexHashMap<u32, u32> >    ("Mutex+HashMap    ", 5);
+    _concurrent_map_bench<_MutexHashMap<u32, u32> >    ("Mutex+HashMap    ", 50);
+}
+
+#pragma endregion
+
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <nms/util/hashmap.h>
+#include <nms/thread/rwlock.h>
+
+namespace nms::thread
+{
+
+/*!
+ * concurrent hash map: lock striping over Ishards HashMaps.
+ * each shard has its own RWLock and cache line, so lookups of different
+ * shards never share a written cache line, and readers of one shard run in parallel.
+ * values are returned by copy: no reference escapes the lock.
+ */
+template<class K, class V, u32 Ishards = 64>
+class ConcurrentHashMap final
+{
+    static_assert((Ishards & (Ishards - 1)) == 0, "nms.thread.ConcurrentHashMap: Ishards should be a power of 2");
+
+public:
+    static constexpr u32 $shards = Ishards;
+
+    ConcurrentHashMap()
+    {}
+
+    ConcurrentHashMap(const ConcurrentHashMap&)             = delete;
+    ConcurrentHashMap& operator=(const ConcurrentHashMap&)  = delete;
+
+    /* number of elements (not a snapshot, if other threads are writing) */
+    u32 count() const {
+        u32 result = 0;
+        for (auto& shard : shards_) {
+            ReadLockGuard guard(shard.lock);
+            result += shard.map.count();
+        }
+        return result;
+    }
+
+    /* reserve room for cnt elements, spread over the shards */
+    void reserve(u32 cnt) {
+        for (auto& shard : shards_) {
+            WriteLockGuard guard(shard.lock);
+            shard.map.reserve((cnt + $shards - 1) / $shards);
+        }
+    }
+
+    void clear() {
+        for (auto& shard : shards_) {
+            WriteLockGuard guard(shard.lock);
+            shard.map.clear();
+        }
+    }
+
+    /*! copy the value to val, @return false if the key does not exist */
+    template<class Q>
+    bool find(const Q& key, V& val) const {
+        auto& shard = _shard(key);
+        ReadLockGuard guard(shard.lock);
+        const auto pval = shard.map.find(key);
+        if (pval == nullptr) {
+            return false;
+        }
+        val = *pval;
+        return true;
+    }
+
+    template<class Q>
+    bool contains(const Q& key) const {
+        auto& shard = _shard(key);
+        ReadLockGuard guard(shard.lock);
+        return shard.map.contains(key);
+    }
+
+    /*! insert or assign, @return true if inserted */
+    template<class Q, class U>
+    bool insert_or_assign(Q&& key, U&& val) {
+        auto& shard = _shard(key);
+        WriteLockGuard guard(shard.lock);
+        if (auto pval = shard.map.find(key)) {
+            *pval = fwd<U>(val);
+            return false;
+        }
+        shard.map.insert(fwd<Q>(key), fwd<U>(val));
+        return true;
+    }
+
+    /*! remove the key, @return false if it does not exist */
+    template<class Q>
+    bool erase(const Q& key) {
+        auto& shard = _shard(key);
+        WriteLockGuard guard(shard.lock);
+        return shard.map.erase(key);
+    }
+
+    /*!
+     * return the value of key, insert func() first if the key does not exist.
+     * func is called at most once per key, with the shard locked: keep it short.
+     */
+    template<class Q, class F>
+    V compute_if_absent(Q&& key, F&& func) {
+        auto& shard = _shard(key);
+        {
+            ReadLockGuard guard(shard.lock);
+            if (auto pval = shard.map.find(key)) {
+                return *pval;
+            }
+        }
+
+        WriteLockGuard guard(shard.lock);
+        if (auto pval = shard.map.find(key)) {
+            return *pval;
+        }
+        V val = func();
+        shard.map.insert(fwd<Q>(key), val);
+        return val;
+    }
+
+    /*! call func(const V&) with the shard read-locked, @return false if the key does not exist */
+    template<class Q, class F>
+    bool visit(const Q& key, F&& func) const {
+        auto& shard = _shard(key);
+        ReadLockGuard guard(shard.lock);
+        const auto pval = shard.map.find(key);
+        if (pval == nullptr) {
+            return false;
+        }
+        func(*pval);
+        return true;
+    }
+
+private:
+    struct alignas(64) Shard
+    {
+        mutable RWLock  lock;
+        HashMap<K, V>   map;
+    };
+
+    Shard shards_[$shards];
+
+    /* the high bits pick the shard, HashMap uses the low bits */
+    template<class Q>
+    Shard& _shard(const Q& key) const {
+        const auto h   = _hash_of(key);
+        const auto idx = u32(h >> 40) & ($shards - 1);
+        return const_cast<Shard&>(shards_[idx]);
+    }
+};
+
+}
@@ -0,0 +1,181 @@
+#include <nms/test.h>
+#include <nms/thread.h>
+#include <nms/util/system.h>
+
+namespace nms::thread
+{
+
+namespace
+{
+
+/* set on pool workers, and on the calling thread while it runs its share */
+thread_local bool   t_in_parallel = false;
+
+class ThreadPool
+{
+public:
+    using Tfunc = void(*)(const void*, u32);
+
+    ThreadPool() {
+        const auto cnt = system::cpu_count();
+        for (u32 i = 1; i < cnt && i < workers_.$capicity; ++i) {
+            Thread thread([=] {
+                loop();
+            });
+            workers_.append(move(thread));
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            LockGuard lock(mutex_);
+            stop_ = true;
+            job_cond_.broadcast();
+        }
+
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&)               = delete;
+    ThreadPool& operator=(const ThreadPool&)    = delete;
+
+    u32 threads() const noexcept {
+        return workers_.count() + 1;
+    }
+
+    void run(u32 count, Tfunc pfun, const void* pobj) {
+        // one job at a time
+        LockGuard job_lock(job_mutex_);
+
+        {
+            LockGuard lock(mutex_);
+            pfun_   = pfun;
+            pobj_   = pobj;
+            count_  = count;
+            next_   = 0;
+            busy_   = workers_.count();
+            ++generation_;
+            job_cond_.broadcast();
+        }
+
+        t_in_parallel = true;
+        try {
+            work();
+        }
+        catch (...) {
+            t_in_parallel = false;
+            wait();
+            throw;
+        }
+        t_in_parallel = false;
+        wait();
+    }
+
+private:
+    List<Thread, 256>   workers_;
+
+    Mutex               job_mutex_;
+    Mutex               mutex_;
+    CondVar             job_cond_;
+    CondVar             done_cond_;
+
+    Tfunc               pfun_       = nullptr;
+    const void*         pobj_       = nullptr;
+    u32                 count_      = 0;
+    Atomic<u32>         next_       = 0;
+    u32                 busy_       = 0;
+    u64                 generation_ = 0;
+    bool                stop_       = false;
+
+    void work() {
+        for (;;) {
+            const auto idx = next_.fetch_add(1);
+            if (idx >= count_) {
+                break;
+            }
+            pfun_(pobj_, idx);
+        }
+    }
+
+    void wait() {
+        LockGuard lock(mutex_);
+        while (busy_ != 0) {
+            done_cond_.wait(mutex_);
+        }
+    }
+
+    void loop() {
+        t_in_parallel = true;
+
+        u64 seen = 0;
+        for (;;) {
+            {
+                LockGuard lock(mutex_);
+                while (generation_ == seen && !stop_) {
+                    job_cond_.wait(mutex_);
+                }
+                if (stop_) {
+                    return;
+                }
+                seen = generation_;
+            }
+
+            try {
+                work();
+            }
+            catch (...) {
+                io::log::error("nms.thread.parallel_for: unexpect exception in worker thread.");
+            }
+
+            {
+                LockGuard lock(mutex_);
+                if (--busy_ == 0) {
+                    done_cond_.signal();
+                }
+            }
+        }
+    }
+};
+
+ThreadPool& thread_pool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+}
+
+NMS_API u32 parallel_threads() {
+    return thread_pool().threads();
+}
+
+NMS_API void _parallel_for(u32 count, void(*pfun)(const void*, u32), const void* pobj) {
+    if (count == 1 || t_in_parallel || parallel_threads() == 1) {
+        for (u32 idx = 0; idx < count; ++idx) {
+            pfun(pobj, idx);
+        }
+        return;
+    }
+
+    thread_pool().run(count, pfun, pobj);
+}
+
+nms_test(parallel_for) {
+    const u32 count = 1000;
+
+    Atomic<u64> sum = 0;
+    Atomic<u32> nested = 0;
+    parallel_for(count, [&](u32 idx) {
+        sum.fetch_add(idx);
+
+        if (idx % 100 == 0) {
+            parallel_for(10, [&](u32) { ++nested; });
+        }
+    });
+
+    test::assert_eq(sum.load(), u64(count) * (count - 1) / 2);
+    test::assert_eq(nested.load(), 100u);
+}
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <nms/core.h>
+
+namespace nms::thread
+{
+
+/*! number of threads used by parallel_for (workers + the calling thread) */
+NMS_API u32  parallel_threads();
+
+NMS_API void _parallel_for(u32 count, void(*pfun)(const void*, u32), const void* pobj);
+
+/*!
+ * run func(idx) for idx in [0, count) on the shared thread pool.
+ * the calling thread takes part, the call returns when every idx is done.
+ * nested calls (from inside func) run serially on the current thread.
+ * func should not throw.
+ */
+template<class Tfunc>
+void parallel_for(u32 count, const Tfunc& func) {
+    if (count == 0) {
+        return;
+    }
+
+    auto pfun = [](const void* pobj, u32 idx) {
+        (*static_cast<const Tfunc*>(pobj))(idx);
+    };
+    _parallel_for(count, pfun, &func);
+}
+
+}
@@ -0,0 +1,152 @@
+#include <nms/test.h>
+#include <nms/thread.h>
+#include <nms/thread/queue.h>
+
+namespace nms::thread
+{
+
+#pragma region unittest
+
+nms_test(SpscRing) {
+    static const u64 n = 100000;
+
+    SpscRing<u64> ring(1000);
+    test::assert_eq(ring.capacity(), u64(1024));
+
+    Thread producer([&] {
+        u64 batch[16];
+        for (u64 i = 0; i < n; ) {
+            if (i % 3 == 0) {
+                ring.push(i++);
+            }
+            else {
+                const auto cnt = n - i < 16 ? n - i : 16;
+                for (u64 k = 0; k < cnt; ++k) batch[k] = i + k;
+                auto pushed = ring.push_n(batch, cnt);
+                i += pushed;
+                if (pushed == 0) yield();
+            }
+        }
+    });
+
+    u64 expect = 0;
+    u64 batch[32];
+    while (expect < n) {
+        const auto cnt = ring.pop_n(batch, 32);
+        for (u64 k = 0; k < cnt; ++k) {
+            test::assert_eq(batch[k], expect++);
+        }
+        if (cnt == 0) yield();
+    }
+    producer.join();
+
+    u64 val = 0;
+    test::assert_false(ring.try_pop(val));
+}
+
+nms_test(MpmcQueue) {
+    static const u32 producers = 4;
+    static const u32 consumers = 4;
+    static const u64 n = 20000;      // per producer
+
+    MpmcQueue<u64> queue(256);
+    Atomic<u64> sum   = 0;
+    Atomic<u64> count = 0;
+
+    List<Thread> threads;
+    for (u32 p = 0; p < producers; ++p) {
+        threads.append(Thread([&, p] {
+            for (u64 i = 0; i < n; ++i) {
+                queue.push(p * n + i);
+            }
+        }));
+    }
+    for (u32 c = 0; c < consumers; ++c) {
+        threads.append(Thread([&] {
+            u64 val = 0;
+            while (count.load() < producers * n) {
+                if (queue.pop(val, 0.001)) {
+                    sum.fetch_add(val);
+                    ++count;
+                }
+            }
+        }));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const u64 total = producers * n;
+    test::assert_eq(count.load(), total);
+    test::assert_eq(sum.load(), total * (total - 1) / 2);
+
+    // timeout
+    u64 val = 0;
+    test::assert_false(queue.pop(val, 0.001));
+    MpmcQueue<u64> full(2);
+    test::assert_true(full.try_push(1u));
+    test::assert_true(full.try_push(2u));
+    test::assert_false(full.push(3u, 0.001));
+}
+
+template<class Tqueue>
+static f64 _queue_throughput(u32 pairs, u64 n) {
+    Tqueue queue(1024);
+
+    List<Thread> threads;
+    Atomic<u32>  start = 0;
+    for (u32 t = 0; t < pairs; ++t) {
+        threads.append(Thread([&] {
+            while (start.load() == 0) yield();
+            for (u64 i = 0; i < n; ++i) queue.push(i);
+        }));
+        threads.append(Thread([&] {
+            while (start.load() == 0) yield();
+            for (u64 i = 0; i < n; ++i) queue.pop();
+        }));
+    }
+    const auto t0 = nms::clock();
+    start.store(1);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const auto t1 = nms::clock();
+    return f64(n * pairs) / (t1 - t0);
+}
+
+nms_test(queue_perf) {
+    static const u64 n = 200000;
+
+    // throughput
+    const auto spsc = _queue_throughput<SpscRing<u64> >(1, n);
+    io::log::info("nms.thread.SpscRing: 1 pair: {.2}M msg/s", spsc / 1e6);
+
+    String<> line;
+    for (u32 pairs = 1; pairs <= 4; pairs *= 2) {
+        const auto mpmc = _queue_throughput<MpmcQueue<u64> >(pairs, n / pairs);
+        sformat(line, " {}:{.2}M/s", pairs, mpmc / 1e6);
+    }
+    io::log::info("nms.thread.MpmcQueue: pairs:msg ->{}", line);
+
+    // latency: ping-pong between two threads
+    static const u32 rounds = 10000;
+    SpscRing<u32> ping(16);
+    SpscRing<u32> pong(16);
+    Thread echo([&] {
+        for (u32 i = 0; i < rounds; ++i) {
+            pong.push(ping.pop());
+        }
+    });
+    const auto t0 = nms::clock();
+    for (u32 i = 0; i < rounds; ++i) {
+        ping.push(i);
+        pong.pop();
+    }
+    const auto t1 = nms::clock();
+    echo.join();
+    io::log::info("nms.thread.SpscRing: round trip = {.3}us", (t1 - t0) / rounds * 1e6);
+}
+
+#pragma endregion
+
+}
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <nms/core.h>
+#include <nms/thread/atomic.h>
+#include <nms/thread/rwlock.h>
+
+namespace nms::thread
+{
+
+/* u64 counter alone on a cache line, with a private cache of the other side */
+struct alignas(64) _QueueIndex
+{
+    Atomic<u64> pos;
+    u64         cache = 0;
+};
+
+/* capacity: the next power of 2 */
+inline u64 _queue_capacity(u64 cnt) {
+    u64 cap = 2;
+    while (cap < cnt) {
+        cap *= 2;
+    }
+    return cap;
+}
+
+#pragma region spsc
+/*!
+ * lock-free single producer, single consumer ring.
+ * the producer only writes tail_, the consumer only writes head_: each side
+ * reads the other index only when its cached copy says full/empty.
+ */
+template<class T>
+class SpscRing final
+{
+public:
+    explicit SpscRing(u64 capacity)
+        : mask_(_queue_capacity(capacity) - 1)
+        , data_(mnew<T>(mask_ + 1))
+    {}
+
+    ~SpscRing() {
+        T val;
+        while (try_pop(val)) {}
+        mdel(data_);
+    }
+
+    SpscRing(const SpscRing&)            = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    u64 capacity() const noexcept {
+        return mask_ + 1;
+    }
+
+    /* number of elements (approximate, if the other side is running) */
+    u64 count() const noexcept {
+        return tail_.pos.load(MemOrder::Acquire) - head_.pos.load(MemOrder::Acquire);
+    }
+
+#pragma region producer
+    template<class U>
+    bool try_push(U&& val) {
+        const auto tail = tail_.pos.load(MemOrder::Relaxed);
+        if (tail - tail_.cache > mask_) {
+            tail_.cache = head_.pos.load(MemOrder::Acquire);
+            if (tail - tail_.cache > mask_) {
+                return false;
+            }
+        }
+        new(&data_[tail & mask_])T(fwd<U>(val));
+        tail_.pos.store(tail + 1, MemOrder::Release);
+        return true;
+    }
+
+    /*! push up to cnt elements, @return number of pushed elements */
+    u64 push_n(const T* vals, u64 cnt) {
+        const auto tail = tail_.pos.load(MemOrder::Relaxed);
+        auto room = mask_ + 1 - (tail - tail_.cache);
+        if (room < cnt) {
+            tail_.cache = head_.pos.load(MemOrder::Acquire);
+            room = mask_ + 1 - (tail - tail_.cache);
+        }
+        const auto n = cnt < room ? cnt : room;
+        for (u64 i = 0; i < n; ++i) {
+            new(&data_[(tail + i) & mask_])T(vals[i]);
+        }
+        tail_.pos.store(tail + n, MemOrder::Release);
+        return n;
+    }
+
+    /* push, spin while full */
+    template<class U>
+    void push(U&& val) {
+        SpinWait wait;
+        while (!try_push(fwd<U>(val))) {
+            wait();
+        }
+    }
+#pragma endregion
+
+#pragma region consumer
+    bool try_pop(T& val) {
+        const auto head = head_.pos.load(MemOrder::Relaxed);
+        if (head == head_.cache) {
+            head_.cache = tail_.pos.load(MemOrder::Acquire);
+            if (head == head_.cache) {
+                return false;
+            }
+        }
+        auto& ref = data_[head & mask_];
+        val = move(ref);
+        ref.~T();
+        head_.pos.store(head + 1, MemOrder::Release);
+        return true;
+    }
+
+    /*! pop up to cnt elements, @return number of popped elements */
+    u64 pop_n(T* vals, u64 cnt) {
+        const auto head = head_.pos.load(MemOrder::Relaxed);
+        auto avail = head_.cache - head;
+        if (avail < cnt) {
+            head_.cache = tail_.pos.load(MemOrder::Acquire);
+            avail = head_.cache - head;
+        }
+        const auto n = cnt < avail ? cnt : avail;
+        for (u64 i = 0; i < n; ++i) {
+            auto& ref = data_[(head + i) & mask_];
+            vals[i] = move(ref);
+            ref.~T();
+        }
+        head_.pos.store(head + n, MemOrder::Release);
+        return n;
+    }
+
+    /* pop, spin while empty */
+    T pop() {
+        T val;
+        SpinWait wait;
+        while (!try_pop(val)) {
+            wait();
+        }
+        return val;
+    }
+#pragma endregion
+
+private:
+    u64         mask_;
+    T*          data_;
+    _QueueIndex head_;      // consumer, cache: last seen tail
+    _QueueIndex tail_;      // producer, cache: last seen head
+};
+#pragma endregion
+
+#pragma region mpmc
+/*!
+ * bounded lock-free multi producer, multi consumer queue (Vyukov).
+ * each cell has a sequence number: a producer claims position p when
+ * seq == p, a consumer when seq == p + 1. one CAS per operation.
+ */
+template<class T>
+class MpmcQueue final
+{
+public:
+    explicit MpmcQueue(u64 capacity)
+        : mask_(_queue_capacity(capacity) - 1)
+        , cells_(mnew<Cell>(mask_ + 1)) {
+        for (u64 i = 0; i <= mask_; ++i) {
+            new(&cells_[i].seq) Atomic<u64>(i);
+        }
+    }
+
+    ~MpmcQueue() {
+        T val;
+        while (try_pop(val)) {}
+        mdel(cells_);
+    }
+
+    MpmcQueue(const MpmcQueue&)            = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    u64 capacity() const noexcept {
+        return mask_ + 1;
+    }
+
+    /* number of elements (approximate) */
+    u64 count() const noexcept {
+        const auto tail = tail_.pos.load(MemOrder::Acquire);
+        const auto head = head_.pos.load(MemOrder::Acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    /*! push, @return false if full */
+    template<class U>
+    bool try_push(U&& val) {
+        auto pos = tail_.pos.load(MemOrder::Relaxed);
+        while (true) {
+            auto& cell = cells_[pos & mask_];
+            const auto seq  = cell.seq.load(MemOrder::Acquire);
+            const auto diff = i64(seq - pos);
+            if (diff == 0) {
+                if (tail_.pos.cas(pos, pos + 1, MemOrder::Relaxed)) {
+                    new(cell.data)T(fwd<U>(val));
+                    cell.seq.store(pos + 1, MemOrder::Release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = tail_.pos.load(MemOrder::Relaxed);
+            }
+        }
+    }
+
+    /*! pop, @return false if empty */
+    bool try_pop(T& val) {
+        auto pos = head_.pos.load(MemOrder::Relaxed);
+        while (true) {
+            auto& cell = cells_[pos & mask_];
+            const auto seq  = cell.seq.load(MemOrder::Acquire);
+            const auto diff = i64(seq - (pos + 1));
+            if (diff == 0) {
+                if (head_.pos.cas(pos, pos + 1, MemOrder::Relaxed)) {
+                    auto& ref = *reinterpret_cast<T*>(cell.data);
+                    val = move(ref);
+                    ref.~T();
+                    cell.seq.store(pos + mask_ + 1, MemOrder::Release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = head_.pos.load(MemOrder::Relaxed);
+            }
+        }
+    }
+
+    /* push, spin while full */
+    template<class U>
+    void push(U&& val) {
+        SpinWait wait;
+        while (!try_push(fwd<U>(val))) {
+            wait();
+        }
+    }
+
+    /* pop, spin while empty */
+    T pop() {
+        T val;
+        SpinWait wait;
+        while (!try_pop(val)) {
+            wait();
+        }
+        return val;
+    }
+
+    /*! push, @return false if still full after timeout seconds */
+    template<class U>
+    bool push(U&& val, f64 timeout) {
+        const auto deadline = nms::clock() + timeout;
+        SpinWait wait;
+        while (!try_push(fwd<U>(val))) {
+            if (nms::clock() > deadline) {
+                return false;
+            }
+            wait();
+        }
+        return true;
+    }
+
+    /*! pop, @return false if still empty after timeout seconds */
+    bool pop(T& val, f64 timeout) {
+        const auto deadline = nms::clock() + timeout;
+        SpinWait wait;
+        while (!try_pop(val)) {
+            if (nms::clock() > deadline) {
+                return false;
+            }
+            wait();
+        }
+        return true;
+    }
+
+private:
+    struct Cell
+    {
+        Atomic<u64> seq;
+        alignas(T) u8 data[sizeof(T)];
+    };
+
+    u64         mask_;
+    Cell*       cells_;
+    _QueueIndex head_;
+    _QueueIndex tail_;
+};
+#pragma endregion
+
+}
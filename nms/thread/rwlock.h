@@ -0,0 +1,132 @@
+#pragma once
+
+#include <nms/core.h>
+#include <nms/core/simd.h>
+#include <nms/thread/atomic.h>
+#include <nms/thread/thread.h>
+
+namespace nms::thread
+{
+
+/* spin-wait with exponential backoff, then yield the cpu */
+struct SpinWait
+{
+public:
+    __forceinline void operator()() noexcept {
+        if (count_ < 6) {
+            for (u32 i = 0; i < (1u << count_); ++i) {
+                pause();
+            }
+            ++count_;
+        }
+        else {
+            Thread::yield();
+        }
+    }
+
+    static __forceinline void pause() noexcept {
+#ifdef NMS_SIMD_SSE2
+        _mm_pause();
+#endif
+    }
+
+private:
+    u32 count_ = 0;
+};
+
+/*!
+ * reader-writer spin lock (4 bytes), writer preferring.
+ * readers only touch the lock word: no syscall, no Mutex.
+ * for short critical sections, a waiting thread spins then yields.
+ */
+class RWLock final
+{
+public:
+    constexpr RWLock() noexcept
+    {}
+
+    RWLock(const RWLock&)            = delete;
+    RWLock& operator=(const RWLock&) = delete;
+
+    __forceinline void lock_shared() noexcept {
+        SpinWait wait;
+        while (true) {
+            auto s = state_.load(MemOrder::Relaxed);
+            if ((s & ($writer | $waiting)) == 0 && state_.cas(s, s + 1, MemOrder::Acquire)) {
+                return;
+            }
+            wait();
+        }
+    }
+
+    __forceinline void unlock_shared() noexcept {
+        state_.fetch_sub(1u, MemOrder::Release);
+    }
+
+    __forceinline void lock() noexcept {
+        SpinWait wait;
+        while (true) {
+            auto s = state_.load(MemOrder::Relaxed);
+            if ((s & ~$waiting) == 0) {
+                if (state_.cas(s, $writer, MemOrder::Acquire)) {
+                    return;
+                }
+            }
+            else if ((s & $waiting) == 0) {
+                // block new readers
+                state_.cas(s, s | $waiting, MemOrder::Relaxed);
+            }
+            wait();
+        }
+    }
+
+    __forceinline void unlock() noexcept {
+        state_.store(0u, MemOrder::Release);
+    }
+
+private:
+    static constexpr u32 $writer  = 1u << 31;
+    static constexpr u32 $waiting = 1u << 30;
+
+    Atomic<u32> state_ = 0u;
+};
+
+struct ReadLockGuard final
+{
+public:
+    explicit ReadLockGuard(RWLock& lock)
+        : lock_(&lock) {
+        lock_->lock_shared();
+    }
+
+    ~ReadLockGuard() {
+        lock_->unlock_shared();
+    }
+
+    ReadLockGuard(const ReadLockGuard&)            = delete;
+    ReadLockGuard& operator=(const ReadLockGuard&) = delete;
+
+private:
+    RWLock* lock_;
+};
+
+struct WriteLockGuard final
+{
+public:
+    explicit WriteLockGuard(RWLock& lock)
+        : lock_(&lock) {
+        lock_->lock();
+    }
+
+    ~WriteLockGuard() {
+        lock_->unlock();
+    }
+
+    WriteLockGuard(const WriteLockGuard&)            = delete;
+    WriteLockGuard& operator=(const WriteLockGuard&) = delete;
+
+private:
+    RWLock* lock_;
+};
+
+}
@@ -76,7 +76,6 @@ NMS_API void Scheduler::run() {
             ptask->invoke();
         });
         threads_.append(move(thread));
-        Thread::sleep(0.01);
     }
 
     for (auto& thread : threads_) {
@@ -60,14 +60,6 @@ extern "C" {
 namespace nms::thread
 {
 
-NMS_API void* Thread::buff(size_t size) {
-    thread_local static char buff[4096];
-    if (size >= sizeof(buff)) {
-        return nullptr;
-    }
-    return buff;
-}
-
 NMS_API void Thread::start(thrd_ret_t(*pfun)(void*), void* pobj) {
     if (impl_ != thrd_t(0)) {
         return;
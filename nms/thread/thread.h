@@ -54,21 +54,18 @@ private:
 #endif
 
     NMS_API void  start(thrd_ret_t(*pfun)(void*), void* pobj);
-    NMS_API static void* buff(size_t size);
 
     template<class Tlambda>
     bool run(Tlambda&& lambda) {
-        auto addr = buff(sizeof(Tlambda));
+        using Tfunc = Tvalue<Tlambda>;
 
-        if (addr == nullptr) {
-            return false;
-        }
-        auto pobj = new(addr)Tlambda(fwd<Tlambda>(lambda));
+        // the lambda is owned by the new thread
+        auto pobj = new Tfunc(fwd<Tlambda>(lambda));
 
         auto pfun = [](void* ptr) -> thrd_ret_t {
-            auto obj = static_cast<Tlambda*>(ptr);
+            auto obj = static_cast<Tfunc*>(ptr);
             (*obj)();
-            obj->~Tlambda();
+            delete obj;
 #ifdef NMS_OS_UNIX
             return nullptr;
 #endif
@@ -76,6 +73,10 @@ private:
 
         start(pfun, pobj);
 
+        if (impl_ == thrd_t(0)) {
+            delete pobj;
+            return false;
+        }
         return true;
     }
 };
@@ -2,6 +2,7 @@
 
 #include <nms/util/arraylist.h>
 #include <nms/util/ringbuf.h>
+#include <nms/util/hashmap.h>
 
 #include <nms/util/system.h>
 #include <nms/util/library.h>
@@ -0,0 +1,25 @@
+#include <nms/test.h>
+#include <nms/util/arraylist.h>
+
+namespace nms
+{
+
+#pragma region unittest
+
+nms_test(ArrayList) {
+    ArrayList<u32, 8, 16> list;
+    for (u32 i = 0; i < 100; ++i) {
+        list.push(i);
+    }
+    test::assert_eq(list.count(), 100u);
+    test::assert_eq(list.getPageCount(), 7u);
+
+    // index: page = idx / $PageSize
+    for (u32 i = 0; i < 100; ++i) {
+        test::assert_eq(list[i], i);
+    }
+}
+
+#pragma endregion
+
+}
@@ -7,6 +7,10 @@
 namespace nms
 {
 
+/*!
+ * paged list: elements never move, so references stay valid while pushing.
+ * single-threaded, @see thread::ConcurrentArrayList
+ */
 template<class T, u32 BookSize, u32 PageSize>
 class ArrayList
 {
@@ -33,8 +37,8 @@ public:
     }
 
     const Type& operator[](u32 idx) const {
-        const auto bid  = idx / $BookSize;
-        const auto pid  = idx % $BookSize;
+        const auto bid  = idx / $PageSize;
+        const auto pid  = idx % $PageSize;
 
         const auto& page = book_[bid];
         const auto& data = page[pid];
@@ -63,7 +67,7 @@ public:
 
         // check if out of range?
         if (bid >= $BookSize) {
-            NMS_THROW(EOutOfRange{});
+            NMS_THROW(EOutOfRange<u32>(0u, $BookSize * $PageSize - 1, idx));
         }
 
         // check book
@@ -127,7 +131,7 @@ protected:
 private:
     template<class File>
     void saveFile(File& file) const {
-        const auto info       = View<T>::info();
+        const auto info       = View<T, 1>::$info;
         const auto count      = this->count_;
         const auto page_count = this->getPageCount();
         const auto last_count = count - (page_count - 1) * $PageSize;
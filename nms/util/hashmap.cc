@@ -0,0 +1,219 @@
+#include <nms/test.h>
+#include <nms/util/hashmap.h>
+
+#include <unordered_map>
+
+namespace nms
+{
+
+#pragma region hash
+static __forceinline u64 _hash_mum(u64 a, u64 b) {
+#if defined(NMS_CC_MSVC) && !defined(NMS_CC_CLANG)
+    u64 hi = 0;
+    const u64 lo = _umul128(a, b, &hi);
+    return lo ^ hi;
+#else
+    const auto r = __uint128_t(a) * b;
+    return u64(r) ^ u64(r >> 64);
+#endif
+}
+
+static __forceinline u64 _hash_r8(const u8* p) {
+    u64 v;
+    ::memcpy(&v, p, 8);
+    return v;
+}
+
+static __forceinline u64 _hash_r4(const u8* p) {
+    u32 v;
+    ::memcpy(&v, p, 4);
+    return v;
+}
+
+NMS_API u64 hash(const void* dat, u64 size) {
+    static const u64 s0 = 0xa0761d6478bd642full;
+    static const u64 s1 = 0xe7037ed1a0b428dbull;
+    static const u64 s2 = 0x8ebc6af09c88c6e3ull;
+    static const u64 s3 = 0x589965cc75374cc3ull;
+
+    auto p    = static_cast<const u8*>(dat);
+    auto seed = s0 ^ _hash_mum(s0 ^ size, s1);
+    u64  a    = 0;
+    u64  b    = 0;
+
+    if (size <= 16) {
+        if (size >= 4) {
+            const auto d = (size >> 3) << 2;
+            a = (_hash_r4(p) << 32)            | _hash_r4(p + d);
+            b = (_hash_r4(p + size - 4) << 32) | _hash_r4(p + size - 4 - d);
+        }
+        else if (size > 0) {
+            a = (u64(p[0]) << 16) | (u64(p[size >> 1]) << 8) | p[size - 1];
+        }
+    }
+    else {
+        auto n = size;
+        if (n > 48) {
+            auto seed1 = seed;
+            auto seed2 = seed;
+            do {
+                seed  = _hash_mum(_hash_r8(p +  0) ^ s1, _hash_r8(p +  8) ^ seed);
+                seed1 = _hash_mum(_hash_r8(p + 16) ^ s2, _hash_r8(p + 24) ^ seed1);
+                seed2 = _hash_mum(_hash_r8(p + 32) ^ s3, _hash_r8(p + 40) ^ seed2);
+                p += 48;
+                n -= 48;
+            } while (n > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (n > 16) {
+            seed = _hash_mum(_hash_r8(p) ^ s1, _hash_r8(p + 8) ^ seed);
+            p += 16;
+            n -= 16;
+        }
+        a = _hash_r8(p + n - 16);
+        b = _hash_r8(p + n - 8);
+    }
+
+    return _hash_mum(s1 ^ size, _hash_mum(a ^ s1, b ^ seed));
+}
+#pragma endregion
+
+#pragma region unittest
+
+nms_test(hashmap) {
+    HashMap<u32, u32> map;
+    for (u32 i = 0; i < 10000; ++i) {
+        test::assert_true(map.insert(i, i * 2));
+    }
+    test::assert_false(map.insert(7u, 0u));
+    test::assert_eq(map.count(), 10000u);
+
+    for (u32 i = 0; i < 10000; ++i) {
+        const auto pval = map.find(i);
+        test::assert_true(pval != nullptr);
+        test::assert_eq(*pval, i * 2);
+    }
+    test::assert_true(map.find(10000u) == nullptr);
+
+    // erase: deleted slots are reused
+    for (u32 i = 0; i < 10000; i += 2) {
+        test::assert_true(map.erase(i));
+    }
+    test::assert_false(map.erase(0u));
+    test::assert_eq(map.count(), 5000u);
+    for (u32 i = 0; i < 10000; ++i) {
+        test::assert_eq(map.contains(i), i % 2 == 1);
+    }
+
+    // iterate
+    u64 sum = 0;
+    for (auto& e : map) {
+        sum += e.value;
+    }
+    test::assert_eq(sum, u64(2 * 5000ull * 5000ull));
+
+    // shrink
+    const auto cap = map.capacity();
+    map.rehash();
+    test::assert_true(map.capacity() < cap);
+    test::assert_eq(*map.find(9999u), 19998u);
+
+    map.clear();
+    test::assert_eq(map.count(), 0u);
+    test::assert_false(map.contains(1u));
+}
+
+nms_test(hashmap_string) {
+    HashMap<String<>, u32> map;
+    map.set("one", 1u);
+    map.set(String<>("two"), 2u);
+    map["three"] = 3;
+    map.set("one", 11u);
+
+    test::assert_eq(map.count(), 3u);
+
+    // heterogeneous lookup: no String is built
+    const StrView two = "two";
+    test::assert_eq(*map.find(two), 2u);
+    test::assert_eq(*map.find("one"), 11u);
+    test::assert_eq(map["three"], 3u);
+    test::assert_true(map.find(StrView("four")) == nullptr);
+
+    HashSet<String<> > set;
+    set.insert("a");
+    set.insert("b");
+    test::assert_false(set.insert("a"));
+    test::assert_true(set.find(StrView("b")) != nullptr);
+
+    io::log::info("map = {}", map);
+    io::log::info("set = {}", set);
+
+    // reserve: no rehash while inserting
+    HashMap<String<>, u32> big;
+    big.reserve(1000);
+    const auto cap = big.capacity();
+    for (u32 i = 0; i < 1000; ++i) {
+        String<> key;
+        sformat(key, "key{}", i);
+        big.insert(static_cast<String<>&&>(key), i);
+    }
+    test::assert_eq(big.capacity(), cap);
+    test::assert_eq(*big.find("key999"), 999u);
+}
+
+nms_test(hashmap_perf) {
+    static const u32 n = 1000 * 1000;
+
+    List<u64> keys;
+    keys.reserve(n);
+    for (u32 i = 0; i < n; ++i) {
+        keys.append(hash(u64(i)));
+    }
+
+    u64 sum0 = 0;
+    u64 sum1 = 0;
+    u32 miss0 = 0;
+    u32 miss1 = 0;
+
+    // nms::HashMap
+    HashMap<u64, u32> map;
+    const auto t0 = nms::clock();
+    for (u32 i = 0; i < n; ++i) {
+        map.insert(keys[i], i);
+    }
+    const auto t1 = nms::clock();
+    for (u32 i = 0; i < n; ++i) {
+        sum0 += *map.find(keys[i]);
+    }
+    const auto t2 = nms::clock();
+    for (u32 i = 0; i < n; ++i) {
+        miss0 += map.find(u64(i)) == nullptr;
+    }
+    const auto t3 = nms::clock();
+
+    // std::unordered_map
+    std::unordered_map<u64, u32> umap;
+    const auto t4 = nms::clock();
+    for (u32 i = 0; i < n; ++i) {
+        umap.emplace(keys[i], i);
+    }
+    const auto t5 = nms::clock();
+    for (u32 i = 0; i < n; ++i) {
+        sum1 += umap.find(keys[i])->second;
+    }
+    const auto t6 = nms::clock();
+    for (u32 i = 0; i < n; ++i) {
+        miss1 += umap.find(u64(i)) == umap.end();
+    }
+    const auto t7 = nms::clock();
+
+    test::assert_eq(sum0, sum1);
+    test::assert_eq(miss0, miss1);
+
+    io::log::info("nms.HashMap: x {}: insert={.3}ms, hit={.3}ms, miss={.3}ms", n, (t1 - t0)*1e3, (t2 - t1)*1e3, (t3 - t2)*1e3);
+    io::log::info("std::unordered_map: x {}: insert={.3}ms, hit={.3}ms, miss={.3}ms", n, (t5 - t4)*1e3, (t6 - t5)*1e3, (t7 - t6)*1e3);
+}
+
+#pragma endregion
+
+}
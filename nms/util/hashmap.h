@@ -0,0 +1,652 @@
+#pragma once
+
+#include <nms/core/type.h>
+#include <nms/core/trait.h>
+#include <nms/core/memory.h>
+#include <nms/core/list.h>
+#include <nms/core/simd.h>
+#include <nms/core/format.h>
+
+#if defined(NMS_CC_MSVC) && !defined(NMS_CC_CLANG)
+#   include <intrin.h>
+#endif
+
+namespace nms
+{
+
+#pragma region hash
+/*! hash of a byte string (wyhash) */
+NMS_API u64 hash(const void* dat, u64 size);
+
+/* integers: murmur3 finalizer, all bits of the result depend on all bits of x */
+constexpr u64 hash(u64 x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+constexpr u64 hash(i64  x) { return hash(u64(x)); }
+constexpr u64 hash(u32  x) { return hash(u64(x)); }
+constexpr u64 hash(i32  x) { return hash(u64(x)); }
+constexpr u64 hash(u16  x) { return hash(u64(x)); }
+constexpr u64 hash(i16  x) { return hash(u64(x)); }
+constexpr u64 hash(u8   x) { return hash(u64(x)); }
+constexpr u64 hash(i8   x) { return hash(u64(x)); }
+constexpr u64 hash(char x) { return hash(u64(x)); }
+
+template<class T>
+u64 hash(T* ptr) {
+    return hash(u64(reinterpret_cast<uintptr_t>(ptr)));
+}
+
+inline u64 hash(StrView s) {
+    return hash(s.data(), s.count());
+}
+
+template<u32 N>
+u64 hash(const List<char, N>& s) {
+    return hash(s.data(), s.count());
+}
+#pragma endregion
+
+#pragma region hash table
+/*
+ * key type used for hashing and comparing:
+ * String<N>, StrView and string literals are all compared as StrView,
+ * so a HashMap<String<>, V> can be searched with a StrView (no copy).
+ */
+template<class K>   struct _HashKey                 { using U = K;       };
+template<u32 N>     struct _HashKey<List<char, N> > { using U = StrView; };
+template<u32 N>     struct _HashKey<char[N]>        { using U = StrView; };
+
+template<class K, class Q>
+__forceinline bool _hash_eq(const K& k, const Q& q) {
+    using Uk = typename _HashKey<K>::U;
+    using Uq = typename _HashKey<Q>::U;
+    return Uk(k) == Uq(q);
+}
+
+template<class Q>
+__forceinline u64 _hash_of(const Q& q) {
+    using Uq = typename _HashKey<Q>::U;
+    return hash(Uq(q));
+}
+
+__forceinline u32 _hash_ctz(u32 x) {
+#if defined(NMS_CC_MSVC) && !defined(NMS_CC_CLANG)
+    unsigned long r;
+    _BitScanForward(&r, x);
+    return u32(r);
+#else
+    return u32(__builtin_ctz(x));
+#endif
+}
+
+/*!
+ * control bytes of a group of 16 slots.
+ * full: 0..127 (7 bits of the hash), empty: -128, deleted: -2
+ * the group width is 16 on every target, so the table layout does not depend on
+ * the compiler flags (SSE2 is the x86-64 baseline, other targets use SWAR).
+ */
+struct _HashGroup
+{
+    static constexpr u32 $width  = 16;
+    static constexpr i8  $empty  = -128;
+    static constexpr i8  $deleted= -2;
+
+#ifdef NMS_SIMD_SSE2
+    __forceinline explicit _HashGroup(const i8* ctrl) noexcept
+        : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl)))
+    {}
+
+    /* bit i: slot i is full, with h2 */
+    __forceinline u32 match(i8 h2) const noexcept {
+        return u32(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_, _mm_set1_epi8(h2))));
+    }
+
+    /* bit i: slot i is empty */
+    __forceinline u32 match_empty() const noexcept {
+        return u32(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_, _mm_set1_epi8($empty))));
+    }
+
+    /* bit i: slot i is empty or deleted */
+    __forceinline u32 match_free() const noexcept {
+        return u32(_mm_movemask_epi8(ctrl_));
+    }
+
+private:
+    __m128i ctrl_;
+#else
+    __forceinline explicit _HashGroup(const i8* ctrl) noexcept {
+        _mcpy(word_, ctrl, sizeof(word_));
+    }
+
+    __forceinline u32 match(i8 h2) const noexcept {
+        const auto b = $lsbs * u8(h2);
+        return movemask(eq0(word_[0] ^ b)) | (movemask(eq0(word_[1] ^ b)) << 8);
+    }
+
+    __forceinline u32 match_empty() const noexcept {
+        // 0x80: bit 7 set, bit 6 clear
+        return movemask(word_[0] & ~(word_[0] << 1) & $msbs) | (movemask(word_[1] & ~(word_[1] << 1) & $msbs) << 8);
+    }
+
+    __forceinline u32 match_free() const noexcept {
+        return movemask(word_[0] & $msbs) | (movemask(word_[1] & $msbs) << 8);
+    }
+
+private:
+    static constexpr u64 $lsbs = 0x0101010101010101ull;
+    static constexpr u64 $msbs = 0x8080808080808080ull;
+
+    /* 0x80 in every zero byte (exact, no false positives) */
+    static __forceinline u64 eq0(u64 x) noexcept {
+        const auto low7 = ~$msbs;
+        return ~(((x & low7) + low7) | x) & $msbs;
+    }
+
+    /* msb of each byte -> bit */
+    static __forceinline u32 movemask(u64 m) noexcept {
+        return u32(((m >> 7) * 0x0102040810204080ull) >> 56);
+    }
+
+    u64 word_[2];
+#endif
+};
+
+/*! slot of a hash table */
+template<class K, class V>
+struct HashEntry
+{
+    K   key;
+    V   value;
+
+    template<class Q, class ...U>
+    HashEntry(Q&& k, U&& ...v)
+        : key(fwd<Q>(k)), value(fwd<U>(v)...)
+    {}
+};
+
+template<class K>
+struct HashEntry<K, void>
+{
+    K   key;
+
+    template<class Q>
+    explicit HashEntry(Q&& k)
+        : key(fwd<Q>(k))
+    {}
+};
+
+template<class K, class V>
+struct Is<$relocatable, HashEntry<K, V> > { static constexpr auto $value = $is<$relocatable, K> && $is<$relocatable, V>; };
+
+template<class K>
+struct Is<$relocatable, HashEntry<K, void> > { static constexpr auto $value = $is<$relocatable, K>; };
+
+/*!
+ * open addressing hash table (swiss table):
+ * one control byte per slot, a probe tests 16 slots with one SIMD compare.
+ * capacity is a power of 2, the max load factor is 7/8.
+ */
+template<class Tentry>
+class _HashTable
+{
+public:
+    using Group = _HashGroup;
+
+    _HashTable() noexcept
+    {}
+
+    ~_HashTable() {
+        _free();
+    }
+
+    _HashTable(_HashTable&& rhs) noexcept
+        : ctrl_(rhs.ctrl_), slots_(rhs.slots_), capacity_(rhs.capacity_), count_(rhs.count_), growth_(rhs.growth_) {
+        rhs.ctrl_     = nullptr;
+        rhs.slots_    = nullptr;
+        rhs.capacity_ = 0;
+        rhs.count_    = 0;
+        rhs.growth_   = 0;
+    }
+
+    _HashTable& operator=(_HashTable&& rhs) noexcept {
+        if (this != &rhs) {
+            _free();
+            ctrl_     = rhs.ctrl_;      rhs.ctrl_     = nullptr;
+            slots_    = rhs.slots_;     rhs.slots_    = nullptr;
+            capacity_ = rhs.capacity_;  rhs.capacity_ = 0;
+            count_    = rhs.count_;     rhs.count_    = 0;
+            growth_   = rhs.growth_;    rhs.growth_   = 0;
+        }
+        return *this;
+    }
+
+    _HashTable(const _HashTable&)            = delete;
+    _HashTable& operator=(const _HashTable&) = delete;
+
+#pragma region property
+    /* number of elements */
+    u32 count() const noexcept {
+        return count_;
+    }
+
+    /* number of slots */
+    u32 capacity() const noexcept {
+        return capacity_;
+    }
+#pragma endregion
+
+#pragma region iterator
+    template<class Tvalue>
+    struct Iterator
+    {
+    public:
+        Iterator(const _HashTable* table, u32 idx)
+            : table_(table), idx_(idx) {
+            skip();
+        }
+
+        Iterator& operator++() {
+            ++idx_;
+            skip();
+            return *this;
+        }
+
+        Tvalue& operator*() const {
+            return const_cast<Tvalue&>(table_->slots_[idx_]);
+        }
+
+        Tvalue* operator->() const {
+            return &**this;
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.idx_ == b.idx_; }
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.idx_ != b.idx_; }
+
+    protected:
+        const _HashTable*   table_;
+        u32                 idx_;
+
+        void skip() {
+            while (idx_ < table_->capacity_ && table_->ctrl_[idx_] < 0) {
+                ++idx_;
+            }
+        }
+    };
+
+    Iterator<Tentry>        begin()         { return { this, 0 };          }
+    Iterator<Tentry>        end()           { return { this, capacity_ };  }
+    Iterator<const Tentry>  begin() const   { return { this, 0 };          }
+    Iterator<const Tentry>  end()   const   { return { this, capacity_ };  }
+#pragma endregion
+
+#pragma region method
+    /* reserve room for cnt elements, without rehash */
+    void reserve(u32 cnt) {
+        const auto newcap = _capacity_for(cnt);
+        if (newcap > capacity_) {
+            _rehash(newcap);
+        }
+    }
+
+    /*!
+     * rebuild the table with room for max(cnt, count()) elements,
+     * deleted slots are dropped. rehash(0) shrinks the table to fit.
+     */
+    void rehash(u32 cnt = 0) {
+        if (cnt < count_) {
+            cnt = count_;
+        }
+        if (cnt == 0) {
+            _free();
+            return;
+        }
+        _rehash(_capacity_for(cnt));
+    }
+
+    /* remove all elements, the capacity is kept */
+    void clear() {
+        for (u32 i = 0; i < capacity_; ++i) {
+            if (ctrl_[i] >= 0) {
+                slots_[i].~Tentry();
+            }
+        }
+        if (ctrl_ != nullptr) {
+            for (u32 i = 0; i < capacity_ + Group::$width; ++i) {
+                ctrl_[i] = Group::$empty;
+            }
+        }
+        count_  = 0;
+        growth_ = capacity_ - capacity_ / 8;
+    }
+
+    /* test if the key exists */
+    template<class Q>
+    bool contains(const Q& key) const {
+        return _find(key, _hash_of(key)) != nullptr;
+    }
+
+    /*! remove an element, @return false if the key does not exist */
+    template<class Q>
+    bool erase(const Q& key) {
+        const auto entry = _find(key, _hash_of(key));
+        if (entry == nullptr) {
+            return false;
+        }
+        const auto idx = u32(entry - slots_);
+        entry->~Tentry();
+        _set_ctrl(idx, Group::$deleted);
+        --count_;
+        return true;
+    }
+#pragma endregion
+
+protected:
+    i8*     ctrl_       = nullptr;  // capacity + 16 bytes, the first group is mirrored at the end
+    Tentry* slots_      = nullptr;
+    u32     capacity_   = 0;
+    u32     count_      = 0;
+    u32     growth_     = 0;        // number of empty slots that can be used before a rehash
+
+    static u32 _capacity_for(u32 cnt) {
+        u32 cap = Group::$width;
+        while (cap - cap / 8 < cnt) {
+            cap *= 2;
+        }
+        return cap;
+    }
+
+    __forceinline void _set_ctrl(u32 idx, i8 h) noexcept {
+        ctrl_[idx] = h;
+        if (idx < Group::$width) {
+            ctrl_[capacity_ + idx] = h;
+        }
+    }
+
+    template<class Q>
+    Tentry* _find(const Q& key, u64 h) const {
+        if (count_ == 0) {
+            return nullptr;
+        }
+
+        const auto mask = capacity_ - 1;
+        const auto h2   = i8(h & 0x7f);
+        auto pos        = u32(h >> 7) & mask;
+        auto step       = 0u;
+
+        while (true) {
+            const Group g(ctrl_ + pos);
+            for (auto m = g.match(h2); m != 0; m &= m - 1) {
+                const auto idx = (pos + _hash_ctz(m)) & mask;
+                if (_hash_eq(slots_[idx].key, key)) {
+                    return &slots_[idx];
+                }
+            }
+            if (g.match_empty() != 0) {
+                return nullptr;
+            }
+            step += Group::$width;
+            pos   = (pos + step) & mask;
+        }
+    }
+
+    /* first empty or deleted slot of the probe sequence */
+    u32 _find_free(u64 h) const noexcept {
+        const auto mask = capacity_ - 1;
+        auto pos        = u32(h >> 7) & mask;
+        auto step       = 0u;
+
+        while (true) {
+            const Group g(ctrl_ + pos);
+            const auto  m = g.match_free();
+            if (m != 0) {
+                return (pos + _hash_ctz(m)) & mask;
+            }
+            step += Group::$width;
+            pos   = (pos + step) & mask;
+        }
+    }
+
+    /*! find the key, or insert a new entry constructed from (key, args...) */
+    template<class Q, class ...U>
+    Tentry* _emplace(bool& inserted, Q&& key, U&& ...args) {
+        const auto h = _hash_of(key);
+
+        if (auto entry = _find(key, h)) {
+            inserted = false;
+            return entry;
+        }
+
+        auto idx = capacity_ == 0 ? 0 : _find_free(h);
+        if (capacity_ == 0 || (growth_ == 0 && ctrl_[idx] == Group::$empty)) {
+            _grow();
+            idx = _find_free(h);
+        }
+
+        // a deleted slot is reused without consuming the growth
+        if (ctrl_[idx] == Group::$empty) {
+            --growth_;
+        }
+        new(&slots_[idx]) Tentry(fwd<Q>(key), fwd<U>(args)...);
+        _set_ctrl(idx, i8(h & 0x7f));
+        ++count_;
+
+        inserted = true;
+        return &slots_[idx];
+    }
+
+    void _grow() {
+        // many deleted slots: clean up in place
+        if (capacity_ != 0 && count_ <= capacity_ / 2 - capacity_ / 16) {
+            _rehash(capacity_);
+        }
+        else {
+            _rehash(capacity_ == 0 ? Group::$width : capacity_ * 2);
+        }
+    }
+
+    void _rehash(u32 newcap) {
+        const auto oldctrl = ctrl_;
+        const auto oldslot = slots_;
+        const auto oldcap  = capacity_;
+
+        ctrl_     = mnew<i8>(newcap + Group::$width);
+        slots_    = mnew<Tentry>(newcap);
+        capacity_ = newcap;
+        for (u32 i = 0; i < newcap + Group::$width; ++i) {
+            ctrl_[i] = Group::$empty;
+        }
+
+        for (u32 i = 0; i < oldcap; ++i) {
+            if (oldctrl[i] < 0) {
+                continue;
+            }
+            auto& src   = oldslot[i];
+            const auto h    = _hash_of(src.key);
+            const auto idx  = _find_free(h);
+            _set_ctrl(idx, i8(h & 0x7f));
+
+            if ($is<$relocatable, Tentry>) {
+                _mcpy(&slots_[idx], &src, sizeof(Tentry));
+            }
+            else {
+                new(&slots_[idx]) Tentry(static_cast<Tentry&&>(src));
+                src.~Tentry();
+            }
+        }
+        growth_ = newcap - newcap / 8 - count_;
+
+        if (oldctrl != nullptr) {
+            mdel(oldctrl);
+            mdel(oldslot);
+        }
+    }
+
+    void _free() {
+        if (ctrl_ == nullptr) {
+            return;
+        }
+        for (u32 i = 0; i < capacity_; ++i) {
+            if (ctrl_[i] >= 0) {
+                slots_[i].~Tentry();
+            }
+        }
+        mdel(ctrl_);
+        mdel(slots_);
+        ctrl_     = nullptr;
+        slots_    = nullptr;
+        capacity_ = 0;
+        count_    = 0;
+        growth_   = 0;
+    }
+};
+#pragma endregion
+
+#pragma region hash map
+/*!
+ * hash map: K -> V
+ * lookups are heterogeneous: HashMap<String<>, V> can be searched with a StrView.
+ * iteration order is unspecified, the entries move on rehash.
+ */
+template<class K, class V>
+class HashMap
+    : public _HashTable<HashEntry<K, V> >
+{
+public:
+    using base   = _HashTable<HashEntry<K, V> >;
+    using Tkey   = K;
+    using Tvalue = V;
+    using Tentry = HashEntry<K, V>;
+
+    HashMap() noexcept
+    {}
+
+    HashMap(HashMap&&)              = default;
+    HashMap& operator=(HashMap&&)   = default;
+
+    /* find a value, nullptr if the key does not exist */
+    template<class Q>
+    V* find(const Q& key) {
+        const auto entry = base::_find(key, _hash_of(key));
+        return entry == nullptr ? nullptr : &entry->value;
+    }
+
+    /* find a value, nullptr if the key does not exist */
+    template<class Q>
+    const V* find(const Q& key) const {
+        const auto entry = base::_find(key, _hash_of(key));
+        return entry == nullptr ? nullptr : &entry->value;
+    }
+
+    /*! insert (key, V(args...)) if the key does not exist, @return true if inserted */
+    template<class Q, class ...U>
+    bool insert(Q&& key, U&& ...args) {
+        auto inserted = false;
+        base::_emplace(inserted, fwd<Q>(key), fwd<U>(args)...);
+        return inserted;
+    }
+
+    /*! insert or assign */
+    template<class Q, class U>
+    V& set(Q&& key, U&& val) {
+        if (auto pval = find(key)) {
+            *pval = fwd<U>(val);
+            return *pval;
+        }
+        auto inserted = false;
+        return base::_emplace(inserted, fwd<Q>(key), fwd<U>(val))->value;
+    }
+
+    /*! find a value, a default value is inserted if the key does not exist */
+    template<class Q>
+    V& operator[](Q&& key) {
+        auto inserted = false;
+        return base::_emplace(inserted, fwd<Q>(key))->value;
+    }
+
+    HashMap dup() const {
+        HashMap tmp;
+        tmp.reserve(base::count());
+        for (auto& e : *this) {
+            tmp.insert(e.key, e.value);
+        }
+        return tmp;
+    }
+
+    /* format: {key: value, ...} */
+    void format(String<>& buf) const {
+        buf += "{";
+        auto first = true;
+        for (auto& e : *this) {
+            if (!first) buf += ", ";
+            first = false;
+            format_switch(buf, {}, e.key);
+            buf += ": ";
+            format_switch(buf, {}, e.value);
+        }
+        buf += "}";
+    }
+};
+#pragma endregion
+
+#pragma region hash set
+/*! hash set, @see HashMap */
+template<class K>
+class HashSet
+    : public _HashTable<HashEntry<K, void> >
+{
+public:
+    using base   = _HashTable<HashEntry<K, void> >;
+    using Tkey   = K;
+    using Tentry = HashEntry<K, void>;
+
+    HashSet() noexcept
+    {}
+
+    HashSet(HashSet&&)              = default;
+    HashSet& operator=(HashSet&&)   = default;
+
+    /* find a key, nullptr if it does not exist */
+    template<class Q>
+    const K* find(const Q& key) const {
+        const auto entry = base::_find(key, _hash_of(key));
+        return entry == nullptr ? nullptr : &entry->key;
+    }
+
+    /*! insert a key, @return true if inserted */
+    template<class Q>
+    bool insert(Q&& key) {
+        auto inserted = false;
+        base::_emplace(inserted, fwd<Q>(key));
+        return inserted;
+    }
+
+    HashSet dup() const {
+        HashSet tmp;
+        tmp.reserve(base::count());
+        for (auto& e : *this) {
+            tmp.insert(e.key);
+        }
+        return tmp;
+    }
+
+    /* format: {key, ...} */
+    void format(String<>& buf) const {
+        buf += "{";
+        auto first = true;
+        for (auto& e : *this) {
+            if (!first) buf += ", ";
+            first = false;
+            format_switch(buf, {}, e.key);
+        }
+        buf += "}";
+    }
+};
+#pragma endregion
+
+}
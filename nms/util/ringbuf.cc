@@ -0,0 +1,41 @@
+#include <nms/test.h>
+#include <nms/util/ringbuf.h>
+
+namespace nms
+{
+
+#pragma region unittest
+
+nms_test(Ringbuf) {
+    Ringbuf<u32> buf(4);
+
+    // wrap around several times
+    u32 next_push = 0;
+    u32 next_pop  = 0;
+    for (u32 loop = 0; loop < 10; ++loop) {
+        while (buf.tryPush(next_push)) {
+            ++next_push;
+        }
+        test::assert_true(buf.isFull());
+        test::assert_eq(buf.len(), u64(4));
+
+        buf.pop();
+        ++next_pop;
+        u32 val = 0;
+        test::assert_true(buf.tryPop(val));
+        test::assert_eq(val, next_pop++);
+        test::assert_eq(buf.len(), u64(2));
+    }
+
+    while (!buf.isEmpty()) {
+        test::assert_eq(buf.pop(), next_pop++);
+    }
+    test::assert_eq(next_pop, next_push);
+
+    u32 val = 0;
+    test::assert_false(buf.tryPop(val));
+}
+
+#pragma endregion
+
+}
@@ -7,6 +7,10 @@
 namespace  nms
 {
 
+/*!
+ * single-threaded ring buffer.
+ * for a hand-off between threads, @see thread::SpscRing, thread::MpmcQueue
+ */
 template<class T>
 class Ringbuf final
 {
@@ -25,20 +29,25 @@ public:
 
     ~Ringbuf() {
         if (data_ != nullptr) {
+            while (!isEmpty()) {
+                data_[tail_++ % cap_].~T();
+            }
             mdel(data_);
         }
     }
 
+    Ringbuf(const Ringbuf&)            = delete;
+    Ringbuf& operator=(const Ringbuf&) = delete;
+
+    // top_ and tail_ count all pushes and pops, the slot is (count % cap_)
     // 0123456789
     // ^         ^
     // |         |
     template<class U>
     Ringbuf& push(U&& val) {
-        if (isFull()) {
+        if (!tryPush(fwd<U>(val))) {
             NMS_THROW(EOverflow());
         }
-        new(&data_[top_++])T(fwd<U>(val));
-        if (top_ > cap_) top_ = 0;
         return *this;
     }
 
@@ -46,14 +55,40 @@ public:
         if (isEmpty()) {
             NMS_THROW(EEmpty());
         }
-        auto tmp(move(data_[tail_++]));
-        if (tail_ >= cap_) tail_ = 0;
+        auto& ref = data_[tail_++ % cap_];
+        auto  tmp(move(ref));
+        ref.~T();
         return tmp;
     }
 
+    /*! push, @return false if full */
+    template<class U>
+    bool tryPush(U&& val) {
+        if (isFull()) {
+            return false;
+        }
+        new(&data_[top_ % cap_])T(fwd<U>(val));
+        ++top_;
+        return true;
+    }
+
+    /*! pop, @return false if empty */
+    bool tryPop(T& val) {
+        if (isEmpty()) {
+            return false;
+        }
+        auto& ref = data_[tail_++ % cap_];
+        val = move(ref);
+        ref.~T();
+        return true;
+    }
+
     u64 len() const noexcept {
-        auto result = top_ > tail_ ? top_ - tail_ : cap_ - (cap_ - top_);
-        return result;
+        return top_ - tail_;
+    }
+
+    u64 capacity() const noexcept {
+        return cap_;
     }
 
     bool isFull() const noexcept {
@@ -2,6 +2,12 @@
 #include <nms/config.h>
 #include <nms/core.h>
 
+#ifdef NMS_OS_WINDOWS
+extern "C" {
+    nms::u32 GetActiveProcessorCount(nms::u16 group);
+}
+#endif
+
 namespace nms::system
 {
 
@@ -33,6 +39,15 @@ NMS_API void sleep(double duration) {
 
 }
 
+NMS_API u32 cpu_count() {
+#ifdef NMS_OS_WINDOWS
+    static const auto cnt = GetActiveProcessorCount(0xFFFF);
+#else
+    static const auto cnt = u32(::sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+    return cnt == 0 ? 1 : cnt;
+}
+
 NMS_API void beep(u32 freq, f64 duration) {
 #ifdef NMS_OS_WINDOWS
     _beep(freq, u32(duration*1e3));
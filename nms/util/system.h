@@ -17,4 +17,7 @@ NMS_API void    beep(u32 freq, f64 duration);
 /*! sleep the thread for some time */
 NMS_API void    sleep(double duration);
 
+/*! number of online logical processors */
+NMS_API u32     cpu_count();
+
 }